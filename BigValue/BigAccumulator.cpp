@@ -0,0 +1,347 @@
+/////////////////////////////////////
+//
+// CBigAccumulator : exact sums and dot products
+// of doubles (Kulisch long accumulator).
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Each double is taken apart like in IEEE constructors of CBigValue:
+// 53-bit mantissa and position of its lowest bit in register.
+// Product of two is 106-bit mantissa (single 64x64 multiply)
+// at sum of positions. Shifted mantissa is split in 32-bit parts
+// which are added to (or subtracted from) five digits:
+// digits are 64-bit so about 2^31 additions fit before
+// carries must be propagated.
+//
+// Batches take a block of values apart first (no branches,
+// suitable for vectorizing by compiler) and then add to register.
+//
+
+#include "BigAccumulator.h"
+#include "BigLimb.h"
+
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+
+typedef std::vector<uint64_t> LimbVector;
+
+// carries are propagated after this many additions:
+// digit stays below 2^32 * (2^30 + block) < 2^63
+static const size_t s_nMaxPending = (size_t)1 << 30;
+
+// values taken apart at a time in batches
+static const size_t s_nBlockSize = 64;
+
+
+////////// local helpers
+
+// mantissa and register position of its lowest bit,
+// returns false for infinity/NaN (mantissa is zero then)
+static inline bool splitDouble(const double value, uint64_t &mantissa, int &nPosition, bool &bNegative)
+{
+	uint64_t bits = 0;
+	::memcpy(&bits, &value, sizeof(bits));
+	const int nBiased = (int)((bits >> 52) & 0x7FF);
+	const uint64_t hidden = (nBiased != 0) ? (1ULL << 52) : 0;
+	const bool bFinite = (nBiased != 0x7FF);
+
+	mantissa = bFinite ? ((bits & ((1ULL << 52) - 1)) | hidden) : 0;
+	nPosition = ((nBiased != 0) ? nBiased : 1) - 1075 + BigAccumulatorOffset;
+	bNegative = ((bits >> 63) != 0);
+	return bFinite;
+}
+
+// digits += (or -=) (high:low) * 2^position,
+// value below 2^106 touches five digits
+static inline void addBits(int64_t *pDigits, const uint64_t low, const uint64_t high, const int nPosition, const bool bNegative)
+{
+	const int nShift = nPosition & 31;
+	int64_t *pDigit = pDigits + (nPosition >> 5);
+
+	const uint64_t w0 = low << nShift;
+	const uint64_t w1 = (high << nShift) | ((nShift != 0) ? (low >> (64 - nShift)) : 0);
+	const uint64_t w2 = (nShift != 0) ? (high >> (64 - nShift)) : 0;
+	const int64_t nSign = bNegative ? -1 : 1;
+
+	pDigit[0] += nSign * (int64_t)(w0 & 0xFFFFFFFF);
+	pDigit[1] += nSign * (int64_t)(w0 >> 32);
+	pDigit[2] += nSign * (int64_t)(w1 & 0xFFFFFFFF);
+	pDigit[3] += nSign * (int64_t)(w1 >> 32);
+	pDigit[4] += nSign * (int64_t)w2;
+}
+
+// carry propagation: lower digits to [0, 2^32), sign to top digit
+static void normalizeDigits(int64_t *pDigits)
+{
+	int64_t carry = 0;
+	for (size_t i = 0; i + 1 < BigAccumulatorDigits; i++)
+	{
+		const int64_t digit = pDigits[i] + carry;
+		// arithmetic shift: floor for negative
+		carry = digit >> 32;
+		pDigits[i] = digit & 0xFFFFFFFF;
+	}
+	pDigits[BigAccumulatorDigits - 1] += carry;
+}
+
+
+////////// protected methods
+
+void CBigAccumulator::normalize()
+{
+	normalizeDigits(m_Digits);
+	m_nPending = 0;
+}
+
+bool CBigAccumulator::getMagnitude(LimbVector &magnitude) const
+{
+	int64_t digits[BigAccumulatorDigits];
+	::memcpy(digits, m_Digits, sizeof(digits));
+	normalizeDigits(digits);
+
+	const bool bNegative = (digits[BigAccumulatorDigits - 1] < 0);
+	magnitude.assign(BigAccumulatorDigits / 2, 0);
+	for (size_t i = 0; i < magnitude.size(); i++)
+	{
+		magnitude[i] = (uint64_t)(uint32_t)digits[2 * i] | ((uint64_t)(uint32_t)digits[2 * i + 1] << 32);
+	}
+
+	if (bNegative == true)
+	{
+		// two's complement to magnitude
+		uint64_t carry = 1;
+		for (size_t i = 0; i < magnitude.size(); i++)
+		{
+			magnitude[i] = ~magnitude[i] + carry;
+			carry = (carry != 0 && magnitude[i] == 0) ? 1 : 0;
+		}
+	}
+
+	magnitude.resize(limbNormN(&magnitude[0], magnitude.size()));
+	return bNegative;
+}
+
+void CBigAccumulator::addSpecial(const double value)
+{
+	if (isnan(value))
+	{
+		m_bNaN = true;
+	}
+	else if (value > 0)
+	{
+		m_bPositiveInfinity = true;
+	}
+	else
+	{
+		m_bNegativeInfinity = true;
+	}
+}
+
+void CBigAccumulator::checkPending(const size_t nAdded)
+{
+	m_nPending += nAdded;
+	if (m_nPending >= s_nMaxPending)
+	{
+		normalize();
+	}
+}
+
+
+////////// public methods
+
+CBigAccumulator::CBigAccumulator()
+{
+	clear();
+}
+
+void CBigAccumulator::clear()
+{
+	::memset(m_Digits, 0, sizeof(m_Digits));
+	m_nPending = 0;
+	m_bNaN = false;
+	m_bPositiveInfinity = false;
+	m_bNegativeInfinity = false;
+}
+
+void CBigAccumulator::add(const double value)
+{
+	uint64_t mantissa = 0;
+	int nPosition = 0;
+	bool bNegative = false;
+	if (splitDouble(value, mantissa, nPosition, bNegative) == false)
+	{
+		addSpecial(value);
+		return;
+	}
+	addBits(m_Digits, mantissa, 0, nPosition, bNegative);
+	checkPending(1);
+}
+
+void CBigAccumulator::addProduct(const double a, const double b)
+{
+	uint64_t mantissaA = 0;
+	uint64_t mantissaB = 0;
+	int nPositionA = 0;
+	int nPositionB = 0;
+	bool bNegativeA = false;
+	bool bNegativeB = false;
+	const bool bFiniteA = splitDouble(a, mantissaA, nPositionA, bNegativeA);
+	const bool bFiniteB = splitDouble(b, mantissaB, nPositionB, bNegativeB);
+	if (bFiniteA == false || bFiniteB == false)
+	{
+		// IEEE product gives the special (infinity * 0 is NaN)
+		addSpecial(a * b);
+		return;
+	}
+
+	uint64_t high = 0;
+	const uint64_t low = limbMul64(mantissaA, mantissaB, &high);
+	addBits(m_Digits, low, high, nPositionA + nPositionB - BigAccumulatorOffset, bNegativeA != bNegativeB);
+	checkPending(1);
+}
+
+void CBigAccumulator::add(const double *pValues, const size_t nCount)
+{
+	uint64_t mantissa[s_nBlockSize];
+	int position[s_nBlockSize];
+	bool negative[s_nBlockSize];
+
+	for (size_t nStart = 0; nStart < nCount; nStart += s_nBlockSize)
+	{
+		const size_t nBlock = (nCount - nStart < s_nBlockSize) ? (nCount - nStart) : s_nBlockSize;
+		const double *pBlock = pValues + nStart;
+
+		bool bFinite = true;
+		for (size_t i = 0; i < nBlock; i++)
+		{
+			bFinite &= splitDouble(pBlock[i], mantissa[i], position[i], negative[i]);
+		}
+		if (bFinite == false)
+		{
+			// specials have zero mantissa: only flags needed
+			for (size_t i = 0; i < nBlock; i++)
+			{
+				if (isfinite(pBlock[i]) == false)
+				{
+					addSpecial(pBlock[i]);
+				}
+			}
+		}
+
+		for (size_t i = 0; i < nBlock; i++)
+		{
+			addBits(m_Digits, mantissa[i], 0, position[i], negative[i]);
+		}
+		checkPending(nBlock);
+	}
+}
+
+void CBigAccumulator::addProducts(const double *pA, const double *pB, const size_t nCount)
+{
+	uint64_t mantissaA[s_nBlockSize];
+	uint64_t mantissaB[s_nBlockSize];
+	int positionA[s_nBlockSize];
+	int positionB[s_nBlockSize];
+	bool negativeA[s_nBlockSize];
+	bool negativeB[s_nBlockSize];
+
+	for (size_t nStart = 0; nStart < nCount; nStart += s_nBlockSize)
+	{
+		const size_t nBlock = (nCount - nStart < s_nBlockSize) ? (nCount - nStart) : s_nBlockSize;
+		const double *pBlockA = pA + nStart;
+		const double *pBlockB = pB + nStart;
+
+		bool bFinite = true;
+		for (size_t i = 0; i < nBlock; i++)
+		{
+			bFinite &= splitDouble(pBlockA[i], mantissaA[i], positionA[i], negativeA[i]);
+			bFinite &= splitDouble(pBlockB[i], mantissaB[i], positionB[i], negativeB[i]);
+		}
+		if (bFinite == false)
+		{
+			for (size_t i = 0; i < nBlock; i++)
+			{
+				if (isfinite(pBlockA[i]) == false || isfinite(pBlockB[i]) == false)
+				{
+					addSpecial(pBlockA[i] * pBlockB[i]);
+					// not added to register below
+					mantissaA[i] = 0;
+				}
+			}
+		}
+
+		for (size_t i = 0; i < nBlock; i++)
+		{
+			uint64_t high = 0;
+			const uint64_t low = limbMul64(mantissaA[i], mantissaB[i], &high);
+			addBits(m_Digits, low, high, positionA[i] + positionB[i] - BigAccumulatorOffset, negativeA[i] != negativeB[i]);
+		}
+		checkPending(nBlock);
+	}
+}
+
+void CBigAccumulator::merge(const CBigAccumulator &other)
+{
+	// own digits in range: sum grows like one more pending addition
+	normalize();
+	for (size_t i = 0; i < BigAccumulatorDigits; i++)
+	{
+		m_Digits[i] += other.m_Digits[i];
+	}
+	m_bNaN |= other.m_bNaN;
+	m_bPositiveInfinity |= other.m_bPositiveInfinity;
+	m_bNegativeInfinity |= other.m_bNegativeInfinity;
+	checkPending(other.m_nPending + 1);
+}
+
+double CBigAccumulator::toDouble(const BigRounding eRounding) const
+{
+	if (m_bNaN == true || (m_bPositiveInfinity == true && m_bNegativeInfinity == true))
+	{
+		return NAN;
+	}
+	if (m_bPositiveInfinity == true)
+	{
+		return INFINITY;
+	}
+	if (m_bNegativeInfinity == true)
+	{
+		return -INFINITY;
+	}
+	return toBigFloat().toDouble(eRounding);
+}
+
+CBigValue CBigAccumulator::toBigValue(const size_t nScale, const BigRounding eRounding) const
+{
+	if (isFinite() == false)
+	{
+		// no representation for infinity/NaN: zero
+		CBigValue value;
+		value.fromLimbs(nullptr, 0, false, nScale);
+		return value;
+	}
+	return toBigFloat().toBigValue(nScale, eRounding);
+}
+
+CBigFloat CBigAccumulator::toBigFloat() const
+{
+	if (isFinite() == false)
+	{
+		return CBigFloat(toDouble(), 64);
+	}
+
+	LimbVector magnitude;
+	const bool bNegative = getMagnitude(magnitude);
+	if (magnitude.empty() == true)
+	{
+		return CBigFloat(64);
+	}
+
+	CBigFloat value(magnitude.size() * 64);
+	value.fromParts(magnitude, -(int64_t)BigAccumulatorOffset, bNegative);
+	return value;
+}
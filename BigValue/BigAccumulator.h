@@ -0,0 +1,104 @@
+/////////////////////////////////////
+//
+// CBigAccumulator : exact sums and dot products
+// of doubles (Kulisch long accumulator).
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Fixed-point register wide enough for every double and
+// every exact product of two doubles (2^-2148 .. 2^2048)
+// with room for more than 2^150 maximum-size terms above that.
+// Nothing is rounded until result is read, so result
+// is same regardless of order of additions:
+// per-thread accumulators can be merged in any order.
+//
+// Register is kept in 32-bit digits stored in 64-bit words:
+// values are added to digits without carrying and
+// carries are propagated only after enough additions
+// that a digit might overflow (or when result is needed).
+//
+
+#ifndef BIGACCUMULATOR_H
+#define BIGACCUMULATOR_H
+
+#include "BigValue.h"
+#include "BigFloat.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+// bits of register: products need 4196 (2^-2148 .. 2^2048),
+// rest is headroom for carries of large sums
+const size_t BigAccumulatorBits = 4352;
+const size_t BigAccumulatorDigits = BigAccumulatorBits / 32;
+
+// bit position of 2^0 in register
+const int BigAccumulatorOffset = 2148;
+
+
+class CBigAccumulator
+{
+protected:
+	// little-endian 32-bit digits, may be out of range
+	// (and negative) until carries are propagated
+	int64_t m_Digits[BigAccumulatorDigits];
+
+	// additions since carries were last propagated
+	size_t m_nPending;
+
+	// special values seen: result is not finite
+	bool m_bNaN;
+	bool m_bPositiveInfinity;
+	bool m_bNegativeInfinity;
+
+	// propagate carries: lower digits in [0, 2^32),
+	// sign of value in top digit
+	void normalize();
+
+	// magnitude of register as 64-bit limbs, returns sign
+	bool getMagnitude(std::vector<uint64_t> &magnitude) const;
+
+	void addSpecial(const double value);
+	void checkPending(const size_t nAdded);
+
+public:
+	CBigAccumulator();
+
+	void clear();
+
+	// sum += value
+	void add(const double value);
+	// sum += a * b (product is exact)
+	void addProduct(const double a, const double b);
+
+	// batches: values are taken apart in blocks
+	// before adding to register
+	void add(const double *pValues, const size_t nCount);
+	// sum += dot product of arrays
+	void addProducts(const double *pA, const double *pB, const size_t nCount);
+
+	// sum += other sum (exact, order does not matter)
+	void merge(const CBigAccumulator &other);
+
+	// false if infinity or NaN was added
+	bool isFinite() const
+	{
+		return (m_bNaN == false && m_bPositiveInfinity == false && m_bNegativeInfinity == false);
+	}
+
+	// correctly rounded sum: NaN if NaN was added
+	// or infinities of both signs, otherwise infinity if added.
+	// exact zero is positive zero.
+	double toDouble(const BigRounding eRounding = BigRoundingNearestEven) const;
+
+	// sum rounded at power of 10 scale (zero if not finite)
+	CBigValue toBigValue(const size_t nScale = 0, const BigRounding eRounding = BigRoundingNearestEven) const;
+
+	// exact sum (precision is enough for all bits)
+	CBigFloat toBigFloat() const;
+};
+
+#endif // BIGACCUMULATOR_H
@@ -0,0 +1,491 @@
+/////////////////////////////////////
+//
+// CBigConstants : mathematical constants
+// to arbitrary precision (pi, e, ln2, sqrt2).
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Hypergeometric series S = sum(a(k) * prod(p(j)/q(j), j=1..k))
+// are summed by binary splitting: for range [m, n)
+//   P = prod p, Q = prod q, T = Q * partial sum,
+// halves merge as P = Pl*Pr, Q = Ql*Qr, T = Tl*Qr + Pl*Tr
+// so that big multiplications have equal-sized operands
+// and S = T/Q needs only single division at the end.
+//
+// Series used:
+// pi: Chudnovsky, about 14 digits per term
+// e: sum 1/k!
+// ln2: 18*atanh(1/26) - 2*atanh(1/4801) + 8*atanh(1/8749)
+// sqrt2: no series, Newton iteration for 1/sqrt(2)
+//
+// Division and square root use Newton iteration doubling
+// precision on each step so cost is few full-size multiplications.
+//
+// Halves of binary splitting and large multiplications run as tasks
+// of current pool (TaskPool.h) or of own pool of setThreadCount().
+//
+
+#include "BigConstants.h"
+#include "BigLimb.h"
+#include "../simplesse/TaskPool.h"
+
+#include <math.h>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+
+typedef std::vector<uint64_t> LimbVector;
+
+// below this count of terms sequential recursion
+static const uint64_t s_nParallelMinTerms = 256;
+
+// extra bits computed beyond requested precision,
+// cached value is trusted to this less
+static const size_t s_nGuardBits = 64;
+static const size_t s_nTrustedGuardBits = 32;
+
+// bits beyond decimal digits in first attempt of getDigits()
+static const size_t s_nDigitGuardBits = 16;
+
+// log2(10)
+static const double s_dBitsPerDigit = 3.32192809488736234787;
+
+// pool of setThreadCount(), null for current pool
+static std::mutex s_PoolLock;
+static std::shared_ptr<TaskPool> s_pPool;
+
+static std::mutex s_CacheLock[BigConstantCount];
+static CBigFloat s_Cache[BigConstantCount];
+static size_t s_nCachedPrecision[BigConstantCount] = {0};
+
+
+////////// series definition
+
+// factors of single term, each fits in a limb
+struct SeriesTerm
+{
+	uint64_t p[4];
+	size_t nP;
+	uint64_t q[4];
+	size_t nQ;
+	uint64_t a;
+	bool bNegativeP;
+};
+
+typedef void (*SeriesLeaf)(const uint64_t k, const uint64_t nParameter, SeriesTerm &term);
+
+struct SplitResult
+{
+	LimbVector P;
+	LimbVector Q;
+	LimbVector T;
+	bool bNegativeP;
+	bool bNegativeT;
+};
+
+// Chudnovsky:
+// p(k) = -(6k-5)(2k-1)(6k-1), q(k) = k^3 * 640320^3/24,
+// a(k) = 13591409 + 545140134k
+static void chudnovskyLeaf(const uint64_t k, const uint64_t /*nParameter*/, SeriesTerm &term)
+{
+	term.a = 13591409ULL + 545140134ULL * k;
+	if (k == 0)
+	{
+		term.p[0] = 1;
+		term.nP = 1;
+		term.q[0] = 1;
+		term.nQ = 1;
+		term.bNegativeP = false;
+		return;
+	}
+
+	term.p[0] = 6 * k - 5;
+	term.p[1] = 2 * k - 1;
+	term.p[2] = 6 * k - 1;
+	term.nP = 3;
+	term.q[0] = k;
+	term.q[1] = k;
+	term.q[2] = k;
+	term.q[3] = 10939058860032000ULL;
+	term.nQ = 4;
+	term.bNegativeP = true;
+}
+
+// e - 1 = sum 1/(k+1)!: p(k) = 1, q(k) = k+1
+static void exponentLeaf(const uint64_t k, const uint64_t /*nParameter*/, SeriesTerm &term)
+{
+	term.a = 1;
+	term.p[0] = 1;
+	term.nP = 1;
+	term.q[0] = k + 1;
+	term.nQ = 1;
+	term.bNegativeP = false;
+}
+
+// x * atanh(1/x) = sum 1/((2k+1) x^2k):
+// p(k) = 2k-1, q(k) = (2k+1) x^2
+static void atanhLeaf(const uint64_t k, const uint64_t nParameter, SeriesTerm &term)
+{
+	term.a = 1;
+	term.bNegativeP = false;
+	if (k == 0)
+	{
+		term.p[0] = 1;
+		term.nP = 1;
+		term.q[0] = 1;
+		term.nQ = 1;
+		return;
+	}
+
+	term.p[0] = 2 * k - 1;
+	term.nP = 1;
+	term.q[0] = 2 * k + 1;
+	term.q[1] = nParameter * nParameter;
+	term.nQ = 2;
+}
+
+// count of terms until term is below 2^-nBits relative to first,
+// terms must be decreasing from there (ratio below 1/2)
+static uint64_t seriesLength(const SeriesLeaf pLeaf, const uint64_t nParameter, const size_t nBits)
+{
+	SeriesTerm term;
+	pLeaf(0, nParameter, term);
+	const double dFirst = log2((double)term.a);
+	double dLog = 0;
+
+	uint64_t k = 1;
+	for (;; k++)
+	{
+		pLeaf(k, nParameter, term);
+		double dRatio = 0;
+		for (size_t i = 0; i < term.nP; i++)
+		{
+			dRatio += log2((double)term.p[i]);
+		}
+		for (size_t i = 0; i < term.nQ; i++)
+		{
+			dRatio -= log2((double)term.q[i]);
+		}
+		dLog += dRatio;
+		if (dRatio < -1 && dLog + log2((double)term.a) < dFirst - (double)nBits - 2)
+		{
+			break;
+		}
+	}
+	return k;
+}
+
+
+////////// signed limb arithmetic
+
+static void mulV(LimbVector &result, const LimbVector &a, const LimbVector &b)
+{
+	result.resize(a.size() + b.size());
+	limbMulN(&result[0], &a[0], a.size(), &b[0], b.size());
+	result.resize(limbNormN(&result[0], result.size()));
+	if (result.empty())
+	{
+		result.push_back(0);
+	}
+}
+
+static void mulWordV(LimbVector &v, const uint64_t nMul)
+{
+	uint64_t carry = limbMul1(&v[0], &v[0], v.size(), nMul);
+	if (carry != 0)
+	{
+		v.push_back(carry);
+	}
+}
+
+// result = x + y with signs (result must not alias)
+static void addSigned(LimbVector &result, bool &bNegative, const LimbVector &x, const bool bNegativeX, const LimbVector &y, const bool bNegativeY)
+{
+	const LimbVector &larger = (limbCompareN(&x[0], x.size(), &y[0], y.size()) >= 0) ? x : y;
+	const LimbVector &smaller = (&larger == &x) ? y : x;
+	bNegative = (&larger == &x) ? bNegativeX : bNegativeY;
+
+	result = larger;
+	if (bNegativeX == bNegativeY)
+	{
+		result.push_back(0);
+		limbAddN(&result[0], &result[0], result.size(), &smaller[0], smaller.size());
+	}
+	else
+	{
+		limbSubN(&result[0], &result[0], result.size(), &smaller[0], smaller.size());
+	}
+	result.resize(limbNormN(&result[0], result.size()));
+	if (result.empty())
+	{
+		result.push_back(0);
+		bNegative = false;
+	}
+}
+
+static void splitLeaf(const SeriesLeaf pLeaf, const uint64_t nParameter, const uint64_t k, SplitResult &result)
+{
+	SeriesTerm term;
+	pLeaf(k, nParameter, term);
+
+	result.P.assign(1, term.p[0]);
+	for (size_t i = 1; i < term.nP; i++)
+	{
+		mulWordV(result.P, term.p[i]);
+	}
+	result.Q.assign(1, term.q[0]);
+	for (size_t i = 1; i < term.nQ; i++)
+	{
+		mulWordV(result.Q, term.q[i]);
+	}
+	result.T = result.P;
+	mulWordV(result.T, term.a);
+	result.bNegativeP = term.bNegativeP;
+	result.bNegativeT = term.bNegativeP;
+}
+
+// terms [nBegin, nEnd), P is only needed by left halves
+static void splitRange(const SeriesLeaf pLeaf, const uint64_t nParameter, const uint64_t nBegin, const uint64_t nEnd, SplitResult &result, const bool bNeedP)
+{
+	if (nEnd - nBegin == 1)
+	{
+		splitLeaf(pLeaf, nParameter, nBegin, result);
+		return;
+	}
+
+	const uint64_t nMiddle = nBegin + (nEnd - nBegin) / 2;
+	SplitResult left;
+	SplitResult right;
+	if (nEnd - nBegin >= s_nParallelMinTerms)
+	{
+		parallelInvoke([&]() { splitRange(pLeaf, nParameter, nMiddle, nEnd, right, bNeedP); },
+			[&]() { splitRange(pLeaf, nParameter, nBegin, nMiddle, left, true); });
+	}
+	else
+	{
+		splitRange(pLeaf, nParameter, nBegin, nMiddle, left, true);
+		splitRange(pLeaf, nParameter, nMiddle, nEnd, right, bNeedP);
+	}
+
+	LimbVector leftT;
+	LimbVector rightT;
+	mulV(leftT, left.T, right.Q);
+	mulV(rightT, left.P, right.T);
+	addSigned(result.T, result.bNegativeT, leftT, left.bNegativeT, rightT, (left.bNegativeP != right.bNegativeT));
+
+	mulV(result.Q, left.Q, right.Q);
+	if (bNeedP == true)
+	{
+		mulV(result.P, left.P, right.P);
+		result.bNegativeP = (left.bNegativeP != right.bNegativeP);
+	}
+	else
+	{
+		result.P.clear();
+		result.bNegativeP = false;
+	}
+}
+
+// T/Q of series rounded to nPrecision bits
+static void sumSeries(CBigFloat &result, const SeriesLeaf pLeaf, const uint64_t nParameter, SplitResult &split)
+{
+	const size_t nPrecision = result.getPrecision();
+	const uint64_t nTerms = seriesLength(pLeaf, nParameter, nPrecision);
+	splitRange(pLeaf, nParameter, 0, nTerms, split, false);
+
+	CBigFloat sumT(nPrecision);
+	sumT.fromParts(split.T, 0, split.bNegativeT);
+	CBigFloat sumQ(nPrecision);
+	sumQ.fromParts(split.Q, 0, false);
+
+	CBigFloat inverseQ(nPrecision);
+	inverseQ.reciprocal(sumQ);
+	result.mul(sumT, inverseQ);
+}
+
+// pi = 426880 * sqrt(10005) * Q / T
+static void computePi(CBigFloat &result)
+{
+	const size_t nPrecision = result.getPrecision();
+	const uint64_t nTerms = seriesLength(chudnovskyLeaf, 0, nPrecision);
+	SplitResult split;
+	splitRange(chudnovskyLeaf, 0, 0, nTerms, split, false);
+
+	CBigFloat sumT(nPrecision);
+	sumT.fromParts(split.T, 0, split.bNegativeT);
+	CBigFloat sumQ(nPrecision);
+	sumQ.fromParts(split.Q, 0, false);
+
+	// sqrt(10005) = 10005 / sqrt(10005)
+	CBigFloat radicand(nPrecision);
+	radicand.fromUInt64(10005);
+	CBigFloat root(nPrecision);
+	root.reciprocalSqrt(radicand);
+	root.mul(root, radicand);
+
+	CBigFloat inverseT(nPrecision);
+	inverseT.reciprocal(sumT);
+
+	CBigFloat factor(nPrecision);
+	factor.fromUInt64(426880);
+	result.mul(factor, root);
+	result.mul(result, sumQ);
+	result.mul(result, inverseT);
+}
+
+static void computeE(CBigFloat &result)
+{
+	SplitResult split;
+	sumSeries(result, exponentLeaf, 0, split);
+
+	CBigFloat one(1);
+	one.fromUInt64(1);
+	result.add(result, one);
+}
+
+// ln2 = 18*atanh(1/26) - 2*atanh(1/4801) + 8*atanh(1/8749),
+// each as (c/x) * series
+static void computeLn2(CBigFloat &result)
+{
+	static const uint64_t s_nArgument[3] = {26, 4801, 8749};
+	static const int64_t s_nFactor[3] = {18, -2, 8};
+
+	const size_t nPrecision = result.getPrecision();
+	result.fromUInt64(0);
+	for (int i = 0; i < 3; i++)
+	{
+		CBigFloat series(nPrecision);
+		SplitResult split;
+		sumSeries(series, atanhLeaf, s_nArgument[i], split);
+
+		CBigFloat divisor(nPrecision);
+		divisor.fromUInt64(s_nArgument[i]);
+		CBigFloat inverse(nPrecision);
+		inverse.reciprocal(divisor);
+
+		CBigFloat factor(nPrecision);
+		factor.fromInt64(s_nFactor[i]);
+		series.mul(series, inverse);
+		series.mul(series, factor);
+		result.add(result, series);
+	}
+}
+
+// sqrt2 = 2 / sqrt(2)
+static void computeSqrt2(CBigFloat &result)
+{
+	CBigFloat two(2);
+	two.fromUInt64(2);
+	result.reciprocalSqrt(two);
+	result.ldexp(1);
+}
+
+// constant to precision of result, in own pool if one is set
+static void computeConstant(const BigConstant eConstant, CBigFloat &result)
+{
+	std::shared_ptr<TaskPool> pPool;
+	{
+		std::lock_guard<std::mutex> lock(s_PoolLock);
+		pPool = s_pPool;
+	}
+	TaskPoolScope scope((pPool) ? *pPool : taskPoolCurrent());
+
+	switch (eConstant)
+	{
+	case BigConstantPi:
+		computePi(result);
+		break;
+	case BigConstantE:
+		computeE(result);
+		break;
+	case BigConstantLn2:
+		computeLn2(result);
+		break;
+	case BigConstantSqrt2:
+		computeSqrt2(result);
+		break;
+	default:
+		break;
+	}
+}
+
+
+////////// public methods
+
+CBigFloat CBigConstants::getFloat(const BigConstant eConstant, const size_t nPrecision)
+{
+	std::unique_lock<std::mutex> lock(s_CacheLock[eConstant]);
+	if (s_nCachedPrecision[eConstant] < nPrecision)
+	{
+		// note: computed without lock, thread waiting for its tasks
+		// runs other tasks of pool and those may need same constant
+		lock.unlock();
+		CBigFloat value(nPrecision + s_nGuardBits);
+		computeConstant(eConstant, value);
+
+		const size_t nTrusted = nPrecision + s_nGuardBits - s_nTrustedGuardBits;
+		lock.lock();
+		if (s_nCachedPrecision[eConstant] < nTrusted)
+		{
+			s_Cache[eConstant] = value;
+			s_nCachedPrecision[eConstant] = nTrusted;
+		}
+	}
+
+	CBigFloat value(nPrecision);
+	value.set(s_Cache[eConstant], BigRoundingTowardZero);
+	return value;
+}
+
+CBigValue CBigConstants::getDigits(const BigConstant eConstant, const size_t nDigits)
+{
+	// truncated value is less than one unit of last bit below exact one
+	// (cached value is trusted beyond that): take floor of both ends of
+	// wider interval, if they differ a digit boundary is within it
+	// and more bits are needed (Ziv)
+	const size_t nDigitBits = (size_t)((double)nDigits * s_dBitsPerDigit);
+	for (size_t nGuard = s_nDigitGuardBits; ; nGuard *= 2)
+	{
+		const size_t nPrecision = nDigitBits + nGuard;
+		const CBigFloat value = getFloat(eConstant, nPrecision);
+
+		CBigFloat error(1);
+		error.fromUInt64(1);
+		error.ldexp(value.topExponent() - (int64_t)nPrecision + 1);
+		CBigFloat lower(nPrecision + 4);
+		lower.sub(value, error);
+		CBigFloat upper(nPrecision + 4);
+		upper.add(value, error);
+
+		const CBigValue digits = lower.toBigValue(nDigits, BigRoundingTowardZero);
+		if (digits == upper.toBigValue(nDigits, BigRoundingTowardZero))
+		{
+			return digits;
+		}
+	}
+}
+
+void CBigConstants::setThreadCount(const unsigned int nThreads)
+{
+	std::lock_guard<std::mutex> lock(s_PoolLock);
+	s_pPool.reset((nThreads > 0) ? new TaskPool(nThreads) : nullptr);
+}
+
+size_t CBigConstants::getCachedPrecision(const BigConstant eConstant)
+{
+	std::lock_guard<std::mutex> lock(s_CacheLock[eConstant]);
+	return s_nCachedPrecision[eConstant];
+}
+
+void CBigConstants::clearCache()
+{
+	for (int i = 0; i < BigConstantCount; i++)
+	{
+		std::lock_guard<std::mutex> lock(s_CacheLock[i]);
+		s_Cache[i] = CBigFloat();
+		s_nCachedPrecision[i] = 0;
+	}
+}
@@ -0,0 +1,73 @@
+/////////////////////////////////////
+//
+// CBigConstants : mathematical constants
+// to arbitrary precision (pi, e, ln2, sqrt2).
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Series are summed exactly with binary splitting
+// and divided once at the end (Newton iteration, see BigConstants.cpp).
+// Computed values are cached per constant:
+// request for lower precision than already computed
+// is answered by truncating cached value.
+//
+
+#ifndef BIGCONSTANTS_H
+#define BIGCONSTANTS_H
+
+#include "BigValue.h"
+#include "BigFloat.h"
+
+#include <stddef.h>
+
+
+enum BigConstant
+{
+	BigConstantPi = 0,
+	BigConstantE,
+	BigConstantLn2,
+	BigConstantSqrt2,
+
+	BigConstantCount // keep last
+};
+
+
+class CBigConstants
+{
+public:
+	// value truncated to nPrecision bits
+	static CBigFloat getFloat(const BigConstant eConstant, const size_t nPrecision);
+
+	// floor(value * 10^nDigits) with scale nDigits
+	static CBigValue getDigits(const BigConstant eConstant, const size_t nDigits);
+
+	static CBigValue pi(const size_t nDigits)
+	{
+		return getDigits(BigConstantPi, nDigits);
+	}
+	static CBigValue e(const size_t nDigits)
+	{
+		return getDigits(BigConstantE, nDigits);
+	}
+	static CBigValue ln2(const size_t nDigits)
+	{
+		return getDigits(BigConstantLn2, nDigits);
+	}
+	static CBigValue sqrt2(const size_t nDigits)
+	{
+		return getDigits(BigConstantSqrt2, nDigits);
+	}
+
+	// threads for binary splitting and multiplications: own pool
+	// of that many threads, zero for current pool (default)
+	static void setThreadCount(const unsigned int nThreads);
+
+	// precision (bits) available without recomputing
+	static size_t getCachedPrecision(const BigConstant eConstant);
+
+	static void clearCache();
+};
+
+#endif // BIGCONSTANTS_H
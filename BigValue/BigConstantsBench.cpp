@@ -0,0 +1,57 @@
+// BigConstantsBench.cpp : digits per second of constants
+// against thread count.
+//
+// usage: BigConstantsBench [digits]
+//
+
+#include "BigConstants.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+
+
+static const char *s_szName[BigConstantCount] = {"pi", "e", "ln2", "sqrt2"};
+
+int main(int argc, char* argv[])
+{
+	size_t nDigits = 100000;
+	if (argc > 1)
+	{
+		nDigits = (size_t)strtoull(argv[1], nullptr, 10);
+	}
+
+	unsigned int nMaxThreads = std::thread::hardware_concurrency();
+	if (nMaxThreads == 0)
+	{
+		nMaxThreads = 1;
+	}
+
+	printf("%zu digits, %u hardware threads\n", nDigits, nMaxThreads);
+	printf("%-8s %8s %12s %14s\n", "constant", "threads", "seconds", "digits/sec");
+	for (int i = 0; i < BigConstantCount; i++)
+	{
+		for (unsigned int nThreads = 1; nThreads <= nMaxThreads; nThreads *= 2)
+		{
+			// nothing cached between runs
+			CBigConstants::clearCache();
+			CBigConstants::setThreadCount(nThreads);
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			CBigValue value = CBigConstants::getDigits((BigConstant)i, nDigits);
+			double dSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			printf("%-8s %8u %12.3f %14.0f\n", s_szName[i], nThreads, dSeconds, (double)nDigits / dSeconds);
+		}
+
+		// from cache: truncation only
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		CBigValue value = CBigConstants::getDigits((BigConstant)i, nDigits / 2);
+		double dSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		printf("%-8s %8s %12.3f %14.0f\n", s_szName[i], "cached", dSeconds, (double)(nDigits / 2) / dSeconds);
+	}
+
+	CBigConstants::setThreadCount(0);
+	return 0;
+}
@@ -0,0 +1,278 @@
+/////////////////////////////////////
+//
+// CBigValue : exact conversion of double
+// to fixed decimal scale.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Double is m * 2^e exactly, so value at scale s is
+// m * 10^s * 2^e rounded to integer: multiply by power of ten
+// and shift with rounding, no decimal digits are generated.
+//
+// For scales upto 19 power of ten is single limb
+// and product m * 10^s fits in 128 bits (m has 53 bits):
+// one 64x64 multiply by table power and a shift.
+// Larger scales or exponents fall back to limb arrays.
+//
+
+#include "BigValue.h"
+#include "BigLimb.h"
+
+#include <string.h>
+#include <vector>
+
+
+typedef std::vector<uint64_t> LimbVector;
+
+
+////////// local helpers
+
+// split into integer mantissa and binary exponent,
+// false for infinity/NaN
+static inline bool decomposeDouble(const double value, uint64_t &mantissa, int &nExponent, bool &bNegative)
+{
+	uint64_t bits = 0;
+	::memcpy(&bits, &value, sizeof(bits));
+	bNegative = ((bits >> 63) != 0);
+
+	const int nBiased = (int)((bits >> 52) & 0x7FF);
+	const uint64_t fraction = bits & ((1ULL << 52) - 1);
+	if (nBiased == 0x7FF)
+	{
+		return false;
+	}
+	if (nBiased == 0)
+	{
+		// subnormal (or zero)
+		mantissa = fraction;
+		nExponent = -1074;
+	}
+	else
+	{
+		mantissa = fraction | (1ULL << 52);
+		nExponent = nBiased - 1075;
+	}
+	return true;
+}
+
+// if magnitude should be incremented after truncation
+static inline bool roundIncrement(const bool bOdd, const bool bRound, const bool bSticky, const bool bNegative, const BigRounding eRounding)
+{
+	switch (eRounding)
+	{
+	case BigRoundingNearestEven:
+		return bRound && (bSticky || bOdd);
+	case BigRoundingNearestAway:
+		return bRound;
+	case BigRoundingTowardZero:
+		return false;
+	case BigRoundingUp:
+		return (bNegative == false) && (bRound || bSticky);
+	case BigRoundingDown:
+		return (bNegative == true) && (bRound || bSticky);
+	}
+	return false;
+}
+
+// fast path: mantissa * 10^scale * 2^exponent rounded in 128 bits,
+// false if scale or result is too large for it
+static bool scaleDouble128(const uint64_t mantissa, const int nExponent, const size_t nScale, const BigRounding eRounding, const bool bNegative, uint64_t &nLow, uint64_t &nHigh)
+{
+	if (nScale > 19)
+	{
+		return false;
+	}
+
+	uint64_t product[2] = {0, 0};
+	product[0] = limbMul64(mantissa, limbPow10((unsigned int)nScale), &product[1]);
+	uint64_t low = product[0];
+	uint64_t high = product[1];
+
+	if (nExponent >= 0)
+	{
+		if (mantissa != 0 && limbBitLengthN(product, 2) + (size_t)nExponent > 128)
+		{
+			return false;
+		}
+		if (nExponent >= 64)
+		{
+			high = low << (nExponent - 64);
+			low = 0;
+		}
+		else if (nExponent > 0)
+		{
+			high = (high << nExponent) | (low >> (64 - nExponent));
+			low <<= nExponent;
+		}
+		nLow = low;
+		nHigh = high;
+		return true;
+	}
+
+	// product is below 2^117, shift is at least one
+	const int nShift = -nExponent;
+	const bool bRound = limbTestBitN(product, 2, (size_t)nShift - 1);
+	const bool bSticky = limbAnyBitsN(product, 2, (size_t)nShift - 1);
+	if (nShift >= 128)
+	{
+		low = 0;
+		high = 0;
+	}
+	else if (nShift >= 64)
+	{
+		low = high >> (nShift - 64);
+		high = 0;
+	}
+	else
+	{
+		low = (low >> nShift) | (high << (64 - nShift));
+		high >>= nShift;
+	}
+
+	if (roundIncrement((low & 1) != 0, bRound, bSticky, bNegative, eRounding) == true)
+	{
+		low++;
+		high += (low == 0) ? 1 : 0;
+	}
+	nLow = low;
+	nHigh = high;
+	return true;
+}
+
+// any scale and exponent using limb arrays
+static void scaleDoubleN(const uint64_t mantissa, const int nExponent, const size_t nScale, const BigRounding eRounding, const bool bNegative, LimbVector &magnitude)
+{
+	magnitude.assign(1, mantissa);
+	size_t nRemaining = nScale;
+	while (nRemaining > 0)
+	{
+		const unsigned int nStep = (nRemaining > 19) ? 19 : (unsigned int)nRemaining;
+		uint64_t carry = limbMul1(&magnitude[0], &magnitude[0], magnitude.size(), limbPow10(nStep));
+		if (carry != 0)
+		{
+			magnitude.push_back(carry);
+		}
+		nRemaining -= nStep;
+	}
+
+	if (nExponent >= 0)
+	{
+		const size_t nSize = magnitude.size() + ((size_t)nExponent + 63) / 64;
+		LimbVector shifted(nSize, 0);
+		limbShiftLeft((uint8_t*)&shifted[0], nSize * 8, (const uint8_t*)&magnitude[0], magnitude.size() * 8, (size_t)nExponent);
+		magnitude.swap(shifted);
+		return;
+	}
+
+	const size_t nShift = (size_t)(-nExponent);
+	const bool bRound = limbTestBitN(&magnitude[0], magnitude.size(), nShift - 1);
+	const bool bSticky = limbAnyBitsN(&magnitude[0], magnitude.size(), nShift - 1);
+	limbShiftRight((uint8_t*)&magnitude[0], magnitude.size() * 8, (const uint8_t*)&magnitude[0], magnitude.size() * 8, nShift);
+
+	if (roundIncrement((magnitude[0] & 1) != 0, bRound, bSticky, bNegative, eRounding) == true)
+	{
+		// shifted value has free high bits: no carry out
+		const uint64_t one = 1;
+		limbAddN(&magnitude[0], &magnitude[0], magnitude.size(), &one, 1);
+	}
+}
+
+// magnitude as nWidth-byte two's complement,
+// false if out of range (destination is not written)
+static bool writeTwosComplement(const uint64_t *pLimbs, const size_t nLimbs, const bool bNegative, uint8_t *pDst, const size_t nWidth)
+{
+	const size_t nBits = limbBitLengthN(pLimbs, nLimbs);
+	const size_t nMaxBits = nWidth * 8 - 1;
+	if (nBits > nMaxBits)
+	{
+		// only -2^(8*width-1) fits with more bits
+		if (bNegative == false || nBits != nMaxBits + 1 || limbTrailingZerosN(pLimbs, nLimbs) != nMaxBits)
+		{
+			return false;
+		}
+	}
+
+	const uint8_t *pBytes = (const uint8_t*)pLimbs;
+	const size_t nBytes = nLimbs * 8;
+	unsigned int carry = 1;
+	for (size_t i = 0; i < nWidth; i++)
+	{
+		const uint8_t byte = (i < nBytes) ? pBytes[i] : 0;
+		if (bNegative == true)
+		{
+			carry += (uint8_t)~byte;
+			pDst[i] = (uint8_t)(carry & 0xFF);
+			carry >>= 8;
+		}
+		else
+		{
+			pDst[i] = byte;
+		}
+	}
+	return true;
+}
+
+
+////////// public methods
+
+CBigValue& CBigValue::fromDouble(const double value, const size_t nScale, const BigRounding eRounding)
+{
+	uint64_t mantissa = 0;
+	int nExponent = 0;
+	bool bNegative = false;
+	if (decomposeDouble(value, mantissa, nExponent, bNegative) == false)
+	{
+		// no representation for infinity/NaN: zero
+		return fromLimbs(nullptr, 0, bNegative, nScale);
+	}
+
+	uint64_t limbs[2] = {0, 0};
+	if (scaleDouble128(mantissa, nExponent, nScale, eRounding, bNegative, limbs[0], limbs[1]) == true)
+	{
+		return fromLimbs(limbs, 2, bNegative, nScale);
+	}
+
+	LimbVector magnitude;
+	scaleDoubleN(mantissa, nExponent, nScale, eRounding, bNegative, magnitude);
+	return fromLimbs(&magnitude[0], magnitude.size(), bNegative, nScale);
+}
+
+size_t CBigValue::fromDoubleColumn(const double *pValues, const size_t nCount, const size_t nScale, const BigRounding eRounding, uint8_t *pColumn, const size_t nWidth, bool *pValid)
+{
+	size_t nInvalid = 0;
+	LimbVector magnitude;
+	for (size_t i = 0; i < nCount; i++)
+	{
+		uint8_t *pDst = pColumn + i * nWidth;
+		uint64_t mantissa = 0;
+		int nExponent = 0;
+		bool bNegative = false;
+		bool bFits = false;
+		if (decomposeDouble(pValues[i], mantissa, nExponent, bNegative) == true)
+		{
+			uint64_t limbs[2] = {0, 0};
+			if (scaleDouble128(mantissa, nExponent, nScale, eRounding, bNegative, limbs[0], limbs[1]) == true)
+			{
+				bFits = writeTwosComplement(limbs, 2, bNegative, pDst, nWidth);
+			}
+			else
+			{
+				scaleDoubleN(mantissa, nExponent, nScale, eRounding, bNegative, magnitude);
+				bFits = writeTwosComplement(&magnitude[0], magnitude.size(), bNegative, pDst, nWidth);
+			}
+		}
+
+		if (bFits == false)
+		{
+			::memset(pDst, 0, nWidth);
+			nInvalid++;
+		}
+		if (pValid != nullptr)
+		{
+			pValid[i] = bFits;
+		}
+	}
+	return nInvalid;
+}
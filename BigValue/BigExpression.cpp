@@ -0,0 +1,355 @@
+/////////////////////////////////////
+//
+// CBigValue : sums of many values and
+// multiply-accumulate without temporaries.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Two longer terms of same sign are added by limb kernel (limbAddN).
+// Other signed sums go column by column: every term adds (or subtracts)
+// its limb to a two-word column accumulator and low word is
+// the result limb, high word (at most term count in magnitude)
+// carries to next column. Negative total is left as
+// two's complement in the last limb and negated at the end.
+// Terms with smaller scale are rescaled to largest one
+// in per-thread scratch first (exact, no digits are lost).
+// Scratch is per nesting level on thread (TaskLocal): product
+// kernel may fork and run other tasks entering here meanwhile.
+//
+// Multiply-accumulate adds rows of x * y directly
+// to accumulator limbs (addmul kernel) instead of
+// building the product first, large operands use
+// the product kernel (Karatsuba) and single addition.
+//
+
+#include "BigValue.h"
+#include "BigLimb.h"
+#include "../simplesse/TaskPool.h"
+
+#include <string.h>
+#include <vector>
+
+
+typedef std::vector<uint64_t> LimbVector;
+
+// smaller operand from this many limbs:
+// product kernel and addition instead of addmul rows
+// (same as Karatsuba threshold in BigLimb.cpp)
+static const size_t s_nAddMulLimit = 32;
+
+// longer term from this many limbs: two-term sum by limb kernel
+// (copying terms to limbs costs more than column sums on short ones)
+static const size_t s_nLimbSumLimit = 8;
+
+
+////////// local helpers
+
+// limb of little-endian byte buffer, zero beyond size
+static inline uint64_t loadLimb(const uint8_t *pData, const size_t nSize, const size_t nIndex)
+{
+	const size_t nOffset = nIndex * sizeof(uint64_t);
+	uint64_t limb = 0;
+	if (nOffset + sizeof(uint64_t) <= nSize)
+	{
+		::memcpy(&limb, pData + nOffset, sizeof(uint64_t));
+	}
+	else if (nOffset < nSize)
+	{
+		::memcpy(&limb, pData + nOffset, nSize - nOffset);
+	}
+	return limb;
+}
+
+// limbs *= 10^n, grows vector as needed
+static void mulPow10(LimbVector &limbs, size_t n)
+{
+	size_t nUsed = limbNormN(limbs.empty() ? nullptr : &limbs[0], limbs.size());
+	limbs.resize(nUsed);
+	if (nUsed == 0)
+	{
+		return;
+	}
+	while (n > 0)
+	{
+		const size_t nStep = (n > 19) ? 19 : n;
+		const uint64_t high = limbMul1(&limbs[0], &limbs[0], limbs.size(), limbPow10((unsigned int)nStep));
+		if (high != 0)
+		{
+			limbs.push_back(high);
+		}
+		n -= nStep;
+	}
+}
+
+// two's complement negation in place
+static void negateLimbs(uint64_t *pLimbs, const size_t nCount)
+{
+	uint64_t carry = 1;
+	for (size_t i = 0; i < nCount; i++)
+	{
+		pLimbs[i] = ~pLimbs[i] + carry;
+		carry = (carry != 0 && pLimbs[i] == 0) ? 1 : 0;
+	}
+}
+
+// term of sum: magnitude bytes and sign
+struct BigSumTerm
+{
+	const uint8_t *m_pData;
+	size_t m_nSize;
+	size_t m_nRescaled; // offset in scratch (or npos)
+	bool m_bNegative;
+};
+
+// scratch of one sum
+struct SumScratch
+{
+	std::vector<BigSumTerm> m_Terms;
+	LimbVector m_Rescaled;
+	LimbVector m_Limbs;
+	LimbVector m_Sum;
+};
+
+// scratch of one multiply-accumulate
+struct MulScratch
+{
+	LimbVector m_Acc;
+	LimbVector m_A;
+	LimbVector m_B;
+	LimbVector m_Product;
+};
+
+// magnitude of term as limbs, zero-extended to nCount limbs
+static void loadTermLimbs(const BigSumTerm &term, LimbVector &limbs, const size_t nCount)
+{
+	limbs.assign(nCount, 0);
+	if (term.m_nSize > 0)
+	{
+		::memcpy(&limbs[0], term.m_pData, term.m_nSize);
+	}
+}
+
+
+////////// protected methods
+
+CBigValue& CBigValue::mulAccumulate(const CBigValue &x, const CBigValue &y, const bool bSubtract)
+{
+	if (&x == this || &y == this)
+	{
+		// operand would change while accumulating
+		const CBigValue copyX(x);
+		const CBigValue copyY(y);
+		return mulAccumulate(copyX, copyY, bSubtract);
+	}
+
+	const TaskLocal<MulScratch> scratch;
+	LimbVector &acc = scratch.get().m_Acc;
+	LimbVector &a = scratch.get().m_A;
+	LimbVector &b = scratch.get().m_B;
+	LimbVector &product = scratch.get().m_Product;
+
+	// result scale as with separate operators:
+	// product has sum of scales, larger scale of that and this
+	const size_t nProductScale = x.m_nScale + y.m_nScale;
+	const size_t nScale = (m_nScale > nProductScale) ? m_nScale : nProductScale;
+
+	getLimbs(acc);
+	x.getLimbs(a);
+	y.getLimbs(b);
+	if (nScale > m_nScale)
+	{
+		mulPow10(acc, nScale - m_nScale);
+	}
+	if (nScale > nProductScale)
+	{
+		// rescale the product through one factor
+		mulPow10(a, nScale - nProductScale);
+	}
+
+	bool bNegative = m_bNegative;
+	if (a.empty() == false && b.empty() == false)
+	{
+		const bool bProductNegative = ((x.m_bNegative != y.m_bNegative) != bSubtract);
+		if (acc.empty() == true)
+		{
+			bNegative = bProductNegative;
+		}
+		const bool bAdd = (bNegative == bProductNegative);
+
+		// room for product and carry out of it
+		const size_t nA = a.size();
+		const size_t nB = b.size();
+		const size_t nOut = ((acc.size() > nA + nB) ? acc.size() : nA + nB) + 1;
+		acc.resize(nOut, 0);
+
+		// subtraction is modulo size of accumulator:
+		// borrow out of top limb (only once) means product was larger
+		uint64_t borrow = 0;
+		if (nA >= s_nAddMulLimit && nB >= s_nAddMulLimit)
+		{
+			product.resize(nA + nB);
+			limbMulN(&product[0], &a[0], nA, &b[0], nB);
+			if (bAdd == true)
+			{
+				limbAddN(&acc[0], &acc[0], nOut, &product[0], nA + nB);
+			}
+			else
+			{
+				borrow = limbSubN(&acc[0], &acc[0], nOut, &product[0], nA + nB);
+			}
+		}
+		else
+		{
+			// shorter one as multiplier words: fewer rows
+			const LimbVector &row = (nA >= nB) ? a : b;
+			const LimbVector &words = (nA >= nB) ? b : a;
+			const size_t nRow = row.size();
+			for (size_t j = 0; j < words.size(); j++)
+			{
+				uint64_t *pDst = &acc[j];
+				if (bAdd == true)
+				{
+					const uint64_t high = limbAddMul1(pDst, &row[0], nRow, words[j]);
+					limbAddN(pDst + nRow, pDst + nRow, nOut - j - nRow, &high, 1);
+				}
+				else
+				{
+					const uint64_t high = limbSubMul1(pDst, &row[0], nRow, words[j]);
+					borrow |= limbSubN(pDst + nRow, pDst + nRow, nOut - j - nRow, &high, 1);
+				}
+			}
+		}
+
+		if (borrow != 0)
+		{
+			// sign changes
+			negateLimbs(&acc[0], nOut);
+			bNegative = !bNegative;
+		}
+	}
+
+	const size_t nUsed = limbNormN(acc.empty() ? nullptr : &acc[0], acc.size());
+	return fromLimbs(acc.empty() ? nullptr : &acc[0], nUsed, (nUsed > 0) ? bNegative : false, nScale);
+}
+
+
+////////// public methods
+
+CBigValue& CBigValue::fromSum(const CBigValue * const *ppTerms, const bool *pNegate, const size_t nCount)
+{
+	const TaskLocal<SumScratch> scratch;
+	std::vector<BigSumTerm> &terms = scratch.get().m_Terms;
+	LimbVector &rescaled = scratch.get().m_Rescaled;
+	LimbVector &limbs = scratch.get().m_Limbs;
+	LimbVector &sum = scratch.get().m_Sum;
+	const size_t npos = (size_t)-1;
+
+	size_t nScale = 0;
+	for (size_t i = 0; i < nCount; i++)
+	{
+		if (ppTerms[i]->m_nScale > nScale)
+		{
+			nScale = ppTerms[i]->m_nScale;
+		}
+	}
+
+	// magnitudes at result scale:
+	// rescaled ones are collected to scratch first
+	// (which may move while growing)
+	terms.resize(nCount);
+	rescaled.clear();
+	size_t nLimbs = 0;
+	for (size_t i = 0; i < nCount; i++)
+	{
+		const CBigValue *pTerm = ppTerms[i];
+		BigSumTerm &term = terms[i];
+		term.m_bNegative = (pTerm->m_bNegative != (pNegate != nullptr && pNegate[i] == true));
+		term.m_pData = pTerm->m_pBuffer;
+		term.m_nSize = pTerm->usedSize();
+		term.m_nRescaled = npos;
+		if (term.m_nSize > 0 && pTerm->m_nScale < nScale)
+		{
+			pTerm->getLimbs(limbs);
+			mulPow10(limbs, nScale - pTerm->m_nScale);
+			term.m_nRescaled = rescaled.size();
+			term.m_nSize = limbs.size() * sizeof(uint64_t);
+			rescaled.insert(rescaled.end(), limbs.begin(), limbs.end());
+		}
+
+		const size_t nTermLimbs = (term.m_nSize + 7) / 8;
+		if (nTermLimbs > nLimbs)
+		{
+			nLimbs = nTermLimbs;
+		}
+	}
+	for (size_t i = 0; i < nCount; i++)
+	{
+		if (terms[i].m_nRescaled != npos)
+		{
+			terms[i].m_pData = (const uint8_t*)&rescaled[terms[i].m_nRescaled];
+		}
+	}
+
+	// two terms of same sign: magnitudes added by limb kernel
+	// (carries resolved per vector of limbs) instead of by columns
+	if (nCount == 2 && terms[0].m_bNegative == terms[1].m_bNegative && nLimbs >= s_nLimbSumLimit)
+	{
+		const BigSumTerm &longer = (terms[0].m_nSize >= terms[1].m_nSize) ? terms[0] : terms[1];
+		const BigSumTerm &shorter = (terms[0].m_nSize >= terms[1].m_nSize) ? terms[1] : terms[0];
+		const size_t nShorter = (shorter.m_nSize + 7) / 8;
+		loadTermLimbs(longer, sum, nLimbs + 1);
+		loadTermLimbs(shorter, limbs, nShorter);
+		sum[nLimbs] = limbAddN(&sum[0], &sum[0], nLimbs, limbs.empty() ? nullptr : &limbs[0], nShorter);
+
+		const size_t nUsed = limbNormN(&sum[0], sum.size());
+		return fromLimbs(&sum[0], nUsed, (nUsed > 0) ? longer.m_bNegative : false, nScale);
+	}
+
+	// column sums: (high:low) is signed two-word accumulator,
+	// last limb keeps final carry (sign of total)
+	sum.resize(nLimbs + 1);
+	int64_t carry = 0;
+	for (size_t i = 0; i < nLimbs; i++)
+	{
+		uint64_t low = (uint64_t)carry;
+		int64_t high = (carry < 0) ? -1 : 0;
+		for (size_t t = 0; t < nCount; t++)
+		{
+			const uint64_t limb = loadLimb(terms[t].m_pData, terms[t].m_nSize, i);
+			if (terms[t].m_bNegative == true)
+			{
+				high -= (low < limb) ? 1 : 0;
+				low -= limb;
+			}
+			else
+			{
+				low += limb;
+				high += (low < limb) ? 1 : 0;
+			}
+		}
+		sum[i] = low;
+		carry = high;
+	}
+	sum[nLimbs] = (uint64_t)carry;
+
+	const bool bNegative = (carry < 0);
+	if (bNegative == true)
+	{
+		negateLimbs(&sum[0], sum.size());
+	}
+
+	// note: may replace buffer of a term, all are read already
+	return fromLimbs(&sum[0], sum.size(), bNegative, nScale);
+}
+
+CBigValue& CBigValue::addMul(const CBigValue &x, const CBigValue &y)
+{
+	return mulAccumulate(x, y, false);
+}
+
+CBigValue& CBigValue::subMul(const CBigValue &x, const CBigValue &y)
+{
+	return mulAccumulate(x, y, true);
+}
@@ -0,0 +1,293 @@
+/////////////////////////////////////
+//
+// CBigExpr : lazy sum and product expressions of CBigValue.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Operators of CBigValue are eager: a + b + c - d builds
+// a new value for every intermediate result.
+// Expression started with bigExpr() instead keeps only references
+// to operands in its type, and assignment evaluates
+// whole sum in single pass (CBigValue::fromSum()),
+// products x * y are added to result with fused
+// multiply-accumulate (CBigValue::addMul()):
+//
+//   result = bigExpr(a) + b + c - d;
+//   acc += bigExpr(x) * y;
+//
+// Result is exactly same as with eager operators
+// (value, scale and sign).
+// Expression must not outlive its operands:
+// do not keep it in "auto" variable beyond the statement.
+//
+
+#ifndef BIGEXPRESSION_H
+#define BIGEXPRESSION_H
+
+#include "BigValue.h"
+
+#include <stddef.h>
+
+
+// base of expressions (static polymorphism)
+template <class E> class CBigExpr
+{
+public:
+	const E& self() const
+	{
+		return static_cast<const E&>(*this);
+	}
+
+	// evaluate to new value
+	CBigValue eval() const
+	{
+		CBigValue value;
+		value = *this;
+		return value;
+	}
+};
+
+// operands of expression flattened to arrays,
+// sizes are known from type of expression
+template <size_t nTermSize, size_t nProductSize> class CBigExprTerms
+{
+public:
+	const CBigValue *m_pTerms[nTermSize + 1];
+	bool m_bNegate[nTermSize + 1];
+	size_t m_nTerms;
+
+	const CBigValue *m_pFactors[2 * nProductSize + 2];
+	bool m_bProductNegate[nProductSize + 1];
+	size_t m_nProducts;
+
+	CBigExprTerms()
+		: m_nTerms(0)
+		, m_nProducts(0)
+	{}
+
+	void addTerm(const CBigValue *pValue, const bool bNegate)
+	{
+		m_pTerms[m_nTerms] = pValue;
+		m_bNegate[m_nTerms] = bNegate;
+		m_nTerms++;
+	}
+	void addProduct(const CBigValue *pX, const CBigValue *pY, const bool bNegate)
+	{
+		m_pFactors[2 * m_nProducts] = pX;
+		m_pFactors[2 * m_nProducts + 1] = pY;
+		m_bProductNegate[m_nProducts] = bNegate;
+		m_nProducts++;
+	}
+
+	// true if some product uses given value
+	bool hasFactor(const CBigValue *pValue) const
+	{
+		for (size_t i = 0; i < 2 * m_nProducts; i++)
+		{
+			if (m_pFactors[i] == pValue)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+};
+
+// single value
+class CBigTermExpr : public CBigExpr<CBigTermExpr>
+{
+protected:
+	const CBigValue &m_Value;
+
+public:
+	static const size_t TermCount = 1;
+	static const size_t ProductCount = 0;
+
+	explicit CBigTermExpr(const CBigValue &value)
+		: m_Value(value)
+	{}
+
+	const CBigValue& value() const
+	{
+		return m_Value;
+	}
+
+	template <class T> void collect(T &terms, const bool bNegate) const
+	{
+		terms.addTerm(&m_Value, bNegate);
+	}
+};
+
+// product of two values
+class CBigProductExpr : public CBigExpr<CBigProductExpr>
+{
+protected:
+	const CBigValue &m_X;
+	const CBigValue &m_Y;
+
+public:
+	static const size_t TermCount = 0;
+	static const size_t ProductCount = 1;
+
+	CBigProductExpr(const CBigValue &x, const CBigValue &y)
+		: m_X(x)
+		, m_Y(y)
+	{}
+
+	template <class T> void collect(T &terms, const bool bNegate) const
+	{
+		terms.addProduct(&m_X, &m_Y, bNegate);
+	}
+};
+
+// left + right, or left - right when bSubtract:
+// subexpressions are kept by value (they are temporaries)
+template <class L, class R, bool bSubtract> class CBigSumExpr : public CBigExpr<CBigSumExpr<L, R, bSubtract> >
+{
+protected:
+	const L m_Left;
+	const R m_Right;
+
+public:
+	static const size_t TermCount = L::TermCount + R::TermCount;
+	static const size_t ProductCount = L::ProductCount + R::ProductCount;
+
+	CBigSumExpr(const L &left, const R &right)
+		: m_Left(left)
+		, m_Right(right)
+	{}
+
+	template <class T> void collect(T &terms, const bool bNegate) const
+	{
+		m_Left.collect(terms, bNegate);
+		m_Right.collect(terms, (bNegate != bSubtract));
+	}
+};
+
+
+// start of lazy expression
+inline CBigTermExpr bigExpr(const CBigValue &value)
+{
+	return CBigTermExpr(value);
+}
+
+// destination (+)= expression (or -= when bNegate):
+// sum in one pass then products accumulated
+template <class E> void bigEvaluate(CBigValue &dst, const E &expr, const bool bAccumulate, const bool bNegate)
+{
+	CBigExprTerms<E::TermCount + 1, E::ProductCount> terms;
+	if (bAccumulate == true)
+	{
+		terms.addTerm(&dst, false);
+	}
+	expr.collect(terms, bNegate);
+
+	if (terms.m_nProducts > 0 && terms.hasFactor(&dst) == true)
+	{
+		// sum would replace a factor before product is added
+		CBigValue value;
+		if (bAccumulate == true)
+		{
+			value = dst;
+		}
+		bigEvaluate(value, expr, bAccumulate, bNegate);
+		dst = value;
+		return;
+	}
+
+	if (terms.m_nTerms == 0)
+	{
+		// only products: start from zero
+		dst.fromLimbs(nullptr, 0, false, 0);
+	}
+	else if (terms.m_nTerms > 1 || terms.m_pTerms[0] != &dst || terms.m_bNegate[0] == true)
+	{
+		dst.fromSum(terms.m_pTerms, terms.m_bNegate, terms.m_nTerms);
+	}
+
+	for (size_t i = 0; i < terms.m_nProducts; i++)
+	{
+		if (terms.m_bProductNegate[i] == true)
+		{
+			dst.subMul(*terms.m_pFactors[2 * i], *terms.m_pFactors[2 * i + 1]);
+		}
+		else
+		{
+			dst.addMul(*terms.m_pFactors[2 * i], *terms.m_pFactors[2 * i + 1]);
+		}
+	}
+}
+
+
+////////// operators building expressions
+
+template <class L, class R> inline CBigSumExpr<L, R, false> operator + (const CBigExpr<L> &left, const CBigExpr<R> &right)
+{
+	return CBigSumExpr<L, R, false>(left.self(), right.self());
+}
+template <class L> inline CBigSumExpr<L, CBigTermExpr, false> operator + (const CBigExpr<L> &left, const CBigValue &right)
+{
+	return CBigSumExpr<L, CBigTermExpr, false>(left.self(), CBigTermExpr(right));
+}
+template <class R> inline CBigSumExpr<CBigTermExpr, R, false> operator + (const CBigValue &left, const CBigExpr<R> &right)
+{
+	return CBigSumExpr<CBigTermExpr, R, false>(CBigTermExpr(left), right.self());
+}
+
+template <class L, class R> inline CBigSumExpr<L, R, true> operator - (const CBigExpr<L> &left, const CBigExpr<R> &right)
+{
+	return CBigSumExpr<L, R, true>(left.self(), right.self());
+}
+template <class L> inline CBigSumExpr<L, CBigTermExpr, true> operator - (const CBigExpr<L> &left, const CBigValue &right)
+{
+	return CBigSumExpr<L, CBigTermExpr, true>(left.self(), CBigTermExpr(right));
+}
+template <class R> inline CBigSumExpr<CBigTermExpr, R, true> operator - (const CBigValue &left, const CBigExpr<R> &right)
+{
+	return CBigSumExpr<CBigTermExpr, R, true>(CBigTermExpr(left), right.self());
+}
+
+// products of single values only
+// (product of sums would need the sum anyway)
+inline CBigProductExpr operator * (const CBigTermExpr &x, const CBigValue &y)
+{
+	return CBigProductExpr(x.value(), y);
+}
+inline CBigProductExpr operator * (const CBigTermExpr &x, const CBigTermExpr &y)
+{
+	return CBigProductExpr(x.value(), y.value());
+}
+
+
+////////// CBigValue members taking expressions
+
+template <class E> CBigValue::CBigValue(const CBigExpr<E> &expr)
+	: m_pBuffer(nullptr)
+	, m_nBufferSize(0)
+	, m_nScale(0)
+	, m_bNegative(false)
+{
+	bigEvaluate(*this, expr.self(), false, false);
+}
+
+template <class E> CBigValue& CBigValue::operator = (const CBigExpr<E> &expr)
+{
+	bigEvaluate(*this, expr.self(), false, false);
+	return *this;
+}
+
+template <class E> CBigValue& CBigValue::operator += (const CBigExpr<E> &expr)
+{
+	bigEvaluate(*this, expr.self(), true, false);
+	return *this;
+}
+
+template <class E> CBigValue& CBigValue::operator -= (const CBigExpr<E> &expr)
+{
+	bigEvaluate(*this, expr.self(), true, true);
+	return *this;
+}
+
+#endif // BIGEXPRESSION_H
@@ -0,0 +1,294 @@
+/////////////////////////////////////
+//
+// CBigValue : combinatorial functions
+// (factorial, binomial, primorial).
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Repeated multiplication by small values is quadratic
+// and always multiplies huge value by tiny one.
+// Instead results are collected as prime-factors
+// and multiplied together with balanced product tree
+// so that expensive multiplications have equal-sized operands.
+//
+// Factorial uses prime-swing (Luschny):
+// n! = ((n/2)!)^2 * swing(n), where swing(n) = n! / ((n/2)!)^2
+// has exponent sum(floor(n/p^i)) mod 2 for each prime p.
+// Powers of two are left out and shifted in at the end:
+// n! has n - popcount(n) factors of two.
+//
+// Independent halves of large product trees are
+// multiplied in parallel as tasks of current pool (TaskPool.h).
+//
+
+#include "BigValue.h"
+#include "BigLimb.h"
+#include "../simplesse/TaskPool.h"
+
+#include <vector>
+
+
+typedef std::vector<uint64_t> LimbVector;
+
+// below this count of factors product is done sequentially
+static const size_t s_nTreeLeafCount = 16;
+
+// below this count of factors subtree is not worth a task
+static const size_t s_nParallelMinCount = 2048;
+
+
+////////// local helpers
+
+// odd-only sieve of primes upto and including n
+static void sievePrimes(const uint64_t n, std::vector<uint64_t> &primes)
+{
+	primes.clear();
+	if (n < 2)
+	{
+		return;
+	}
+	primes.push_back(2);
+
+	// index i is odd number 2*i+1
+	const size_t nCount = (size_t)((n - 1) / 2) + 1;
+	std::vector<uint8_t> composite(nCount, 0);
+	for (size_t i = 1; i < nCount; i++)
+	{
+		if (composite[i] != 0)
+		{
+			continue;
+		}
+
+		uint64_t p = 2 * i + 1;
+		primes.push_back(p);
+
+		// mark odd multiples starting from p^2
+		for (uint64_t m = (p * p - 1) / 2; m < nCount; m += p)
+		{
+			composite[(size_t)m] = 1;
+		}
+	}
+}
+
+// multiply factors together while product fits in single limb:
+// fewer and evenly sized leaves for product tree
+static void packFactors(const std::vector<uint64_t> &factors, std::vector<uint64_t> &words)
+{
+	words.clear();
+	uint64_t word = 1;
+	for (size_t i = 0; i < factors.size(); i++)
+	{
+		uint64_t high = 0;
+		uint64_t product = limbMul64(word, factors[i], &high);
+		if (high != 0)
+		{
+			words.push_back(word);
+			product = factors[i];
+		}
+		word = product;
+	}
+	if (word != 1 || words.empty())
+	{
+		words.push_back(word);
+	}
+}
+
+// product of word-sized factors as balanced binary tree
+static void productTree(const uint64_t *pWords, const size_t nCount, LimbVector &result)
+{
+	if (nCount <= s_nTreeLeafCount)
+	{
+		result.assign(1, pWords[0]);
+		for (size_t i = 1; i < nCount; i++)
+		{
+			uint64_t carry = limbMul1(&result[0], &result[0], result.size(), pWords[i]);
+			if (carry != 0)
+			{
+				result.push_back(carry);
+			}
+		}
+		return;
+	}
+
+	const size_t nHalf = nCount / 2;
+	LimbVector left;
+	LimbVector right;
+	if (nCount >= s_nParallelMinCount)
+	{
+		parallelInvoke([&]() { productTree(pWords + nHalf, nCount - nHalf, right); },
+			[&]() { productTree(pWords, nHalf, left); });
+	}
+	else
+	{
+		productTree(pWords, nHalf, left);
+		productTree(pWords + nHalf, nCount - nHalf, right);
+	}
+
+	result.resize(left.size() + right.size());
+	limbMulN(&result[0], &left[0], left.size(), &right[0], right.size());
+	result.resize(limbNormN(&result[0], result.size()));
+}
+
+static void productOfFactors(const std::vector<uint64_t> &factors, LimbVector &result)
+{
+	std::vector<uint64_t> words;
+	packFactors(factors, words);
+	productTree(&words[0], words.size(), result);
+}
+
+// odd part of swing(n): odd primes with exponent
+// sum(floor(n/p^i)) mod 2, each prime-power is <= n
+static void oddSwing(const uint64_t n, const std::vector<uint64_t> &primes, LimbVector &result)
+{
+	std::vector<uint64_t> factors;
+	for (size_t i = 1; i < primes.size() && primes[i] <= n; i++)
+	{
+		const uint64_t p = primes[i];
+		if (p > n / 2)
+		{
+			// exponent is always one
+			factors.push_back(p);
+		}
+		else if (p > n / 3)
+		{
+			// exponent is always zero
+			continue;
+		}
+		else
+		{
+			uint64_t q = n;
+			uint64_t power = 1;
+			while ((q /= p) > 0)
+			{
+				if ((q & 1) != 0)
+				{
+					power *= p;
+				}
+			}
+			if (power > 1)
+			{
+				factors.push_back(power);
+			}
+		}
+	}
+
+	productOfFactors(factors, result);
+}
+
+// odd part of n!
+static void oddFactorial(const uint64_t n, const std::vector<uint64_t> &primes, LimbVector &result)
+{
+	if (n < 3)
+	{
+		result.assign(1, 1);
+		return;
+	}
+
+	LimbVector half;
+	oddFactorial(n / 2, primes, half);
+
+	LimbVector square(2 * half.size());
+	limbMulN(&square[0], &half[0], half.size(), &half[0], half.size());
+	square.resize(limbNormN(&square[0], square.size()));
+
+	LimbVector swing;
+	oddSwing(n, primes, swing);
+
+	result.resize(square.size() + swing.size());
+	limbMulN(&result[0], &square[0], square.size(), &swing[0], swing.size());
+	result.resize(limbNormN(&result[0], result.size()));
+}
+
+static size_t popCountWord(uint64_t value)
+{
+	size_t nCount = 0;
+	while (value != 0)
+	{
+		value &= (value - 1);
+		nCount++;
+	}
+	return nCount;
+}
+
+
+////////// public methods
+
+CBigValue CBigValue::factorial(const uint64_t n)
+{
+	std::vector<uint64_t> primes;
+	sievePrimes(n, primes);
+
+	LimbVector odd;
+	oddFactorial(n, primes, odd);
+
+	CBigValue value;
+	value.fromLimbs(&odd[0], odd.size(), false);
+	value <<= (size_t)(n - popCountWord(n));
+	return value;
+}
+
+// exponent of prime p in C(n, k) by Legendre's formula:
+// sum(floor(n/p^i) - floor(k/p^i) - floor((n-k)/p^i)),
+// prime-power is always <= n (Kummer)
+CBigValue CBigValue::binomial(const uint64_t n, const uint64_t k)
+{
+	CBigValue value;
+	if (k > n)
+	{
+		value.CreateBuffer(1);
+		return value;
+	}
+
+	const uint64_t r = (k > n - k) ? (n - k) : k;
+	std::vector<uint64_t> primes;
+	sievePrimes(n, primes);
+
+	std::vector<uint64_t> factors;
+	for (size_t i = 0; i < primes.size(); i++)
+	{
+		const uint64_t p = primes[i];
+		if (p > n - r)
+		{
+			// in numerator once, never in denominator
+			factors.push_back(p);
+			continue;
+		}
+
+		uint64_t power = 1;
+		uint64_t pn = n, pk = r, pm = n - r;
+		while (pn > 0)
+		{
+			pn /= p;
+			pk /= p;
+			pm /= p;
+			for (uint64_t e = pn - pk - pm; e > 0; e--)
+			{
+				power *= p;
+			}
+		}
+		if (power > 1)
+		{
+			factors.push_back(power);
+		}
+	}
+
+	LimbVector product;
+	productOfFactors(factors, product);
+	value.fromLimbs(&product[0], product.size(), false);
+	return value;
+}
+
+CBigValue CBigValue::primorial(const uint64_t n)
+{
+	std::vector<uint64_t> primes;
+	sievePrimes(n, primes);
+
+	LimbVector product;
+	productOfFactors(primes, product);
+
+	CBigValue value;
+	value.fromLimbs(&product[0], product.size(), false);
+	return value;
+}
@@ -0,0 +1,1413 @@
+/////////////////////////////////////
+//
+// CBigFloat : arbitrary-precision
+// binary floating point.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Rounding works on exact integer magnitude and "sticky" flag
+// (nonzero bits exist below the magnitude): with at least
+// precision+2 bits in magnitude that is enough to round correctly.
+//
+// When operands are truncated to limit work, result is only known
+// to be inside small interval of such magnitudes. Rounding is monotonic,
+// so if both ends of the interval round to same value, that is
+// the correctly rounded result. Otherwise exact computation
+// is done (Ziv's strategy), with 64 guard bits this is very rare.
+//
+
+#include "BigFloat.h"
+#include "BigLimb.h"
+
+#include <math.h>
+#include <string.h>
+#include <limits>
+
+
+typedef std::vector<uint64_t> LimbVector;
+
+
+////////// local helpers
+
+static size_t bitLengthV(const LimbVector &v)
+{
+	if (v.empty())
+	{
+		return 0;
+	}
+	return limbBitLengthN(&v[0], v.size());
+}
+
+static void normalizeV(LimbVector &v)
+{
+	if (v.empty() == false)
+	{
+		v.resize(limbNormN(&v[0], v.size()));
+	}
+}
+
+static void shiftLeftV(LimbVector &v, const size_t nBits)
+{
+	normalizeV(v);
+	if (v.empty() || nBits == 0)
+	{
+		return;
+	}
+
+	size_t nOld = v.size();
+	size_t nNew = (bitLengthV(v) + nBits + 63) / 64;
+	v.resize(nNew, 0);
+	limbShiftLeft((uint8_t*)&v[0], nNew * 8, (const uint8_t*)&v[0], nOld * 8, nBits);
+}
+
+static void shiftRightV(LimbVector &v, const size_t nBits)
+{
+	if (v.empty() || nBits == 0)
+	{
+		return;
+	}
+	if (nBits >= v.size() * 64)
+	{
+		v.clear();
+		return;
+	}
+	limbShiftRight((uint8_t*)&v[0], v.size() * 8, (const uint8_t*)&v[0], v.size() * 8, nBits);
+	normalizeV(v);
+}
+
+static void addV(LimbVector &v, const LimbVector &other)
+{
+	if (other.size() > v.size())
+	{
+		v.resize(other.size(), 0);
+	}
+	if (other.empty())
+	{
+		return;
+	}
+	uint64_t carry = limbAddN(&v[0], &v[0], v.size(), &other[0], other.size());
+	if (carry != 0)
+	{
+		v.push_back(carry);
+	}
+}
+
+static void addOneV(LimbVector &v)
+{
+	const LimbVector one(1, 1);
+	addV(v, one);
+}
+
+// requires v > 0
+static void subOneV(LimbVector &v)
+{
+	const uint64_t one = 1;
+	limbSubN(&v[0], &v[0], v.size(), &one, 1);
+	normalizeV(v);
+}
+
+// requires a >= b
+static void subV(LimbVector &result, const LimbVector &a, const LimbVector &b)
+{
+	result = a;
+	if (b.empty() == false)
+	{
+		limbSubN(&result[0], &result[0], result.size(), &b[0], b.size());
+	}
+	normalizeV(result);
+}
+
+static int compareV(const LimbVector &a, const LimbVector &b)
+{
+	return limbCompareN(a.empty() ? nullptr : &a[0], a.size(), b.empty() ? nullptr : &b[0], b.size());
+}
+
+static void mulV(LimbVector &result, const LimbVector &a, const LimbVector &b)
+{
+	if (a.empty() || b.empty())
+	{
+		result.clear();
+		return;
+	}
+	result.resize(a.size() + b.size());
+	limbMulN(&result[0], &a[0], a.size(), &b[0], b.size());
+	normalizeV(result);
+}
+
+// quotient and remainder, divisor must be nonzero
+static void divModV(const LimbVector &a, const LimbVector &d, LimbVector &quotient, LimbVector &remainder)
+{
+	LimbVector n = a;
+	LimbVector dn = d;
+	normalizeV(n);
+	normalizeV(dn);
+	if (n.size() < dn.size())
+	{
+		quotient.clear();
+		remainder = n;
+		return;
+	}
+	quotient.resize(n.size() - dn.size() + 1);
+	remainder.resize(dn.size());
+	limbDivRemN(&quotient[0], &remainder[0], &n[0], n.size(), &dn[0], dn.size());
+	normalizeV(quotient);
+	normalizeV(remainder);
+}
+
+// 10^n as limbs: squaring for large powers,
+// word-multiplies would be quadratic for millions of digits
+static void powerOfTenV(size_t n, LimbVector &v)
+{
+	if (n > 19 * 64)
+	{
+		LimbVector half;
+		powerOfTenV(n / 2, half);
+		mulV(v, half, half);
+		if ((n & 1) != 0)
+		{
+			uint64_t carry = limbMul1(&v[0], &v[0], v.size(), 10);
+			if (carry != 0)
+			{
+				v.push_back(carry);
+			}
+		}
+		return;
+	}
+
+	v.assign(1, 1);
+	while (n > 0)
+	{
+		unsigned int nStep = (n > 19) ? 19 : (unsigned int)n;
+		uint64_t carry = limbMul1(&v[0], &v[0], v.size(), limbPow10(nStep));
+		if (carry != 0)
+		{
+			v.push_back(carry);
+		}
+		n -= nStep;
+	}
+}
+
+// floor of square root by Newton's iteration from above
+static void isqrtV(const LimbVector &n, LimbVector &root)
+{
+	size_t nBits = bitLengthV(n);
+	if (nBits == 0)
+	{
+		root.clear();
+		return;
+	}
+
+	// 2^ceil(bits/2) is above the root
+	LimbVector x(1, 1);
+	shiftLeftV(x, (nBits + 1) / 2);
+	for (;;)
+	{
+		LimbVector quotient, remainder;
+		divModV(n, x, quotient, remainder);
+		LimbVector y = x;
+		addV(y, quotient);
+		shiftRightV(y, 1);
+		if (compareV(y, x) >= 0)
+		{
+			break;
+		}
+		x.swap(y);
+	}
+	root.swap(x);
+}
+
+// working precisions of Newton iteration from target
+// down to where double is enough, each step doubles correct bits
+static void newtonSteps(const size_t nPrecision, std::vector<size_t> &steps)
+{
+	steps.clear();
+	for (size_t nStep = nPrecision + 16; nStep > 48; nStep = nStep / 2 + 8)
+	{
+		steps.push_back(nStep);
+	}
+}
+
+// magnitude scaled to exponent nLsb:
+// floor(mantissa * 2^(nExponent - nLsb)), bTruncated if bits were lost
+static void alignTo(const LimbVector &mantissa, const int64_t nExponent, const int64_t nLsb, LimbVector &result, bool &bTruncated)
+{
+	result = mantissa;
+	bTruncated = false;
+	if (nExponent >= nLsb)
+	{
+		shiftLeftV(result, (size_t)(nExponent - nLsb));
+	}
+	else
+	{
+		size_t nShift = (size_t)(nLsb - nExponent);
+		bTruncated = (result.empty() == false) && limbAnyBitsN(&result[0], result.size(), nShift);
+		shiftRightV(result, nShift);
+	}
+}
+
+// keep highest nLimit bits: returns count of dropped bits
+static size_t truncateTo(const LimbVector &mantissa, const size_t nLimit, LimbVector &result, bool &bTruncated)
+{
+	result = mantissa;
+	bTruncated = false;
+	size_t nBits = bitLengthV(result);
+	if (nBits <= nLimit)
+	{
+		return 0;
+	}
+	size_t nShift = nBits - nLimit;
+	bTruncated = limbAnyBitsN(&result[0], result.size(), nShift);
+	shiftRightV(result, nShift);
+	return nShift;
+}
+
+// round magnitude * 2^nExponent to multiple of 2^nLsb:
+// nExponent is updated to nLsb when bits are dropped
+static void roundToLsb(LimbVector &magnitude, int64_t &nExponent, bool bSticky, const int64_t nLsb, const BigRounding eRounding, const bool bNegative)
+{
+	bool bRound = false;
+	if (nLsb > nExponent)
+	{
+		size_t nShift = (size_t)(nLsb - nExponent);
+		if (magnitude.empty() == false)
+		{
+			bRound = limbTestBitN(&magnitude[0], magnitude.size(), nShift - 1);
+			bSticky = bSticky || limbAnyBitsN(&magnitude[0], magnitude.size(), nShift - 1);
+		}
+		shiftRightV(magnitude, nShift);
+		nExponent = nLsb;
+	}
+
+	bool bIncrement = false;
+	switch (eRounding)
+	{
+	case BigRoundingNearestEven:
+		{
+			bool bOdd = (magnitude.empty() == false) && ((magnitude[0] & 1) != 0);
+			bIncrement = bRound && (bSticky || bOdd);
+		}
+		break;
+	case BigRoundingNearestAway:
+		bIncrement = bRound;
+		break;
+	case BigRoundingTowardZero:
+		bIncrement = false;
+		break;
+	case BigRoundingUp:
+		bIncrement = (bNegative == false) && (bRound || bSticky);
+		break;
+	case BigRoundingDown:
+		bIncrement = (bNegative == true) && (bRound || bSticky);
+		break;
+	}
+
+	if (bIncrement == true)
+	{
+		addOneV(magnitude);
+	}
+}
+
+
+////////// protected methods
+
+void CBigFloat::setSpecial(const BigFloatClass eClass, const bool bNegative)
+{
+	m_Mantissa.clear();
+	m_nExponent = 0;
+	m_bNegative = bNegative;
+	m_eClass = eClass;
+}
+
+void CBigFloat::setRounded(LimbVector &magnitude, const int64_t nExponent, const bool bSticky, const bool bNegative, const BigRounding eRounding)
+{
+	normalizeV(magnitude);
+	if (magnitude.empty())
+	{
+		// callers give sticky only with enough bits
+		setSpecial(BigFloatZero, bNegative);
+		return;
+	}
+
+	int64_t nExp = nExponent;
+	const int64_t nLsb = nExp + (int64_t)bitLengthV(magnitude) - (int64_t)m_nPrecision;
+	roundToLsb(magnitude, nExp, bSticky, nLsb, eRounding, bNegative);
+
+	// rounding up may carry to one more bit (power of two)
+	if (bitLengthV(magnitude) > m_nPrecision)
+	{
+		shiftRightV(magnitude, 1);
+		nExp++;
+	}
+
+	// keep mantissa odd: less limbs for values like small integers
+	size_t nZeros = limbTrailingZerosN(&magnitude[0], magnitude.size());
+	shiftRightV(magnitude, nZeros);
+
+	m_Mantissa.swap(magnitude);
+	m_nExponent = nExp + (int64_t)nZeros;
+	m_bNegative = bNegative;
+	m_eClass = BigFloatNormal;
+}
+
+bool CBigFloat::isSame(const CBigFloat &other) const
+{
+	return (m_eClass == other.m_eClass
+		&& m_bNegative == other.m_bNegative
+		&& m_nExponent == other.m_nExponent
+		&& m_Mantissa == other.m_Mantissa);
+}
+
+int64_t CBigFloat::topExponent() const
+{
+	return m_nExponent + (int64_t)bitLengthV(m_Mantissa);
+}
+
+void CBigFloat::addCore(const CBigFloat &a, const CBigFloat &b, const bool bNegateB, const BigRounding eRounding)
+{
+	if (this == &a || this == &b)
+	{
+		CBigFloat result(m_nPrecision);
+		result.addCore(a, b, bNegateB, eRounding);
+		*this = result;
+		return;
+	}
+
+	const bool bNegativeA = a.m_bNegative;
+	const bool bNegativeB = (b.m_bNegative != bNegateB);
+
+	if (a.isNaN() || b.isNaN())
+	{
+		setSpecial(BigFloatNaN, false);
+		return;
+	}
+	if (a.isInfinity() || b.isInfinity())
+	{
+		if (a.isInfinity() && b.isInfinity() && bNegativeA != bNegativeB)
+		{
+			setSpecial(BigFloatNaN, false);
+		}
+		else
+		{
+			setSpecial(BigFloatInfinity, a.isInfinity() ? bNegativeA : bNegativeB);
+		}
+		return;
+	}
+	if (a.isZero() && b.isZero())
+	{
+		// IEEE: exact zero sum is +0 except when rounding down
+		bool bNegative = (bNegativeA == bNegativeB) ? bNegativeA : (eRounding == BigRoundingDown);
+		setSpecial(BigFloatZero, bNegative);
+		return;
+	}
+	if (b.isZero())
+	{
+		LimbVector magnitude = a.m_Mantissa;
+		setRounded(magnitude, a.m_nExponent, false, bNegativeA, eRounding);
+		return;
+	}
+	if (a.isZero())
+	{
+		LimbVector magnitude = b.m_Mantissa;
+		setRounded(magnitude, b.m_nExponent, false, bNegativeB, eRounding);
+		return;
+	}
+
+	const bool bSubtract = (bNegativeA != bNegativeB);
+	const int64_t nTop = (a.topExponent() > b.topExponent()) ? a.topExponent() : b.topExponent();
+	const int64_t nLowest = (a.m_nExponent < b.m_nExponent) ? a.m_nExponent : b.m_nExponent;
+
+	// window of precision + guard bits below highest bit of result:
+	// anything below only contributes as sticky
+	const int64_t nWindow = nTop - (int64_t)(m_nPrecision + 66);
+	if (nLowest < nWindow)
+	{
+		LimbVector alignedA, alignedB;
+		bool bTruncatedA = false, bTruncatedB = false;
+		alignTo(a.m_Mantissa, a.m_nExponent, nWindow, alignedA, bTruncatedA);
+		alignTo(b.m_Mantissa, b.m_nExponent, nWindow, alignedB, bTruncatedB);
+
+		if (bSubtract == false)
+		{
+			// value in [X, X + truncated parts)
+			addV(alignedA, alignedB);
+			if (bTruncatedA == false || bTruncatedB == false)
+			{
+				setRounded(alignedA, nWindow, (bTruncatedA || bTruncatedB), bNegativeA, eRounding);
+				return;
+			}
+
+			LimbVector upper = alignedA;
+			addOneV(upper);
+			CBigFloat check(m_nPrecision);
+			check.setRounded(upper, nWindow, true, bNegativeA, eRounding);
+			setRounded(alignedA, nWindow, true, bNegativeA, eRounding);
+			if (isSame(check))
+			{
+				return;
+			}
+		}
+		else
+		{
+			int nOrder = compareV(alignedA, alignedB);
+			if (nOrder != 0)
+			{
+				// larger minus smaller, result has sign of larger
+				const bool bNegative = (nOrder > 0) ? bNegativeA : bNegativeB;
+				const bool bTruncatedLarge = (nOrder > 0) ? bTruncatedA : bTruncatedB;
+				const bool bTruncatedSmall = (nOrder > 0) ? bTruncatedB : bTruncatedA;
+				LimbVector difference;
+				if (nOrder > 0)
+				{
+					subV(difference, alignedA, alignedB);
+				}
+				else
+				{
+					subV(difference, alignedB, alignedA);
+				}
+
+				if (bTruncatedLarge == false && bTruncatedSmall == false)
+				{
+					setRounded(difference, nWindow, false, bNegative, eRounding);
+					return;
+				}
+
+				// value is in (X-1, X) when only smaller was truncated,
+				// (X, X+1) when only larger, (X-1, X+1) when both
+				LimbVector lower = difference;
+				if (bTruncatedSmall == true)
+				{
+					subOneV(lower);
+				}
+				if (bitLengthV(lower) >= m_nPrecision + 2)
+				{
+					if (bTruncatedLarge == false || bTruncatedSmall == false)
+					{
+						setRounded(lower, nWindow, true, bNegative, eRounding);
+						return;
+					}
+
+					CBigFloat check(m_nPrecision);
+					check.setRounded(difference, nWindow, true, bNegative, eRounding);
+					setRounded(lower, nWindow, true, bNegative, eRounding);
+					if (isSame(check))
+					{
+						return;
+					}
+				}
+			}
+		}
+		// undecided: fall through to exact
+	}
+
+	// exact sum at lowest exponent of operands
+	LimbVector alignedA, alignedB;
+	bool bTruncated = false;
+	alignTo(a.m_Mantissa, a.m_nExponent, nLowest, alignedA, bTruncated);
+	alignTo(b.m_Mantissa, b.m_nExponent, nLowest, alignedB, bTruncated);
+	if (bSubtract == false)
+	{
+		addV(alignedA, alignedB);
+		setRounded(alignedA, nLowest, false, bNegativeA, eRounding);
+		return;
+	}
+
+	int nOrder = compareV(alignedA, alignedB);
+	if (nOrder == 0)
+	{
+		setSpecial(BigFloatZero, (eRounding == BigRoundingDown));
+		return;
+	}
+
+	LimbVector difference;
+	if (nOrder > 0)
+	{
+		subV(difference, alignedA, alignedB);
+		setRounded(difference, nLowest, false, bNegativeA, eRounding);
+	}
+	else
+	{
+		subV(difference, alignedB, alignedA);
+		setRounded(difference, nLowest, false, bNegativeB, eRounding);
+	}
+}
+
+
+///////// public methods
+
+CBigFloat::CBigFloat(const size_t nPrecision)
+	: m_Mantissa()
+	, m_nExponent(0)
+	, m_nPrecision((nPrecision > 0) ? nPrecision : 1)
+	, m_bNegative(false)
+	, m_eClass(BigFloatZero)
+{}
+
+CBigFloat::CBigFloat(const double value, const size_t nPrecision)
+	: m_Mantissa()
+	, m_nExponent(0)
+	, m_nPrecision((nPrecision > 0) ? nPrecision : 1)
+	, m_bNegative(false)
+	, m_eClass(BigFloatZero)
+{
+	fromDouble(value);
+}
+
+CBigFloat::CBigFloat(const CBigValue &value, const size_t nPrecision, const BigRounding eRounding)
+	: m_Mantissa()
+	, m_nExponent(0)
+	, m_nPrecision((nPrecision > 0) ? nPrecision : 1)
+	, m_bNegative(false)
+	, m_eClass(BigFloatZero)
+{
+	fromBigValue(value, eRounding);
+}
+
+// IEEE double: 1 sign bit, 11 bits exponent (bias 1023),
+// 52 bits mantissa with hidden bit for normalized value
+CBigFloat& CBigFloat::fromDouble(const double value, const BigRounding eRounding)
+{
+	uint64_t bits = 0;
+	::memcpy(&bits, &value, sizeof(bits));
+
+	const bool bNegative = ((bits >> 63) != 0);
+	const int nExponent = (int)((bits >> 52) & 0x7FF);
+	const uint64_t fraction = bits & ((1ULL << 52) - 1);
+
+	if (nExponent == 0x7FF)
+	{
+		setSpecial((fraction != 0) ? BigFloatNaN : BigFloatInfinity, bNegative);
+		return *this;
+	}
+	if (nExponent == 0 && fraction == 0)
+	{
+		setSpecial(BigFloatZero, bNegative);
+		return *this;
+	}
+
+	LimbVector magnitude(1, (nExponent != 0) ? (fraction | (1ULL << 52)) : fraction);
+	setRounded(magnitude, (nExponent != 0) ? (nExponent - 1075) : -1074, false, bNegative, eRounding);
+	return *this;
+}
+
+// IEEE float: 1 sign bit, 8 bits exponent (bias 127),
+// 23 bits mantissa with hidden bit for normalized value
+CBigFloat& CBigFloat::fromFloat(const float value, const BigRounding eRounding)
+{
+	uint32_t bits = 0;
+	::memcpy(&bits, &value, sizeof(bits));
+
+	const bool bNegative = ((bits >> 31) != 0);
+	const int nExponent = (int)((bits >> 23) & 0xFF);
+	const uint32_t fraction = bits & ((1U << 23) - 1);
+
+	if (nExponent == 0xFF)
+	{
+		setSpecial((fraction != 0) ? BigFloatNaN : BigFloatInfinity, bNegative);
+		return *this;
+	}
+	if (nExponent == 0 && fraction == 0)
+	{
+		setSpecial(BigFloatZero, bNegative);
+		return *this;
+	}
+
+	LimbVector magnitude(1, (nExponent != 0) ? (fraction | (1U << 23)) : fraction);
+	setRounded(magnitude, (nExponent != 0) ? (nExponent - 150) : -149, false, bNegative, eRounding);
+	return *this;
+}
+
+CBigFloat& CBigFloat::fromInt64(const int64_t value, const BigRounding eRounding)
+{
+	if (value == 0)
+	{
+		setSpecial(BigFloatZero, false);
+		return *this;
+	}
+
+	// note: negate as unsigned so that minimum value works
+	const bool bNegative = (value < 0);
+	LimbVector magnitude(1, bNegative ? (0 - (uint64_t)value) : (uint64_t)value);
+	setRounded(magnitude, 0, false, bNegative, eRounding);
+	return *this;
+}
+
+CBigFloat& CBigFloat::fromUInt64(const uint64_t value, const BigRounding eRounding)
+{
+	if (value == 0)
+	{
+		setSpecial(BigFloatZero, false);
+		return *this;
+	}
+	LimbVector magnitude(1, value);
+	setRounded(magnitude, 0, false, false, eRounding);
+	return *this;
+}
+
+// value is magnitude / 10^scale:
+// divide with enough bits for rounding, remainder is sticky
+CBigFloat& CBigFloat::fromBigValue(const CBigValue &value, const BigRounding eRounding)
+{
+	LimbVector magnitude;
+	value.getLimbs(magnitude);
+	normalizeV(magnitude);
+	if (magnitude.empty())
+	{
+		setSpecial(BigFloatZero, value.isNegative());
+		return *this;
+	}
+
+	if (value.getScale() == 0)
+	{
+		setRounded(magnitude, 0, false, value.isNegative(), eRounding);
+		return *this;
+	}
+
+	LimbVector divisor;
+	powerOfTenV(value.getScale(), divisor);
+
+	int64_t nShift = (int64_t)(m_nPrecision + 3 + bitLengthV(divisor)) - (int64_t)bitLengthV(magnitude);
+	if (nShift < 0)
+	{
+		nShift = 0;
+	}
+	shiftLeftV(magnitude, (size_t)nShift);
+
+	LimbVector quotient, remainder;
+	divModV(magnitude, divisor, quotient, remainder);
+	setRounded(quotient, -nShift, (remainder.empty() == false), value.isNegative(), eRounding);
+	return *this;
+}
+
+// expecting 80 bits in "long double" format, always big-endian value:
+// 1 sign bit, 15 bits exponent (bias 16383),
+// 64 bits significand with explicit integer bit
+CBigFloat& CBigFloat::fromExtended(const uint8_t *data, const BigRounding eRounding)
+{
+	const bool bNegative = ((data[0] & (1 << 7)) != 0);
+	const int nExponent = ((data[0] & 0x7F) << 8) | data[1];
+
+	uint64_t significand = 0;
+	for (int i = 2; i < 10; i++)
+	{
+		significand = (significand << 8) | data[i];
+	}
+
+	if (nExponent == 0x7FFF)
+	{
+		// integer bit is ignored for infinity/NaN
+		setSpecial(((significand << 1) != 0) ? BigFloatNaN : BigFloatInfinity, bNegative);
+		return *this;
+	}
+	if (significand == 0)
+	{
+		setSpecial(BigFloatZero, bNegative);
+		return *this;
+	}
+
+	LimbVector magnitude(1, significand);
+	setRounded(magnitude, ((nExponent != 0) ? nExponent : 1) - 16383 - 63, false, bNegative, eRounding);
+	return *this;
+}
+
+// 128-bits (16 bytes, SPARC/PowerPC), always big-endian value:
+// 1 sign bit, 15 bits exponent (bias 16383),
+// 112 bits mantissa with hidden bit for normalized value
+CBigFloat& CBigFloat::fromQuadruple(const uint8_t *data, const BigRounding eRounding)
+{
+	const bool bNegative = ((data[0] & (1 << 7)) != 0);
+	const int nExponent = ((data[0] & 0x7F) << 8) | data[1];
+
+	uint64_t high = 0; // 48 bits
+	uint64_t low = 0;
+	for (int i = 2; i < 8; i++)
+	{
+		high = (high << 8) | data[i];
+	}
+	for (int i = 8; i < 16; i++)
+	{
+		low = (low << 8) | data[i];
+	}
+
+	if (nExponent == 0x7FFF)
+	{
+		setSpecial((high != 0 || low != 0) ? BigFloatNaN : BigFloatInfinity, bNegative);
+		return *this;
+	}
+	if (nExponent == 0 && high == 0 && low == 0)
+	{
+		setSpecial(BigFloatZero, bNegative);
+		return *this;
+	}
+
+	if (nExponent != 0)
+	{
+		high |= (1ULL << 48); // hidden bit
+	}
+	LimbVector magnitude(2);
+	magnitude[0] = low;
+	magnitude[1] = high;
+	setRounded(magnitude, ((nExponent != 0) ? nExponent : 1) - 16383 - 112, false, bNegative, eRounding);
+	return *this;
+}
+
+CBigFloat& CBigFloat::fromParts(const std::vector<uint64_t> &mantissa, const int64_t nExponent, const bool bNegative, const BigRounding eRounding)
+{
+	LimbVector magnitude = mantissa;
+	setRounded(magnitude, nExponent, false, bNegative, eRounding);
+	return *this;
+}
+
+CBigFloat& CBigFloat::set(const CBigFloat &other, const BigRounding eRounding)
+{
+	if (other.m_eClass != BigFloatNormal)
+	{
+		setSpecial(other.m_eClass, other.m_bNegative);
+		return *this;
+	}
+	LimbVector magnitude = other.m_Mantissa;
+	setRounded(magnitude, other.m_nExponent, false, other.m_bNegative, eRounding);
+	return *this;
+}
+
+CBigFloat& CBigFloat::setPrecision(const size_t nPrecision, const BigRounding eRounding)
+{
+	m_nPrecision = (nPrecision > 0) ? nPrecision : 1;
+	if (m_eClass == BigFloatNormal)
+	{
+		LimbVector magnitude = m_Mantissa;
+		setRounded(magnitude, m_nExponent, false, m_bNegative, eRounding);
+	}
+	return *this;
+}
+
+CBigFloat& CBigFloat::add(const CBigFloat &a, const CBigFloat &b, const BigRounding eRounding)
+{
+	addCore(a, b, false, eRounding);
+	return *this;
+}
+
+CBigFloat& CBigFloat::sub(const CBigFloat &a, const CBigFloat &b, const BigRounding eRounding)
+{
+	addCore(a, b, true, eRounding);
+	return *this;
+}
+
+// operands are cut to precision+64 bits: product of truncated operands
+// is a short product of the full ones with known error bound
+CBigFloat& CBigFloat::mul(const CBigFloat &a, const CBigFloat &b, const BigRounding eRounding)
+{
+	if (this == &a || this == &b)
+	{
+		CBigFloat result(m_nPrecision);
+		result.mul(a, b, eRounding);
+		*this = result;
+		return *this;
+	}
+
+	const bool bNegative = (a.m_bNegative != b.m_bNegative);
+	if (a.isNaN() || b.isNaN()
+		|| (a.isInfinity() && b.isZero())
+		|| (a.isZero() && b.isInfinity()))
+	{
+		setSpecial(BigFloatNaN, false);
+		return *this;
+	}
+	if (a.isInfinity() || b.isInfinity())
+	{
+		setSpecial(BigFloatInfinity, bNegative);
+		return *this;
+	}
+	if (a.isZero() || b.isZero())
+	{
+		setSpecial(BigFloatZero, bNegative);
+		return *this;
+	}
+
+	const size_t nLimit = m_nPrecision + 64;
+	LimbVector truncA, truncB;
+	bool bTruncatedA = false, bTruncatedB = false;
+	size_t nShiftA = truncateTo(a.m_Mantissa, nLimit, truncA, bTruncatedA);
+	size_t nShiftB = truncateTo(b.m_Mantissa, nLimit, truncB, bTruncatedB);
+	const int64_t nExponent = a.m_nExponent + (int64_t)nShiftA + b.m_nExponent + (int64_t)nShiftB;
+
+	LimbVector product;
+	mulV(product, truncA, truncB);
+	if (bTruncatedA == false && bTruncatedB == false)
+	{
+		setRounded(product, nExponent, false, bNegative, eRounding);
+		return *this;
+	}
+
+	// (A' + ea)(B' + eb) with 0 < ea, eb < 1
+	// is in (A'B', A'B' + A' + B' + 1) when both truncated
+	LimbVector upper = product;
+	if (bTruncatedA == true)
+	{
+		addV(upper, truncB);
+	}
+	if (bTruncatedB == true)
+	{
+		addV(upper, truncA);
+	}
+	if (bTruncatedA == false || bTruncatedB == false)
+	{
+		subOneV(upper);
+	}
+
+	CBigFloat check(m_nPrecision);
+	check.setRounded(upper, nExponent, true, bNegative, eRounding);
+	setRounded(product, nExponent, true, bNegative, eRounding);
+	if (isSame(check))
+	{
+		return *this;
+	}
+
+	// undecided: exact product
+	mulV(product, a.m_Mantissa, b.m_Mantissa);
+	setRounded(product, a.m_nExponent + b.m_nExponent, false, bNegative, eRounding);
+	return *this;
+}
+
+// quotient with precision+2 bits at least, remainder is sticky
+CBigFloat& CBigFloat::div(const CBigFloat &a, const CBigFloat &b, const BigRounding eRounding)
+{
+	if (this == &a || this == &b)
+	{
+		CBigFloat result(m_nPrecision);
+		result.div(a, b, eRounding);
+		*this = result;
+		return *this;
+	}
+
+	const bool bNegative = (a.m_bNegative != b.m_bNegative);
+	if (a.isNaN() || b.isNaN()
+		|| (a.isInfinity() && b.isInfinity())
+		|| (a.isZero() && b.isZero()))
+	{
+		setSpecial(BigFloatNaN, false);
+		return *this;
+	}
+	if (a.isInfinity() || b.isZero())
+	{
+		setSpecial(BigFloatInfinity, bNegative);
+		return *this;
+	}
+	if (a.isZero() || b.isInfinity())
+	{
+		setSpecial(BigFloatZero, bNegative);
+		return *this;
+	}
+
+	LimbVector truncA, truncB;
+	bool bTruncatedA = false, bTruncatedB = false;
+	size_t nShiftB = truncateTo(b.m_Mantissa, m_nPrecision + 64, truncB, bTruncatedB);
+	size_t nShiftA = truncateTo(a.m_Mantissa, m_nPrecision + 66 + bitLengthV(truncB), truncA, bTruncatedA);
+
+	int64_t nScale = (int64_t)(m_nPrecision + 3 + bitLengthV(truncB)) - (int64_t)bitLengthV(truncA);
+	if (nScale < 0)
+	{
+		nScale = 0;
+	}
+	const int64_t nExponent = (a.m_nExponent + (int64_t)nShiftA - nScale) - (b.m_nExponent + (int64_t)nShiftB);
+
+	LimbVector dividend = truncA;
+	shiftLeftV(dividend, (size_t)nScale);
+
+	LimbVector quotient, remainder;
+	divModV(dividend, truncB, quotient, remainder);
+	if (bTruncatedA == false && bTruncatedB == false)
+	{
+		setRounded(quotient, nExponent, (remainder.empty() == false), bNegative, eRounding);
+		return *this;
+	}
+
+	// value is in [A'/(B'+1), (A'+1)/B')
+	LimbVector lower = quotient;
+	if (bTruncatedB == true)
+	{
+		LimbVector divisor = truncB;
+		addOneV(divisor);
+		divModV(dividend, divisor, lower, remainder);
+	}
+	LimbVector upper = quotient;
+	if (bTruncatedA == true)
+	{
+		LimbVector dividendUpper = truncA;
+		addOneV(dividendUpper);
+		shiftLeftV(dividendUpper, (size_t)nScale);
+		divModV(dividendUpper, truncB, upper, remainder);
+	}
+
+	CBigFloat check(m_nPrecision);
+	check.setRounded(upper, nExponent, true, bNegative, eRounding);
+	setRounded(lower, nExponent, false, bNegative, eRounding);
+	if (isSame(check))
+	{
+		return *this;
+	}
+
+	// undecided: exact division
+	nScale = (int64_t)(m_nPrecision + 3 + bitLengthV(b.m_Mantissa)) - (int64_t)bitLengthV(a.m_Mantissa);
+	if (nScale < 0)
+	{
+		nScale = 0;
+	}
+	dividend = a.m_Mantissa;
+	shiftLeftV(dividend, (size_t)nScale);
+	divModV(dividend, b.m_Mantissa, quotient, remainder);
+	setRounded(quotient, a.m_nExponent - nScale - b.m_nExponent, (remainder.empty() == false), bNegative, eRounding);
+	return *this;
+}
+
+// integer square root with 2*(precision+2) bits in radicand,
+// remainder is sticky
+CBigFloat& CBigFloat::sqrt(const CBigFloat &a, const BigRounding eRounding)
+{
+	if (this == &a)
+	{
+		CBigFloat result(m_nPrecision);
+		result.sqrt(a, eRounding);
+		*this = result;
+		return *this;
+	}
+
+	if (a.isNaN() || (a.m_bNegative == true && a.isZero() == false))
+	{
+		setSpecial(BigFloatNaN, false);
+		return *this;
+	}
+	if (a.isInfinity() || a.isZero())
+	{
+		// sqrt(-0) is -0
+		setSpecial(a.m_eClass, a.m_bNegative);
+		return *this;
+	}
+
+	const size_t nRadicandBits = 2 * (m_nPrecision + 2);
+	LimbVector truncA;
+	bool bTruncatedA = false;
+	size_t nShiftA = truncateTo(a.m_Mantissa, nRadicandBits + 64, truncA, bTruncatedA);
+	int64_t nExponent = a.m_nExponent + (int64_t)nShiftA;
+
+	int64_t nScale = (int64_t)nRadicandBits - (int64_t)bitLengthV(truncA);
+	if (nScale < 0)
+	{
+		nScale = 0;
+	}
+	if (((nExponent - nScale) & 1) != 0)
+	{
+		// exponent must be even
+		nScale++;
+	}
+
+	LimbVector radicand = truncA;
+	shiftLeftV(radicand, (size_t)nScale);
+	LimbVector root;
+	isqrtV(radicand, root);
+
+	LimbVector square;
+	mulV(square, root, root);
+	const bool bInexact = (compareV(square, radicand) != 0);
+	const int64_t nRootExponent = (nExponent - nScale) / 2;
+	if (bTruncatedA == false)
+	{
+		setRounded(root, nRootExponent, bInexact, false, eRounding);
+		return *this;
+	}
+
+	// value is in [sqrt(N), sqrt(N + 2^scale))
+	LimbVector radicandUpper = truncA;
+	addOneV(radicandUpper);
+	shiftLeftV(radicandUpper, (size_t)nScale);
+	LimbVector rootUpper;
+	isqrtV(radicandUpper, rootUpper);
+
+	CBigFloat check(m_nPrecision);
+	check.setRounded(rootUpper, nRootExponent, true, false, eRounding);
+	setRounded(root, nRootExponent, false, false, eRounding);
+	if (isSame(check))
+	{
+		return *this;
+	}
+
+	// undecided: exact radicand
+	nExponent = a.m_nExponent;
+	nScale = (int64_t)nRadicandBits - (int64_t)bitLengthV(a.m_Mantissa);
+	if (nScale < 0)
+	{
+		nScale = 0;
+	}
+	if (((nExponent - nScale) & 1) != 0)
+	{
+		nScale++;
+	}
+	radicand = a.m_Mantissa;
+	shiftLeftV(radicand, (size_t)nScale);
+	isqrtV(radicand, root);
+	mulV(square, root, root);
+	setRounded(root, (nExponent - nScale) / 2, (compareV(square, radicand) != 0), false, eRounding);
+	return *this;
+}
+
+// 1/a: x = x + x*(1 - a*x), precision doubles on each step
+CBigFloat& CBigFloat::reciprocal(const CBigFloat &a)
+{
+	if (this == &a)
+	{
+		CBigFloat result(m_nPrecision);
+		result.reciprocal(a);
+		*this = result;
+		return *this;
+	}
+
+	if (a.m_eClass != BigFloatNormal)
+	{
+		if (a.isNaN())
+		{
+			setSpecial(BigFloatNaN, false);
+		}
+		else
+		{
+			setSpecial(a.isZero() ? BigFloatInfinity : BigFloatZero, a.m_bNegative);
+		}
+		return *this;
+	}
+
+	// start from double: a scaled to [0.5, 1)
+	const int64_t nTop = a.topExponent();
+	CBigFloat scaled(53);
+	scaled.set(a);
+	scaled.ldexp(-nTop);
+
+	CBigFloat x(53);
+	x.fromDouble(1.0 / scaled.toDouble());
+	x.ldexp(-nTop);
+
+	CBigFloat one(1);
+	one.fromUInt64(1);
+
+	std::vector<size_t> steps;
+	newtonSteps(m_nPrecision, steps);
+	for (size_t i = steps.size(); i > 0; i--)
+	{
+		const size_t nStep = steps[i - 1];
+		CBigFloat product(nStep);
+		product.mul(a, x);
+		CBigFloat error(nStep);
+		error.sub(one, product);
+		// error is below 2^-(step/2): half precision is enough
+		CBigFloat correction(nStep / 2 + 32);
+		correction.mul(x, error);
+		CBigFloat next(nStep);
+		next.add(x, correction);
+		x = next;
+	}
+	return set(x);
+}
+
+// 1/sqrt(a): y = y + y*(1 - a*y^2)/2
+CBigFloat& CBigFloat::reciprocalSqrt(const CBigFloat &a)
+{
+	if (this == &a)
+	{
+		CBigFloat result(m_nPrecision);
+		result.reciprocalSqrt(a);
+		*this = result;
+		return *this;
+	}
+
+	if (a.isNaN() || (a.m_bNegative == true && a.isZero() == false))
+	{
+		setSpecial(BigFloatNaN, false);
+		return *this;
+	}
+	if (a.m_eClass != BigFloatNormal)
+	{
+		setSpecial(a.isZero() ? BigFloatInfinity : BigFloatZero, a.m_bNegative);
+		return *this;
+	}
+
+	// even power of two so that it can be halved
+	int64_t nTop = a.topExponent();
+	if ((nTop & 1) != 0)
+	{
+		nTop++;
+	}
+	CBigFloat scaled(53);
+	scaled.set(a);
+	scaled.ldexp(-nTop);
+
+	CBigFloat y(53);
+	y.fromDouble(1.0 / ::sqrt(scaled.toDouble()));
+	y.ldexp(-nTop / 2);
+
+	CBigFloat one(1);
+	one.fromUInt64(1);
+
+	std::vector<size_t> steps;
+	newtonSteps(m_nPrecision, steps);
+	for (size_t i = steps.size(); i > 0; i--)
+	{
+		const size_t nStep = steps[i - 1];
+		CBigFloat square(nStep);
+		square.mul(y, y);
+		CBigFloat product(nStep);
+		product.mul(a, square);
+		CBigFloat error(nStep);
+		error.sub(one, product);
+		CBigFloat correction(nStep / 2 + 32);
+		correction.mul(y, error);
+		correction.ldexp(-1);
+		CBigFloat next(nStep);
+		next.add(y, correction);
+		y = next;
+	}
+	return set(y);
+}
+
+CBigFloat CBigFloat::operator + (const CBigFloat &other) const
+{
+	CBigFloat value((m_nPrecision > other.m_nPrecision) ? m_nPrecision : other.m_nPrecision);
+	value.add(*this, other);
+	return value;
+}
+
+CBigFloat CBigFloat::operator - (const CBigFloat &other) const
+{
+	CBigFloat value((m_nPrecision > other.m_nPrecision) ? m_nPrecision : other.m_nPrecision);
+	value.sub(*this, other);
+	return value;
+}
+
+CBigFloat CBigFloat::operator * (const CBigFloat &other) const
+{
+	CBigFloat value((m_nPrecision > other.m_nPrecision) ? m_nPrecision : other.m_nPrecision);
+	value.mul(*this, other);
+	return value;
+}
+
+CBigFloat CBigFloat::operator / (const CBigFloat &other) const
+{
+	CBigFloat value((m_nPrecision > other.m_nPrecision) ? m_nPrecision : other.m_nPrecision);
+	value.div(*this, other);
+	return value;
+}
+
+CBigFloat CBigFloat::operator - () const
+{
+	CBigFloat value(*this);
+	value.negate();
+	return value;
+}
+
+CBigFloat& CBigFloat::operator += (const CBigFloat &other)
+{
+	if (other.m_nPrecision > m_nPrecision)
+	{
+		m_nPrecision = other.m_nPrecision;
+	}
+	return add(*this, other);
+}
+
+CBigFloat& CBigFloat::operator -= (const CBigFloat &other)
+{
+	if (other.m_nPrecision > m_nPrecision)
+	{
+		m_nPrecision = other.m_nPrecision;
+	}
+	return sub(*this, other);
+}
+
+CBigFloat& CBigFloat::operator *= (const CBigFloat &other)
+{
+	if (other.m_nPrecision > m_nPrecision)
+	{
+		m_nPrecision = other.m_nPrecision;
+	}
+	return mul(*this, other);
+}
+
+CBigFloat& CBigFloat::operator /= (const CBigFloat &other)
+{
+	if (other.m_nPrecision > m_nPrecision)
+	{
+		m_nPrecision = other.m_nPrecision;
+	}
+	return div(*this, other);
+}
+
+CBigFloat& CBigFloat::ldexp(const int64_t nExponent)
+{
+	if (m_eClass == BigFloatNormal)
+	{
+		m_nExponent += nExponent;
+	}
+	return *this;
+}
+
+CBigFloat& CBigFloat::negate()
+{
+	if (m_eClass != BigFloatNaN)
+	{
+		m_bNegative = !m_bNegative;
+	}
+	return *this;
+}
+
+int CBigFloat::compare(const CBigFloat &other) const
+{
+	if (isNaN() || other.isNaN())
+	{
+		return 0;
+	}
+	if (isZero() && other.isZero())
+	{
+		return 0;
+	}
+
+	// sign, zero has no sign here
+	const bool bNegative = isZero() ? !other.m_bNegative : m_bNegative;
+	const bool bOtherNegative = other.isZero() ? !m_bNegative : other.m_bNegative;
+	if (bNegative != bOtherNegative)
+	{
+		return (bNegative == true) ? -1 : 1;
+	}
+
+	// same sign: compare magnitudes
+	int nOrder = 0;
+	if (isZero() || other.isZero())
+	{
+		nOrder = isZero() ? -1 : 1;
+	}
+	else if (isInfinity() || other.isInfinity())
+	{
+		nOrder = (isInfinity() == other.isInfinity()) ? 0 : (isInfinity() ? 1 : -1);
+	}
+	else if (topExponent() != other.topExponent())
+	{
+		nOrder = (topExponent() < other.topExponent()) ? -1 : 1;
+	}
+	else
+	{
+		// same highest bit: align to lower exponent (sizes are bounded by lengths)
+		const int64_t nLowest = (m_nExponent < other.m_nExponent) ? m_nExponent : other.m_nExponent;
+		LimbVector a, b;
+		bool bTruncated = false;
+		alignTo(m_Mantissa, m_nExponent, nLowest, a, bTruncated);
+		alignTo(other.m_Mantissa, other.m_nExponent, nLowest, b, bTruncated);
+		nOrder = compareV(a, b);
+	}
+	return (bNegative == true) ? -nOrder : nOrder;
+}
+
+bool CBigFloat::operator == (const CBigFloat &other) const
+{
+	return (isNaN() == false && other.isNaN() == false && compare(other) == 0);
+}
+
+bool CBigFloat::operator != (const CBigFloat &other) const
+{
+	return !(*this == other);
+}
+
+bool CBigFloat::operator < (const CBigFloat &other) const
+{
+	return (isNaN() == false && other.isNaN() == false && compare(other) < 0);
+}
+
+bool CBigFloat::operator <= (const CBigFloat &other) const
+{
+	return (isNaN() == false && other.isNaN() == false && compare(other) <= 0);
+}
+
+bool CBigFloat::operator > (const CBigFloat &other) const
+{
+	return (isNaN() == false && other.isNaN() == false && compare(other) > 0);
+}
+
+bool CBigFloat::operator >= (const CBigFloat &other) const
+{
+	return (isNaN() == false && other.isNaN() == false && compare(other) >= 0);
+}
+
+// round to 53 bits or less for subnormal range:
+// lowest bit can't be below 2^-1074
+double CBigFloat::toDouble(const BigRounding eRounding) const
+{
+	switch (m_eClass)
+	{
+	case BigFloatNaN:
+		return std::numeric_limits<double>::quiet_NaN();
+	case BigFloatInfinity:
+		return (m_bNegative == true) ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+	case BigFloatZero:
+		return (m_bNegative == true) ? -0.0 : 0.0;
+	default:
+		break;
+	}
+
+	int64_t nLsb = topExponent() - 53;
+	if (nLsb < -1074)
+	{
+		nLsb = -1074;
+	}
+
+	LimbVector magnitude = m_Mantissa;
+	int64_t nExponent = m_nExponent;
+	roundToLsb(magnitude, nExponent, false, nLsb, eRounding, m_bNegative);
+	normalizeV(magnitude);
+	if (magnitude.empty())
+	{
+		return (m_bNegative == true) ? -0.0 : 0.0;
+	}
+
+	// at most 2^53 here
+	if (nExponent + (int64_t)bitLengthV(magnitude) > 1024)
+	{
+		// overflow: infinity or largest finite depending on direction
+		bool bToInfinity = true;
+		if (eRounding == BigRoundingTowardZero
+			|| (eRounding == BigRoundingUp && m_bNegative == true)
+			|| (eRounding == BigRoundingDown && m_bNegative == false))
+		{
+			bToInfinity = false;
+		}
+		double value = bToInfinity ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::max();
+		return (m_bNegative == true) ? -value : value;
+	}
+
+	double value = ::ldexp((double)magnitude[0], (int)nExponent);
+	return (m_bNegative == true) ? -value : value;
+}
+
+CBigValue CBigFloat::toBigValue(const size_t nScale, const BigRounding eRounding) const
+{
+	CBigValue value;
+	if (m_eClass != BigFloatNormal)
+	{
+		// no representation for infinity/NaN: zero
+		value.fromLimbs(nullptr, 0, m_bNegative, nScale);
+		return value;
+	}
+
+	LimbVector magnitude;
+	LimbVector power;
+	powerOfTenV(nScale, power);
+	mulV(magnitude, m_Mantissa, power);
+
+	int64_t nExponent = m_nExponent;
+	if (nExponent >= 0)
+	{
+		shiftLeftV(magnitude, (size_t)nExponent);
+	}
+	else
+	{
+		roundToLsb(magnitude, nExponent, false, 0, eRounding, m_bNegative);
+	}
+
+	normalizeV(magnitude);
+	value.fromLimbs(magnitude.empty() ? nullptr : &magnitude[0], magnitude.size(), m_bNegative, nScale);
+	return value;
+}
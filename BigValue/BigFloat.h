@@ -0,0 +1,178 @@
+/////////////////////////////////////
+//
+// CBigFloat : arbitrary-precision
+// binary floating point.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Value is kept in same form as IEEE formats are taken apart:
+// sign, integer mantissa (64-bit limbs) and power-of-two exponent:
+//   value = (-1)^sign * mantissa * 2^exponent
+// Mantissa has at most "precision" bits, chosen by user per value.
+//
+// Like MPFR, result of an operation is rounded to precision
+// of the destination using requested rounding mode,
+// results are correctly rounded (add, sub, mul, div, sqrt).
+//
+// Operands longer than what destination precision needs
+// are truncated first so that cost of an operation depends
+// on destination precision and not on operand history;
+// exact computation is only needed when truncation error
+// leaves rounding undecided (very rare).
+//
+
+#ifndef BIGFLOAT_H
+#define BIGFLOAT_H
+
+#include "BigValue.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+
+enum BigFloatClass
+{
+	BigFloatZero = 0,
+	BigFloatNormal,
+	BigFloatInfinity,
+	BigFloatNaN
+};
+
+
+class CBigFloat
+{
+protected:
+	std::vector<uint64_t> m_Mantissa; // odd integer (trailing zero-bits moved to exponent), empty unless normal
+	int64_t m_nExponent; // power of two
+	size_t m_nPrecision; // bits
+	bool m_bNegative;
+	BigFloatClass m_eClass;
+
+	void setSpecial(const BigFloatClass eClass, const bool bNegative);
+
+	// round magnitude * 2^nExponent to our precision:
+	// bSticky means there are nonzero bits below magnitude,
+	// in which case magnitude must have at least precision+2 bits
+	void setRounded(std::vector<uint64_t> &magnitude, const int64_t nExponent, const bool bSticky, const bool bNegative, const BigRounding eRounding);
+
+	// same value and class
+	bool isSame(const CBigFloat &other) const;
+
+	void addCore(const CBigFloat &a, const CBigFloat &b, const bool bNegateB, const BigRounding eRounding);
+
+public:
+	explicit CBigFloat(const size_t nPrecision = 64);
+	CBigFloat(const double value, const size_t nPrecision);
+	CBigFloat(const CBigValue &value, const size_t nPrecision, const BigRounding eRounding = BigRoundingNearestEven);
+
+	// conversions: value is rounded to precision of this
+	CBigFloat& fromDouble(const double value, const BigRounding eRounding = BigRoundingNearestEven);
+	CBigFloat& fromFloat(const float value, const BigRounding eRounding = BigRoundingNearestEven);
+	CBigFloat& fromInt64(const int64_t value, const BigRounding eRounding = BigRoundingNearestEven);
+	CBigFloat& fromUInt64(const uint64_t value, const BigRounding eRounding = BigRoundingNearestEven);
+	CBigFloat& fromBigValue(const CBigValue &value, const BigRounding eRounding = BigRoundingNearestEven);
+
+	// expecting 80 bits in "long double" format, big-endian (as CBigValue)
+	CBigFloat& fromExtended(const uint8_t *data, const BigRounding eRounding = BigRoundingNearestEven);
+	// expecting 128 bits (SPARC/PowerPC), big-endian (as CBigValue)
+	CBigFloat& fromQuadruple(const uint8_t *data, const BigRounding eRounding = BigRoundingNearestEven);
+
+	// mantissa * 2^exponent, rounded to precision of this
+	CBigFloat& fromParts(const std::vector<uint64_t> &mantissa, const int64_t nExponent, const bool bNegative, const BigRounding eRounding = BigRoundingNearestEven);
+
+	// copy value rounded to precision of this
+	CBigFloat& set(const CBigFloat &other, const BigRounding eRounding = BigRoundingNearestEven);
+
+	// change precision, value is rounded if precision is reduced
+	CBigFloat& setPrecision(const size_t nPrecision, const BigRounding eRounding = BigRoundingNearestEven);
+	size_t getPrecision() const
+	{
+		return m_nPrecision;
+	}
+
+	// this = operation rounded to precision of this
+	CBigFloat& add(const CBigFloat &a, const CBigFloat &b, const BigRounding eRounding = BigRoundingNearestEven);
+	CBigFloat& sub(const CBigFloat &a, const CBigFloat &b, const BigRounding eRounding = BigRoundingNearestEven);
+	CBigFloat& mul(const CBigFloat &a, const CBigFloat &b, const BigRounding eRounding = BigRoundingNearestEven);
+	CBigFloat& div(const CBigFloat &a, const CBigFloat &b, const BigRounding eRounding = BigRoundingNearestEven);
+	CBigFloat& sqrt(const CBigFloat &a, const BigRounding eRounding = BigRoundingNearestEven);
+
+	// this = 1/a and 1/sqrt(a) by Newton iteration at precision of this:
+	// error is few ulps (not correctly rounded) but cost
+	// is few multiplications instead of long division
+	CBigFloat& reciprocal(const CBigFloat &a);
+	CBigFloat& reciprocalSqrt(const CBigFloat &a);
+
+	// operators: result has larger precision of operands,
+	// rounded to nearest-even
+	CBigFloat operator + (const CBigFloat &other) const;
+	CBigFloat operator - (const CBigFloat &other) const;
+	CBigFloat operator * (const CBigFloat &other) const;
+	CBigFloat operator / (const CBigFloat &other) const;
+	CBigFloat operator - () const;
+
+	CBigFloat& operator += (const CBigFloat &other);
+	CBigFloat& operator -= (const CBigFloat &other);
+	CBigFloat& operator *= (const CBigFloat &other);
+	CBigFloat& operator /= (const CBigFloat &other);
+
+	// multiply by power of two (exact)
+	CBigFloat& ldexp(const int64_t nExponent);
+	CBigFloat& negate();
+
+	// three-way compare (-1, 0, 1), NaN compares as unordered:
+	// relational operators give false
+	int compare(const CBigFloat &other) const;
+	bool operator == (const CBigFloat &other) const;
+	bool operator != (const CBigFloat &other) const;
+	bool operator < (const CBigFloat &other) const;
+	bool operator <= (const CBigFloat &other) const;
+	bool operator > (const CBigFloat &other) const;
+	bool operator >= (const CBigFloat &other) const;
+
+	// correctly rounded to double (handles subnormals and overflow)
+	double toDouble(const BigRounding eRounding = BigRoundingNearestEven) const;
+
+	// rounded to integer at given power of 10 scale
+	// (value * 10^scale rounded to integer, kept as scale of result)
+	CBigValue toBigValue(const size_t nScale = 0, const BigRounding eRounding = BigRoundingNearestEven) const;
+
+	bool isZero() const
+	{
+		return (m_eClass == BigFloatZero);
+	}
+	bool isNaN() const
+	{
+		return (m_eClass == BigFloatNaN);
+	}
+	bool isInfinity() const
+	{
+		return (m_eClass == BigFloatInfinity);
+	}
+	bool isNegative() const
+	{
+		return m_bNegative;
+	}
+	BigFloatClass getClass() const
+	{
+		return m_eClass;
+	}
+
+	// mantissa and exponent: value = mantissa * 2^exponent
+	const std::vector<uint64_t>& getMantissa() const
+	{
+		return m_Mantissa;
+	}
+	int64_t getExponent() const
+	{
+		return m_nExponent;
+	}
+
+	// exponent of highest bit +1 (value in [2^(top-1), 2^top))
+	int64_t topExponent() const;
+};
+
+#endif // BIGFLOAT_H
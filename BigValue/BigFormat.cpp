@@ -0,0 +1,381 @@
+/////////////////////////////////////
+//
+// BigFormat : shortest round-trip
+// decimal conversion of double.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Schubfach: rounding interval of the double (halfway to neighbours)
+// is scaled by 10^-k so that it contains one or two integers with
+// at most 17 digits; three products (both ends and the value)
+// decide which of the candidates is inside the interval.
+// Products are rounded to odd which keeps comparisons exact
+// (see "The Schubfach way to render doubles", R. Giulietti).
+//
+// Table of 10^k with 128-bit significand (rounded up)
+// is generated once from exact big integer arithmetic
+// instead of being pasted as a literal table.
+//
+
+#include "BigFormat.h"
+#include "BigLimb.h"
+
+#include <string.h>
+#include <vector>
+#include <mutex>
+
+
+// powers needed by doubles (subnormal to largest)
+static const int s_nPow10Min = -292;
+static const int s_nPow10Max = 326;
+
+// high and low limb of significand for each power
+static uint64_t s_Pow10Table[s_nPow10Max - s_nPow10Min + 1][2];
+static std::once_flag s_Pow10Once;
+
+static const char s_DigitPairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+
+////////// local helpers
+
+// floor(10^k * 2^(127 - floor(log2(10^k)))) + 1
+static void buildPow10Table()
+{
+	std::vector<uint64_t> power(1, 1);
+	for (int n = 0; n <= s_nPow10Max || n <= -s_nPow10Min; n++)
+	{
+		if (n > 0)
+		{
+			uint64_t carry = limbMul1(&power[0], &power[0], power.size(), 10);
+			if (carry != 0)
+			{
+				power.push_back(carry);
+			}
+		}
+		const size_t nBits = limbBitLengthN(&power[0], power.size());
+
+		if (n <= s_nPow10Max)
+		{
+			// 10^n: top 128 bits
+			std::vector<uint64_t> top(power.size() + 2, 0);
+			if (nBits <= 128)
+			{
+				limbShiftLeft((uint8_t*)&top[0], top.size() * 8, (const uint8_t*)&power[0], power.size() * 8, 128 - nBits);
+			}
+			else
+			{
+				limbShiftRight((uint8_t*)&top[0], top.size() * 8, (const uint8_t*)&power[0], power.size() * 8, nBits - 128);
+			}
+			s_Pow10Table[n - s_nPow10Min][0] = top[1];
+			s_Pow10Table[n - s_nPow10Min][1] = top[0] + 1;
+		}
+
+		if (n > 0 && -n >= s_nPow10Min)
+		{
+			// 10^-n: 2^(127 + bits) / 10^n
+			const size_t nShift = 127 + nBits;
+			std::vector<uint64_t> dividend(nShift / 64 + 1, 0);
+			dividend[nShift / 64] = 1ULL << (nShift % 64);
+			std::vector<uint64_t> quotient(dividend.size() - power.size() + 1, 0);
+			limbDivRemN(&quotient[0], nullptr, &dividend[0], dividend.size(), &power[0], power.size());
+			s_Pow10Table[-n - s_nPow10Min][0] = quotient[1];
+			s_Pow10Table[-n - s_nPow10Min][1] = quotient[0] + 1;
+		}
+	}
+}
+
+// floor(log2(10^e))
+static inline int floorLog2Pow10(const int e)
+{
+	return (e * 1741647) >> 19;
+}
+
+// floor(log10(2^e))
+static inline int floorLog10Pow2(const int e)
+{
+	return (e * 1262611) >> 22;
+}
+
+// floor(log10(3/4 * 2^e))
+static inline int floorLog10ThreeQuartersPow2(const int e)
+{
+	return (e * 1262611 - 524031) >> 22;
+}
+
+// floor(g * cp / 2^128), lowest bit set if inexact
+static inline uint64_t roundToOdd(const uint64_t *pG, const uint64_t cp)
+{
+	uint64_t xHigh = 0;
+	limbMul64(pG[1], cp, &xHigh);
+	uint64_t yHigh = 0;
+	uint64_t yLow = limbMul64(pG[0], cp, &yHigh);
+
+	yLow += xHigh;
+	yHigh += (yLow < xHigh) ? 1 : 0;
+	return yHigh | ((yLow > 1) ? 1 : 0);
+}
+
+// digits of value into buffer, returns count
+static size_t writeDigits(uint64_t value, char *pBuffer)
+{
+	char temp[24];
+	char *pEnd = temp + sizeof(temp);
+	char *p = pEnd;
+	while (value >= 100)
+	{
+		const unsigned int nPair = (unsigned int)(value % 100) * 2;
+		value /= 100;
+		*(--p) = s_DigitPairs[nPair + 1];
+		*(--p) = s_DigitPairs[nPair];
+	}
+	if (value >= 10)
+	{
+		const unsigned int nPair = (unsigned int)value * 2;
+		*(--p) = s_DigitPairs[nPair + 1];
+		*(--p) = s_DigitPairs[nPair];
+	}
+	else
+	{
+		*(--p) = (char)('0' + value);
+	}
+
+	const size_t nCount = (size_t)(pEnd - p);
+	::memcpy(pBuffer, p, nCount);
+	return nCount;
+}
+
+
+////////// public functions
+
+void decimalShortest(const double value, uint64_t &digits, int &exponent)
+{
+	std::call_once(s_Pow10Once, buildPow10Table);
+
+	uint64_t bits = 0;
+	::memcpy(&bits, &value, sizeof(bits));
+	const uint64_t fraction = bits & ((1ULL << 52) - 1);
+	const int nBiasedExponent = (int)((bits >> 52) & 0x7FF);
+
+	uint64_t c = 0;
+	int q = 0;
+	if (nBiasedExponent != 0)
+	{
+		c = fraction | (1ULL << 52);
+		q = nBiasedExponent - 1075;
+
+		// small integers are exact
+		if (q <= 0 && q > -53 && (c & ((1ULL << -q) - 1)) == 0)
+		{
+			digits = c >> -q;
+			exponent = 0;
+			while (digits % 10 == 0)
+			{
+				digits /= 10;
+				exponent++;
+			}
+			return;
+		}
+	}
+	else
+	{
+		c = fraction;
+		q = -1074;
+	}
+
+	// interval of values rounding to this double (scaled by 4)
+	const bool bEven = ((c & 1) == 0);
+	const bool bLowerCloser = (fraction == 0 && nBiasedExponent > 1);
+	const uint64_t cbl = 4 * c - 2 + (bLowerCloser ? 1 : 0);
+	const uint64_t cb = 4 * c;
+	const uint64_t cbr = 4 * c + 2;
+
+	const int k = bLowerCloser ? floorLog10ThreeQuartersPow2(q) : floorLog10Pow2(q);
+	const int h = q + floorLog2Pow10(-k) + 1;
+	const uint64_t *pG = s_Pow10Table[-k - s_nPow10Min];
+
+	const uint64_t vbl = roundToOdd(pG, cbl << h);
+	const uint64_t vb = roundToOdd(pG, cb << h);
+	const uint64_t vbr = roundToOdd(pG, cbr << h);
+	const uint64_t lower = vbl + (bEven ? 0 : 1);
+	const uint64_t upper = vbr - (bEven ? 0 : 1);
+
+	uint64_t s = vb / 4;
+	int nExponent = k;
+	bool bDone = false;
+	if (s >= 10)
+	{
+		// one digit less if interval allows
+		const uint64_t sp = s / 10;
+		const bool bUpInside = (lower <= 40 * sp);
+		const bool bWpInside = (40 * sp + 40 <= upper);
+		if (bUpInside != bWpInside)
+		{
+			s = sp + (bWpInside ? 1 : 0);
+			nExponent = k + 1;
+			bDone = true;
+		}
+	}
+	if (bDone == false)
+	{
+		const bool bUInside = (lower <= 4 * s);
+		const bool bWInside = (4 * s + 4 <= upper);
+		if (bUInside != bWInside)
+		{
+			s += (bWInside ? 1 : 0);
+		}
+		else
+		{
+			// both inside: nearest to value, ties to even
+			const uint64_t mid = 4 * s + 2;
+			const bool bRoundUp = (vb > mid || (vb == mid && (s & 1) != 0));
+			s += (bRoundUp ? 1 : 0);
+		}
+	}
+
+	while (s % 10 == 0)
+	{
+		s /= 10;
+		nExponent++;
+	}
+	digits = s;
+	exponent = nExponent;
+}
+
+size_t formatShortest(const double value, char *pBuffer)
+{
+	uint64_t bits = 0;
+	::memcpy(&bits, &value, sizeof(bits));
+	char *p = pBuffer;
+	if ((bits >> 63) != 0)
+	{
+		*p++ = '-';
+	}
+
+	if (((bits >> 52) & 0x7FF) == 0x7FF)
+	{
+		if ((bits & ((1ULL << 52) - 1)) != 0)
+		{
+			// no sign for NaN
+			::memcpy(pBuffer, "nan", 4);
+			return 3;
+		}
+		::memcpy(p, "inf", 4);
+		return (size_t)(p - pBuffer) + 3;
+	}
+	if ((bits << 1) == 0)
+	{
+		*p++ = '0';
+		*p = '\0';
+		return (size_t)(p - pBuffer);
+	}
+
+	uint64_t digits = 0;
+	int nExponent = 0;
+	decimalShortest(value, digits, nExponent);
+
+	char digitText[24];
+	const int nCount = (int)writeDigits(digits, digitText);
+	// exponent in scientific notation
+	const int nScientific = nExponent + nCount - 1;
+
+	if (nScientific >= -4 && nScientific < 17)
+	{
+		if (nExponent >= 0)
+		{
+			// integer
+			::memcpy(p, digitText, nCount);
+			p += nCount;
+			::memset(p, '0', nExponent);
+			p += nExponent;
+		}
+		else if (nScientific >= 0)
+		{
+			const int nInteger = nScientific + 1;
+			::memcpy(p, digitText, nInteger);
+			p += nInteger;
+			*p++ = '.';
+			::memcpy(p, digitText + nInteger, nCount - nInteger);
+			p += nCount - nInteger;
+		}
+		else
+		{
+			*p++ = '0';
+			*p++ = '.';
+			::memset(p, '0', -nScientific - 1);
+			p += -nScientific - 1;
+			::memcpy(p, digitText, nCount);
+			p += nCount;
+		}
+	}
+	else
+	{
+		*p++ = digitText[0];
+		if (nCount > 1)
+		{
+			*p++ = '.';
+			::memcpy(p, digitText + 1, nCount - 1);
+			p += nCount - 1;
+		}
+		*p++ = 'e';
+		*p++ = (nScientific < 0) ? '-' : '+';
+		int nAbsolute = (nScientific < 0) ? -nScientific : nScientific;
+		if (nAbsolute >= 100)
+		{
+			*p++ = (char)('0' + nAbsolute / 100);
+			nAbsolute %= 100;
+		}
+		*p++ = s_DigitPairs[nAbsolute * 2];
+		*p++ = s_DigitPairs[nAbsolute * 2 + 1];
+	}
+	*p = '\0';
+	return (size_t)(p - pBuffer);
+}
+
+CBigValue decimalValueShortest(const double value)
+{
+	CBigValue result;
+	uint64_t bits = 0;
+	::memcpy(&bits, &value, sizeof(bits));
+	const bool bNegative = ((bits >> 63) != 0);
+	if (((bits >> 52) & 0x7FF) == 0x7FF || (bits << 1) == 0)
+	{
+		// no representation for infinity/NaN: zero
+		result.fromLimbs(nullptr, 0, bNegative);
+		return result;
+	}
+
+	uint64_t digits = 0;
+	int nExponent = 0;
+	decimalShortest(value, digits, nExponent);
+	if (nExponent < 0)
+	{
+		result.fromLimbs(&digits, 1, bNegative, (size_t)(-nExponent));
+		return result;
+	}
+
+	std::vector<uint64_t> limbs(1, digits);
+	while (nExponent > 0)
+	{
+		const unsigned int nStep = (nExponent > 19) ? 19 : (unsigned int)nExponent;
+		uint64_t carry = limbMul1(&limbs[0], &limbs[0], limbs.size(), limbPow10(nStep));
+		if (carry != 0)
+		{
+			limbs.push_back(carry);
+		}
+		nExponent -= (int)nStep;
+	}
+	result.fromLimbs(&limbs[0], limbs.size(), bNegative);
+	return result;
+}
@@ -0,0 +1,43 @@
+/////////////////////////////////////
+//
+// BigFormat : shortest round-trip
+// decimal conversion of double.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Shortest digits that read back as same double
+// (and nearest to exact value when there are several),
+// by Schubfach algorithm (Giulietti):
+// single 64x128-bit multiply per boundary with table
+// of 128-bit powers of ten, no allocations per call.
+//
+
+#ifndef BIGFORMAT_H
+#define BIGFORMAT_H
+
+#include "BigValue.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+// large enough for any double: "-d.ddddddddddddddddde-324" and terminator
+const size_t BigFormatMaxLength = 32;
+
+// finite nonzero value as digits * 10^exponent (sign ignored),
+// digits has at most 17 decimal digits and no trailing zeros
+void decimalShortest(const double value, uint64_t &digits, int &exponent);
+
+// text of shortest digits, like "%.17g" but without redundant digits:
+// fixed notation when decimal exponent is in [-4, 17), otherwise scientific.
+// "nan", "inf" and "-inf" for specials.
+// buffer needs BigFormatMaxLength bytes, returns length without terminator
+size_t formatShortest(const double value, char *pBuffer);
+
+// value of shortest digits as CBigValue (scale for fraction digits):
+// exact decimal that is read back as same double
+CBigValue decimalValueShortest(const double value);
+
+#endif // BIGFORMAT_H
@@ -0,0 +1,83 @@
+// BigFormatBench.cpp : doubles per second of shortest formatting
+// against "%.17g" and std::to_chars.
+//
+// usage: BigFormatBench [count]
+//
+
+#include "BigFormat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <charconv>
+
+
+int main(int argc, char* argv[])
+{
+	size_t nCount = 1000000;
+	if (argc > 1)
+	{
+		nCount = (size_t)strtoull(argv[1], nullptr, 10);
+	}
+
+	// random finite bit patterns: all exponents equally likely
+	std::mt19937_64 rng(12345);
+	std::vector<double> values(nCount);
+	for (size_t i = 0; i < nCount; i++)
+	{
+		uint64_t bits = rng();
+		if (((bits >> 52) & 0x7FF) == 0x7FF)
+		{
+			bits ^= 1ULL << 62;
+		}
+		::memcpy(&values[i], &bits, sizeof(bits));
+	}
+
+	char buffer[64];
+	size_t nTotal = 0;
+	printf("%zu doubles\n", nCount);
+	printf("%-14s %12s %14s %10s\n", "method", "seconds", "doubles/sec", "chars");
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < nCount; i++)
+	{
+		nTotal += formatShortest(values[i], buffer);
+	}
+	double dSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("%-14s %12.3f %14.0f %10zu\n", "formatShortest", dSeconds, (double)nCount / dSeconds, nTotal);
+
+	nTotal = 0;
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < nCount; i++)
+	{
+		nTotal += (size_t)snprintf(buffer, sizeof(buffer), "%.17g", values[i]);
+	}
+	dSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("%-14s %12.3f %14.0f %10zu\n", "%.17g", dSeconds, (double)nCount / dSeconds, nTotal);
+
+	nTotal = 0;
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < nCount; i++)
+	{
+		std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), values[i]);
+		nTotal += (size_t)(result.ptr - buffer);
+	}
+	dSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("%-14s %12.3f %14.0f %10zu\n", "to_chars", dSeconds, (double)nCount / dSeconds, nTotal);
+
+	// round trip check of shortest output
+	size_t nBad = 0;
+	for (size_t i = 0; i < nCount; i++)
+	{
+		formatShortest(values[i], buffer);
+		if (strtod(buffer, nullptr) != values[i])
+		{
+			nBad++;
+		}
+	}
+	printf("round trip failures: %zu\n", nBad);
+	return 0;
+}
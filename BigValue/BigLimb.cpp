@@ -0,0 +1,1104 @@
+/////////////////////////////////////
+//
+// BigLimb : low-level kernels on the
+// magnitude buffers used by CBigValue.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Buffers are little-endian byte arrays of any size,
+// kernels handle them as 64-bit limbs internally.
+//
+// Multi-limb shifts are a single pass over memory for any bit count:
+// limb-offset is folded into load-address and remaining bit-count
+// is funnel-shifted between two neighbouring limbs.
+// With AVX2 four limbs are done at a time: two unaligned loads
+// offset by one limb give "this" and "neighbour" limbs in each lane.
+//
+// Multiply-rows (limbMul1, limbAddMul1) under multiplication are
+// selected at runtime: with BMI2 and ADX mulx leaves flags alone
+// so that adcx (carry from previous row-limb) and adox (sum to destination)
+// run as two independent carry chains instead of serializing on one flag.
+// Kernel is selected on first call and called through pointer after that.
+//
+// With AVX2 longer additions (limbAddN) add four limbs lane by lane
+// and resolve carries between lanes from bit masks: lanes that wrapped
+// generate a carry and lanes of all ones propagate one, integer addition
+// of those masks carries through runs of propagating lanes (prefix scan)
+// so that serial dependency is one addition per vector instead of per limb.
+//
+// Three half-size products of large Karatsuba steps are independent
+// and run as tasks of current pool (TaskPool.h), recursion below
+// them forks again so all workers are busy in big multiplications.
+//
+
+#include "BigLimb.h"
+#include "../simplesse/CpuFeatures.h"
+#include "../simplesse/SimdInt.h"
+#include "../simplesse/TaskPool.h"
+
+#include <string.h>
+#include <vector>
+#include <atomic>
+
+#if defined(__AVX2__) || (defined(_MSC_VER) && defined(_M_X64))
+#include <immintrin.h>
+#endif
+
+
+////////// helpers
+
+static const uint64_t s_Pow10Limb[20] =
+{
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL,
+	100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+	10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+	1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+static inline size_t limbCount(const size_t nSize)
+{
+	return (nSize + 7) / 8;
+}
+
+// load limb by index, zero outside of buffer,
+// partial last limb is zero-extended
+static inline uint64_t loadLimb(const uint8_t *pData, const size_t nSize, const ptrdiff_t nIndex)
+{
+	if (nIndex < 0)
+	{
+		return 0;
+	}
+	size_t nPos = ((size_t)nIndex) * 8;
+	if (nPos >= nSize)
+	{
+		return 0;
+	}
+
+	uint64_t value = 0;
+	size_t nCount = nSize - nPos;
+	if (nCount > 8)
+	{
+		nCount = 8;
+	}
+	::memcpy(&value, pData + nPos, nCount);
+	return value;
+}
+
+// store limb by index, partial last limb is truncated
+static inline void storeLimb(uint8_t *pData, const size_t nSize, const ptrdiff_t nIndex, const uint64_t value)
+{
+	size_t nPos = ((size_t)nIndex) * 8;
+	size_t nCount = nSize - nPos;
+	if (nCount > 8)
+	{
+		nCount = 8;
+	}
+	::memcpy(pData + nPos, &value, nCount);
+}
+
+static inline size_t popCount64(const uint64_t value)
+{
+#if defined(_MSC_VER)
+	return (size_t)__popcnt64(value);
+#else
+	return (size_t)__builtin_popcountll(value);
+#endif
+}
+
+static inline unsigned int leadingZeros64(uint64_t value)
+{
+	unsigned int nCount = 0;
+	if (value == 0)
+	{
+		return 64;
+	}
+	while ((value & (1ULL << 63)) == 0)
+	{
+		value <<= 1;
+		nCount++;
+	}
+	return nCount;
+}
+
+static inline size_t bitLength8(const uint8_t value)
+{
+	size_t nBits = 0;
+	uint32_t v = value;
+	while (v != 0)
+	{
+		nBits++;
+		v >>= 1;
+	}
+	return nBits;
+}
+
+// note: two lanes of SSE2 are slower than scalar carry chain
+#if defined(SIMDVEC_AVX2)
+#define LIMB_VECTOR_ADD
+
+typedef avxInt64x4 LimbLanes;
+
+// shorter operand from this many limbs: vector addition
+// (below that mask handling costs more than it saves)
+static const size_t s_nVectorAddLimit = 32;
+
+// destination = A + B + carry for whole vectors of limbs, returns carry out.
+// in-place is allowed (pDst == pA or pDst == pB).
+static uint64_t addLimbVectors(uint64_t *pDst, const uint64_t *pA, const uint64_t *pB, const size_t nVectors, uint64_t carry)
+{
+	const unsigned int nLanes = LimbLanes::Lanes;
+	const unsigned int nLaneMask = (1u << nLanes) - 1;
+	const LimbLanes ones(~0ULL);
+	for (size_t v = 0; v < nVectors; v++)
+	{
+		const LimbLanes a = LimbLanes::loadUnaligned(pA + v * nLanes);
+		const LimbLanes b = LimbLanes::loadUnaligned(pB + v * nLanes);
+		const LimbLanes sum = a + b;
+		const unsigned int nGenerate = LimbLanes::carryMask(a, b, sum);
+		const unsigned int nPropagate = LimbLanes::equal(sum, ones).mask();
+
+		// lanes taking carry in are bits changed by addition,
+		// bit above lanes is carry out
+		const unsigned int nCarries = (nGenerate << 1) + nPropagate + (unsigned int)carry;
+		const unsigned int nIncrement = (nCarries ^ nPropagate) & nLaneMask;
+		(sum - LimbLanes::fromMask(nIncrement)).storeUnaligned(pDst + v * nLanes);
+		carry = nCarries >> nLanes;
+	}
+	return carry;
+}
+
+#endif
+
+
+////////// queries
+
+uint64_t limbPow10(const unsigned int n)
+{
+	return s_Pow10Limb[n];
+}
+
+size_t limbUsedSize(const uint8_t *pData, const size_t nSize)
+{
+	size_t n = nSize;
+
+	// skip whole zero-limbs from top first
+	while (n >= 8)
+	{
+		uint64_t value = 0;
+		::memcpy(&value, pData + n - 8, 8);
+		if (value != 0)
+		{
+			break;
+		}
+		n -= 8;
+	}
+
+	while (n > 0 && pData[n - 1] == 0)
+	{
+		n--;
+	}
+	return n;
+}
+
+size_t limbBitLength(const uint8_t *pData, const size_t nSize)
+{
+	size_t nUsed = limbUsedSize(pData, nSize);
+	if (nUsed == 0)
+	{
+		return 0;
+	}
+	return ((nUsed - 1) * 8) + bitLength8(pData[nUsed - 1]);
+}
+
+size_t limbPopCount(const uint8_t *pData, const size_t nSize)
+{
+	size_t nCount = 0;
+	const ptrdiff_t nLimbs = (ptrdiff_t)limbCount(nSize);
+	for (ptrdiff_t i = 0; i < nLimbs; i++)
+	{
+		nCount += popCount64(loadLimb(pData, nSize, i));
+	}
+	return nCount;
+}
+
+int limbCompare(const uint8_t *pA, const size_t nASize, const uint8_t *pB, const size_t nBSize)
+{
+	size_t nA = limbUsedSize(pA, nASize);
+	size_t nB = limbUsedSize(pB, nBSize);
+	if (nA != nB)
+	{
+		return (nA < nB) ? -1 : 1;
+	}
+
+	// same used size: same limb count and partial top
+	ptrdiff_t i = (ptrdiff_t)limbCount(nA) - 1;
+	for (; i >= 0; i--)
+	{
+		uint64_t a = loadLimb(pA, nA, i);
+		uint64_t b = loadLimb(pB, nB, i);
+		if (a != b)
+		{
+			return (a < b) ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+
+////////// arithmetic
+
+void limbMulWord(uint8_t *pDst, const size_t nDstSize, const uint8_t *pSrc, const size_t nSrcSize, const uint64_t nMul)
+{
+	uint64_t carry = 0;
+	const ptrdiff_t nDstLimbs = (ptrdiff_t)limbCount(nDstSize);
+	for (ptrdiff_t i = 0; i < nDstLimbs; i++)
+	{
+		uint64_t high = 0;
+		uint64_t low = limbMul64(loadLimb(pSrc, nSrcSize, i), nMul, &high);
+		low += carry;
+		high += (low < carry) ? 1 : 0;
+		storeLimb(pDst, nDstSize, i, low);
+		carry = high;
+	}
+}
+
+uint64_t limbModM61(const uint8_t *pData, const size_t nSize)
+{
+	const uint64_t nPrime = (1ULL << 61) - 1;
+
+	// horner from top: h = h * 2^64 + limb,
+	// where 2^64 = 8 (mod 2^61-1)
+	uint64_t h = 0;
+	for (ptrdiff_t i = (ptrdiff_t)limbCount(nSize) - 1; i >= 0; i--)
+	{
+		uint64_t limb = loadLimb(pData, nSize, i);
+
+		// rotate h by 3 bits within 61 bits (= h*8 mod p),
+		// then fold limb in two parts to stay in range
+		uint64_t sum = ((h << 3) & nPrime) + (h >> 58);
+		sum += (limb & nPrime);
+		sum = (sum & nPrime) + (sum >> 61);
+		sum += (limb >> 61);
+		sum = (sum & nPrime) + (sum >> 61);
+		if (sum >= nPrime)
+		{
+			sum -= nPrime;
+		}
+		h = sum;
+	}
+	return h;
+}
+
+
+////////// shifts
+
+// out[j] = (in[j-q] << r) | (in[j-q-1] >> (64-r))
+// walks downwards so that in-place shift does not overwrite unread limbs
+void limbShiftLeft(uint8_t *pDst, const size_t nDstSize, const uint8_t *pSrc, const size_t nSrcSize, const size_t nBits)
+{
+	const ptrdiff_t q = (ptrdiff_t)(nBits / 64);
+	const unsigned int r = (unsigned int)(nBits % 64);
+	const ptrdiff_t nDstLimbs = (ptrdiff_t)limbCount(nDstSize);
+
+	ptrdiff_t j = nDstLimbs - 1;
+
+#if defined(__AVX2__)
+	// block [j-3, j] reads whole source limbs [j-3-q-1, j-q]
+	// and stores whole destination limbs
+	const ptrdiff_t nDstFull = (ptrdiff_t)(nDstSize / 8);
+	const ptrdiff_t nSrcFull = (ptrdiff_t)(nSrcSize / 8);
+	ptrdiff_t nVecTop = nDstFull - 1;
+	if (nSrcFull - 1 + q < nVecTop)
+	{
+		nVecTop = nSrcFull - 1 + q;
+	}
+
+	for (; j >= 0 && j > nVecTop; j--)
+	{
+		uint64_t value = loadLimb(pSrc, nSrcSize, j - q) << r;
+		if (r != 0)
+		{
+			value |= (loadLimb(pSrc, nSrcSize, j - q - 1) >> (64 - r));
+		}
+		storeLimb(pDst, nDstSize, j, value);
+	}
+
+	// note: shift count of 64 gives zero for whole lane
+	// -> no special case needed when r == 0
+	const __m128i countLeft = _mm_cvtsi32_si128((int)r);
+	const __m128i countRight = _mm_cvtsi32_si128((int)(64 - r));
+	for (; (j - 3) >= (q + 1); j -= 4)
+	{
+		const ptrdiff_t j0 = j - 3;
+		__m256i hi = _mm256_loadu_si256((const __m256i*)(pSrc + (j0 - q) * 8));
+		__m256i lo = _mm256_loadu_si256((const __m256i*)(pSrc + (j0 - q - 1) * 8));
+		__m256i value = _mm256_or_si256(_mm256_sll_epi64(hi, countLeft), _mm256_srl_epi64(lo, countRight));
+		_mm256_storeu_si256((__m256i*)(pDst + j0 * 8), value);
+	}
+#endif
+
+	for (; j >= 0; j--)
+	{
+		uint64_t value = loadLimb(pSrc, nSrcSize, j - q) << r;
+		if (r != 0)
+		{
+			value |= (loadLimb(pSrc, nSrcSize, j - q - 1) >> (64 - r));
+		}
+		storeLimb(pDst, nDstSize, j, value);
+	}
+}
+
+// out[j] = (in[j+q] >> r) | (in[j+q+1] << (64-r))
+// walks upwards so that in-place shift does not overwrite unread limbs
+void limbShiftRight(uint8_t *pDst, const size_t nDstSize, const uint8_t *pSrc, const size_t nSrcSize, const size_t nBits)
+{
+	const ptrdiff_t q = (ptrdiff_t)(nBits / 64);
+	const unsigned int r = (unsigned int)(nBits % 64);
+	const ptrdiff_t nDstLimbs = (ptrdiff_t)limbCount(nDstSize);
+
+	ptrdiff_t j = 0;
+
+#if defined(__AVX2__)
+	// block [j, j+3] reads whole source limbs [j+q, j+q+4]
+	// and stores whole destination limbs
+	const ptrdiff_t nDstFull = (ptrdiff_t)(nDstSize / 8);
+	const ptrdiff_t nSrcFull = (ptrdiff_t)(nSrcSize / 8);
+	ptrdiff_t nVecEnd = nDstFull - 4;
+	if (nSrcFull - 5 - q < nVecEnd)
+	{
+		nVecEnd = nSrcFull - 5 - q;
+	}
+
+	const __m128i countRight = _mm_cvtsi32_si128((int)r);
+	const __m128i countLeft = _mm_cvtsi32_si128((int)(64 - r));
+	for (; j <= nVecEnd; j += 4)
+	{
+		__m256i lo = _mm256_loadu_si256((const __m256i*)(pSrc + (j + q) * 8));
+		__m256i hi = _mm256_loadu_si256((const __m256i*)(pSrc + (j + q + 1) * 8));
+		__m256i value = _mm256_or_si256(_mm256_srl_epi64(lo, countRight), _mm256_sll_epi64(hi, countLeft));
+		_mm256_storeu_si256((__m256i*)(pDst + j * 8), value);
+	}
+#endif
+
+	for (; j < nDstLimbs; j++)
+	{
+		uint64_t value = loadLimb(pSrc, nSrcSize, j + q) >> r;
+		if (r != 0)
+		{
+			value |= (loadLimb(pSrc, nSrcSize, j + q + 1) << (64 - r));
+		}
+		storeLimb(pDst, nDstSize, j, value);
+	}
+}
+
+
+////////// bitwise
+
+enum LimbBitOp
+{
+	LimbBitOpAnd,
+	LimbBitOpOr,
+	LimbBitOpXor
+};
+
+template <LimbBitOp op>
+static inline uint64_t applyBitOp(const uint64_t a, const uint64_t b)
+{
+	switch (op)
+	{
+	case LimbBitOpAnd:
+		return (a & b);
+	case LimbBitOpOr:
+		return (a | b);
+	case LimbBitOpXor:
+	default:
+		return (a ^ b);
+	}
+}
+
+template <LimbBitOp op>
+static void limbBitwise(uint8_t *pDst, const size_t nDstSize, const uint8_t *pA, const size_t nASize, const uint8_t *pB, const size_t nBSize)
+{
+	// whole limbs in all three: plain loop, compiler vectorizes this
+	size_t nCommon = nDstSize / 8;
+	if (nASize / 8 < nCommon)
+	{
+		nCommon = nASize / 8;
+	}
+	if (nBSize / 8 < nCommon)
+	{
+		nCommon = nBSize / 8;
+	}
+
+	for (size_t i = 0; i < nCommon; i++)
+	{
+		uint64_t a, b;
+		::memcpy(&a, pA + i * 8, 8);
+		::memcpy(&b, pB + i * 8, 8);
+		uint64_t value = applyBitOp<op>(a, b);
+		::memcpy(pDst + i * 8, &value, 8);
+	}
+
+	// rest: different sizes and partial limbs
+	const ptrdiff_t nDstLimbs = (ptrdiff_t)limbCount(nDstSize);
+	for (ptrdiff_t i = (ptrdiff_t)nCommon; i < nDstLimbs; i++)
+	{
+		uint64_t value = applyBitOp<op>(loadLimb(pA, nASize, i), loadLimb(pB, nBSize, i));
+		storeLimb(pDst, nDstSize, i, value);
+	}
+}
+
+void limbAnd(uint8_t *pDst, const size_t nDstSize, const uint8_t *pA, const size_t nASize, const uint8_t *pB, const size_t nBSize)
+{
+	limbBitwise<LimbBitOpAnd>(pDst, nDstSize, pA, nASize, pB, nBSize);
+}
+
+void limbOr(uint8_t *pDst, const size_t nDstSize, const uint8_t *pA, const size_t nASize, const uint8_t *pB, const size_t nBSize)
+{
+	limbBitwise<LimbBitOpOr>(pDst, nDstSize, pA, nASize, pB, nBSize);
+}
+
+void limbXor(uint8_t *pDst, const size_t nDstSize, const uint8_t *pA, const size_t nASize, const uint8_t *pB, const size_t nBSize)
+{
+	limbBitwise<LimbBitOpXor>(pDst, nDstSize, pA, nASize, pB, nBSize);
+}
+
+
+////////// limb-array kernels
+
+// below this (smaller operand in limbs) schoolbook is faster
+static const size_t s_nKaratsubaThreshold = 32;
+
+// half size (limbs) from which Karatsuba products run as tasks:
+// product of half size takes over 100us, much more than fork and wakeup
+static const size_t s_nParallelMulLimit = 512;
+
+size_t limbNormN(const uint64_t *pA, const size_t nA)
+{
+	size_t n = nA;
+	while (n > 0 && pA[n - 1] == 0)
+	{
+		n--;
+	}
+	return n;
+}
+
+size_t limbBitLengthN(const uint64_t *pA, const size_t nA)
+{
+	size_t n = limbNormN(pA, nA);
+	if (n == 0)
+	{
+		return 0;
+	}
+	return (n * 64) - leadingZeros64(pA[n - 1]);
+}
+
+size_t limbTrailingZerosN(const uint64_t *pA, const size_t nA)
+{
+	for (size_t i = 0; i < nA; i++)
+	{
+		uint64_t value = pA[i];
+		if (value != 0)
+		{
+			size_t nCount = i * 64;
+			while ((value & 1) == 0)
+			{
+				value >>= 1;
+				nCount++;
+			}
+			return nCount;
+		}
+	}
+	return 0;
+}
+
+bool limbTestBitN(const uint64_t *pA, const size_t nA, const size_t nBit)
+{
+	size_t nIndex = nBit / 64;
+	if (nIndex >= nA)
+	{
+		return false;
+	}
+	return (((pA[nIndex] >> (nBit % 64)) & 1) != 0);
+}
+
+bool limbAnyBitsN(const uint64_t *pA, const size_t nA, const size_t nBits)
+{
+	size_t nWhole = nBits / 64;
+	for (size_t i = 0; i < nWhole && i < nA; i++)
+	{
+		if (pA[i] != 0)
+		{
+			return true;
+		}
+	}
+	if (nWhole < nA && (nBits % 64) != 0)
+	{
+		uint64_t mask = (1ULL << (nBits % 64)) - 1;
+		return ((pA[nWhole] & mask) != 0);
+	}
+	return false;
+}
+
+int limbCompareN(const uint64_t *pA, const size_t nA, const uint64_t *pB, const size_t nB)
+{
+	size_t nUsedA = limbNormN(pA, nA);
+	size_t nUsedB = limbNormN(pB, nB);
+	if (nUsedA != nUsedB)
+	{
+		return (nUsedA < nUsedB) ? -1 : 1;
+	}
+	for (size_t i = nUsedA; i > 0; i--)
+	{
+		if (pA[i - 1] != pB[i - 1])
+		{
+			return (pA[i - 1] < pB[i - 1]) ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+uint64_t limbAddN(uint64_t *pDst, const uint64_t *pA, const size_t nA, const uint64_t *pB, const size_t nB)
+{
+	uint64_t carry = 0;
+	size_t i = 0;
+#if defined(LIMB_VECTOR_ADD)
+	if (nB >= s_nVectorAddLimit)
+	{
+		const size_t nVectors = nB / LimbLanes::Lanes;
+		carry = addLimbVectors(pDst, pA, pB, nVectors, 0);
+		i = nVectors * LimbLanes::Lanes;
+	}
+#endif
+	for (; i < nB; i++)
+	{
+		uint64_t a = pA[i];
+		uint64_t sum = a + pB[i];
+		uint64_t carryOut = (sum < a) ? 1 : 0;
+		sum += carry;
+		carryOut += (sum < carry) ? 1 : 0;
+		pDst[i] = sum;
+		carry = carryOut;
+	}
+	for (; i < nA; i++)
+	{
+		if (carry == 0 && pDst == pA)
+		{
+			// in-place and nothing left to propagate
+			return 0;
+		}
+		uint64_t sum = pA[i] + carry;
+		carry = (sum < carry) ? 1 : 0;
+		pDst[i] = sum;
+	}
+	return carry;
+}
+
+uint64_t limbSubN(uint64_t *pDst, const uint64_t *pA, const size_t nA, const uint64_t *pB, const size_t nB)
+{
+	uint64_t borrow = 0;
+	size_t i = 0;
+	for (; i < nB; i++)
+	{
+		uint64_t a = pA[i];
+		uint64_t diff = a - pB[i];
+		uint64_t borrowOut = (diff > a) ? 1 : 0;
+		uint64_t result = diff - borrow;
+		borrowOut += (result > diff) ? 1 : 0;
+		pDst[i] = result;
+		borrow = borrowOut;
+	}
+	for (; i < nA; i++)
+	{
+		if (borrow == 0 && pDst == pA)
+		{
+			// in-place and nothing left to propagate
+			return 0;
+		}
+		uint64_t a = pA[i];
+		pDst[i] = a - borrow;
+		borrow = (a < borrow) ? 1 : 0;
+	}
+	return borrow;
+}
+
+// portable versions
+static uint64_t mul1Generic(uint64_t *pDst, const uint64_t *pA, const size_t n, const uint64_t nMul)
+{
+	uint64_t carry = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		uint64_t high = 0;
+		uint64_t low = limbMul64(pA[i], nMul, &high);
+		low += carry;
+		high += (low < carry) ? 1 : 0;
+		pDst[i] = low;
+		carry = high;
+	}
+	return carry;
+}
+
+static uint64_t addMul1Generic(uint64_t *pDst, const uint64_t *pA, const size_t n, const uint64_t nMul)
+{
+	uint64_t carry = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		uint64_t high = 0;
+		uint64_t low = limbMul64(pA[i], nMul, &high);
+		low += carry;
+		high += (low < carry) ? 1 : 0;
+		uint64_t sum = pDst[i] + low;
+		high += (sum < low) ? 1 : 0;
+		pDst[i] = sum;
+		carry = high;
+	}
+	return carry;
+}
+
+// BMI2 (mulx) and ADX (adcx, adox) versions:
+// only called when CPU has those, no compiler flags needed
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LIMB_MULX_KERNELS
+
+// note: loop counter is decremented by lea and tested by jrcxz
+// since dec/sub would overwrite overflow-flag used by adox
+static uint64_t mul1Mulx(uint64_t *pDst, const uint64_t *pA, const size_t n, const uint64_t nMul)
+{
+	if (n == 0)
+	{
+		return 0;
+	}
+	uint64_t carry = 0;
+	uint64_t zero;
+	uint64_t low;
+	uint64_t high;
+	size_t count = n;
+	__asm__ __volatile__ (
+		"xorl %k[zero], %k[zero]\n\t"
+		"1:\n\t"
+		"mulx (%[a]), %[low], %[high]\n\t"
+		"adcx %[carry], %[low]\n\t"
+		"movq %[low], (%[dst])\n\t"
+		"movq %[high], %[carry]\n\t"
+		"leaq 8(%[a]), %[a]\n\t"
+		"leaq 8(%[dst]), %[dst]\n\t"
+		"leaq -1(%%rcx), %%rcx\n\t"
+		"jrcxz 2f\n\t"
+		"jmp 1b\n"
+		"2:\n\t"
+		"adcx %[zero], %[carry]\n\t"
+		: [carry] "+&r" (carry), [zero] "=&r" (zero), [low] "=&r" (low), [high] "=&r" (high),
+		  [a] "+&r" (pA), [dst] "+&r" (pDst), "+&c" (count)
+		: "d" (nMul)
+		: "cc", "memory");
+	return carry;
+}
+
+static uint64_t addMul1Mulx(uint64_t *pDst, const uint64_t *pA, const size_t n, const uint64_t nMul)
+{
+	if (n == 0)
+	{
+		return 0;
+	}
+	uint64_t carry = 0;
+	uint64_t zero;
+	uint64_t low;
+	uint64_t high;
+	size_t count = n;
+	__asm__ __volatile__ (
+		"xorl %k[zero], %k[zero]\n\t"
+		"1:\n\t"
+		"mulx (%[a]), %[low], %[high]\n\t"
+		"adcx %[carry], %[low]\n\t"
+		"adox (%[dst]), %[low]\n\t"
+		"movq %[low], (%[dst])\n\t"
+		"movq %[high], %[carry]\n\t"
+		"leaq 8(%[a]), %[a]\n\t"
+		"leaq 8(%[dst]), %[dst]\n\t"
+		"leaq -1(%%rcx), %%rcx\n\t"
+		"jrcxz 2f\n\t"
+		"jmp 1b\n"
+		"2:\n\t"
+		"adcx %[zero], %[carry]\n\t"
+		"adox %[zero], %[carry]\n\t"
+		: [carry] "+&r" (carry), [zero] "=&r" (zero), [low] "=&r" (low), [high] "=&r" (high),
+		  [a] "+&r" (pA), [dst] "+&r" (pDst), "+&c" (count)
+		: "d" (nMul)
+		: "cc", "memory");
+	return carry;
+}
+
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define LIMB_MULX_KERNELS
+
+// note: no inline assembly on x64 with MSVC,
+// intrinsics give same instructions
+static uint64_t mul1Mulx(uint64_t *pDst, const uint64_t *pA, const size_t n, const uint64_t nMul)
+{
+	uint64_t carry = 0;
+	unsigned char cf = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		unsigned __int64 high = 0;
+		unsigned __int64 low = _mulx_u64(pA[i], nMul, &high);
+		cf = _addcarryx_u64(cf, low, carry, &low);
+		pDst[i] = low;
+		carry = high;
+	}
+	return carry + cf;
+}
+
+static uint64_t addMul1Mulx(uint64_t *pDst, const uint64_t *pA, const size_t n, const uint64_t nMul)
+{
+	uint64_t carry = 0;
+	unsigned char cf = 0;
+	unsigned char of = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		unsigned __int64 high = 0;
+		unsigned __int64 low = _mulx_u64(pA[i], nMul, &high);
+		cf = _addcarryx_u64(cf, low, carry, &low);
+		of = _addcarryx_u64(of, low, pDst[i], &low);
+		pDst[i] = low;
+		carry = high;
+	}
+	return carry + cf + of;
+}
+
+#endif
+
+
+////////// kernel dispatch
+
+typedef uint64_t (*LimbMulRowFunc)(uint64_t *pDst, const uint64_t *pA, const size_t n, const uint64_t nMul);
+
+static uint64_t mul1Resolve(uint64_t *pDst, const uint64_t *pA, const size_t n, const uint64_t nMul);
+static uint64_t addMul1Resolve(uint64_t *pDst, const uint64_t *pA, const size_t n, const uint64_t nMul);
+
+// note: constant-initialized so that calls during static initialization
+// (other translation units) also resolve first
+static std::atomic<LimbMulRowFunc> s_pMul1(mul1Resolve);
+static std::atomic<LimbMulRowFunc> s_pAddMul1(addMul1Resolve);
+static std::atomic<const char*> s_szKernelName("generic");
+
+static uint64_t mul1Resolve(uint64_t *pDst, const uint64_t *pA, const size_t n, const uint64_t nMul)
+{
+	limbSelectKernels();
+	return s_pMul1.load(std::memory_order_relaxed)(pDst, pA, n, nMul);
+}
+
+static uint64_t addMul1Resolve(uint64_t *pDst, const uint64_t *pA, const size_t n, const uint64_t nMul)
+{
+	limbSelectKernels();
+	return s_pAddMul1.load(std::memory_order_relaxed)(pDst, pA, n, nMul);
+}
+
+void limbSelectKernels()
+{
+	LimbMulRowFunc pMul1 = mul1Generic;
+	LimbMulRowFunc pAddMul1 = addMul1Generic;
+	const char *szName = "generic";
+
+#if defined(LIMB_MULX_KERNELS)
+	if (cpuHasFeature(CpuFeatureBMI2) == true && cpuHasFeature(CpuFeatureADX) == true)
+	{
+		pMul1 = mul1Mulx;
+		pAddMul1 = addMul1Mulx;
+		szName = "mulx-adx";
+	}
+#endif
+
+	s_pMul1.store(pMul1, std::memory_order_relaxed);
+	s_pAddMul1.store(pAddMul1, std::memory_order_relaxed);
+	s_szKernelName.store(szName, std::memory_order_relaxed);
+}
+
+const char* limbKernelName()
+{
+	return s_szKernelName.load(std::memory_order_relaxed);
+}
+
+uint64_t limbMul1(uint64_t *pDst, const uint64_t *pA, const size_t n, const uint64_t nMul)
+{
+	return s_pMul1.load(std::memory_order_relaxed)(pDst, pA, n, nMul);
+}
+
+uint64_t limbAddMul1(uint64_t *pDst, const uint64_t *pA, const size_t n, const uint64_t nMul)
+{
+	return s_pAddMul1.load(std::memory_order_relaxed)(pDst, pA, n, nMul);
+}
+
+// nA >= nB > 0
+static void mulBasecase(uint64_t *pDst, const uint64_t *pA, const size_t nA, const uint64_t *pB, const size_t nB)
+{
+	pDst[nA] = limbMul1(pDst, pA, nA, pB[0]);
+	for (size_t j = 1; j < nB; j++)
+	{
+		pDst[nA + j] = limbAddMul1(pDst + j, pA, nA, pB[j]);
+	}
+}
+
+// nA >= 2*nB: cut longer one to pieces of nB limbs
+// so that each partial product is balanced
+static void mulUnbalanced(uint64_t *pDst, const uint64_t *pA, const size_t nA, const uint64_t *pB, const size_t nB)
+{
+	::memset(pDst, 0, (nA + nB) * sizeof(uint64_t));
+
+	std::vector<uint64_t> partial(2 * nB);
+	for (size_t i = 0; i < nA; i += nB)
+	{
+		size_t nChunk = (nA - i < nB) ? (nA - i) : nB;
+		limbMulN(&partial[0], pA + i, nChunk, pB, nB);
+		limbAddN(pDst + i, pDst + i, nA + nB - i, &partial[0], nChunk + nB);
+	}
+}
+
+// nB <= nA < 2*nB:
+// A = a1*X + a0, B = b1*X + b0 where X = 2^(64*m)
+// A*B = z2*X^2 + ((a0+a1)(b0+b1) - z0 - z2)*X + z0
+static void mulKaratsuba(uint64_t *pDst, const uint64_t *pA, const size_t nA, const uint64_t *pB, const size_t nB)
+{
+	const size_t m = (nA + 1) / 2;
+	const size_t nA1 = nA - m;
+	const size_t nB1 = nB - m;
+
+	// z0 to low part, z2 to high part of destination
+	auto lowProduct = [=]() { limbMulN(pDst, pA, m, pB, m); };
+	auto highProduct = [=]() { limbMulN(pDst + 2 * m, pA + m, nA1, pB + m, nB1); };
+
+	std::vector<uint64_t> middle(2 * (m + 1));
+	auto middleProduct = [=, &middle]()
+	{
+		std::vector<uint64_t> sums(2 * (m + 1));
+		uint64_t *pSumA = &sums[0];
+		uint64_t *pSumB = &sums[m + 1];
+		pSumA[m] = limbAddN(pSumA, pA, m, pA + m, nA1);
+		pSumB[m] = limbAddN(pSumB, pB, m, pB + m, nB1);
+		limbMulN(&middle[0], pSumA, m + 1, pSumB, m + 1);
+	};
+
+	if (m >= s_nParallelMulLimit)
+	{
+		parallelInvoke(middleProduct, lowProduct, highProduct);
+	}
+	else
+	{
+		lowProduct();
+		highProduct();
+		middleProduct();
+	}
+
+	limbSubN(&middle[0], &middle[0], middle.size(), pDst, 2 * m);
+	limbSubN(&middle[0], &middle[0], middle.size(), pDst + 2 * m, nA1 + nB1);
+
+	size_t nMiddle = limbNormN(&middle[0], middle.size());
+	limbAddN(pDst + m, pDst + m, nA + nB - m, &middle[0], nMiddle);
+}
+
+void limbMulN(uint64_t *pDst, const uint64_t *pA, const size_t nA, const uint64_t *pB, const size_t nB)
+{
+	if (nA < nB)
+	{
+		limbMulN(pDst, pB, nB, pA, nA);
+		return;
+	}
+
+	if (nB == 0)
+	{
+		::memset(pDst, 0, nA * sizeof(uint64_t));
+		return;
+	}
+
+	if (nB < s_nKaratsubaThreshold)
+	{
+		mulBasecase(pDst, pA, nA, pB, nB);
+	}
+	else if (nA >= 2 * nB)
+	{
+		mulUnbalanced(pDst, pA, nA, pB, nB);
+	}
+	else
+	{
+		mulKaratsuba(pDst, pA, nA, pB, nB);
+	}
+}
+
+uint64_t limbSubMul1(uint64_t *pDst, const uint64_t *pA, const size_t n, const uint64_t nMul)
+{
+	uint64_t borrow = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		uint64_t high = 0;
+		uint64_t low = limbMul64(pA[i], nMul, &high);
+		low += borrow;
+		high += (low < borrow) ? 1 : 0;
+		uint64_t value = pDst[i];
+		pDst[i] = value - low;
+		high += (value < low) ? 1 : 0;
+		borrow = high;
+	}
+	return borrow;
+}
+
+
+void limbDivRemN(uint64_t *pQuot, uint64_t *pRem, const uint64_t *pA, const size_t nA, const uint64_t *pB, const size_t nB)
+{
+	if (nB == 1)
+	{
+		// single limb divisor: one pass from top
+		uint64_t remainder = 0;
+		for (size_t i = nA; i > 0; i--)
+		{
+			uint64_t quotient = limbDiv128(remainder, pA[i - 1], pB[0], &remainder);
+			if (pQuot != nullptr)
+			{
+				pQuot[i - 1] = quotient;
+			}
+		}
+		if (pRem != nullptr)
+		{
+			pRem[0] = remainder;
+		}
+		return;
+	}
+
+	// normalize so that top bit of divisor is set:
+	// then estimate from top limbs is off by at most two
+	const unsigned int nShift = leadingZeros64(pB[nB - 1]);
+	std::vector<uint64_t> un(nA + 1);
+	std::vector<uint64_t> vn(nB);
+	limbShiftLeft((uint8_t*)&vn[0], nB * 8, (const uint8_t*)pB, nB * 8, nShift);
+	limbShiftLeft((uint8_t*)&un[0], (nA + 1) * 8, (const uint8_t*)pA, nA * 8, nShift);
+
+	const uint64_t vTop = vn[nB - 1];
+	const uint64_t vNext = vn[nB - 2];
+	for (size_t j = nA - nB + 1; j > 0; j--)
+	{
+		const size_t k = j - 1;
+		const uint64_t uTop = un[k + nB];
+		const uint64_t uNext = un[k + nB - 1];
+
+		uint64_t qhat = 0;
+		uint64_t rhat = 0;
+		bool bRhatOverflow = false;
+		if (uTop >= vTop)
+		{
+			qhat = ~0ULL;
+			rhat = uNext + vTop;
+			bRhatOverflow = (rhat < vTop);
+		}
+		else
+		{
+			qhat = limbDiv128(uTop, uNext, vTop, &rhat);
+		}
+
+		// refine with second limb of divisor
+		while (bRhatOverflow == false)
+		{
+			uint64_t productHigh = 0;
+			uint64_t productLow = limbMul64(qhat, vNext, &productHigh);
+			if (productHigh > rhat
+				|| (productHigh == rhat && productLow > un[k + nB - 2]))
+			{
+				qhat--;
+				rhat += vTop;
+				bRhatOverflow = (rhat < vTop);
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		// multiply and subtract, add back if estimate was one too large
+		uint64_t borrow = limbSubMul1(&un[k], &vn[0], nB, qhat);
+		un[k + nB] = uTop - borrow;
+		if (uTop < borrow)
+		{
+			qhat--;
+			uint64_t carry = limbAddN(&un[k], &un[k], nB, &vn[0], nB);
+			un[k + nB] += carry;
+		}
+
+		if (pQuot != nullptr)
+		{
+			pQuot[k] = qhat;
+		}
+	}
+
+	if (pRem != nullptr)
+	{
+		limbShiftRight((uint8_t*)pRem, nB * 8, (const uint8_t*)&un[0], nB * 8, nShift);
+	}
+}
+
+// binary gcd of single limbs (Stein): no divisions
+static uint64_t gcd64(uint64_t a, uint64_t b)
+{
+	if (a == 0 || b == 0)
+	{
+		return a | b;
+	}
+	size_t nShift = limbTrailingZerosN(&a, 1);
+	const size_t nShiftB = limbTrailingZerosN(&b, 1);
+	a >>= nShift;
+	b >>= nShiftB;
+	if (nShiftB < nShift)
+	{
+		nShift = nShiftB;
+	}
+	while (a != b)
+	{
+		if (a > b)
+		{
+			const uint64_t t = a;
+			a = b;
+			b = t;
+		}
+		b -= a;
+		b >>= limbTrailingZerosN(&b, 1);
+	}
+	return a << nShift;
+}
+
+size_t limbGcdN(uint64_t *pDst, const uint64_t *pA, const size_t nA, const uint64_t *pB, const size_t nB)
+{
+	std::vector<uint64_t> u(pA, pA + limbNormN(pA, nA));
+	std::vector<uint64_t> v(pB, pB + limbNormN(pB, nB));
+	std::vector<uint64_t> r;
+
+	// gcd(0, b) = b
+	if (u.empty() == true)
+	{
+		u.swap(v);
+	}
+
+	// larger first, then replace with remainders
+	while (v.empty() == false)
+	{
+		if (limbCompareN(u.data(), u.size(), &v[0], v.size()) < 0)
+		{
+			u.swap(v);
+		}
+		if (u.size() == 1)
+		{
+			u[0] = gcd64(u[0], v[0]);
+			v.clear();
+			break;
+		}
+
+		r.resize(v.size());
+		limbDivRemN(nullptr, &r[0], &u[0], u.size(), &v[0], v.size());
+		r.resize(limbNormN(&r[0], r.size()));
+		u.swap(v);
+		v.swap(r);
+	}
+
+	if (u.empty() == false)
+	{
+		::memcpy(pDst, &u[0], u.size() * sizeof(uint64_t));
+	}
+	return u.size();
+}
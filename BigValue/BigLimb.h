@@ -0,0 +1,162 @@
+/////////////////////////////////////
+//
+// BigLimb : low-level kernels on the
+// magnitude buffers used by CBigValue.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Buffers are little-endian byte arrays of any size,
+// kernels handle them as 64-bit limbs internally
+// (loads/stores through memcpy so alignment and partial
+// last limb are not a concern for the caller).
+//
+// Arithmetic kernels ("N"-suffix) work on arrays of 64-bit limbs
+// (least significant first) where sizes are given in limbs.
+//
+// Note: assumes little-endian host (as does CBigValue
+// when it takes native values apart byte-by-byte).
+//
+
+#ifndef BIGLIMB_H
+#define BIGLIMB_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+// full 64x64 -> 128 bit product, returns low part
+static inline uint64_t limbMul64(const uint64_t a, const uint64_t b, uint64_t *pHigh)
+{
+#if defined(_MSC_VER)
+	return _umul128(a, b, pHigh);
+#else
+	unsigned __int128 product = (unsigned __int128)a * b;
+	*pHigh = (uint64_t)(product >> 64);
+	return (uint64_t)product;
+#endif
+}
+
+// (hi:lo) / divisor, requires hi < divisor, returns quotient
+static inline uint64_t limbDiv128(const uint64_t hi, const uint64_t lo, const uint64_t divisor, uint64_t *pRemainder)
+{
+#if defined(_MSC_VER)
+	return _udiv128(hi, lo, divisor, pRemainder);
+#else
+	unsigned __int128 dividend = (((unsigned __int128)hi) << 64) | lo;
+	*pRemainder = (uint64_t)(dividend % divisor);
+	return (uint64_t)(dividend / divisor);
+#endif
+}
+
+// 10^n for n <= 19 (largest power of ten in single limb)
+uint64_t limbPow10(const unsigned int n);
+
+// size without high zero-bytes
+size_t limbUsedSize(const uint8_t *pData, const size_t nSize);
+
+// highest set bit +1, zero for zero-value
+size_t limbBitLength(const uint8_t *pData, const size_t nSize);
+
+// count of set bits
+size_t limbPopCount(const uint8_t *pData, const size_t nSize);
+
+// shift to higher bits: every byte of destination is written
+// (zero-filled below shift, source truncated above destination).
+// in-place is allowed (pDst == pSrc).
+void limbShiftLeft(uint8_t *pDst, const size_t nDstSize, const uint8_t *pSrc, const size_t nSrcSize, const size_t nBits);
+
+// shift to lower bits: every byte of destination is written
+// (zero-filled above remaining source bits).
+// in-place is allowed (pDst == pSrc).
+void limbShiftRight(uint8_t *pDst, const size_t nDstSize, const uint8_t *pSrc, const size_t nSrcSize, const size_t nBits);
+
+// compare magnitudes: normalized size first,
+// then limbs from most significant down until first difference.
+// returns -1, 0 or 1
+int limbCompare(const uint8_t *pA, const size_t nASize, const uint8_t *pB, const size_t nBSize);
+
+// destination = source * multiplier (truncated to destination size),
+// every byte of destination is written.
+// in-place is allowed (pDst == pSrc).
+void limbMulWord(uint8_t *pDst, const size_t nDstSize, const uint8_t *pSrc, const size_t nSrcSize, const uint64_t nMul);
+
+// remainder of magnitude by Mersenne-prime 2^61-1, single pass
+uint64_t limbModM61(const uint8_t *pData, const size_t nSize);
+
+// bitwise operations, shorter operand is zero-extended,
+// every byte of destination is written.
+// in-place is allowed (pDst == pA or pDst == pB).
+void limbAnd(uint8_t *pDst, const size_t nDstSize, const uint8_t *pA, const size_t nASize, const uint8_t *pB, const size_t nBSize);
+void limbOr(uint8_t *pDst, const size_t nDstSize, const uint8_t *pA, const size_t nASize, const uint8_t *pB, const size_t nBSize);
+void limbXor(uint8_t *pDst, const size_t nDstSize, const uint8_t *pA, const size_t nASize, const uint8_t *pB, const size_t nBSize);
+
+
+
+////////// limb-array kernels
+
+// limb count without high zero-limbs
+size_t limbNormN(const uint64_t *pA, const size_t nA);
+
+// highest set bit +1, zero for zero-value
+size_t limbBitLengthN(const uint64_t *pA, const size_t nA);
+
+// count of zero-bits below lowest set bit (zero for zero-value)
+size_t limbTrailingZerosN(const uint64_t *pA, const size_t nA);
+
+// value of single bit, zero beyond array
+bool limbTestBitN(const uint64_t *pA, const size_t nA, const size_t nBit);
+
+// true if any of lowest nBits bits is set
+bool limbAnyBitsN(const uint64_t *pA, const size_t nA, const size_t nBits);
+
+// compare values (-1, 0, 1), sizes may differ
+int limbCompareN(const uint64_t *pA, const size_t nA, const uint64_t *pB, const size_t nB);
+
+// destination (nA limbs) = A + B, requires nA >= nB,
+// returns carry out. in-place is allowed (pDst == pA).
+uint64_t limbAddN(uint64_t *pDst, const uint64_t *pA, const size_t nA, const uint64_t *pB, const size_t nB);
+
+// destination (nA limbs) = A - B, requires nA >= nB,
+// returns borrow out. in-place is allowed (pDst == pA).
+uint64_t limbSubN(uint64_t *pDst, const uint64_t *pA, const size_t nA, const uint64_t *pB, const size_t nB);
+
+// select multiply-row kernels for features of CPU
+// (done on first call, again only after cpuLimitTier())
+void limbSelectKernels();
+
+// name of selected multiply-row kernels
+const char* limbKernelName();
+
+// destination (n limbs) = A * multiplier, returns high limb
+uint64_t limbMul1(uint64_t *pDst, const uint64_t *pA, const size_t n, const uint64_t nMul);
+
+// destination (n limbs) += A * multiplier, returns carry limb
+uint64_t limbAddMul1(uint64_t *pDst, const uint64_t *pA, const size_t n, const uint64_t nMul);
+
+// destination (n limbs) -= A * multiplier, returns borrow limb
+uint64_t limbSubMul1(uint64_t *pDst, const uint64_t *pA, const size_t n, const uint64_t nMul);
+
+// destination (nA + nB limbs) = A * B,
+// schoolbook for small and Karatsuba for larger sizes,
+// unbalanced sizes are cut to balanced pieces.
+// destination must not overlap operands.
+void limbMulN(uint64_t *pDst, const uint64_t *pA, const size_t nA, const uint64_t *pB, const size_t nB);
+
+// quotient (nA - nB + 1 limbs) and remainder (nB limbs) of A / B
+// by schoolbook long division (Knuth, algorithm D).
+// requires nA >= nB and top limb of B nonzero,
+// either output may be null if not needed.
+void limbDivRemN(uint64_t *pQuot, uint64_t *pRem, const uint64_t *pA, const size_t nA, const uint64_t *pB, const size_t nB);
+
+// greatest common divisor of A and B (Euclid, binary on single limb),
+// destination needs larger of nA and nB limbs, returns count of used limbs
+// (zero if both are zero). destination may be same as either operand.
+size_t limbGcdN(uint64_t *pDst, const uint64_t *pA, const size_t nA, const uint64_t *pB, const size_t nB);
+
+#endif // BIGLIMB_H
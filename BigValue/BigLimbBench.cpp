@@ -0,0 +1,132 @@
+// BigLimbBench.cpp : limb kernels and CBigValue arithmetic
+// over operand sizes, timed by MicroBench.
+//
+// usage: BigLimbBench [max limbs] [MicroBench options]
+//
+// operand sizes are powers of two from 1 limb to max (default 4096),
+// see MicroBench.h for options (--csv, --json, --baseline, ..).
+// Multiplication of max limbs and factorial of 16 * max limbs
+// are also timed in pools of 1, 2, 4.. upto hardware threads.
+//
+
+#include "BigLimb.h"
+#include "BigValue.h"
+#include "../simplesse/MicroBench.h"
+#include "../simplesse/TaskPool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+
+// A + B as serial carry chain (limbAddN without vector lanes)
+static uint64_t carryChainAdd(uint64_t *pDst, const uint64_t *pA, const uint64_t *pB, const size_t n)
+{
+	uint64_t carry = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		const uint64_t a = pA[i];
+		uint64_t sum = a + pB[i];
+		uint64_t carryOut = (sum < a) ? 1 : 0;
+		sum += carry;
+		carryOut += (sum < carry) ? 1 : 0;
+		pDst[i] = sum;
+		carry = carryOut;
+	}
+	return carry;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t nMaxLimbs = 4096;
+	if (argc > 1 && argv[1][0] != '-')
+	{
+		nMaxLimbs = (size_t)::strtoull(argv[1], nullptr, 10);
+	}
+
+	MicroBench bench;
+	if (bench.parseArgs(argc, argv) == false)
+	{
+		fprintf(stderr, "invalid options\n");
+		return 1;
+	}
+
+	std::mt19937_64 rng(1234);
+	std::vector<uint64_t> a(2 * nMaxLimbs);
+	std::vector<uint64_t> b(nMaxLimbs);
+	std::vector<uint64_t> dst(3 * nMaxLimbs + 1);
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		a[i] = rng();
+	}
+	for (size_t i = 0; i < b.size(); i++)
+	{
+		b[i] = rng();
+	}
+
+	limbSelectKernels();
+	printf("limb kernels: %s\n", limbKernelName());
+	const std::vector<size_t> sizes = MicroBench::powersOfTwo(1, nMaxLimbs);
+	auto limbs = [](const size_t n) { return n; };
+
+	bench.sweep("limbAddN", "limbs", sizes,
+		[&](const size_t n) { microBenchKeep(limbAddN(dst.data(), a.data(), n, b.data(), n)); }, limbs);
+	bench.sweep("carry chain add", "limbs", sizes,
+		[&](const size_t n) { microBenchKeep(carryChainAdd(dst.data(), a.data(), b.data(), n)); }, limbs);
+	bench.sweep("limbAddMul1", "limbs", sizes,
+		[&](const size_t n) { microBenchKeep(limbAddMul1(dst.data(), a.data(), n, b[0])); }, limbs);
+	bench.sweep("limbMulN", "limbs", sizes,
+		[&](const size_t n) { limbMulN(dst.data(), a.data(), n, b.data(), n); }, limbs);
+	// 2n / n limbs
+	bench.sweep("limbDivRemN", "limbs", sizes,
+		[&](const size_t n) { limbDivRemN(dst.data(), dst.data() + 2 * n + 1, a.data(), 2 * n, b.data(), n); }, limbs);
+
+	// same through CBigValue: allocation and sign handling included
+	std::vector<CBigValue> valuesA;
+	std::vector<CBigValue> valuesB;
+	for (size_t i = 0; i < sizes.size(); i++)
+	{
+		// top limb set: n limbs
+		const size_t nShift = 64 * (sizes[i] - 1);
+		valuesA.push_back((CBigValue((uint64_t)0x9e3779b97f4a7c15) << nShift) + CBigValue((uint64_t)rng()));
+		valuesB.push_back((CBigValue((uint64_t)0xc2b2ae3d27d4eb4f) << nShift) + CBigValue((uint64_t)rng()));
+	}
+	auto index = [&sizes](const size_t n) { return (size_t)(std::lower_bound(sizes.begin(), sizes.end(), n) - sizes.begin()); };
+	bench.sweep("CBigValue add", "limbs", sizes,
+		[&](const size_t n) { const size_t i = index(n); CBigValue result = valuesA[i] + valuesB[i]; microBenchKeep(result); }, limbs);
+	bench.sweep("CBigValue mul", "limbs", sizes,
+		[&](const size_t n) { const size_t i = index(n); CBigValue result = valuesA[i] * valuesB[i]; microBenchKeep(result); }, limbs);
+
+	// thread scaling: Karatsuba halves and product tree
+	// as tasks of pool of each thread count
+	const size_t nHardware = (std::thread::hardware_concurrency() > 0) ? std::thread::hardware_concurrency() : 1;
+	const std::vector<size_t> threads = MicroBench::powersOfTwo(1, nHardware);
+	std::vector<std::unique_ptr<TaskPool>> pools;
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		pools.push_back(std::unique_ptr<TaskPool>(new TaskPool(threads[i])));
+	}
+	for (size_t i = 0; i < pools.size(); i++)
+	{
+		const TaskPoolScope scope(*pools[i]);
+		MicroBenchParams params;
+		params.push_back(std::make_pair(std::string("limbs"), (double)nMaxLimbs));
+		params.push_back(std::make_pair(std::string("threads"), (double)threads[i]));
+		bench.run("limbMulN threads", params,
+			[&]() { limbMulN(dst.data(), a.data(), nMaxLimbs, b.data(), nMaxLimbs); }, (double)nMaxLimbs);
+	}
+	for (size_t i = 0; i < pools.size(); i++)
+	{
+		const TaskPoolScope scope(*pools[i]);
+		MicroBenchParams params;
+		params.push_back(std::make_pair(std::string("n"), (double)(16 * nMaxLimbs)));
+		params.push_back(std::make_pair(std::string("threads"), (double)threads[i]));
+		bench.run("factorial threads", params,
+			[&]() { CBigValue result = CBigValue::factorial(16 * nMaxLimbs); microBenchKeep(result); });
+	}
+
+	return (bench.report() == true) ? 0 : 1;
+}
@@ -0,0 +1,951 @@
+/////////////////////////////////////
+//
+// CBigMath : elementary functions
+// on CBigFloat (exp, log, sin, cos, atan).
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Method depends on working precision:
+// - exp: x = k*ln2 + r, r divided by 2^s (s ~ sqrt(precision)/2),
+//   Taylor series, then squared s times.
+//   Above AGM threshold Newton iteration on log instead.
+// - log: Newton iteration on exp,
+//   above AGM threshold log(x) = pi / (2*AGM(1, 4/s)) - m*ln2
+//   where s = x*2^m is large enough.
+// - sin/cos: x = k*pi/2 + r (pi with enough bits for size of x),
+//   r divided by 2^s, Taylor series for both,
+//   then doubling formulas s times.
+// - atan: |x| > 1 by pi/2 - atan(1/x), halving angle by
+//   x / (1 + sqrt(1 + x^2)) until small, then Taylor series.
+//
+// Constants (pi, ln2) come from CBigConstants (binary splitting).
+//
+// Value is computed with guard bits, if interval of its error
+// rounds to two different values precision is doubled (Ziv).
+// Exact cases (exp(0), log(1) etc.) are handled separately
+// since they would never be decided.
+//
+
+#include "BigMath.h"
+#include "BigConstants.h"
+#include "../simplesse/TaskPool.h"
+
+#include <math.h>
+#include <map>
+#include <limits>
+
+
+// above this working precision (bits) AGM-based methods
+// and Newton division are faster than series and long division
+static const size_t s_nAgmThreshold = 16384;
+
+// guard bits in first attempt
+static const size_t s_nInitialGuardBits = 32;
+
+// keep caches for this many precisions per thread
+static const size_t s_nMaxCachedPrecisions = 8;
+
+static const double s_dLn2 = 0.69314718055994530942;
+
+// exponents of exp() results are kept within +-2^62:
+// beyond that overflow and underflow round by mode
+static const int64_t s_nExpExponentLimit = (int64_t)1 << 62;
+
+
+////////// cache of constants and coefficients
+
+struct FunctionCache
+{
+	size_t nPrecision;
+	CBigFloat ln2;
+	CBigFloat pi;
+	std::vector<CBigFloat> inverseFactorial; // 1/n!
+	std::vector<CBigFloat> inverseOdd; // 1/(2n+1)
+
+	explicit FunctionCache(const size_t nBits)
+		: nPrecision(nBits)
+		, ln2(1)
+		, pi(1)
+		, inverseFactorial()
+		, inverseOdd()
+	{}
+};
+
+// caches per thread and nesting level (TaskLocal):
+// multiplication may fork and waiting thread may run
+// another evaluation while outer one holds its cache
+typedef std::map<size_t, FunctionCache> CacheMap;
+
+static FunctionCache& getCache(CacheMap &caches, const size_t nPrecision)
+{
+	CacheMap::iterator it = caches.find(nPrecision);
+	if (it != caches.end())
+	{
+		return it->second;
+	}
+
+	if (caches.size() >= s_nMaxCachedPrecisions)
+	{
+		caches.clear();
+	}
+	return caches.insert(CacheMap::value_type(nPrecision, FunctionCache(nPrecision))).first->second;
+}
+
+// constants are cached with some extra bits,
+// larger requests (reduction of big arguments) go to CBigConstants
+static CBigFloat getConstant(FunctionCache &cache, const BigConstant eConstant, const size_t nBits)
+{
+	const size_t nCached = cache.nPrecision + 64;
+	if (nBits > nCached)
+	{
+		return CBigConstants::getFloat(eConstant, nBits);
+	}
+
+	CBigFloat &value = (eConstant == BigConstantPi) ? cache.pi : cache.ln2;
+	if (value.getPrecision() < nCached)
+	{
+		value = CBigConstants::getFloat(eConstant, nCached);
+	}
+	return value;
+}
+
+// 1/n!, each from previous by small division
+static const CBigFloat& inverseFactorial(FunctionCache &cache, const size_t n)
+{
+	std::vector<CBigFloat> &coefficients = cache.inverseFactorial;
+	if (coefficients.empty())
+	{
+		coefficients.push_back(CBigFloat(cache.nPrecision + 32));
+		coefficients.back().fromUInt64(1);
+	}
+	while (coefficients.size() <= n)
+	{
+		CBigFloat divisor(64);
+		divisor.fromUInt64(coefficients.size());
+		CBigFloat next(cache.nPrecision + 32);
+		next.div(coefficients.back(), divisor);
+		coefficients.push_back(next);
+	}
+	return coefficients[n];
+}
+
+// 1/(2n+1)
+static const CBigFloat& inverseOdd(FunctionCache &cache, const size_t n)
+{
+	std::vector<CBigFloat> &coefficients = cache.inverseOdd;
+	CBigFloat one(1);
+	one.fromUInt64(1);
+	while (coefficients.size() <= n)
+	{
+		CBigFloat divisor(64);
+		divisor.fromUInt64(2 * coefficients.size() + 1);
+		CBigFloat next(cache.nPrecision + 32);
+		next.div(one, divisor);
+		coefficients.push_back(next);
+	}
+	return coefficients[n];
+}
+
+
+////////// local helpers
+
+// argument is divided by 2^s before series
+static size_t reductionFor(const size_t nPrecision)
+{
+	return (size_t)(::sqrt((double)nPrecision) / 2) + 1;
+}
+
+static size_t bitLength64(uint64_t value)
+{
+	size_t nBits = 0;
+	while (value != 0)
+	{
+		value >>= 1;
+		nBits++;
+	}
+	return nBits;
+}
+
+// count of series terms n where |x|^(step*n) / (step*n)! < 2^-nBits,
+// nTop is upper bound of log2|x|
+static size_t seriesTerms(const int64_t nTop, const size_t nStep, const size_t nBits)
+{
+	double dLog = 0;
+	size_t n = 0;
+	while (dLog > -(double)nBits - 2)
+	{
+		n++;
+		for (size_t i = 0; i < nStep; i++)
+		{
+			dLog += (double)nTop - log2((double)(nStep * (n - 1) + i + 1));
+		}
+	}
+	return n;
+}
+
+// division and square root: long division is quadratic,
+// above threshold Newton iteration is used
+static void divideAt(CBigFloat &result, const CBigFloat &a, const CBigFloat &b)
+{
+	if (result.getPrecision() < s_nAgmThreshold)
+	{
+		result.div(a, b);
+		return;
+	}
+	CBigFloat inverse(result.getPrecision() + 16);
+	inverse.reciprocal(b);
+	result.mul(a, inverse);
+}
+
+static void sqrtAt(CBigFloat &result, const CBigFloat &a)
+{
+	if (result.getPrecision() < s_nAgmThreshold)
+	{
+		result.sqrt(a);
+		return;
+	}
+	CBigFloat inverse(result.getPrecision() + 16);
+	inverse.reciprocalSqrt(a);
+	result.mul(a, inverse);
+}
+
+static CBigFloat oneFloat()
+{
+	CBigFloat one(1);
+	one.fromUInt64(1);
+	return one;
+}
+
+
+////////// function kernels: result with about nPrecision correct bits
+
+typedef void (*FunctionCore)(CBigFloat &result, const CBigFloat &x, const size_t nPrecision, FunctionCache &cache);
+
+static void expCore(CBigFloat &result, const CBigFloat &x, const size_t nPrecision, FunctionCache &cache);
+static void logCore(CBigFloat &result, const CBigFloat &x, const size_t nPrecision, FunctionCache &cache);
+
+// exp by Taylor series on reduced argument
+static void expSeries(CBigFloat &result, const CBigFloat &x, const size_t nPrecision, FunctionCache &cache)
+{
+	const size_t nReduction = reductionFor(nPrecision);
+	// squaring doubles relative error each time
+	const size_t nWork = nPrecision + nReduction + 16;
+
+	// x = k*ln2 + r, |r| <= ln2/2
+	int64_t k = 0;
+	CBigFloat r(nWork);
+	if (x.topExponent() > -1)
+	{
+		k = llround(x.toDouble() / s_dLn2);
+		const size_t nKBits = bitLength64((k < 0) ? (0 - (uint64_t)k) : (uint64_t)k);
+		CBigFloat ln2 = getConstant(cache, BigConstantLn2, nWork + nKBits + 8);
+
+		CBigFloat factor(64);
+		factor.fromInt64(k);
+		// exact product
+		CBigFloat product(ln2.getPrecision() + 64);
+		product.mul(ln2, factor);
+		r.sub(x, product);
+	}
+	else
+	{
+		r.set(x);
+	}
+	if (r.isZero())
+	{
+		result.fromUInt64(1);
+		result.ldexp(k);
+		return;
+	}
+
+	r.ldexp(-(int64_t)nReduction);
+	const size_t nTerms = seriesTerms(r.topExponent(), 1, nWork);
+
+	// Horner: sum of r^n/n!
+	CBigFloat sum(nWork);
+	sum.set(inverseFactorial(cache, nTerms));
+	for (size_t n = nTerms; n > 0; n--)
+	{
+		sum.mul(sum, r);
+		sum.add(sum, inverseFactorial(cache, n - 1));
+	}
+
+	for (size_t i = 0; i < nReduction; i++)
+	{
+		sum.mul(sum, sum);
+	}
+	sum.ldexp(k);
+	result.set(sum);
+}
+
+// exp by Newton iteration y = y*(1 + x - log(y)),
+// log by AGM at high precision
+static void expNewton(CBigFloat &result, const CBigFloat &x, const size_t nPrecision, FunctionCache &cache)
+{
+	// absolute error of log(y) is relative error of y,
+	// scaled by size of x
+	const size_t nWork = nPrecision + 16 + (size_t)((x.topExponent() > 0) ? x.topExponent() : 0);
+
+	std::vector<size_t> steps;
+	for (size_t nStep = nWork; nStep >= s_nAgmThreshold; nStep = nStep / 2 + 8)
+	{
+		steps.push_back(nStep);
+	}
+
+	const size_t nStart = (steps.empty() ? nWork : steps.back()) / 2 + 8;
+	CBigFloat y(nStart);
+	expSeries(y, x, nStart, cache);
+
+	for (size_t i = steps.size(); i > 0; i--)
+	{
+		const size_t nStep = steps[i - 1];
+		CBigFloat logY(nStep);
+		logCore(logY, y, nStep, cache);
+		CBigFloat difference(nStep);
+		difference.sub(x, logY);
+		CBigFloat correction(nStep);
+		correction.mul(y, difference);
+		CBigFloat next(nStep);
+		next.add(y, correction);
+		y = next;
+	}
+	result.set(y);
+}
+
+static void expCore(CBigFloat &result, const CBigFloat &x, const size_t nPrecision, FunctionCache &cache)
+{
+	if (nPrecision >= s_nAgmThreshold)
+	{
+		expNewton(result, x, nPrecision, cache);
+	}
+	else
+	{
+		expSeries(result, x, nPrecision, cache);
+	}
+}
+
+// log by AGM: log(s) ~ pi / (2*AGM(1, 4/s)) when s > 2^(precision/2)
+static void logAgm(CBigFloat &result, const CBigFloat &x, const size_t nPrecision, FunctionCache &cache)
+{
+	const size_t nWork = nPrecision + bitLength64(nPrecision) + 16;
+	const int64_t nShift = (int64_t)(nWork / 2 + 2) - x.topExponent();
+
+	CBigFloat s(x);
+	s.ldexp(nShift);
+
+	CBigFloat a(nWork);
+	a.fromUInt64(1);
+	CBigFloat b(nWork);
+	b.reciprocal(s);
+	b.ldexp(2);
+
+	// converges quadratically: once half of bits agree
+	// single iteration more is enough
+	bool bLast = false;
+	for (;;)
+	{
+		CBigFloat mean(nWork);
+		mean.add(a, b);
+		mean.ldexp(-1);
+		CBigFloat product(nWork);
+		product.mul(a, b);
+		sqrtAt(b, product);
+		a = mean;
+		if (bLast == true)
+		{
+			break;
+		}
+
+		CBigFloat difference(nWork);
+		difference.sub(a, b);
+		if (difference.isZero() || difference.topExponent() < a.topExponent() - (int64_t)(nWork / 2))
+		{
+			bLast = true;
+		}
+	}
+
+	CBigFloat pi = getConstant(cache, BigConstantPi, nWork);
+	CBigFloat logS(nWork);
+	divideAt(logS, pi, a);
+	logS.ldexp(-1);
+
+	CBigFloat ln2 = getConstant(cache, BigConstantLn2, nWork + 64);
+	CBigFloat factor(64);
+	factor.fromInt64(nShift);
+	CBigFloat product(ln2.getPrecision() + 64);
+	product.mul(ln2, factor);
+	result.sub(logS, product);
+}
+
+// log by Newton iteration y = y + x*exp(-y) - 1
+static void logNewton(CBigFloat &result, const CBigFloat &x, const size_t nPrecision, FunctionCache &cache)
+{
+	const CBigFloat one = oneFloat();
+
+	// start from double: x = m * 2^e
+	const int64_t nTop = x.topExponent();
+	CBigFloat scaled(53);
+	scaled.set(x);
+	scaled.ldexp(-nTop);
+
+	CBigFloat y(128);
+	CBigFloat ln2 = getConstant(cache, BigConstantLn2, 128);
+	CBigFloat factor(64);
+	factor.fromInt64(nTop);
+	y.mul(ln2, factor);
+	CBigFloat start(53);
+	start.fromDouble(::log(scaled.toDouble()));
+	y.add(y, start);
+
+	std::vector<size_t> steps;
+	for (size_t nStep = nPrecision + 16; nStep > 48; nStep = nStep / 2 + 8)
+	{
+		steps.push_back(nStep);
+	}
+	// double may give less than half of first step
+	steps.push_back(steps.back());
+
+	for (size_t i = steps.size(); i > 0; i--)
+	{
+		const size_t nStep = steps[i - 1];
+		CBigFloat negated(y);
+		negated.negate();
+		CBigFloat power(nStep);
+		expCore(power, negated, nStep, cache);
+		CBigFloat product(nStep);
+		product.mul(x, power);
+		CBigFloat error(nStep);
+		error.sub(product, one);
+		CBigFloat next(nStep);
+		next.add(y, error);
+		y = next;
+	}
+	result.set(y);
+}
+
+// x > 0 and x != 1
+static void logCore(CBigFloat &result, const CBigFloat &x, const size_t nPrecision, FunctionCache &cache)
+{
+	// near one result is small: more absolute accuracy
+	const CBigFloat one = oneFloat();
+	CBigFloat distance(64);
+	distance.sub(x, one);
+	size_t nExtra = 0;
+	if (distance.topExponent() < 0)
+	{
+		nExtra = (size_t)(-distance.topExponent());
+	}
+
+	const size_t nWork = nPrecision + nExtra + 16;
+	if (nWork >= s_nAgmThreshold)
+	{
+		logAgm(result, x, nWork, cache);
+	}
+	else
+	{
+		logNewton(result, x, nWork, cache);
+	}
+}
+
+// x = k*pi/2 + r with |r| <= pi/4, r keeps nPrecision bits
+// even when x is close to multiple of pi/2
+static void reduceHalfPi(CBigFloat &r, unsigned int &nQuadrant, const CBigFloat &x, const size_t nPrecision, FunctionCache &cache)
+{
+	const int64_t nTop = x.topExponent();
+	if (nTop < 0)
+	{
+		// below 1/2
+		r.set(x);
+		nQuadrant = 0;
+		return;
+	}
+
+	size_t nExtra = 0;
+	for (;;)
+	{
+		const size_t nPiBits = nPrecision + (size_t)nTop + 16 + nExtra;
+		CBigFloat halfPi = getConstant(cache, BigConstantPi, nPiBits);
+		halfPi.ldexp(-1);
+
+		// nearest integer to x/(pi/2)
+		CBigFloat quotient((size_t)nTop + 16);
+		quotient.div(x, halfPi);
+		CBigValue integer = quotient.toBigValue(0, BigRoundingNearestEven);
+		std::vector<uint64_t> limbs;
+		integer.getLimbs(limbs);
+		nQuadrant = limbs.empty() ? 0 : (unsigned int)(limbs[0] & 3);
+		if (integer.isNegative() == true)
+		{
+			nQuadrant = (4 - nQuadrant) & 3;
+		}
+
+		// exact product
+		CBigFloat factor(integer, integer.bitLength() + 1);
+		CBigFloat product(nPiBits + integer.bitLength() + 8);
+		product.mul(halfPi, factor);
+		r.sub(x, product);
+
+		// cancellation: bits lost must be covered by extra bits of pi
+		const size_t nLost = r.isZero() ? 64 : (size_t)((r.topExponent() < 0) ? -r.topExponent() : 0);
+		if (r.isZero() == false && nLost <= nExtra)
+		{
+			break;
+		}
+		nExtra = nLost + 32 + nExtra;
+	}
+}
+
+// sin and cos of |r| <= pi/4 by Taylor series on r/2^s,
+// then doubling: sin(2a) = 2*sin(a)*cos(a), cos(2a) = 1 - 2*sin(a)^2
+static void sinCosSeries(CBigFloat &sinValue, CBigFloat &cosValue, const CBigFloat &r, const size_t nPrecision, FunctionCache &cache)
+{
+	const size_t nReduction = reductionFor(nPrecision);
+	const size_t nWork = nPrecision + 2 * nReduction + 16;
+	const CBigFloat one = oneFloat();
+
+	CBigFloat reduced(nWork);
+	reduced.set(r);
+	reduced.ldexp(-(int64_t)nReduction);
+	CBigFloat square(nWork);
+	square.mul(reduced, reduced);
+
+	const size_t nTerms = seriesTerms(reduced.topExponent(), 2, nWork);
+
+	// Horner in r^2 with alternating signs
+	CBigFloat sinSum(nWork);
+	CBigFloat cosSum(nWork);
+	sinSum.set(inverseFactorial(cache, 2 * nTerms + 1));
+	cosSum.set(inverseFactorial(cache, 2 * nTerms));
+	if ((nTerms & 1) != 0)
+	{
+		sinSum.negate();
+		cosSum.negate();
+	}
+	for (size_t n = nTerms; n > 0; n--)
+	{
+		CBigFloat sinCoefficient(inverseFactorial(cache, 2 * n - 1));
+		CBigFloat cosCoefficient(inverseFactorial(cache, 2 * n - 2));
+		if (((n - 1) & 1) != 0)
+		{
+			sinCoefficient.negate();
+			cosCoefficient.negate();
+		}
+		sinSum.mul(sinSum, square);
+		sinSum.add(sinSum, sinCoefficient);
+		cosSum.mul(cosSum, square);
+		cosSum.add(cosSum, cosCoefficient);
+	}
+	sinSum.mul(sinSum, reduced);
+
+	for (size_t i = 0; i < nReduction; i++)
+	{
+		CBigFloat sinDouble(nWork);
+		sinDouble.mul(sinSum, cosSum);
+		sinDouble.ldexp(1);
+		CBigFloat sinSquare(nWork);
+		sinSquare.mul(sinSum, sinSum);
+		sinSquare.ldexp(1);
+		cosSum.sub(one, sinSquare);
+		sinSum = sinDouble;
+	}
+	sinValue.set(sinSum);
+	cosValue.set(cosSum);
+}
+
+static void sinCosCore(CBigFloat &sinValue, CBigFloat &cosValue, const CBigFloat &x, const size_t nPrecision, FunctionCache &cache)
+{
+	const size_t nWork = nPrecision + 16;
+	CBigFloat r(nWork);
+	unsigned int nQuadrant = 0;
+	reduceHalfPi(r, nQuadrant, x, nWork, cache);
+
+	CBigFloat sinR(nWork);
+	CBigFloat cosR(nWork);
+	sinCosSeries(sinR, cosR, r, nWork, cache);
+
+	// rotate by quadrant
+	switch (nQuadrant)
+	{
+	case 0:
+		sinValue.set(sinR);
+		cosValue.set(cosR);
+		break;
+	case 1:
+		sinValue.set(cosR);
+		cosValue.set(sinR);
+		cosValue.negate();
+		break;
+	case 2:
+		sinValue.set(sinR);
+		sinValue.negate();
+		cosValue.set(cosR);
+		cosValue.negate();
+		break;
+	default:
+		sinValue.set(cosR);
+		sinValue.negate();
+		cosValue.set(sinR);
+		break;
+	}
+}
+
+static void sinCore(CBigFloat &result, const CBigFloat &x, const size_t nPrecision, FunctionCache &cache)
+{
+	CBigFloat cosValue(nPrecision);
+	sinCosCore(result, cosValue, x, nPrecision, cache);
+}
+
+static void cosCore(CBigFloat &result, const CBigFloat &x, const size_t nPrecision, FunctionCache &cache)
+{
+	CBigFloat sinValue(nPrecision);
+	sinCosCore(sinValue, result, x, nPrecision, cache);
+}
+
+static void atanCore(CBigFloat &result, const CBigFloat &x, const size_t nPrecision, FunctionCache &cache)
+{
+	const size_t nReduction = reductionFor(nPrecision);
+	const size_t nWork = nPrecision + 16;
+	const CBigFloat one = oneFloat();
+
+	CBigFloat a(nWork);
+	a.set(x);
+	if (a.isNegative() == true)
+	{
+		a.negate();
+	}
+
+	// atan(x) = pi/2 - atan(1/x)
+	const bool bInvert = (a > one);
+	if (bInvert == true)
+	{
+		CBigFloat inverse(nWork);
+		divideAt(inverse, one, a);
+		a = inverse;
+	}
+
+	// halve angle: atan(a) = 2*atan(a / (1 + sqrt(1 + a^2)))
+	int64_t nHalvings = 0;
+	while (a.topExponent() > -(int64_t)nReduction)
+	{
+		CBigFloat denominator(nWork);
+		denominator.mul(a, a);
+		denominator.add(denominator, one);
+		sqrtAt(denominator, denominator);
+		denominator.add(denominator, one);
+		CBigFloat next(nWork);
+		divideAt(next, a, denominator);
+		a = next;
+		nHalvings++;
+	}
+
+	// Horner in a^2: sum (-1)^n a^(2n+1) / (2n+1)
+	CBigFloat square(nWork);
+	square.mul(a, a);
+	const size_t nTerms = (nWork + 2) / (2 * (size_t)(-a.topExponent())) + 1;
+
+	CBigFloat sum(nWork);
+	sum.set(inverseOdd(cache, nTerms));
+	if ((nTerms & 1) != 0)
+	{
+		sum.negate();
+	}
+	for (size_t n = nTerms; n > 0; n--)
+	{
+		CBigFloat coefficient(inverseOdd(cache, n - 1));
+		if (((n - 1) & 1) != 0)
+		{
+			coefficient.negate();
+		}
+		sum.mul(sum, square);
+		sum.add(sum, coefficient);
+	}
+	sum.mul(sum, a);
+	sum.ldexp(nHalvings);
+
+	if (bInvert == true)
+	{
+		CBigFloat halfPi = getConstant(cache, BigConstantPi, nWork + 8);
+		halfPi.ldexp(-1);
+		sum.sub(halfPi, sum);
+	}
+	if (x.isNegative() == true)
+	{
+		sum.negate();
+	}
+	result.set(sum);
+}
+
+
+////////// correct rounding
+
+// round value to result if error of 2^(top - nPrecision - nGuard/2)
+// can't change rounding
+static bool roundIfDecided(CBigFloat &result, const CBigFloat &value, const size_t nGuard, const BigRounding eRounding)
+{
+	const size_t nPrecision = result.getPrecision();
+	CBigFloat error(1);
+	error.fromUInt64(1);
+	error.ldexp(value.topExponent() - (int64_t)(nPrecision + nGuard / 2));
+
+	CBigFloat lower(value.getPrecision() + 2);
+	lower.sub(value, error);
+	CBigFloat upper(value.getPrecision() + 2);
+	upper.add(value, error);
+
+	CBigFloat roundedLower(nPrecision);
+	roundedLower.set(lower, eRounding);
+	CBigFloat roundedUpper(nPrecision);
+	roundedUpper.set(upper, eRounding);
+	if (roundedLower != roundedUpper || roundedLower.isNegative() != roundedUpper.isNegative())
+	{
+		return false;
+	}
+	result = roundedLower;
+	return true;
+}
+
+static CBigFloat evaluate(CacheMap &caches, const FunctionCore pCore, const CBigFloat &x, const size_t nPrecision, const BigRounding eRounding)
+{
+	CBigFloat result(nPrecision);
+	for (size_t nGuard = s_nInitialGuardBits; ; nGuard *= 2)
+	{
+		const size_t nWork = nPrecision + nGuard;
+		FunctionCache &cache = getCache(caches, nWork);
+		CBigFloat value(nWork);
+		pCore(value, x, nWork, cache);
+		if (roundIfDecided(result, value, nGuard, eRounding) == true)
+		{
+			break;
+		}
+	}
+	return result;
+}
+
+// special values and exact cases: true when result is set
+static bool expSpecial(CBigFloat &result, const CBigFloat &x, const BigRounding eRounding)
+{
+	if (x.isNaN())
+	{
+		result.fromDouble(std::numeric_limits<double>::quiet_NaN());
+		return true;
+	}
+	if (x.isZero())
+	{
+		result.fromUInt64(1);
+		return true;
+	}
+	// exponent of result would not fit
+	if (x.isInfinity() || x.topExponent() > 62)
+	{
+		const size_t nPrecision = result.getPrecision();
+		if (x.isNegative() == true)
+		{
+			// smallest positive when rounding up
+			if (eRounding == BigRoundingUp && x.isInfinity() == false)
+			{
+				result.fromParts(std::vector<uint64_t>(1, 1), -s_nExpExponentLimit, false);
+			}
+			else
+			{
+				result.fromUInt64(0);
+			}
+		}
+		else
+		{
+			// largest finite when rounding toward zero or down
+			if ((eRounding == BigRoundingTowardZero || eRounding == BigRoundingDown) && x.isInfinity() == false)
+			{
+				std::vector<uint64_t> mantissa((nPrecision + 63) / 64, ~(uint64_t)0);
+				if ((nPrecision % 64) != 0)
+				{
+					mantissa.back() >>= 64 - (nPrecision % 64);
+				}
+				result.fromParts(mantissa, s_nExpExponentLimit - (int64_t)nPrecision, false);
+			}
+			else
+			{
+				result.fromDouble(std::numeric_limits<double>::infinity());
+			}
+		}
+		return true;
+	}
+	return false;
+}
+
+// exact results: rounding mode does not matter
+static bool logSpecial(CBigFloat &result, const CBigFloat &x, const BigRounding /*eRounding*/)
+{
+	if (x.isNaN() || (x.isNegative() == true && x.isZero() == false))
+	{
+		result.fromDouble(std::numeric_limits<double>::quiet_NaN());
+		return true;
+	}
+	if (x.isZero())
+	{
+		result.fromDouble(-std::numeric_limits<double>::infinity());
+		return true;
+	}
+	if (x.isInfinity())
+	{
+		result.fromDouble(std::numeric_limits<double>::infinity());
+		return true;
+	}
+	if (x == oneFloat())
+	{
+		result.fromUInt64(0);
+		return true;
+	}
+	return false;
+}
+
+static bool sinSpecial(CBigFloat &result, const CBigFloat &x, const BigRounding /*eRounding*/)
+{
+	if (x.isNaN() || x.isInfinity())
+	{
+		result.fromDouble(std::numeric_limits<double>::quiet_NaN());
+		return true;
+	}
+	if (x.isZero())
+	{
+		// keeps sign
+		result.set(x);
+		return true;
+	}
+	return false;
+}
+
+static bool cosSpecial(CBigFloat &result, const CBigFloat &x, const BigRounding /*eRounding*/)
+{
+	if (x.isNaN() || x.isInfinity())
+	{
+		result.fromDouble(std::numeric_limits<double>::quiet_NaN());
+		return true;
+	}
+	if (x.isZero())
+	{
+		result.fromUInt64(1);
+		return true;
+	}
+	return false;
+}
+
+static bool atanSpecial(CBigFloat &result, const CBigFloat &x, const BigRounding eRounding)
+{
+	if (x.isNaN())
+	{
+		result.fromDouble(std::numeric_limits<double>::quiet_NaN());
+		return true;
+	}
+	if (x.isZero())
+	{
+		result.set(x);
+		return true;
+	}
+	if (x.isInfinity())
+	{
+		// irrational: extra bits decide rounding
+		CBigFloat halfPi = CBigConstants::getFloat(BigConstantPi, result.getPrecision() + 64);
+		halfPi.ldexp(-1);
+		if (x.isNegative() == true)
+		{
+			halfPi.negate();
+		}
+		result.set(halfPi, eRounding);
+		return true;
+	}
+	return false;
+}
+
+typedef bool (*FunctionSpecial)(CBigFloat &result, const CBigFloat &x, const BigRounding eRounding);
+
+static CBigFloat evaluateFunction(CacheMap &caches, const FunctionSpecial pSpecial, const FunctionCore pCore, const CBigFloat &x, const size_t nPrecision, const BigRounding eRounding)
+{
+	CBigFloat result(nPrecision);
+	if (pSpecial(result, x, eRounding) == true)
+	{
+		return result;
+	}
+	return evaluate(caches, pCore, x, nPrecision, eRounding);
+}
+
+static CBigFloat evaluateFunction(const FunctionSpecial pSpecial, const FunctionCore pCore, const CBigFloat &x, const size_t nPrecision, const BigRounding eRounding)
+{
+	const TaskLocal<CacheMap> caches;
+	return evaluateFunction(caches.get(), pSpecial, pCore, x, nPrecision, eRounding);
+}
+
+static void evaluateBatch(const FunctionSpecial pSpecial, const FunctionCore pCore, const std::vector<CBigFloat> &values, std::vector<CBigFloat> &results, const size_t nPrecision, const BigRounding eRounding)
+{
+	// constants of first attempt once for whole batch
+	const TaskLocal<CacheMap> caches;
+	FunctionCache &cache = getCache(caches.get(), nPrecision + s_nInitialGuardBits);
+	getConstant(cache, BigConstantLn2, cache.nPrecision);
+	getConstant(cache, BigConstantPi, cache.nPrecision);
+
+	results.clear();
+	results.reserve(values.size());
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		results.push_back(evaluateFunction(caches.get(), pSpecial, pCore, values[i], nPrecision, eRounding));
+	}
+}
+
+
+////////// public methods
+
+CBigFloat CBigMath::exp(const CBigFloat &x, const size_t nPrecision, const BigRounding eRounding)
+{
+	return evaluateFunction(expSpecial, expCore, x, nPrecision, eRounding);
+}
+
+CBigFloat CBigMath::log(const CBigFloat &x, const size_t nPrecision, const BigRounding eRounding)
+{
+	return evaluateFunction(logSpecial, logCore, x, nPrecision, eRounding);
+}
+
+CBigFloat CBigMath::sin(const CBigFloat &x, const size_t nPrecision, const BigRounding eRounding)
+{
+	return evaluateFunction(sinSpecial, sinCore, x, nPrecision, eRounding);
+}
+
+CBigFloat CBigMath::cos(const CBigFloat &x, const size_t nPrecision, const BigRounding eRounding)
+{
+	return evaluateFunction(cosSpecial, cosCore, x, nPrecision, eRounding);
+}
+
+CBigFloat CBigMath::atan(const CBigFloat &x, const size_t nPrecision, const BigRounding eRounding)
+{
+	return evaluateFunction(atanSpecial, atanCore, x, nPrecision, eRounding);
+}
+
+void CBigMath::exp(const std::vector<CBigFloat> &values, std::vector<CBigFloat> &results, const size_t nPrecision, const BigRounding eRounding)
+{
+	evaluateBatch(expSpecial, expCore, values, results, nPrecision, eRounding);
+}
+
+void CBigMath::log(const std::vector<CBigFloat> &values, std::vector<CBigFloat> &results, const size_t nPrecision, const BigRounding eRounding)
+{
+	evaluateBatch(logSpecial, logCore, values, results, nPrecision, eRounding);
+}
+
+void CBigMath::sin(const std::vector<CBigFloat> &values, std::vector<CBigFloat> &results, const size_t nPrecision, const BigRounding eRounding)
+{
+	evaluateBatch(sinSpecial, sinCore, values, results, nPrecision, eRounding);
+}
+
+void CBigMath::cos(const std::vector<CBigFloat> &values, std::vector<CBigFloat> &results, const size_t nPrecision, const BigRounding eRounding)
+{
+	evaluateBatch(cosSpecial, cosCore, values, results, nPrecision, eRounding);
+}
+
+void CBigMath::atan(const std::vector<CBigFloat> &values, std::vector<CBigFloat> &results, const size_t nPrecision, const BigRounding eRounding)
+{
+	evaluateBatch(atanSpecial, atanCore, values, results, nPrecision, eRounding);
+}
+
+void CBigMath::clearCache()
+{
+	TaskLocal<CacheMap>::release();
+}
@@ -0,0 +1,52 @@
+/////////////////////////////////////
+//
+// CBigMath : elementary functions
+// on CBigFloat (exp, log, sin, cos, atan).
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Results are correctly rounded to requested precision
+// in requested mode: value is computed with guard bits
+// and recomputed with more if rounding is not yet decided
+// (Ziv's strategy, see BigMath.cpp).
+// exp() beyond exponent range (|x| >= 2^62) gives infinity or zero,
+// or largest finite or smallest positive value when rounding toward them.
+//
+// Constants and series coefficients are cached per thread
+// (and nesting level when tasks run inside) for the working precision so repeated calls at same
+// precision (and batches) only pay for the evaluation.
+//
+
+#ifndef BIGMATH_H
+#define BIGMATH_H
+
+#include "BigFloat.h"
+
+#include <stddef.h>
+#include <vector>
+
+
+class CBigMath
+{
+public:
+	static CBigFloat exp(const CBigFloat &x, const size_t nPrecision, const BigRounding eRounding = BigRoundingNearestEven);
+	static CBigFloat log(const CBigFloat &x, const size_t nPrecision, const BigRounding eRounding = BigRoundingNearestEven);
+	static CBigFloat sin(const CBigFloat &x, const size_t nPrecision, const BigRounding eRounding = BigRoundingNearestEven);
+	static CBigFloat cos(const CBigFloat &x, const size_t nPrecision, const BigRounding eRounding = BigRoundingNearestEven);
+	static CBigFloat atan(const CBigFloat &x, const size_t nPrecision, const BigRounding eRounding = BigRoundingNearestEven);
+
+	// same function over batch of arguments:
+	// setup (constants, coefficients) is done once
+	static void exp(const std::vector<CBigFloat> &values, std::vector<CBigFloat> &results, const size_t nPrecision, const BigRounding eRounding = BigRoundingNearestEven);
+	static void log(const std::vector<CBigFloat> &values, std::vector<CBigFloat> &results, const size_t nPrecision, const BigRounding eRounding = BigRoundingNearestEven);
+	static void sin(const std::vector<CBigFloat> &values, std::vector<CBigFloat> &results, const size_t nPrecision, const BigRounding eRounding = BigRoundingNearestEven);
+	static void cos(const std::vector<CBigFloat> &values, std::vector<CBigFloat> &results, const size_t nPrecision, const BigRounding eRounding = BigRoundingNearestEven);
+	static void atan(const std::vector<CBigFloat> &values, std::vector<CBigFloat> &results, const size_t nPrecision, const BigRounding eRounding = BigRoundingNearestEven);
+
+	// release cached constants and coefficients of calling thread
+	static void clearCache();
+};
+
+#endif // BIGMATH_H
@@ -0,0 +1,985 @@
+/////////////////////////////////////
+//
+// CDoubleDouble, CQuadDouble : fast mid-precision
+// floating point as unevaluated sums of doubles.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Quad-double operations collect error-free terms
+// (sorted by magnitude or by order of product terms)
+// and renormalize them to four non-overlapping components
+// (VecSum and VecSumErrBranch of Joldes, Muller, Popescu:
+// "Arithmetic algorithms for extended precision using floating-point expansions").
+//
+// Elementary functions are same templates for both types:
+// exp by reduction with ln2 and halving, Taylor series of expm1
+// and squaring back; log and atan by Newton iteration from
+// double approximation (exp and sin/cos being cheaper);
+// sin and cos by reduction with pi/2 and Taylor series.
+// Constants and inverse factorials are taken from
+// CBigConstants/CBigFloat once and split to doubles.
+//
+
+#include "BigMultiDouble.h"
+#include "BigConstants.h"
+
+#include <string.h>
+#include <mutex>
+
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define BIGMULTIDOUBLE_AVX2
+#include <immintrin.h>
+#endif
+
+
+// inverse factorials 1/k! for series
+static const int s_nFactorialCount = 64;
+
+// bits used for constants before splitting
+static const size_t s_nTablePrecision = 320;
+
+struct MultiDoubleTables
+{
+	double ln2[4];
+	double halfPi[4];
+	double inverseFactorial[s_nFactorialCount][4];
+};
+
+static MultiDoubleTables s_Tables;
+static std::once_flag s_TablesOnce;
+
+
+////////// local helpers
+
+// components of value rounded to nearest, largest first
+static void splitBigFloat(const CBigFloat &value, double *pParts, const size_t nParts)
+{
+	CBigFloat rest(value.getPrecision() + 64);
+	rest.set(value);
+	for (size_t i = 0; i < nParts; i++)
+	{
+		pParts[i] = rest.toDouble();
+		if (pParts[i] == 0.0 || isfinite(pParts[i]) == false)
+		{
+			for (size_t j = i + 1; j < nParts; j++)
+			{
+				pParts[j] = 0.0;
+			}
+			return;
+		}
+		rest -= CBigFloat(pParts[i], 53);
+	}
+}
+
+// exact sum of components
+static CBigFloat sumParts(const double *pParts, const size_t nParts)
+{
+	if (isfinite(pParts[0]) == false)
+	{
+		return CBigFloat(pParts[0], 53);
+	}
+
+	// span from largest to smallest nonzero component
+	int nTop = 0;
+	int nBottom = 0;
+	bool bAny = false;
+	for (size_t i = 0; i < nParts; i++)
+	{
+		if (pParts[i] != 0.0)
+		{
+			const int nExponent = ilogb(pParts[i]);
+			nTop = (bAny == false || nExponent > nTop) ? nExponent : nTop;
+			nBottom = (bAny == false || nExponent < nBottom) ? nExponent : nBottom;
+			bAny = true;
+		}
+	}
+
+	CBigFloat sum(bAny ? (size_t)(nTop - nBottom) + 54 : 53);
+	for (size_t i = 0; i < nParts; i++)
+	{
+		if (pParts[i] != 0.0)
+		{
+			sum += CBigFloat(pParts[i], 53);
+		}
+	}
+	return sum;
+}
+
+static void buildTables()
+{
+	splitBigFloat(CBigConstants::getFloat(BigConstantLn2, s_nTablePrecision), s_Tables.ln2, 4);
+
+	CBigFloat halfPi = CBigConstants::getFloat(BigConstantPi, s_nTablePrecision);
+	halfPi.ldexp(-1);
+	splitBigFloat(halfPi, s_Tables.halfPi, 4);
+
+	CBigFloat one(1.0, s_nTablePrecision);
+	CBigFloat factorial(1.0, s_nTablePrecision);
+	for (int k = 0; k < s_nFactorialCount; k++)
+	{
+		if (k > 1)
+		{
+			factorial *= CBigFloat((double)k, s_nTablePrecision);
+		}
+		splitBigFloat(one / factorial, s_Tables.inverseFactorial[k], 4);
+	}
+}
+
+static const MultiDoubleTables& getTables()
+{
+	std::call_once(s_TablesOnce, buildTables);
+	return s_Tables;
+}
+
+static inline void setParts(CDoubleDouble &value, const double *pParts)
+{
+	value = CDoubleDouble(pParts[0], pParts[1]);
+}
+
+static inline void setParts(CQuadDouble &value, const double *pParts)
+{
+	value = CQuadDouble(pParts[0], pParts[1], pParts[2], pParts[3]);
+}
+
+template <class T> static T tableValue(const double *pParts)
+{
+	T value;
+	setParts(value, pParts);
+	return value;
+}
+
+// terms (roughly by decreasing magnitude) to four non-overlapping components:
+// error-free VecSum from smallest upward, then nonzero errors are collected
+static void renormalize(double *pTerms, const size_t nCount, double *pParts)
+{
+	double s = pTerms[nCount - 1];
+	for (size_t i = nCount - 1; i > 0; i--)
+	{
+		s = eftTwoSum(pTerms[i - 1], s, pTerms[i]);
+	}
+	pTerms[0] = s;
+
+	pParts[0] = pParts[1] = pParts[2] = pParts[3] = 0.0;
+	size_t j = 0;
+	double eps = pTerms[0];
+	for (size_t i = 1; i < nCount; i++)
+	{
+		double err = 0.0;
+		const double r = eftTwoSum(eps, pTerms[i], err);
+		if (err != 0.0)
+		{
+			pParts[j] = r;
+			if (j == 3)
+			{
+				return;
+			}
+			j++;
+			eps = err;
+		}
+		else
+		{
+			eps = r;
+		}
+	}
+	pParts[j] = eps;
+}
+
+// merge non-overlapping expansions by decreasing magnitude
+static size_t mergeByMagnitude(const double *pA, const size_t nA, const double *pB, const size_t nB, double *pDst)
+{
+	size_t i = 0;
+	size_t j = 0;
+	size_t k = 0;
+	while (i < nA && j < nB)
+	{
+		pDst[k++] = (fabs(pA[i]) >= fabs(pB[j])) ? pA[i++] : pB[j++];
+	}
+	while (i < nA)
+	{
+		pDst[k++] = pA[i++];
+	}
+	while (j < nB)
+	{
+		pDst[k++] = pB[j++];
+	}
+	return k;
+}
+
+
+////////// elementary functions for both types
+
+// sum of series terms is small enough to stop
+template <class T> static bool isNegligible(const T &term, const T &sum)
+{
+	return (fabs(term.toDouble()) <= fabs(sum.toDouble()) * T::epsilon() * 0.125);
+}
+
+// expm1 of reduced argument: x = k * ln2 + r,
+// exp(x) = (1 + result) * 2^k
+template <class T> static T expReduced(const T &x, const int nHalvings, double &k)
+{
+	const MultiDoubleTables &tables = getTables();
+	k = nearbyint(x.toDouble() / tables.ln2[0]);
+	const T r = (x - tableValue<T>(tables.ln2) * k).ldexp(-nHalvings);
+
+	// expm1(r) by Taylor series
+	T power = r;
+	T sum = r;
+	for (int i = 2; i < s_nFactorialCount; i++)
+	{
+		power = power * r;
+		const T term = power * tableValue<T>(tables.inverseFactorial[i]);
+		sum = sum + term;
+		if (isNegligible(term, sum) == true)
+		{
+			break;
+		}
+	}
+
+	// expm1(2r) = expm1(r) * (expm1(r) + 2)
+	for (int i = 0; i < nHalvings; i++)
+	{
+		sum = sum * (sum + 2.0);
+	}
+	return sum;
+}
+
+template <class T> static T expGeneric(const T &x, const int nHalvings)
+{
+	const double d = x.toDouble();
+	if (isnan(d))
+	{
+		return T(d);
+	}
+	if (d > 709.79)
+	{
+		return T(INFINITY);
+	}
+	if (d < -745.2)
+	{
+		return T(0.0);
+	}
+	if (d == 0.0)
+	{
+		return T(1.0);
+	}
+
+	double k = 0.0;
+	const T sum = expReduced(x, nHalvings, k);
+	return (sum + 1.0).ldexp((int)k);
+}
+
+template <class T> static T logGeneric(const T &x, const int nIterations, const int nHalvings)
+{
+	const double d = x.toDouble();
+	if (isnan(d) || d < 0.0)
+	{
+		return T(NAN);
+	}
+	if (d == 0.0)
+	{
+		return T(-INFINITY);
+	}
+	if (isinf(d))
+	{
+		return T(INFINITY);
+	}
+
+	// log(x) = e * ln2 + log(x / 2^e) with x / 2^e in [1/sqrt(2), sqrt(2)]:
+	// Newton starts with small absolute error
+	int nExponent = ilogb(d);
+	if (::ldexp(d, -nExponent) > 1.4142135623730951)
+	{
+		nExponent++;
+	}
+	const T scaled = x.ldexp(-nExponent);
+
+	// Newton: y += x * exp(-y) - 1,
+	// near 1 as (x - 1) * (1 + m) + m where m = expm1(-y)
+	// so that result has relative accuracy
+	T y = ::log(scaled.toDouble());
+	for (int i = 0; i < nIterations; i++)
+	{
+		double k = 0.0;
+		const T m = expReduced(-y, nHalvings, k);
+		if (k == 0.0)
+		{
+			const T xm1 = scaled - 1.0;
+			y = y + (xm1 + xm1 * m + m);
+		}
+		else
+		{
+			y = y + scaled * (m + 1.0).ldexp((int)k) - 1.0;
+		}
+	}
+	if (nExponent != 0)
+	{
+		y = y + tableValue<T>(getTables().ln2) * (double)nExponent;
+	}
+	return y;
+}
+
+// sine and cosine of |r| <= pi/4 by Taylor series
+template <class T> static void sinCosSeries(const T &r, T &s, T &c)
+{
+	const MultiDoubleTables &tables = getTables();
+	const T square = r * r;
+
+	T power = r;
+	s = r;
+	for (int i = 3; i < s_nFactorialCount; i += 2)
+	{
+		power = power * square;
+		const T term = power * tableValue<T>(tables.inverseFactorial[i]);
+		s = ((i & 2) != 0) ? (s - term) : (s + term);
+		if (isNegligible(term, s) == true)
+		{
+			break;
+		}
+	}
+
+	power = square;
+	c = T(1.0) - square.ldexp(-1);
+	for (int i = 4; i < s_nFactorialCount; i += 2)
+	{
+		power = power * square;
+		const T term = power * tableValue<T>(tables.inverseFactorial[i]);
+		c = ((i & 2) != 0) ? (c - term) : (c + term);
+		if (isNegligible(term, c) == true)
+		{
+			break;
+		}
+	}
+}
+
+template <class T> static void sinCosGeneric(const T &x, T &s, T &c)
+{
+	const double d = x.toDouble();
+	if (isfinite(d) == false)
+	{
+		s = c = T(NAN);
+		return;
+	}
+	if (d == 0.0)
+	{
+		s = x;
+		c = T(1.0);
+		return;
+	}
+
+	// reduce to [-pi/4, pi/4] and quadrant
+	const MultiDoubleTables &tables = getTables();
+	const double k = nearbyint(d / tables.halfPi[0]);
+	const T r = x - tableValue<T>(tables.halfPi) * k;
+	int nQuadrant = (int)fmod(k, 4.0);
+	if (nQuadrant < 0)
+	{
+		nQuadrant += 4;
+	}
+
+	T sr;
+	T cr;
+	sinCosSeries(r, sr, cr);
+	switch (nQuadrant)
+	{
+	case 0:
+		s = sr;
+		c = cr;
+		break;
+	case 1:
+		s = cr;
+		c = -sr;
+		break;
+	case 2:
+		s = -sr;
+		c = -cr;
+		break;
+	default:
+		s = -cr;
+		c = sr;
+		break;
+	}
+}
+
+template <class T> static T atanGeneric(const T &x, const int nIterations)
+{
+	const double d = x.toDouble();
+	if (isnan(d))
+	{
+		return x;
+	}
+	if (isinf(d))
+	{
+		const T halfPi = tableValue<T>(getTables().halfPi);
+		return (d > 0.0) ? halfPi : -halfPi;
+	}
+	if (d == 0.0)
+	{
+		return x;
+	}
+
+	// atan(x) = pi/2 - atan(1/x) keeps Newton
+	// in range where it converges quadratically (|x| <= 1)
+	const bool bInvert = (fabs(d) > 1.0);
+	const T y = bInvert ? T(1.0) / x : x;
+
+	// Newton on tan(z) = y: z += (y * cos(z) - sin(z)) * cos(z)
+	T z = ::atan(y.toDouble());
+	for (int i = 0; i < nIterations; i++)
+	{
+		T s;
+		T c;
+		sinCosGeneric(z, s, c);
+		z = z + (y * c - s) * c;
+	}
+
+	if (bInvert == true)
+	{
+		const T halfPi = tableValue<T>(getTables().halfPi);
+		z = (d > 0.0) ? (halfPi - z) : (-halfPi - z);
+	}
+	return z;
+}
+
+
+////////// SIMD kernels
+
+#if defined(BIGMULTIDOUBLE_AVX2)
+
+static inline __m256d twoSum4(const __m256d a, const __m256d b, __m256d &err)
+{
+	const __m256d s = _mm256_add_pd(a, b);
+	const __m256d bb = _mm256_sub_pd(s, a);
+	err = _mm256_add_pd(_mm256_sub_pd(a, _mm256_sub_pd(s, bb)), _mm256_sub_pd(b, bb));
+	return s;
+}
+
+static inline __m256d quickTwoSum4(const __m256d a, const __m256d b, __m256d &err)
+{
+	const __m256d s = _mm256_add_pd(a, b);
+	err = _mm256_sub_pd(b, _mm256_sub_pd(s, a));
+	return s;
+}
+
+static inline __m256d twoProd4(const __m256d a, const __m256d b, __m256d &err)
+{
+	const __m256d p = _mm256_mul_pd(a, b);
+	err = _mm256_fmsub_pd(a, b, p);
+	return p;
+}
+
+// a * b + c as ddMulAdd()
+static inline __m256d mulAdd4(const __m256d a, const __m256d b, const __m256d c)
+{
+#if defined(BIGMULTIDOUBLE_FMA)
+	return _mm256_fmadd_pd(a, b, c);
+#else
+	return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+#endif
+}
+
+static inline void add4(const __m256d aHigh, const __m256d aLow, const __m256d bHigh, const __m256d bLow, __m256d &high, __m256d &low)
+{
+	__m256d s2;
+	__m256d t2;
+	__m256d s1 = twoSum4(aHigh, bHigh, s2);
+	const __m256d t1 = twoSum4(aLow, bLow, t2);
+	s2 = _mm256_add_pd(s2, t1);
+	s1 = quickTwoSum4(s1, s2, s2);
+	s2 = _mm256_add_pd(s2, t2);
+	high = quickTwoSum4(s1, s2, low);
+}
+
+static inline void addDouble4(const __m256d aHigh, const __m256d aLow, const __m256d b, __m256d &high, __m256d &low)
+{
+	__m256d s2;
+	const __m256d s1 = twoSum4(aHigh, b, s2);
+	s2 = _mm256_add_pd(s2, aLow);
+	high = quickTwoSum4(s1, s2, low);
+}
+
+static inline void mul4(const __m256d aHigh, const __m256d aLow, const __m256d bHigh, const __m256d bLow, __m256d &high, __m256d &low)
+{
+	__m256d p2;
+	const __m256d p1 = twoProd4(aHigh, bHigh, p2);
+	p2 = _mm256_add_pd(p2, mulAdd4(aHigh, bLow, _mm256_mul_pd(aLow, bHigh)));
+	high = quickTwoSum4(p1, p2, low);
+}
+
+static inline void mulDouble4(const __m256d aHigh, const __m256d aLow, const __m256d b, __m256d &high, __m256d &low)
+{
+	__m256d p2;
+	const __m256d p1 = twoProd4(aHigh, b, p2);
+	p2 = mulAdd4(aLow, b, p2);
+	high = quickTwoSum4(p1, p2, low);
+}
+
+static inline void div4(const __m256d aHigh, const __m256d aLow, const __m256d bHigh, const __m256d bLow, __m256d &high, __m256d &low)
+{
+	const __m256d negate = _mm256_set1_pd(-0.0);
+	__m256d tHigh;
+	__m256d tLow;
+	__m256d rHigh;
+	__m256d rLow;
+
+	__m256d q1 = _mm256_div_pd(aHigh, bHigh);
+	mulDouble4(bHigh, bLow, q1, tHigh, tLow);
+	add4(aHigh, aLow, _mm256_xor_pd(tHigh, negate), _mm256_xor_pd(tLow, negate), rHigh, rLow);
+
+	__m256d q2 = _mm256_div_pd(rHigh, bHigh);
+	mulDouble4(bHigh, bLow, q2, tHigh, tLow);
+	add4(rHigh, rLow, _mm256_xor_pd(tHigh, negate), _mm256_xor_pd(tLow, negate), rHigh, rLow);
+
+	const __m256d q3 = _mm256_div_pd(rHigh, bHigh);
+	q1 = quickTwoSum4(q1, q2, q2);
+	addDouble4(q1, q2, q3, high, low);
+}
+
+#endif // BIGMULTIDOUBLE_AVX2
+
+
+////////// double-double
+
+CDoubleDouble& CDoubleDouble::fromBigFloat(const CBigFloat &value)
+{
+	double parts[2];
+	splitBigFloat(value, parts, 2);
+	m_dHigh = parts[0];
+	m_dLow = parts[1];
+	return *this;
+}
+
+CDoubleDouble& CDoubleDouble::fromBigValue(const CBigValue &value)
+{
+	return fromBigFloat(CBigFloat(value, 128));
+}
+
+CDoubleDouble& CDoubleDouble::fromExtended(const uint8_t *data)
+{
+	CBigFloat value(64);
+	value.fromExtended(data);
+	return fromBigFloat(value);
+}
+
+CDoubleDouble& CDoubleDouble::fromQuadruple(const uint8_t *data)
+{
+	CBigFloat value(113);
+	value.fromQuadruple(data);
+	return fromBigFloat(value);
+}
+
+CBigFloat CDoubleDouble::toBigFloat() const
+{
+	const double parts[2] = {m_dHigh, m_dLow};
+	return sumParts(parts, 2);
+}
+
+CBigValue CDoubleDouble::toBigValue(const size_t nScale, const BigRounding eRounding) const
+{
+	return toBigFloat().toBigValue(nScale, eRounding);
+}
+
+CDoubleDouble CDoubleDouble::operator / (const CDoubleDouble &other) const
+{
+	// long division: quotient digit per double
+	double q1 = m_dHigh / other.m_dHigh;
+	CDoubleDouble r = *this - other * q1;
+	double q2 = r.m_dHigh / other.m_dHigh;
+	r -= other * q2;
+	const double q3 = r.m_dHigh / other.m_dHigh;
+
+	q1 = eftQuickTwoSum(q1, q2, q2);
+	return CDoubleDouble(q1, q2) + q3;
+}
+
+CDoubleDouble CDoubleDouble::operator / (const double other) const
+{
+	const double q1 = m_dHigh / other;
+
+	// remainder of high part exactly
+	double p2 = 0.0;
+	const double p1 = eftTwoProd(q1, other, p2);
+	double e = 0.0;
+	const double s = eftTwoSum(m_dHigh, -p1, e);
+	e -= p2;
+	e += m_dLow;
+
+	double q2 = (s + e) / other;
+	const double q = eftQuickTwoSum(q1, q2, q2);
+	return CDoubleDouble(q, q2);
+}
+
+CDoubleDouble CDoubleDouble::sqrt(const CDoubleDouble &a)
+{
+	if (a.m_dHigh == 0.0)
+	{
+		return a;
+	}
+	if (a.m_dHigh < 0.0)
+	{
+		return CDoubleDouble(NAN);
+	}
+
+	// Karp: sqrt(a) = a*x + (a - (a*x)^2) * x/2 where x = 1/sqrt(a)
+	const double x = 1.0 / ::sqrt(a.m_dHigh);
+	const double ax = a.m_dHigh * x;
+	const double dCorrection = (a - product(ax, ax)).m_dHigh * (x * 0.5);
+	double err = 0.0;
+	const double s = eftTwoSum(ax, dCorrection, err);
+	return CDoubleDouble(s, err);
+}
+
+CDoubleDouble CDoubleDouble::exp(const CDoubleDouble &x)
+{
+	return expGeneric(x, 8);
+}
+
+CDoubleDouble CDoubleDouble::log(const CDoubleDouble &x)
+{
+	return logGeneric(x, 1, 8);
+}
+
+CDoubleDouble CDoubleDouble::sin(const CDoubleDouble &x)
+{
+	CDoubleDouble s;
+	CDoubleDouble c;
+	sinCosGeneric(x, s, c);
+	return s;
+}
+
+CDoubleDouble CDoubleDouble::cos(const CDoubleDouble &x)
+{
+	CDoubleDouble s;
+	CDoubleDouble c;
+	sinCosGeneric(x, s, c);
+	return c;
+}
+
+CDoubleDouble CDoubleDouble::atan(const CDoubleDouble &x)
+{
+	return atanGeneric(x, 1);
+}
+
+
+////////// quad-double
+
+CQuadDouble& CQuadDouble::fromBigFloat(const CBigFloat &value)
+{
+	splitBigFloat(value, m_dParts, 4);
+	return *this;
+}
+
+CQuadDouble& CQuadDouble::fromBigValue(const CBigValue &value)
+{
+	return fromBigFloat(CBigFloat(value, 256));
+}
+
+CQuadDouble& CQuadDouble::fromExtended(const uint8_t *data)
+{
+	CBigFloat value(64);
+	value.fromExtended(data);
+	return fromBigFloat(value);
+}
+
+CQuadDouble& CQuadDouble::fromQuadruple(const uint8_t *data)
+{
+	CBigFloat value(113);
+	value.fromQuadruple(data);
+	return fromBigFloat(value);
+}
+
+CBigFloat CQuadDouble::toBigFloat() const
+{
+	return sumParts(m_dParts, 4);
+}
+
+CBigValue CQuadDouble::toBigValue(const size_t nScale, const BigRounding eRounding) const
+{
+	return toBigFloat().toBigValue(nScale, eRounding);
+}
+
+CQuadDouble CQuadDouble::operator + (const CQuadDouble &other) const
+{
+	double terms[8];
+	mergeByMagnitude(m_dParts, 4, other.m_dParts, 4, terms);
+
+	CQuadDouble result;
+	renormalize(terms, 8, result.m_dParts);
+	return result;
+}
+
+CQuadDouble CQuadDouble::operator + (const double other) const
+{
+	double terms[5];
+	mergeByMagnitude(m_dParts, 4, &other, 1, terms);
+
+	CQuadDouble result;
+	renormalize(terms, 5, result.m_dParts);
+	return result;
+}
+
+CQuadDouble CQuadDouble::operator - (const CQuadDouble &other) const
+{
+	return *this + (-other);
+}
+
+CQuadDouble CQuadDouble::operator - (const double other) const
+{
+	return *this + (-other);
+}
+
+CQuadDouble CQuadDouble::operator * (const CQuadDouble &other) const
+{
+	const double *a = m_dParts;
+	const double *b = other.m_dParts;
+
+	// products by order (sum of component indices),
+	// errors of each order belong to next one
+	double e00, e01, e10, e02, e11, e20, e03, e12, e21, e30;
+	const double p00 = eftTwoProd(a[0], b[0], e00);
+	const double p01 = eftTwoProd(a[0], b[1], e01);
+	const double p10 = eftTwoProd(a[1], b[0], e10);
+	const double p02 = eftTwoProd(a[0], b[2], e02);
+	const double p11 = eftTwoProd(a[1], b[1], e11);
+	const double p20 = eftTwoProd(a[2], b[0], e20);
+	const double p03 = eftTwoProd(a[0], b[3], e03);
+	const double p12 = eftTwoProd(a[1], b[2], e12);
+	const double p21 = eftTwoProd(a[2], b[1], e21);
+	const double p30 = eftTwoProd(a[3], b[0], e30);
+	const double q4 = (a[1] * b[3] + a[2] * b[2] + a[3] * b[1]) + ((e03 + e12) + (e21 + e30));
+
+	double terms[17] = {
+		p00,
+		e00, p01, p10,
+		e01, e10, p02, p11, p20,
+		e02, e11, e20, p03, p12, p21, p30,
+		q4
+	};
+
+	CQuadDouble result;
+	renormalize(terms, 17, result.m_dParts);
+	return result;
+}
+
+CQuadDouble CQuadDouble::operator * (const double other) const
+{
+	double e0, e1, e2;
+	const double p0 = eftTwoProd(m_dParts[0], other, e0);
+	const double p1 = eftTwoProd(m_dParts[1], other, e1);
+	const double p2 = eftTwoProd(m_dParts[2], other, e2);
+	const double p3 = m_dParts[3] * other;
+
+	double terms[7] = {p0, e0, p1, e1, p2, e2, p3};
+
+	CQuadDouble result;
+	renormalize(terms, 7, result.m_dParts);
+	return result;
+}
+
+CQuadDouble CQuadDouble::operator / (const CQuadDouble &other) const
+{
+	// long division: quotient digit per double
+	double terms[5];
+	CQuadDouble r = *this;
+	for (int i = 0; i < 4; i++)
+	{
+		terms[i] = r.m_dParts[0] / other.m_dParts[0];
+		r -= other * terms[i];
+	}
+	terms[4] = r.m_dParts[0] / other.m_dParts[0];
+
+	CQuadDouble result;
+	renormalize(terms, 5, result.m_dParts);
+	return result;
+}
+
+CQuadDouble CQuadDouble::operator / (const double other) const
+{
+	return *this / CQuadDouble(other);
+}
+
+int CQuadDouble::compare(const CQuadDouble &other) const
+{
+	for (int i = 0; i < 4; i++)
+	{
+		if (m_dParts[i] < other.m_dParts[i])
+		{
+			return -1;
+		}
+		if (m_dParts[i] > other.m_dParts[i])
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+CQuadDouble CQuadDouble::sqrt(const CQuadDouble &a)
+{
+	if (a.m_dParts[0] == 0.0)
+	{
+		return a;
+	}
+	if (a.m_dParts[0] < 0.0)
+	{
+		return CQuadDouble(NAN);
+	}
+
+	// Newton for x = 1/sqrt(a): x += x * (1/2 - a/2 * x^2),
+	// then Karp: sqrt(a) = a*x + (a - (a*x)^2) * x/2
+	const CQuadDouble half = a.ldexp(-1);
+	CQuadDouble x = 1.0 / ::sqrt(a.m_dParts[0]);
+	for (int i = 0; i < 2; i++)
+	{
+		x += x * (CQuadDouble(0.5) - half * (x * x));
+	}
+	const CQuadDouble y = a * x;
+	return y + (a - y * y) * x.ldexp(-1);
+}
+
+CQuadDouble CQuadDouble::exp(const CQuadDouble &x)
+{
+	return expGeneric(x, 10);
+}
+
+CQuadDouble CQuadDouble::log(const CQuadDouble &x)
+{
+	return logGeneric(x, 2, 10);
+}
+
+CQuadDouble CQuadDouble::sin(const CQuadDouble &x)
+{
+	CQuadDouble s;
+	CQuadDouble c;
+	sinCosGeneric(x, s, c);
+	return s;
+}
+
+CQuadDouble CQuadDouble::cos(const CQuadDouble &x)
+{
+	CQuadDouble s;
+	CQuadDouble c;
+	sinCosGeneric(x, s, c);
+	return c;
+}
+
+CQuadDouble CQuadDouble::atan(const CQuadDouble &x)
+{
+	return atanGeneric(x, 2);
+}
+
+
+////////// bulk operations
+
+void ddArrayAdd(double *pHigh, double *pLow, const double *pAHigh, const double *pALow, const double *pBHigh, const double *pBLow, const size_t nCount)
+{
+	size_t i = 0;
+#if defined(BIGMULTIDOUBLE_AVX2)
+	for (; i + 4 <= nCount; i += 4)
+	{
+		__m256d high;
+		__m256d low;
+		add4(_mm256_loadu_pd(pAHigh + i), _mm256_loadu_pd(pALow + i), _mm256_loadu_pd(pBHigh + i), _mm256_loadu_pd(pBLow + i), high, low);
+		_mm256_storeu_pd(pHigh + i, high);
+		_mm256_storeu_pd(pLow + i, low);
+	}
+#endif
+	for (; i < nCount; i++)
+	{
+		const CDoubleDouble value = CDoubleDouble(pAHigh[i], pALow[i]) + CDoubleDouble(pBHigh[i], pBLow[i]);
+		pHigh[i] = value.getHigh();
+		pLow[i] = value.getLow();
+	}
+}
+
+void ddArrayMul(double *pHigh, double *pLow, const double *pAHigh, const double *pALow, const double *pBHigh, const double *pBLow, const size_t nCount)
+{
+	size_t i = 0;
+#if defined(BIGMULTIDOUBLE_AVX2)
+	for (; i + 4 <= nCount; i += 4)
+	{
+		__m256d high;
+		__m256d low;
+		mul4(_mm256_loadu_pd(pAHigh + i), _mm256_loadu_pd(pALow + i), _mm256_loadu_pd(pBHigh + i), _mm256_loadu_pd(pBLow + i), high, low);
+		_mm256_storeu_pd(pHigh + i, high);
+		_mm256_storeu_pd(pLow + i, low);
+	}
+#endif
+	for (; i < nCount; i++)
+	{
+		const CDoubleDouble value = CDoubleDouble(pAHigh[i], pALow[i]) * CDoubleDouble(pBHigh[i], pBLow[i]);
+		pHigh[i] = value.getHigh();
+		pLow[i] = value.getLow();
+	}
+}
+
+void ddArrayDiv(double *pHigh, double *pLow, const double *pAHigh, const double *pALow, const double *pBHigh, const double *pBLow, const size_t nCount)
+{
+	size_t i = 0;
+#if defined(BIGMULTIDOUBLE_AVX2)
+	for (; i + 4 <= nCount; i += 4)
+	{
+		__m256d high;
+		__m256d low;
+		div4(_mm256_loadu_pd(pAHigh + i), _mm256_loadu_pd(pALow + i), _mm256_loadu_pd(pBHigh + i), _mm256_loadu_pd(pBLow + i), high, low);
+		_mm256_storeu_pd(pHigh + i, high);
+		_mm256_storeu_pd(pLow + i, low);
+	}
+#endif
+	for (; i < nCount; i++)
+	{
+		const CDoubleDouble value = CDoubleDouble(pAHigh[i], pALow[i]) / CDoubleDouble(pBHigh[i], pBLow[i]);
+		pHigh[i] = value.getHigh();
+		pLow[i] = value.getLow();
+	}
+}
+
+CDoubleDouble ddArrayDot(const double *pAHigh, const double *pALow, const double *pBHigh, const double *pBLow, const size_t nCount)
+{
+	// summation order as in header, same with and without AVX2
+	CDoubleDouble sum;
+	size_t i = 0;
+	if (nCount >= 4)
+	{
+#if defined(BIGMULTIDOUBLE_AVX2)
+		__m256d sumHigh = _mm256_setzero_pd();
+		__m256d sumLow = _mm256_setzero_pd();
+		for (; i + 4 <= nCount; i += 4)
+		{
+			__m256d high;
+			__m256d low;
+			mul4(_mm256_loadu_pd(pAHigh + i), _mm256_loadu_pd(pALow + i), _mm256_loadu_pd(pBHigh + i), _mm256_loadu_pd(pBLow + i), high, low);
+			add4(sumHigh, sumLow, high, low, sumHigh, sumLow);
+		}
+
+		double high[4];
+		double low[4];
+		_mm256_storeu_pd(high, sumHigh);
+		_mm256_storeu_pd(low, sumLow);
+		for (int j = 0; j < 4; j++)
+		{
+			sum += CDoubleDouble(high[j], low[j]);
+		}
+#else
+		CDoubleDouble partial[4];
+		for (; i + 4 <= nCount; i += 4)
+		{
+			for (size_t j = 0; j < 4; j++)
+			{
+				partial[j] += CDoubleDouble(pAHigh[i + j], pALow[i + j]) * CDoubleDouble(pBHigh[i + j], pBLow[i + j]);
+			}
+		}
+		for (int j = 0; j < 4; j++)
+		{
+			sum += partial[j];
+		}
+#endif
+	}
+	for (; i < nCount; i++)
+	{
+		sum += CDoubleDouble(pAHigh[i], pALow[i]) * CDoubleDouble(pBHigh[i], pBLow[i]);
+	}
+	return sum;
+}
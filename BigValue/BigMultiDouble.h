@@ -0,0 +1,438 @@
+/////////////////////////////////////
+//
+// CDoubleDouble, CQuadDouble : fast mid-precision
+// floating point as unevaluated sums of doubles.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Value is sum of components, largest first, each component
+// at most half ulp of previous one (non-overlapping):
+// double-double has 106 bits (about 32 digits) and
+// quad-double 212 bits (about 64 digits) of precision,
+// exponent range is same as of double.
+//
+// Arithmetic uses error-free transformations:
+// a + b = s + e exactly (TwoSum) and a * b = p + e exactly
+// (TwoProd by fused multiply-add) so that an operation is
+// a handful of double operations instead of limb arithmetic
+// (Hida, Li, Bailey: "Library for double-double and quad-double arithmetic").
+//
+// Results are not correctly rounded: relative error is
+// few units of epsilon() for arithmetic and elementary functions
+// (error of sin and cos is absolute near their zeros,
+// argument reduction error grows with |x| for exp, sin and cos).
+// Infinity and NaN are not kept reliably by arithmetic.
+// Must not be compiled with unsafe math optimizations
+// (-ffast-math, /fp:fast) which remove error terms.
+//
+
+#ifndef BIGMULTIDOUBLE_H
+#define BIGMULTIDOUBLE_H
+
+#include "BigValue.h"
+#include "BigFloat.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+
+////////// error-free transformations
+
+// fused multiply-add available: used explicitly in scalar code
+// and SIMD kernels alike (see ddMulAdd)
+#if defined(FP_FAST_FMA) || defined(__FMA__)
+#define BIGMULTIDOUBLE_FMA
+#endif
+
+// a + b = sum + err exactly
+static inline double eftTwoSum(const double a, const double b, double &err)
+{
+	const double s = a + b;
+	const double bb = s - a;
+	err = (a - (s - bb)) + (b - bb);
+	return s;
+}
+
+// a + b = sum + err exactly, requires |a| >= |b|
+static inline double eftQuickTwoSum(const double a, const double b, double &err)
+{
+	const double s = a + b;
+	err = b - (s - a);
+	return s;
+}
+
+// a * b = product + err exactly (unless product overflows)
+static inline double eftTwoProd(const double a, const double b, double &err)
+{
+	const double p = a * b;
+#if defined(BIGMULTIDOUBLE_FMA)
+	err = ::fma(a, b, -p);
+#else
+	// Dekker: split to 26-bit halves
+	const double dSplitter = 134217729.0; // 2^27 + 1
+	double t = dSplitter * a;
+	const double aHigh = t - (t - a);
+	const double aLow = a - aHigh;
+	t = dSplitter * b;
+	const double bHigh = t - (t - b);
+	const double bLow = b - bHigh;
+	err = ((aHigh * bHigh - p) + aHigh * bLow + aLow * bHigh) + aLow * bLow;
+#endif
+	return p;
+}
+
+// a * b + c, fused when available: compiler may otherwise contract
+// some expressions and not others, and result of bulk operation
+// would depend on element position (SIMD body or scalar tail)
+static inline double ddMulAdd(const double a, const double b, const double c)
+{
+#if defined(BIGMULTIDOUBLE_FMA)
+	return ::fma(a, b, c);
+#else
+	return a * b + c;
+#endif
+}
+
+
+class CDoubleDouble
+{
+protected:
+	double m_dHigh;
+	double m_dLow;
+
+public:
+	CDoubleDouble()
+		: m_dHigh(0.0)
+		, m_dLow(0.0)
+	{}
+	CDoubleDouble(const double value)
+		: m_dHigh(value)
+		, m_dLow(0.0)
+	{}
+	// components must be non-overlapping
+	CDoubleDouble(const double dHigh, const double dLow)
+		: m_dHigh(dHigh)
+		, m_dLow(dLow)
+	{}
+
+	// conversions: value is rounded to nearest
+	CDoubleDouble& fromBigFloat(const CBigFloat &value);
+	CDoubleDouble& fromBigValue(const CBigValue &value);
+	// expecting 80 bits in "long double" format, big-endian (as CBigValue)
+	CDoubleDouble& fromExtended(const uint8_t *data);
+	// expecting 128 bits (SPARC/PowerPC), big-endian (as CBigValue)
+	CDoubleDouble& fromQuadruple(const uint8_t *data);
+
+	// exact value
+	CBigFloat toBigFloat() const;
+	// rounded to integer at given power of 10 scale
+	CBigValue toBigValue(const size_t nScale = 0, const BigRounding eRounding = BigRoundingNearestEven) const;
+
+	double toDouble() const
+	{
+		return m_dHigh;
+	}
+	double getHigh() const
+	{
+		return m_dHigh;
+	}
+	double getLow() const
+	{
+		return m_dLow;
+	}
+
+	// relative precision: 2^-104
+	static double epsilon()
+	{
+		return 4.93038065763132e-32;
+	}
+
+	CDoubleDouble operator - () const
+	{
+		return CDoubleDouble(-m_dHigh, -m_dLow);
+	}
+
+	inline CDoubleDouble operator + (const CDoubleDouble &other) const;
+	inline CDoubleDouble operator + (const double other) const;
+	inline CDoubleDouble operator - (const CDoubleDouble &other) const;
+	inline CDoubleDouble operator - (const double other) const;
+	inline CDoubleDouble operator * (const CDoubleDouble &other) const;
+	inline CDoubleDouble operator * (const double other) const;
+	CDoubleDouble operator / (const CDoubleDouble &other) const;
+	CDoubleDouble operator / (const double other) const;
+
+	CDoubleDouble& operator += (const CDoubleDouble &other)
+	{
+		return (*this = *this + other);
+	}
+	CDoubleDouble& operator -= (const CDoubleDouble &other)
+	{
+		return (*this = *this - other);
+	}
+	CDoubleDouble& operator *= (const CDoubleDouble &other)
+	{
+		return (*this = *this * other);
+	}
+	CDoubleDouble& operator /= (const CDoubleDouble &other)
+	{
+		return (*this = *this / other);
+	}
+
+	bool operator == (const CDoubleDouble &other) const
+	{
+		return (m_dHigh == other.m_dHigh && m_dLow == other.m_dLow);
+	}
+	bool operator != (const CDoubleDouble &other) const
+	{
+		return !(*this == other);
+	}
+	bool operator < (const CDoubleDouble &other) const
+	{
+		return (m_dHigh < other.m_dHigh || (m_dHigh == other.m_dHigh && m_dLow < other.m_dLow));
+	}
+	bool operator > (const CDoubleDouble &other) const
+	{
+		return (other < *this);
+	}
+	bool operator <= (const CDoubleDouble &other) const
+	{
+		return (m_dHigh < other.m_dHigh || (m_dHigh == other.m_dHigh && m_dLow <= other.m_dLow));
+	}
+	bool operator >= (const CDoubleDouble &other) const
+	{
+		return (other <= *this);
+	}
+
+	// value * 2^n (exact)
+	CDoubleDouble ldexp(const int n) const
+	{
+		return CDoubleDouble(::ldexp(m_dHigh, n), ::ldexp(m_dLow, n));
+	}
+
+	// product of two doubles exactly
+	static CDoubleDouble product(const double a, const double b)
+	{
+		double err = 0.0;
+		const double p = eftTwoProd(a, b, err);
+		return CDoubleDouble(p, err);
+	}
+
+	static CDoubleDouble sqrt(const CDoubleDouble &a);
+	static CDoubleDouble exp(const CDoubleDouble &x);
+	static CDoubleDouble log(const CDoubleDouble &x);
+	static CDoubleDouble sin(const CDoubleDouble &x);
+	static CDoubleDouble cos(const CDoubleDouble &x);
+	static CDoubleDouble atan(const CDoubleDouble &x);
+};
+
+
+class CQuadDouble
+{
+protected:
+	double m_dParts[4];
+
+public:
+	CQuadDouble()
+	{
+		m_dParts[0] = m_dParts[1] = m_dParts[2] = m_dParts[3] = 0.0;
+	}
+	CQuadDouble(const double value)
+	{
+		m_dParts[0] = value;
+		m_dParts[1] = m_dParts[2] = m_dParts[3] = 0.0;
+	}
+	CQuadDouble(const CDoubleDouble &value)
+	{
+		m_dParts[0] = value.getHigh();
+		m_dParts[1] = value.getLow();
+		m_dParts[2] = m_dParts[3] = 0.0;
+	}
+	// components must be non-overlapping
+	CQuadDouble(const double d0, const double d1, const double d2, const double d3)
+	{
+		m_dParts[0] = d0;
+		m_dParts[1] = d1;
+		m_dParts[2] = d2;
+		m_dParts[3] = d3;
+	}
+
+	// conversions: value is rounded to nearest
+	CQuadDouble& fromBigFloat(const CBigFloat &value);
+	CQuadDouble& fromBigValue(const CBigValue &value);
+	// expecting 80 bits in "long double" format, big-endian (as CBigValue)
+	CQuadDouble& fromExtended(const uint8_t *data);
+	// expecting 128 bits (SPARC/PowerPC), big-endian (as CBigValue)
+	CQuadDouble& fromQuadruple(const uint8_t *data);
+
+	// exact value
+	CBigFloat toBigFloat() const;
+	// rounded to integer at given power of 10 scale
+	CBigValue toBigValue(const size_t nScale = 0, const BigRounding eRounding = BigRoundingNearestEven) const;
+
+	double toDouble() const
+	{
+		return m_dParts[0];
+	}
+	double getPart(const size_t nIndex) const
+	{
+		return m_dParts[nIndex];
+	}
+	// two largest components
+	CDoubleDouble toDoubleDouble() const
+	{
+		double err = 0.0;
+		const double s = eftQuickTwoSum(m_dParts[0], m_dParts[1] + m_dParts[2], err);
+		return CDoubleDouble(s, err);
+	}
+
+	// relative precision: 2^-209
+	static double epsilon()
+	{
+		return 1.21543267145725e-63;
+	}
+
+	CQuadDouble operator - () const
+	{
+		return CQuadDouble(-m_dParts[0], -m_dParts[1], -m_dParts[2], -m_dParts[3]);
+	}
+
+	CQuadDouble operator + (const CQuadDouble &other) const;
+	CQuadDouble operator + (const double other) const;
+	CQuadDouble operator - (const CQuadDouble &other) const;
+	CQuadDouble operator - (const double other) const;
+	CQuadDouble operator * (const CQuadDouble &other) const;
+	CQuadDouble operator * (const double other) const;
+	CQuadDouble operator / (const CQuadDouble &other) const;
+	CQuadDouble operator / (const double other) const;
+
+	CQuadDouble& operator += (const CQuadDouble &other)
+	{
+		return (*this = *this + other);
+	}
+	CQuadDouble& operator -= (const CQuadDouble &other)
+	{
+		return (*this = *this - other);
+	}
+	CQuadDouble& operator *= (const CQuadDouble &other)
+	{
+		return (*this = *this * other);
+	}
+	CQuadDouble& operator /= (const CQuadDouble &other)
+	{
+		return (*this = *this / other);
+	}
+
+	// compare components from largest
+	int compare(const CQuadDouble &other) const;
+	bool operator == (const CQuadDouble &other) const
+	{
+		return (compare(other) == 0);
+	}
+	bool operator != (const CQuadDouble &other) const
+	{
+		return (compare(other) != 0);
+	}
+	bool operator < (const CQuadDouble &other) const
+	{
+		return (compare(other) < 0);
+	}
+	bool operator <= (const CQuadDouble &other) const
+	{
+		return (compare(other) <= 0);
+	}
+	bool operator > (const CQuadDouble &other) const
+	{
+		return (compare(other) > 0);
+	}
+	bool operator >= (const CQuadDouble &other) const
+	{
+		return (compare(other) >= 0);
+	}
+
+	// value * 2^n (exact)
+	CQuadDouble ldexp(const int n) const
+	{
+		return CQuadDouble(::ldexp(m_dParts[0], n), ::ldexp(m_dParts[1], n), ::ldexp(m_dParts[2], n), ::ldexp(m_dParts[3], n));
+	}
+
+	static CQuadDouble sqrt(const CQuadDouble &a);
+	static CQuadDouble exp(const CQuadDouble &x);
+	static CQuadDouble log(const CQuadDouble &x);
+	static CQuadDouble sin(const CQuadDouble &x);
+	static CQuadDouble cos(const CQuadDouble &x);
+	static CQuadDouble atan(const CQuadDouble &x);
+};
+
+
+////////// double-double arithmetic (inline, only few operations)
+
+inline CDoubleDouble CDoubleDouble::operator + (const CDoubleDouble &other) const
+{
+	double s2 = 0.0;
+	double t2 = 0.0;
+	double s1 = eftTwoSum(m_dHigh, other.m_dHigh, s2);
+	const double t1 = eftTwoSum(m_dLow, other.m_dLow, t2);
+	s2 += t1;
+	s1 = eftQuickTwoSum(s1, s2, s2);
+	s2 += t2;
+	s1 = eftQuickTwoSum(s1, s2, s2);
+	return CDoubleDouble(s1, s2);
+}
+
+inline CDoubleDouble CDoubleDouble::operator + (const double other) const
+{
+	double s2 = 0.0;
+	double s1 = eftTwoSum(m_dHigh, other, s2);
+	s2 += m_dLow;
+	s1 = eftQuickTwoSum(s1, s2, s2);
+	return CDoubleDouble(s1, s2);
+}
+
+inline CDoubleDouble CDoubleDouble::operator - (const CDoubleDouble &other) const
+{
+	return *this + (-other);
+}
+
+inline CDoubleDouble CDoubleDouble::operator - (const double other) const
+{
+	return *this + (-other);
+}
+
+inline CDoubleDouble CDoubleDouble::operator * (const CDoubleDouble &other) const
+{
+	double p2 = 0.0;
+	double p1 = eftTwoProd(m_dHigh, other.m_dHigh, p2);
+	p2 += ddMulAdd(m_dHigh, other.m_dLow, m_dLow * other.m_dHigh);
+	p1 = eftQuickTwoSum(p1, p2, p2);
+	return CDoubleDouble(p1, p2);
+}
+
+inline CDoubleDouble CDoubleDouble::operator * (const double other) const
+{
+	double p2 = 0.0;
+	double p1 = eftTwoProd(m_dHigh, other, p2);
+	p2 = ddMulAdd(m_dLow, other, p2);
+	p1 = eftQuickTwoSum(p1, p2, p2);
+	return CDoubleDouble(p1, p2);
+}
+
+
+////////// bulk operations
+
+// double-double arrays kept as separate arrays of
+// high and low components (structure of arrays):
+// destination = A op B elementwise (AVX2 when compiled for it),
+// destination may be same as either operand.
+void ddArrayAdd(double *pHigh, double *pLow, const double *pAHigh, const double *pALow, const double *pBHigh, const double *pBLow, const size_t nCount);
+void ddArrayMul(double *pHigh, double *pLow, const double *pAHigh, const double *pALow, const double *pBHigh, const double *pBLow, const size_t nCount);
+void ddArrayDiv(double *pHigh, double *pLow, const double *pAHigh, const double *pALow, const double *pBHigh, const double *pBLow, const size_t nCount);
+
+// sum of elementwise products: four partial sums (element i to sum i % 4
+// for whole blocks of four), added in order 0-3, then remaining elements,
+// with or without AVX2 (bitwise same result when FMA use is same, see ddMulAdd)
+CDoubleDouble ddArrayDot(const double *pAHigh, const double *pALow, const double *pBHigh, const double *pBLow, const size_t nCount);
+
+#endif // BIGMULTIDOUBLE_H
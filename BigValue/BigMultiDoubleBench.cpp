@@ -0,0 +1,166 @@
+// BigMultiDoubleBench.cpp : operations per second of double-double
+// and quad-double against CBigFloat at equal precision.
+//
+// usage: BigMultiDoubleBench [count]
+//
+
+#include "BigMultiDouble.h"
+#include "BigMath.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+
+static double s_dSink = 0.0;
+
+static double elapsed(const std::chrono::steady_clock::time_point &start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void printRow(const char *szName, const size_t nCount, const double dFast, const double dBig)
+{
+	printf("%-8s %14.0f %14.0f %10.1f\n", szName, (double)nCount / dFast, (double)nCount / dBig, dBig / dFast);
+}
+
+// T against CBigFloat of same precision: ops/sec and speedup
+template <class T> static void benchType(const char *szName, const size_t nPrecision, const std::vector<T> &a, const std::vector<T> &b, const std::vector<CBigFloat> &bigA, const std::vector<CBigFloat> &bigB)
+{
+	const size_t nCount = a.size();
+	printf("\n%s (%zu bits)\n", szName, nPrecision);
+	printf("%-8s %14s %14s %10s\n", "op", "ops/sec", "CBigFloat", "speedup");
+
+	std::vector<T> result(nCount);
+	std::vector<CBigFloat> bigResult(nCount, CBigFloat(nPrecision));
+
+	const char *szOps[5] = {"add", "mul", "div", "sqrt", "exp"};
+	for (int nOp = 0; nOp < 5; nOp++)
+	{
+		// exp is much slower: fewer values
+		const size_t nOpCount = (nOp == 4) ? nCount / 20 : nCount;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < nOpCount; i++)
+		{
+			switch (nOp)
+			{
+			case 0: result[i] = a[i] + b[i]; break;
+			case 1: result[i] = a[i] * b[i]; break;
+			case 2: result[i] = a[i] / b[i]; break;
+			case 3: result[i] = T::sqrt(a[i]); break;
+			default: result[i] = T::exp(a[i]); break;
+			}
+		}
+		const double dFast = elapsed(start);
+		s_dSink += result[nOpCount / 2].toDouble();
+
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < nOpCount; i++)
+		{
+			switch (nOp)
+			{
+			case 0: bigResult[i].add(bigA[i], bigB[i]); break;
+			case 1: bigResult[i].mul(bigA[i], bigB[i]); break;
+			case 2: bigResult[i].div(bigA[i], bigB[i]); break;
+			case 3: bigResult[i].sqrt(bigA[i]); break;
+			default: bigResult[i] = CBigMath::exp(bigA[i], nPrecision); break;
+			}
+		}
+		const double dBig = elapsed(start);
+		s_dSink += bigResult[nOpCount / 2].toDouble();
+
+		printRow(szOps[nOp], nOpCount, dFast, dBig);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	size_t nCount = 200000;
+	if (argc > 1)
+	{
+		nCount = (size_t)strtoull(argv[1], nullptr, 10);
+	}
+
+	// positive values in [1, 2) with all bits used
+	std::mt19937_64 rng(12345);
+	std::uniform_real_distribution<double> dist(1.0, 2.0);
+	std::vector<CDoubleDouble> ddA(nCount);
+	std::vector<CDoubleDouble> ddB(nCount);
+	std::vector<CQuadDouble> qdA(nCount);
+	std::vector<CQuadDouble> qdB(nCount);
+	for (size_t i = 0; i < nCount; i++)
+	{
+		qdA[i] = CQuadDouble(dist(rng)) / CQuadDouble(dist(rng));
+		qdB[i] = CQuadDouble(dist(rng)) / CQuadDouble(dist(rng));
+		ddA[i] = qdA[i].toDoubleDouble();
+		ddB[i] = qdB[i].toDoubleDouble();
+	}
+
+	printf("%zu values\n", nCount);
+
+	std::vector<CBigFloat> bigA(nCount, CBigFloat(106));
+	std::vector<CBigFloat> bigB(nCount, CBigFloat(106));
+	for (size_t i = 0; i < nCount; i++)
+	{
+		bigA[i].set(ddA[i].toBigFloat());
+		bigB[i].set(ddB[i].toBigFloat());
+	}
+	benchType("double-double", 106, ddA, ddB, bigA, bigB);
+
+	bigA.assign(nCount, CBigFloat(212));
+	bigB.assign(nCount, CBigFloat(212));
+	for (size_t i = 0; i < nCount; i++)
+	{
+		bigA[i].set(qdA[i].toBigFloat());
+		bigB[i].set(qdB[i].toBigFloat());
+	}
+	benchType("quad-double", 212, qdA, qdB, bigA, bigB);
+
+	// structure of arrays against loop of scalar operations
+	std::vector<double> aHigh(nCount), aLow(nCount), bHigh(nCount), bLow(nCount), high(nCount), low(nCount);
+	for (size_t i = 0; i < nCount; i++)
+	{
+		aHigh[i] = ddA[i].getHigh();
+		aLow[i] = ddA[i].getLow();
+		bHigh[i] = ddB[i].getHigh();
+		bLow[i] = ddB[i].getLow();
+	}
+
+	printf("\ndouble-double arrays\n");
+	printf("%-8s %14s %14s %10s\n", "op", "array/sec", "scalar/sec", "speedup");
+	const char *szOps[3] = {"add", "mul", "div"};
+	std::vector<CDoubleDouble> result(nCount);
+	for (int nOp = 0; nOp < 3; nOp++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		switch (nOp)
+		{
+		case 0: ddArrayAdd(&high[0], &low[0], &aHigh[0], &aLow[0], &bHigh[0], &bLow[0], nCount); break;
+		case 1: ddArrayMul(&high[0], &low[0], &aHigh[0], &aLow[0], &bHigh[0], &bLow[0], nCount); break;
+		default: ddArrayDiv(&high[0], &low[0], &aHigh[0], &aLow[0], &bHigh[0], &bLow[0], nCount); break;
+		}
+		const double dArray = elapsed(start);
+		s_dSink += high[nCount / 2];
+
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < nCount; i++)
+		{
+			switch (nOp)
+			{
+			case 0: result[i] = ddA[i] + ddB[i]; break;
+			case 1: result[i] = ddA[i] * ddB[i]; break;
+			default: result[i] = ddA[i] / ddB[i]; break;
+			}
+		}
+		const double dScalar = elapsed(start);
+		s_dSink += result[nCount / 2].toDouble();
+
+		printRow(szOps[nOp], nCount, dArray, dScalar);
+	}
+
+	printf("\n(checksum %g)\n", s_dSink);
+	return 0;
+}
@@ -0,0 +1,145 @@
+// BigParallelCheck.cpp : results of big-number operations
+// run as tasks of TaskPool against same operations on single thread.
+//
+// usage: BigParallelCheck [rounds] [threads]
+//
+// Large multiplications fork inside tasks of parallel loop:
+// thread waiting at join runs other tasks of loop, so per-thread
+// scratch (multiply-accumulate, sums, function caches) is entered
+// again on same thread before outer call is done.
+// Default 20 rounds with 4 threads (oversubscribed on small machines
+// on purpose), exit code is nonzero on any mismatch.
+//
+
+#include "BigValue.h"
+#include "BigExpression.h"
+#include "BigMath.h"
+#include "../simplesse/TaskPool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <random>
+#include <vector>
+
+
+// operands of 1100-2600 limbs: Karatsuba halves above fork limit
+static const size_t s_nItems = 24;
+static const size_t s_nMinLimbs = 1100;
+static const size_t s_nLimbRange = 1500;
+
+// exp over distinct precisions (more than cached per thread)
+static const size_t s_nExpItems = 10;
+static const size_t s_nExpPrecision = 66000;
+
+static CBigValue randomValue(std::mt19937_64 &rng, const size_t nLimbs)
+{
+	CBigValue value((uint64_t)(rng() | 1));
+	for (size_t i = 1; i < nLimbs; i++)
+	{
+		value <<= 64;
+		value += CBigValue((uint64_t)rng());
+	}
+	return value;
+}
+
+// acc += x * y and x + y + acc for each item
+static void accumulateItems(const std::vector<CBigValue> &x, const std::vector<CBigValue> &y, const std::vector<CBigValue> &base,
+	std::vector<CBigValue> &products, std::vector<CBigValue> &sums)
+{
+	parallelFor(0, s_nItems, 1, [&](const size_t nBegin, const size_t nEnd)
+	{
+		for (size_t i = nBegin; i < nEnd; i++)
+		{
+			CBigValue acc(base[i]);
+			acc += bigExpr(x[i]) * y[i];
+			products[i] = acc;
+			sums[i] = bigExpr(x[i]) + y[i] - base[i];
+		}
+	});
+}
+
+static void expItems(const std::vector<CBigFloat> &args, std::vector<CBigFloat> &results)
+{
+	parallelFor(0, s_nExpItems, 1, [&](const size_t nBegin, const size_t nEnd)
+	{
+		for (size_t i = nBegin; i < nEnd; i++)
+		{
+			results[i] = CBigMath::exp(args[i], s_nExpPrecision + 64 * i);
+		}
+	});
+}
+
+int main(int argc, char *argv[])
+{
+	size_t nRounds = 20;
+	size_t nThreads = 4;
+	if (argc > 1)
+	{
+		nRounds = (size_t)::strtoull(argv[1], nullptr, 10);
+	}
+	if (argc > 2)
+	{
+		nThreads = (size_t)::strtoull(argv[2], nullptr, 10);
+	}
+
+	std::mt19937_64 rng(2024);
+	std::vector<CBigValue> x;
+	std::vector<CBigValue> y;
+	std::vector<CBigValue> base;
+	for (size_t i = 0; i < s_nItems; i++)
+	{
+		x.push_back(randomValue(rng, s_nMinLimbs + (size_t)(rng() % s_nLimbRange)));
+		y.push_back(randomValue(rng, s_nMinLimbs + (size_t)(rng() % s_nLimbRange)));
+		base.push_back(randomValue(rng, s_nMinLimbs + (size_t)(rng() % (2 * s_nLimbRange))));
+	}
+	std::vector<CBigFloat> args;
+	for (size_t i = 0; i < s_nExpItems; i++)
+	{
+		CBigFloat arg(64);
+		arg.fromDouble(0.25 + 0.125 * (double)i);
+		args.push_back(arg);
+	}
+
+	// reference on single thread
+	std::vector<CBigValue> expectedProducts(s_nItems);
+	std::vector<CBigValue> expectedSums(s_nItems);
+	std::vector<CBigFloat> expectedExp(s_nExpItems);
+	{
+		TaskPool single(1);
+		const TaskPoolScope scope(single);
+		accumulateItems(x, y, base, expectedProducts, expectedSums);
+		expItems(args, expectedExp);
+	}
+
+	TaskPool pool(nThreads);
+	const TaskPoolScope scope(pool);
+	size_t nChecked = 0;
+	size_t nErrors = 0;
+	for (size_t nRound = 0; nRound < nRounds; nRound++)
+	{
+		std::vector<CBigValue> products(s_nItems);
+		std::vector<CBigValue> sums(s_nItems);
+		accumulateItems(x, y, base, products, sums);
+		for (size_t i = 0; i < s_nItems; i++)
+		{
+			nErrors += (products[i] != expectedProducts[i]) ? 1 : 0;
+			nErrors += (sums[i] != expectedSums[i]) ? 1 : 0;
+		}
+		nChecked += 2 * s_nItems;
+	}
+
+	// exp is slow at this precision: two rounds
+	for (size_t nRound = 0; nRound < 2 && nRound < nRounds; nRound++)
+	{
+		std::vector<CBigFloat> results(s_nExpItems);
+		expItems(args, results);
+		for (size_t i = 0; i < s_nExpItems; i++)
+		{
+			nErrors += (results[i] != expectedExp[i]) ? 1 : 0;
+		}
+		nChecked += s_nExpItems;
+	}
+
+	printf("%zu threads: %zu results, %zu mismatches\n", pool.threadCount(), nChecked, nErrors);
+	return (nErrors == 0) ? 0 : 1;
+}
@@ -0,0 +1,572 @@
+/////////////////////////////////////
+//
+// CBigRational : exact ratio of two
+// arbitrary-size integers.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Sum of a/b and c/d is (a*d + c*b) / (b*d) formed with fused
+// multiply-accumulate (see BigExpression.h), with shortcuts
+// when denominators are equal or either is one
+// (common with integers and values of same decimal scale).
+//
+// Conversions divide only as far as result needs:
+// numerator is shifted so that truncated quotient has
+// a few bits more than target precision and nonzero remainder
+// is kept as sticky bit below them, result is then rounded once.
+//
+
+#include "BigRational.h"
+#include "BigExpression.h"
+#include "BigLimb.h"
+
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+
+typedef std::vector<uint64_t> LimbVector;
+
+// ratios smaller than this (bits of numerator and denominator)
+// are not reduced by arithmetic
+static const size_t s_nReduceBits = 512;
+
+
+////////// local helpers
+
+static inline bool roundIncrement(const bool bOdd, const bool bRound, const bool bSticky, const bool bNegative, const BigRounding eRounding)
+{
+	switch (eRounding)
+	{
+	case BigRoundingNearestEven:
+		return bRound && (bSticky || bOdd);
+	case BigRoundingNearestAway:
+		return bRound;
+	case BigRoundingTowardZero:
+		return false;
+	case BigRoundingUp:
+		return (bNegative == false) && (bRound || bSticky);
+	case BigRoundingDown:
+		return (bNegative == true) && (bRound || bSticky);
+	}
+	return false;
+}
+
+// magnitude * 10^nScale as limbs
+static void scaledLimbs(const CBigValue &value, size_t nScale, LimbVector &limbs)
+{
+	value.getLimbs(limbs);
+	limbs.resize(limbNormN(limbs.data(), limbs.size()));
+	while (nScale > 0 && limbs.empty() == false)
+	{
+		const size_t nStep = (nScale > 19) ? 19 : nScale;
+		const uint64_t high = limbMul1(&limbs[0], &limbs[0], limbs.size(), limbPow10((unsigned int)nStep));
+		if (high != 0)
+		{
+			limbs.push_back(high);
+		}
+		nScale -= nStep;
+	}
+}
+
+// same magnitude with given sign
+static void setSign(CBigValue &value, const bool bNegative)
+{
+	if (value.isNegative() != bNegative)
+	{
+		LimbVector limbs;
+		value.getLimbs(limbs);
+		value.fromLimbs(limbs.data(), limbs.size(), bNegative, value.getScale());
+	}
+}
+
+static inline bool isOne(const CBigValue &value)
+{
+	return (value.bitLength() == 1);
+}
+
+
+////////// protected methods
+
+void CBigRational::checkReduce()
+{
+	const size_t nBits = m_Numerator.bitLength() + m_Denominator.bitLength();
+	if (nBits > s_nReduceBits && nBits > 2 * m_nReducedBits)
+	{
+		normalize();
+	}
+}
+
+void CBigRational::addCore(const CBigRational &a, const CBigRational &b, const bool bSubtract)
+{
+	const CBigValue &p = a.m_Numerator;
+	const CBigValue &q = a.m_Denominator;
+	const CBigValue &r = b.m_Numerator;
+	const CBigValue &s = b.m_Denominator;
+
+	// note: this may be same as either operand
+	CBigValue numerator;
+	CBigValue denominator;
+	if (q == s)
+	{
+		if (bSubtract == true)
+		{
+			numerator = bigExpr(p) - r;
+		}
+		else
+		{
+			numerator = bigExpr(p) + r;
+		}
+		denominator = q;
+	}
+	else if (isOne(q) == true)
+	{
+		if (bSubtract == true)
+		{
+			numerator = bigExpr(p) * s - r;
+		}
+		else
+		{
+			numerator = bigExpr(p) * s + r;
+		}
+		denominator = s;
+	}
+	else if (isOne(s) == true)
+	{
+		if (bSubtract == true)
+		{
+			numerator = bigExpr(p) - bigExpr(r) * q;
+		}
+		else
+		{
+			numerator = bigExpr(p) + bigExpr(r) * q;
+		}
+		denominator = q;
+	}
+	else
+	{
+		if (bSubtract == true)
+		{
+			numerator = bigExpr(p) * s - bigExpr(r) * q;
+		}
+		else
+		{
+			numerator = bigExpr(p) * s + bigExpr(r) * q;
+		}
+		denominator = q * s;
+	}
+
+	const size_t nReducedBits = (a.m_nReducedBits > b.m_nReducedBits) ? a.m_nReducedBits : b.m_nReducedBits;
+	m_Numerator = numerator;
+	m_Denominator = denominator;
+	m_bReduced = false;
+	m_nReducedBits = nReducedBits;
+	checkReduce();
+}
+
+CBigFloat CBigRational::stickyQuotient(const size_t nBits) const
+{
+	if (isZero() == true)
+	{
+		return CBigFloat(64);
+	}
+
+	// at least nBits + 2 quotient bits
+	const size_t nNumeratorBits = m_Numerator.bitLength();
+	const size_t nWanted = nBits + 2 + m_Denominator.bitLength();
+	const size_t nShift = (nWanted > nNumeratorBits) ? (nWanted - nNumeratorBits) : 0;
+
+	LimbVector numerator;
+	LimbVector denominator;
+	m_Numerator.getLimbs(numerator);
+	m_Denominator.getLimbs(denominator);
+
+	const size_t nA = numerator.size() + nShift / 64 + 1;
+	LimbVector shifted(nA);
+	limbShiftLeft((uint8_t*)&shifted[0], nA * 8, (const uint8_t*)&numerator[0], numerator.size() * 8, nShift);
+	const size_t nUsed = limbNormN(&shifted[0], nA);
+	const size_t nB = denominator.size();
+
+	// one more limb for sticky bit
+	LimbVector remainder(nB);
+	LimbVector quotient(nUsed - nB + 2, 0);
+	limbDivRemN(&quotient[0], &remainder[0], &shifted[0], nUsed, &denominator[0], nB);
+	int64_t nExponent = -(int64_t)nShift;
+	if (limbNormN(&remainder[0], nB) > 0)
+	{
+		limbShiftLeft((uint8_t*)&quotient[0], quotient.size() * 8, (const uint8_t*)&quotient[0], quotient.size() * 8, 1);
+		quotient[0] |= 1;
+		nExponent--;
+	}
+
+	CBigFloat value(quotient.size() * 64);
+	value.fromParts(quotient, nExponent, isNegative());
+	return value;
+}
+
+
+////////// public methods
+
+CBigRational::CBigRational()
+	: m_Numerator((int64_t)0)
+	, m_Denominator((int64_t)1)
+	, m_bReduced(true)
+	, m_nReducedBits(1)
+{}
+
+CBigRational::CBigRational(const int64_t value)
+	: m_Numerator(value)
+	, m_Denominator((int64_t)1)
+	, m_bReduced(true)
+	, m_nReducedBits(0)
+{
+	m_nReducedBits = m_Numerator.bitLength() + m_Denominator.bitLength();
+}
+
+CBigRational::CBigRational(const CBigValue &numerator, const CBigValue &denominator)
+	: m_bReduced(false)
+	, m_nReducedBits(0)
+{
+	// a / 10^s1 / (b / 10^s2) = (a * 10^s2) / (b * 10^s1)
+	LimbVector a;
+	LimbVector b;
+	scaledLimbs(numerator, denominator.getScale(), a);
+	scaledLimbs(denominator, numerator.getScale(), b);
+
+	const bool bNegative = (numerator.isNegative() != denominator.isNegative());
+	m_Numerator.fromLimbs(a.data(), a.size(), (a.empty() == false) ? bNegative : false, 0);
+	m_Denominator.fromLimbs(b.data(), b.size(), false, 0);
+	checkReduce();
+}
+
+CBigRational::CBigRational(const double value)
+	: m_bReduced(true)
+	, m_nReducedBits(0)
+{
+	fromDouble(value);
+}
+
+CBigRational& CBigRational::fromDouble(const double value)
+{
+	// exact IEEE decomposition: odd mantissa * 2^exponent
+	// is already in lowest terms
+	const CBigFloat decomposed(value, 53);
+	const uint64_t one = 1;
+	if (decomposed.getClass() != BigFloatNormal)
+	{
+		m_Numerator.fromLimbs(nullptr, 0, false, 0);
+		m_Denominator.fromLimbs(&one, 1, false, 0);
+	}
+	else
+	{
+		const LimbVector &mantissa = decomposed.getMantissa();
+		const int64_t nExponent = decomposed.getExponent();
+		const size_t nShift = (size_t)((nExponent < 0) ? -nExponent : nExponent);
+		LimbVector power(nShift / 64 + 1, 0);
+		power[nShift / 64] = (one << (nShift % 64));
+
+		if (nExponent >= 0)
+		{
+			LimbVector shifted(mantissa.size() + nShift / 64 + 1);
+			limbShiftLeft((uint8_t*)&shifted[0], shifted.size() * 8, (const uint8_t*)&mantissa[0], mantissa.size() * 8, nShift);
+			m_Numerator.fromLimbs(&shifted[0], shifted.size(), decomposed.isNegative(), 0);
+			m_Denominator.fromLimbs(&one, 1, false, 0);
+		}
+		else
+		{
+			m_Numerator.fromLimbs(&mantissa[0], mantissa.size(), decomposed.isNegative(), 0);
+			m_Denominator.fromLimbs(&power[0], power.size(), false, 0);
+		}
+	}
+	m_bReduced = true;
+	m_nReducedBits = m_Numerator.bitLength() + m_Denominator.bitLength();
+	return *this;
+}
+
+CBigRational& CBigRational::fromBigValue(const CBigValue &value)
+{
+	*this = CBigRational(value);
+	return *this;
+}
+
+void CBigRational::normalize() const
+{
+	if (m_bReduced == true)
+	{
+		return;
+	}
+
+	// zero is 0/1
+	if (m_Numerator.usedSize() == 0)
+	{
+		m_Numerator = CBigValue((int64_t)0);
+		m_Denominator = CBigValue((int64_t)1);
+		m_bReduced = true;
+		m_nReducedBits = 1;
+		return;
+	}
+
+	LimbVector a;
+	LimbVector b;
+	m_Numerator.getLimbs(a);
+	m_Denominator.getLimbs(b);
+
+	LimbVector divisor((a.size() > b.size()) ? a.size() : b.size());
+	const size_t nDivisor = limbGcdN(divisor.data(), a.data(), a.size(), b.data(), b.size());
+	if (nDivisor > 1 || (nDivisor == 1 && divisor[0] != 1))
+	{
+		// exact divisions: both are multiples of divisor
+		LimbVector quotient;
+		if (a.empty() == false)
+		{
+			quotient.resize(a.size() - nDivisor + 1);
+			limbDivRemN(&quotient[0], nullptr, &a[0], a.size(), &divisor[0], nDivisor);
+			m_Numerator.fromLimbs(&quotient[0], quotient.size(), m_Numerator.isNegative(), 0);
+		}
+		if (b.empty() == false)
+		{
+			quotient.resize(b.size() - nDivisor + 1);
+			limbDivRemN(&quotient[0], nullptr, &b[0], b.size(), &divisor[0], nDivisor);
+			m_Denominator.fromLimbs(&quotient[0], quotient.size(), false, 0);
+		}
+	}
+
+	m_bReduced = true;
+	m_nReducedBits = m_Numerator.bitLength() + m_Denominator.bitLength();
+}
+
+const CBigValue& CBigRational::getNumerator() const
+{
+	normalize();
+	return m_Numerator;
+}
+
+const CBigValue& CBigRational::getDenominator() const
+{
+	normalize();
+	return m_Denominator;
+}
+
+CBigRational CBigRational::operator + (const CBigRational &other) const
+{
+	CBigRational value;
+	value.addCore(*this, other, false);
+	return value;
+}
+
+CBigRational CBigRational::operator - (const CBigRational &other) const
+{
+	CBigRational value;
+	value.addCore(*this, other, true);
+	return value;
+}
+
+CBigRational CBigRational::operator * (const CBigRational &other) const
+{
+	CBigRational value;
+	value.m_Numerator = m_Numerator * other.m_Numerator;
+	value.m_Denominator = m_Denominator * other.m_Denominator;
+	value.m_bReduced = false;
+	value.m_nReducedBits = (m_nReducedBits > other.m_nReducedBits) ? m_nReducedBits : other.m_nReducedBits;
+	value.checkReduce();
+	return value;
+}
+
+CBigRational CBigRational::operator / (const CBigRational &other) const
+{
+	CBigRational value;
+	value.m_Numerator = m_Numerator * other.m_Denominator;
+	value.m_Denominator = m_Denominator * other.m_Numerator;
+
+	// sign to numerator
+	const bool bNegative = (value.m_Numerator.isNegative() != value.m_Denominator.isNegative());
+	setSign(value.m_Numerator, (value.m_Numerator.usedSize() > 0) ? bNegative : false);
+	setSign(value.m_Denominator, false);
+
+	value.m_bReduced = false;
+	value.m_nReducedBits = (m_nReducedBits > other.m_nReducedBits) ? m_nReducedBits : other.m_nReducedBits;
+	value.checkReduce();
+	return value;
+}
+
+CBigRational CBigRational::operator - () const
+{
+	CBigRational value(*this);
+	setSign(value.m_Numerator, (isNegative() == false && isZero() == false));
+	return value;
+}
+
+CBigRational& CBigRational::operator += (const CBigRational &other)
+{
+	addCore(*this, other, false);
+	return *this;
+}
+
+CBigRational& CBigRational::operator -= (const CBigRational &other)
+{
+	addCore(*this, other, true);
+	return *this;
+}
+
+CBigRational& CBigRational::operator *= (const CBigRational &other)
+{
+	*this = (*this * other);
+	return *this;
+}
+
+CBigRational& CBigRational::operator /= (const CBigRational &other)
+{
+	*this = (*this / other);
+	return *this;
+}
+
+int CBigRational::compare(const CBigRational &other) const
+{
+	const int nSign = isZero() ? 0 : (isNegative() ? -1 : 1);
+	const int nOtherSign = other.isZero() ? 0 : (other.isNegative() ? -1 : 1);
+	if (nSign != nOtherSign)
+	{
+		return (nSign < nOtherSign) ? -1 : 1;
+	}
+	if (nSign == 0)
+	{
+		return 0;
+	}
+
+	if (m_Denominator == other.m_Denominator)
+	{
+		return m_Numerator.compare(other.m_Numerator);
+	}
+
+	// |a/b| against |c/d| is |a*d| against |c*b|:
+	// product of x and y bits has x+y-1 or x+y bits
+	const size_t nLeft = m_Numerator.bitLength() + other.m_Denominator.bitLength();
+	const size_t nRight = other.m_Numerator.bitLength() + m_Denominator.bitLength();
+	if (nLeft + 1 < nRight)
+	{
+		return -nSign;
+	}
+	if (nLeft > nRight + 1)
+	{
+		return nSign;
+	}
+
+	// denominators are positive: signs are kept
+	const CBigValue left = m_Numerator * other.m_Denominator;
+	const CBigValue right = other.m_Numerator * m_Denominator;
+	return left.compare(right);
+}
+
+bool CBigRational::operator == (const CBigRational &other) const
+{
+	// lowest terms are unique
+	normalize();
+	other.normalize();
+	return (m_Numerator == other.m_Numerator && m_Denominator == other.m_Denominator);
+}
+
+bool CBigRational::operator != (const CBigRational &other) const
+{
+	return !(*this == other);
+}
+
+bool CBigRational::operator < (const CBigRational &other) const
+{
+	return (compare(other) < 0);
+}
+
+bool CBigRational::operator <= (const CBigRational &other) const
+{
+	return (compare(other) <= 0);
+}
+
+bool CBigRational::operator > (const CBigRational &other) const
+{
+	return (compare(other) > 0);
+}
+
+bool CBigRational::operator >= (const CBigRational &other) const
+{
+	return (compare(other) >= 0);
+}
+
+size_t CBigRational::hash() const
+{
+	normalize();
+	const size_t h = m_Numerator.hash();
+	return h ^ (m_Denominator.hash() + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2));
+}
+
+double CBigRational::toDouble(const BigRounding eRounding) const
+{
+	if (m_Denominator.usedSize() == 0)
+	{
+		if (isZero() == true)
+		{
+			return NAN;
+		}
+		return (isNegative() == true) ? -INFINITY : INFINITY;
+	}
+	return stickyQuotient(53).toDouble(eRounding);
+}
+
+CBigFloat CBigRational::toBigFloat(const size_t nPrecision, const BigRounding eRounding) const
+{
+	CBigFloat value(nPrecision);
+	if (m_Denominator.usedSize() == 0)
+	{
+		value.fromDouble(toDouble());
+		return value;
+	}
+	value.set(stickyQuotient(nPrecision), eRounding);
+	return value;
+}
+
+CBigValue CBigRational::toBigValue(const size_t nScale, const BigRounding eRounding) const
+{
+	CBigValue value;
+	LimbVector numerator;
+	LimbVector denominator;
+	scaledLimbs(m_Numerator, nScale, numerator);
+	m_Denominator.getLimbs(denominator);
+	const size_t nA = numerator.size();
+	const size_t nB = limbNormN(denominator.data(), denominator.size());
+	if (nA == 0 || nB == 0)
+	{
+		// zero (or division by zero)
+		value.fromLimbs(nullptr, 0, false, nScale);
+		return value;
+	}
+
+	LimbVector quotient(1, 0);
+	LimbVector remainder(numerator);
+	if (nA >= nB)
+	{
+		quotient.resize(nA - nB + 1);
+		remainder.resize(nB);
+		limbDivRemN(&quotient[0], &remainder[0], &numerator[0], nA, &denominator[0], nB);
+	}
+	quotient.push_back(0);
+
+	// remainder against half of denominator: 2r against d
+	LimbVector twice(remainder.size() + 1, 0);
+	twice[remainder.size()] = limbAddN(&twice[0], &remainder[0], remainder.size(), &remainder[0], remainder.size());
+	const int nHalf = limbCompareN(&twice[0], twice.size(), &denominator[0], nB);
+	const bool bSticky = (limbNormN(&remainder[0], remainder.size()) > 0);
+
+	// round bit and sticky below it from comparison to half
+	const bool bRound = (nHalf >= 0);
+	const bool bBelow = (nHalf > 0) || (bRound == false && bSticky == true);
+	const bool bNegative = isNegative();
+	if (roundIncrement((quotient[0] & 1) != 0, bRound, bBelow, bNegative, eRounding) == true)
+	{
+		const uint64_t one = 1;
+		limbAddN(&quotient[0], &quotient[0], quotient.size(), &one, 1);
+	}
+
+	const size_t nUsed = limbNormN(&quotient[0], quotient.size());
+	value.fromLimbs(&quotient[0], nUsed, (nUsed > 0) ? bNegative : false, nScale);
+	return value;
+}
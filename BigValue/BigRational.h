@@ -0,0 +1,129 @@
+/////////////////////////////////////
+//
+// CBigRational : exact ratio of two
+// arbitrary-size integers.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Value is numerator / denominator where numerator keeps the sign
+// and denominator is positive, both are CBigValue with zero scale.
+//
+// Normalization (dividing out greatest common divisor)
+// is the expensive part of rational arithmetic, so it is deferred:
+// operations do not reduce until size of the ratio has grown
+// past threshold (or doubled since last reduction),
+// comparison uses cross-multiplication (with shortcuts for
+// equal denominators and sizes far apart) instead of reducing.
+// Equality, hash and access to parts reduce first
+// since those need lowest terms.
+//
+// Division by zero leaves zero denominator:
+// toDouble() gives infinity (NaN for 0/0).
+//
+
+#ifndef BIGRATIONAL_H
+#define BIGRATIONAL_H
+
+#include "BigValue.h"
+#include "BigFloat.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+class CBigRational
+{
+protected:
+	// note: mutable since reducing to lowest terms
+	// does not change value
+	mutable CBigValue m_Numerator;
+	mutable CBigValue m_Denominator;
+
+	// in lowest terms
+	mutable bool m_bReduced;
+	// bits of numerator and denominator after last reduction
+	mutable size_t m_nReducedBits;
+
+	// reduce if grown past threshold
+	void checkReduce();
+
+	// this = a +/- b
+	void addCore(const CBigRational &a, const CBigRational &b, const bool bSubtract);
+
+	// exact value of quotient truncated to at least nBits + 2 bits
+	// and sticky bit below those (if inexact): rounds like full quotient
+	CBigFloat stickyQuotient(const size_t nBits) const;
+
+public:
+	CBigRational();
+	explicit CBigRational(const int64_t value);
+	// value of numerator / denominator, scales of both are honored
+	CBigRational(const CBigValue &numerator, const CBigValue &denominator = CBigValue((int64_t)1));
+	// exact value of double (infinity/NaN give zero)
+	explicit CBigRational(const double value);
+
+	CBigRational& fromDouble(const double value);
+	CBigRational& fromBigValue(const CBigValue &value);
+
+	// divide out greatest common divisor now
+	void normalize() const;
+
+	// parts in lowest terms
+	const CBigValue& getNumerator() const;
+	const CBigValue& getDenominator() const;
+
+	bool isZero() const
+	{
+		return (m_Numerator.usedSize() == 0);
+	}
+	bool isNegative() const
+	{
+		return (m_Numerator.isNegative() == true && m_Numerator.usedSize() > 0);
+	}
+
+	CBigRational operator + (const CBigRational &other) const;
+	CBigRational operator - (const CBigRational &other) const;
+	CBigRational operator * (const CBigRational &other) const;
+	CBigRational operator / (const CBigRational &other) const;
+	CBigRational operator - () const;
+
+	CBigRational& operator += (const CBigRational &other);
+	CBigRational& operator -= (const CBigRational &other);
+	CBigRational& operator *= (const CBigRational &other);
+	CBigRational& operator /= (const CBigRational &other);
+
+	// three-way compare (-1, 0, 1) by cross-multiplication
+	int compare(const CBigRational &other) const;
+
+	bool operator == (const CBigRational &other) const;
+	bool operator != (const CBigRational &other) const;
+	bool operator < (const CBigRational &other) const;
+	bool operator <= (const CBigRational &other) const;
+	bool operator > (const CBigRational &other) const;
+	bool operator >= (const CBigRational &other) const;
+
+	// equal for equal values
+	size_t hash() const;
+
+	// correctly rounded (quotient is never formed in full)
+	double toDouble(const BigRounding eRounding = BigRoundingNearestEven) const;
+	CBigFloat toBigFloat(const size_t nPrecision, const BigRounding eRounding = BigRoundingNearestEven) const;
+	// value * 10^scale rounded to integer (kept as scale of result)
+	CBigValue toBigValue(const size_t nScale = 0, const BigRounding eRounding = BigRoundingNearestEven) const;
+};
+
+// allow use as key in unordered containers
+namespace std
+{
+	template <> struct hash<CBigRational>
+	{
+		size_t operator()(const CBigRational &value) const
+		{
+			return value.hash();
+		}
+	};
+}
+
+#endif // BIGRATIONAL_H
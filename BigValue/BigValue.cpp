@@ -49,22 +49,138 @@
 
 
 #include "BigValue.h"
+#include "BigLimb.h"
+#include "../simplesse/AlignedAllocator.h"
 
 #include <memory>
+#include <new>
+#include <vector>
+#include <string.h>
+
+
+////////// local helpers
+
+// magnitude buffers are 16-byte aligned for SSE loads on all targets.
+// note: not aligned to cache line: values are small and short-lived,
+// and over-aligned malloc (memalign) made arithmetic on 8-limb values
+// over 1.5x slower while limb kernels use unaligned loads anyway
+static uint8_t* allocateBuffer(const size_t nSize)
+{
+	uint8_t *pBuffer = static_cast<uint8_t*>(alignedAlloc(nSize, AlignedBoundarySSE));
+	if (pBuffer == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return pBuffer;
+}
+
+// modulo 2^61-1 helpers for hashing
+static const uint64_t s_nPrimeM61 = (1ULL << 61) - 1;
+static const uint64_t s_nInverse10M61 = 0x1cccccccccccccccULL; // 10 * this = 1 (mod 2^61-1)
+
+static uint64_t mulModM61(const uint64_t a, const uint64_t b)
+{
+	uint64_t high = 0;
+	uint64_t low = limbMul64(a, b, &high);
+	// product < 2^122: split at bit 61
+	uint64_t value = (low & s_nPrimeM61) + ((low >> 61) | (high << 3));
+	value = (value & s_nPrimeM61) + (value >> 61);
+	if (value >= s_nPrimeM61)
+	{
+		value -= s_nPrimeM61;
+	}
+	return value;
+}
+
+static uint64_t powModM61(uint64_t base, size_t nExponent)
+{
+	uint64_t value = 1;
+	while (nExponent > 0)
+	{
+		if (nExponent & 1)
+		{
+			value = mulModM61(value, base);
+		}
+		base = mulModM61(base, base);
+		nExponent >>= 1;
+	}
+	return value;
+}
+
+// compare magnitudes of A / 10^nScaleA and B / 10^nScaleB
+static int compareScaledMagnitude(const uint8_t *pA, const size_t nA, const size_t nScaleA, 
+								  const uint8_t *pB, const size_t nB, const size_t nScaleB)
+{
+	if (nA == 0 || nB == 0 || nScaleA == nScaleB)
+	{
+		// zero is zero in any scale
+		return limbCompare(pA, nA, pB, nB);
+	}
+
+	// make A the one needing upscaling (smaller scale)
+	if (nScaleA > nScaleB)
+	{
+		return -compareScaledMagnitude(pB, nB, nScaleB, pA, nA, nScaleA);
+	}
+
+	// estimate from bit-lengths first:
+	// A * 10^diff is in [2^(bitsA-1 + diff*log2(10)), 2^(bitsA + diff*log2(10)))
+	// and B is in [2^(bitsB-1), 2^bitsB)
+	const size_t nDiff = nScaleB - nScaleA;
+	const double dScaledBits = ((double)nDiff) * 3.32192809488736234787; // log2(10)
+	const double dMargin = 1e-6 + dScaledBits * 1e-12;
+	const double dBitsA = (double)limbBitLength(pA, nA);
+	const double dBitsB = (double)limbBitLength(pB, nB);
+	if (dBitsA + dScaledBits < dBitsB - 1.0 - dMargin)
+	{
+		return -1;
+	}
+	if (dBitsA - 1.0 + dScaledBits > dBitsB + dMargin)
+	{
+		return 1;
+	}
+
+	// too close to tell: rescale A exactly,
+	// per-thread scratch is reused so no allocation in steady state
+	static thread_local std::vector<uint8_t> scratch;
+	size_t nNeeded = nA + 8 * (nDiff / 19 + 2);
+	if (scratch.size() < nNeeded)
+	{
+		scratch.resize(nNeeded);
+	}
+
+	uint8_t *pScaled = &scratch[0];
+	::memcpy(pScaled, pA, nA);
+	size_t nScaled = nA;
+	size_t nLeft = nDiff;
+	while (nLeft > 0)
+	{
+		size_t nStep = (nLeft > 19) ? 19 : nLeft;
+		limbMulWord(pScaled, nScaled + 8, pScaled, nScaled, limbPow10((unsigned int)nStep));
+		nScaled += 8;
+		nLeft -= nStep;
+	}
+	return limbCompare(pScaled, nScaled, pB, nB);
+}
 
 
 ////////// protected methods
 
-void CBigValue::CreateBuffer(const size_t nBufSize)
+// note: bClear can be skipped when caller
+// writes every byte anyway (limb kernels do)
+void CBigValue::CreateBuffer(const size_t nBufSize, const bool bClear)
 {
 	if (m_pBuffer != nullptr)
 	{
-		delete m_pBuffer;
+		alignedFree(m_pBuffer);
 	}
 
-	m_pBuffer = new uint8_t[nBufSize];
+	m_pBuffer = allocateBuffer(nBufSize);
 	m_nBufferSize = nBufSize;
-	::memset(m_pBuffer, 0, m_nBufferSize);
+	if (bClear == true)
+	{
+		::memset(m_pBuffer, 0, m_nBufferSize);
+	}
 }
 
 void CBigValue::GrowBuffer(const size_t nBufSize)
@@ -78,10 +194,10 @@ void CBigValue::GrowBuffer(const size_t nBufSize)
 	// grow buffer, keep data
 	if (nBufSize > m_nBufferSize)
 	{
-		uint8_t *pBuffer = new uint8_t[nBufSize];
+		uint8_t *pBuffer = allocateBuffer(nBufSize);
 		::memset(pBuffer, 0, nBufSize); // clear entirely first
 		::memcpy(pBuffer, m_pBuffer, m_nBufferSize); // copy to new
-		delete m_pBuffer;
+		alignedFree(m_pBuffer);
 		m_pBuffer = pBuffer;
 		m_nBufferSize = nBufSize;
 		return;
@@ -271,7 +387,7 @@ CBigValue::~CBigValue(void)
 {
 	if (m_pBuffer != nullptr)
 	{
-		delete m_pBuffer;
+		alignedFree(m_pBuffer);
 		m_pBuffer = nullptr;
 	}
 }
@@ -435,6 +551,31 @@ CBigValue& CBigValue::fromBuffer(const uint8_t *pData, const size_t nSize, const
 	return *this;
 }
 
+CBigValue& CBigValue::fromLimbs(const uint64_t *pLimbs, const size_t nCount, const bool bIsNegative, size_t nScale)
+{
+	// keep whole limbs so that result can be used as limbs again
+	size_t nUsed = limbNormN(pLimbs, nCount);
+	CreateBuffer((nUsed > 0) ? nUsed * sizeof(uint64_t) : 1);
+	if (nUsed > 0)
+	{
+		::memcpy(m_pBuffer, pLimbs, nUsed * sizeof(uint64_t));
+	}
+	m_bNegative = bIsNegative;
+	m_nScale = nScale;
+
+	return *this;
+}
+
+void CBigValue::getLimbs(std::vector<uint64_t> &limbs) const
+{
+	size_t nUsed = usedSize();
+	limbs.assign((nUsed + 7) / 8, 0);
+	if (nUsed > 0)
+	{
+		::memcpy(&limbs[0], m_pBuffer, nUsed);
+	}
+}
+
 CBigValue& CBigValue::operator = (const CBigValue &other)
 {
 	// avoid self-assignment
@@ -448,68 +589,342 @@ CBigValue& CBigValue::operator = (const CBigValue &other)
 
 CBigValue CBigValue::operator + (const CBigValue &other) const
 {
-	// we don't know output size or scale yet
-	// so we need to check our and given data for estimate..
+	const CBigValue *terms[2] = {this, &other};
+	CBigValue value;
+	value.fromSum(terms, nullptr, 2);
+	return value;
+}
 
-	// TODO:
-	// also need to check scaling of both,
-	// if either is negative, buffer sizes etc.
+CBigValue CBigValue::operator - (const CBigValue &other) const
+{
+	const CBigValue *terms[2] = {this, &other};
+	const bool negate[2] = {false, true};
+	CBigValue value;
+	value.fromSum(terms, negate, 2);
+	return value;
+}
 
+CBigValue& CBigValue::operator += (const CBigValue &other)
+{
+	const CBigValue *terms[2] = {this, &other};
+	return fromSum(terms, nullptr, 2);
+}
+
+CBigValue& CBigValue::operator -= (const CBigValue &other)
+{
+	const CBigValue *terms[2] = {this, &other};
+	const bool negate[2] = {false, true};
+	return fromSum(terms, negate, 2);
+}
+
+CBigValue CBigValue::operator * (const CBigValue &other) const
+{
 	CBigValue value;
-	value.CreateBuffer(m_nBufferSize+1); // guess sufficient size for now..
 
-	uint8_t *pother = other.m_pBuffer;
-	/*
-	if (m_nScale > other.m_nScale)
+	std::vector<uint64_t> a, b;
+	getLimbs(a);
+	other.getLimbs(b);
+	if (a.empty() || b.empty())
 	{
-		// need temp and change scaling,
-		// memmove() to align values..
-		//pother = new uint8_t...
-		//other.scaleTo(m_nScale);
+		// zero
+		value.CreateBuffer(1);
+		value.m_nScale = m_nScale + other.m_nScale;
+		return value;
 	}
-	*/
 
-	// for larger than single element, keep overflow to next
-	uint16_t carry = 0;
+	std::vector<uint64_t> product(a.size() + b.size());
+	limbMulN(&product[0], &a[0], a.size(), &b[0], b.size());
+	value.fromLimbs(&product[0], product.size(), (m_bNegative != other.m_bNegative), m_nScale + other.m_nScale);
+	return value;
+}
+
+CBigValue& CBigValue::operator *= (const CBigValue &other)
+{
+	*this = (*this * other);
+	return *this;
+}
 
-	// TODO: likely different buffer sizes also..
-	for (size_t i = 0, j = 0; i < m_nBufferSize || j < other.m_nBufferSize; i++, j++)
+CBigValue CBigValue::operator << (const size_t nBits) const
+{
+	CBigValue value;
+	value.m_bNegative = m_bNegative;
+	value.m_nScale = m_nScale;
+
+	size_t nUsedBits = bitLength();
+	if (nUsedBits == 0)
 	{
-		if (i >= m_nBufferSize)
-		{
-			carry += pother[j];
-		}
-		else if (j >= other.m_nBufferSize)
-		{
-			carry += m_pBuffer[i];
-		}
-		else
-		{
-			carry += (m_pBuffer[i] + pother[j]);
-		}
-		value.m_pBuffer[i] += (carry & 0xFF);
-		carry >>= 8;
+		// zero stays zero
+		value.CreateBuffer(m_nBufferSize);
+		return value;
 	}
 
-	if (carry > 0)
+	// shift straight from our buffer to result,
+	// kernel writes every byte so no need to clear first
+	size_t nSize = (nUsedBits + nBits + 7) / 8;
+	value.CreateBuffer(nSize, false);
+	limbShiftLeft(value.m_pBuffer, nSize, m_pBuffer, m_nBufferSize, nBits);
+	return value;
+}
+
+CBigValue CBigValue::operator >> (const size_t nBits) const
+{
+	CBigValue value;
+	value.m_bNegative = m_bNegative;
+	value.m_nScale = m_nScale;
+
+	size_t nUsed = usedSize();
+	size_t nSize = (nUsed > (nBits / 8)) ? (nUsed - (nBits / 8)) : 0;
+	if (nSize == 0)
 	{
-		// overflow to destination (which should be larger)
-		value.m_pBuffer[value.m_nBufferSize -1] += (carry &0xFF);
+		// keep buffer for zero-value
+		nSize = 1;
 	}
 
+	value.CreateBuffer(nSize, false);
+	limbShiftRight(value.m_pBuffer, nSize, m_pBuffer, nUsed, nBits);
 	return value;
 }
 
-CBigValue CBigValue::operator - (const CBigValue &other) const
+CBigValue& CBigValue::operator <<= (const size_t nBits)
 {
-	// we don't know output size or scale yet
-	// so we need to check our and given data for estimate..
+	size_t nUsedBits = bitLength();
+	if (nUsedBits == 0 || nBits == 0)
+	{
+		return *this;
+	}
 
+	size_t nSize = (nUsedBits + nBits + 7) / 8;
+	if (nSize > m_nBufferSize)
+	{
+		// shift directly into larger buffer:
+		// single pass instead of grow (copy) and then shift
+		uint8_t *pBuffer = allocateBuffer(nSize);
+		limbShiftLeft(pBuffer, nSize, m_pBuffer, m_nBufferSize, nBits);
+		alignedFree(m_pBuffer);
+		m_pBuffer = pBuffer;
+		m_nBufferSize = nSize;
+	}
+	else
+	{
+		limbShiftLeft(m_pBuffer, m_nBufferSize, m_pBuffer, m_nBufferSize, nBits);
+	}
+	return *this;
+}
+
+CBigValue& CBigValue::operator >>= (const size_t nBits)
+{
+	if (nBits == 0)
+	{
+		return *this;
+	}
+
+	// buffer size is kept, high bytes are cleared
+	limbShiftRight(m_pBuffer, m_nBufferSize, m_pBuffer, m_nBufferSize, nBits);
+	return *this;
+}
+
+CBigValue CBigValue::operator & (const CBigValue &other) const
+{
 	CBigValue value;
+	value.m_bNegative = (m_bNegative && other.m_bNegative);
+	value.m_nScale = m_nScale;
 
+	// result can't be larger than smaller one
+	size_t nSize = usedSize();
+	size_t nOther = other.usedSize();
+	if (nOther < nSize)
+	{
+		nSize = nOther;
+	}
+	if (nSize == 0)
+	{
+		nSize = 1;
+	}
+
+	value.CreateBuffer(nSize, false);
+	limbAnd(value.m_pBuffer, nSize, m_pBuffer, m_nBufferSize, other.m_pBuffer, other.m_nBufferSize);
 	return value;
 }
 
+CBigValue CBigValue::operator | (const CBigValue &other) const
+{
+	CBigValue value;
+	value.m_bNegative = (m_bNegative || other.m_bNegative);
+	value.m_nScale = m_nScale;
+
+	size_t nSize = usedSize();
+	size_t nOther = other.usedSize();
+	if (nOther > nSize)
+	{
+		nSize = nOther;
+	}
+	if (nSize == 0)
+	{
+		nSize = 1;
+	}
+
+	value.CreateBuffer(nSize, false);
+	limbOr(value.m_pBuffer, nSize, m_pBuffer, m_nBufferSize, other.m_pBuffer, other.m_nBufferSize);
+	return value;
+}
+
+CBigValue CBigValue::operator ^ (const CBigValue &other) const
+{
+	CBigValue value;
+	value.m_bNegative = (m_bNegative != other.m_bNegative);
+	value.m_nScale = m_nScale;
+
+	size_t nSize = usedSize();
+	size_t nOther = other.usedSize();
+	if (nOther > nSize)
+	{
+		nSize = nOther;
+	}
+	if (nSize == 0)
+	{
+		nSize = 1;
+	}
+
+	value.CreateBuffer(nSize, false);
+	limbXor(value.m_pBuffer, nSize, m_pBuffer, m_nBufferSize, other.m_pBuffer, other.m_nBufferSize);
+	return value;
+}
+
+CBigValue& CBigValue::operator &= (const CBigValue &other)
+{
+	// never grows: bytes above other are cleared
+	limbAnd(m_pBuffer, m_nBufferSize, m_pBuffer, m_nBufferSize, other.m_pBuffer, other.m_nBufferSize);
+	m_bNegative = (m_bNegative && other.m_bNegative);
+	return *this;
+}
+
+CBigValue& CBigValue::operator |= (const CBigValue &other)
+{
+	size_t nOther = other.usedSize();
+	if (nOther > m_nBufferSize)
+	{
+		// combine directly into larger buffer
+		uint8_t *pBuffer = allocateBuffer(nOther);
+		limbOr(pBuffer, nOther, m_pBuffer, m_nBufferSize, other.m_pBuffer, other.m_nBufferSize);
+		alignedFree(m_pBuffer);
+		m_pBuffer = pBuffer;
+		m_nBufferSize = nOther;
+	}
+	else
+	{
+		limbOr(m_pBuffer, m_nBufferSize, m_pBuffer, m_nBufferSize, other.m_pBuffer, other.m_nBufferSize);
+	}
+	m_bNegative = (m_bNegative || other.m_bNegative);
+	return *this;
+}
+
+CBigValue& CBigValue::operator ^= (const CBigValue &other)
+{
+	size_t nOther = other.usedSize();
+	if (nOther > m_nBufferSize)
+	{
+		// combine directly into larger buffer
+		uint8_t *pBuffer = allocateBuffer(nOther);
+		limbXor(pBuffer, nOther, m_pBuffer, m_nBufferSize, other.m_pBuffer, other.m_nBufferSize);
+		alignedFree(m_pBuffer);
+		m_pBuffer = pBuffer;
+		m_nBufferSize = nOther;
+	}
+	else
+	{
+		limbXor(m_pBuffer, m_nBufferSize, m_pBuffer, m_nBufferSize, other.m_pBuffer, other.m_nBufferSize);
+	}
+	m_bNegative = (m_bNegative != other.m_bNegative);
+	return *this;
+}
+
+int CBigValue::compare(const CBigValue &other) const
+{
+	size_t nUsed = usedSize();
+	size_t nOtherUsed = other.usedSize();
+
+	// zero has no sign: negative zero equals positive zero
+	bool bNegative = (nUsed > 0) ? m_bNegative : false;
+	bool bOtherNegative = (nOtherUsed > 0) ? other.m_bNegative : false;
+	if (bNegative != bOtherNegative)
+	{
+		return (bNegative == true) ? -1 : 1;
+	}
+
+	int result = compareScaledMagnitude(m_pBuffer, nUsed, m_nScale, other.m_pBuffer, nOtherUsed, other.m_nScale);
+	return (bNegative == true) ? -result : result;
+}
+
+bool CBigValue::operator == (const CBigValue &other) const
+{
+	return (compare(other) == 0);
+}
+
+bool CBigValue::operator != (const CBigValue &other) const
+{
+	return (compare(other) != 0);
+}
+
+bool CBigValue::operator < (const CBigValue &other) const
+{
+	return (compare(other) < 0);
+}
+
+bool CBigValue::operator <= (const CBigValue &other) const
+{
+	return (compare(other) <= 0);
+}
+
+bool CBigValue::operator > (const CBigValue &other) const
+{
+	return (compare(other) > 0);
+}
+
+bool CBigValue::operator >= (const CBigValue &other) const
+{
+	return (compare(other) >= 0);
+}
+
+// value modulo 2^61-1 with scale divided out:
+// magnitude / 10^scale is same residue for any scale of same value
+// since 10 is invertible modulo prime -> no need to normalize scale.
+// Single pass over buffer and no allocation.
+size_t CBigValue::hash() const
+{
+	uint64_t h = limbModM61(m_pBuffer, m_nBufferSize);
+	if (h != 0 && m_nScale != 0)
+	{
+		h = mulModM61(h, powModM61(s_nInverse10M61, m_nScale));
+	}
+	if (h != 0 && m_bNegative == true)
+	{
+		h = s_nPrimeM61 - h;
+	}
+
+	// finalize (murmur3 fmix64) so that small values spread over buckets
+	h ^= (h >> 33);
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= (h >> 33);
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= (h >> 33);
+	return (size_t)h;
+}
+
+size_t CBigValue::usedSize() const
+{
+	return limbUsedSize(m_pBuffer, m_nBufferSize);
+}
+
+size_t CBigValue::bitLength() const
+{
+	return limbBitLength(m_pBuffer, m_nBufferSize);
+}
+
+size_t CBigValue::popCount() const
+{
+	return limbPopCount(m_pBuffer, m_nBufferSize);
+}
+
 CBigValue::operator uint64_t() const
 {
 	// we know output limits so that simplifies..
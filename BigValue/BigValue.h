@@ -51,6 +51,10 @@
 #define BIGVALUE_H
 
 #include <stdint.h>
+#include <stddef.h>
+
+#include <functional>
+#include <vector>
 
 
 // for future, allow external arithmetic operators
@@ -92,10 +96,26 @@ union quadruple
 */
 
 
+// lazy sum/product expressions (see BigExpression.h)
+template <class E> class CBigExpr;
+
+
+// rounding modes (IEEE 754 directions + nearest ties away)
+// for conversions and arithmetic that lose precision
+enum BigRounding
+{
+	BigRoundingNearestEven = 0, // nearest, ties to even (IEEE default)
+	BigRoundingNearestAway,     // nearest, ties away from zero
+	BigRoundingTowardZero,      // truncate
+	BigRoundingUp,              // toward +infinity
+	BigRoundingDown             // toward -infinity
+};
+
+
 class CBigValue
 {
 protected:
-	uint8_t *m_pBuffer;
+	uint8_t *m_pBuffer; // 16-byte aligned (alignedAlloc)
 	size_t m_nBufferSize;
 
 	//size_t m_nUsedSize; // is this needed?
@@ -103,11 +123,14 @@ protected:
 	size_t m_nScale; // power of 10 scale
 	bool m_bNegative; // if negative
 
-	void CreateBuffer(const size_t nBufSize);
+	void CreateBuffer(const size_t nBufSize, const bool bClear = true);
 	void GrowBuffer(const size_t nBufSize);
 
 	void fromIEEEMantissa(const uint8_t *mantissa, const size_t size, const bool isBigendian);
 
+	// this += x * y, or -= when bSubtract
+	CBigValue& mulAccumulate(const CBigValue &x, const CBigValue &y, const bool bSubtract);
+
 public:
 	explicit CBigValue(const int64_t value);
 	explicit CBigValue(const uint64_t value);
@@ -116,6 +139,9 @@ public:
 
 	CBigValue(const CBigValue &other);
 
+	// evaluate expression (see BigExpression.h)
+	template <class E> CBigValue(const CBigExpr<E> &expr);
+
 	CBigValue(void);
 	~CBigValue(void);
 
@@ -141,16 +167,114 @@ public:
 	// other buffer "as-is" ?
 	CBigValue& fromBuffer(const uint8_t *pData, const size_t nSize, const bool bIsNegative, size_t nScale = 0);
 
+	// exact value of double rounded to decimal scale,
+	// as needed for DECIMAL(p,s) columns (see BigDecimal.cpp).
+	// infinity/NaN give zero.
+	CBigValue& fromDouble(const double value, const size_t nScale, const BigRounding eRounding = BigRoundingNearestEven);
+
+	// column of doubles to packed decimal column:
+	// each value * 10^nScale (rounded) as nWidth-byte
+	// little-endian two's complement integer.
+	// values that do not fit (and infinity/NaN) are written as zero
+	// and marked false in pValid (if given), returns count of those.
+	static size_t fromDoubleColumn(const double *pValues, const size_t nCount, const size_t nScale, const BigRounding eRounding, uint8_t *pColumn, const size_t nWidth, bool *pValid = nullptr);
+
+	// magnitude as 64-bit limbs (least significant first),
+	// for use with limb-array kernels
+	CBigValue& fromLimbs(const uint64_t *pLimbs, const size_t nCount, const bool bIsNegative, size_t nScale = 0);
+	void getLimbs(std::vector<uint64_t> &limbs) const;
+
 	CBigValue& operator = (const CBigValue &other);
 
+	// sum and difference: result has larger scale of the two
+	// (other one is rescaled exactly)
 	CBigValue operator + (const CBigValue &other) const;
 	CBigValue operator - (const CBigValue &other) const;
+	CBigValue& operator += (const CBigValue &other);
+	CBigValue& operator -= (const CBigValue &other);
+
+	// signed sum of any count of values in single carry-propagating pass
+	// (see BigExpression.cpp), pNegate may be null if none are subtracted.
+	// terms may include this value.
+	CBigValue& fromSum(const CBigValue * const *ppTerms, const bool *pNegate, const size_t nCount);
+
+	// this += x * y (or -=) without temporary product,
+	// same result as with separate operators
+	CBigValue& addMul(const CBigValue &x, const CBigValue &y);
+	CBigValue& subMul(const CBigValue &x, const CBigValue &y);
+
+	// evaluate expression (see BigExpression.h)
+	template <class E> CBigValue& operator = (const CBigExpr<E> &expr);
+	template <class E> CBigValue& operator += (const CBigExpr<E> &expr);
+	template <class E> CBigValue& operator -= (const CBigExpr<E> &expr);
+
+	// product: signs combine and scales add
+	CBigValue operator * (const CBigValue &other) const;
+	CBigValue& operator *= (const CBigValue &other);
+
+	// bit-shifts of magnitude (sign and scale are kept as-is),
+	// any shift count is single pass over buffer
+	CBigValue operator << (const size_t nBits) const;
+	CBigValue operator >> (const size_t nBits) const;
+	CBigValue& operator <<= (const size_t nBits);
+	CBigValue& operator >>= (const size_t nBits);
+
+	// bitwise on magnitudes, sign is combined with same operation
+	// (like an extra bit), scale of this value is kept
+	CBigValue operator & (const CBigValue &other) const;
+	CBigValue operator | (const CBigValue &other) const;
+	CBigValue operator ^ (const CBigValue &other) const;
+	CBigValue& operator &= (const CBigValue &other);
+	CBigValue& operator |= (const CBigValue &other);
+	CBigValue& operator ^= (const CBigValue &other);
+
+	// three-way compare of values (-1, 0, 1):
+	// sign first, then magnitude. Different scales are compared
+	// without making rescaled copy when magnitudes differ enough.
+	int compare(const CBigValue &other) const;
+
+	bool operator == (const CBigValue &other) const;
+	bool operator != (const CBigValue &other) const;
+	bool operator < (const CBigValue &other) const;
+	bool operator <= (const CBigValue &other) const;
+	bool operator > (const CBigValue &other) const;
+	bool operator >= (const CBigValue &other) const;
+
+	// hash of numeric value:
+	// equal for equal values regardless of scale or buffer size
+	size_t hash() const;
+
+	// exact combinatorial functions using prime factorization
+	// and balanced product tree (see BigFactorial.cpp)
+	static CBigValue factorial(const uint64_t n);
+	static CBigValue binomial(const uint64_t n, const uint64_t k);
+	static CBigValue primorial(const uint64_t n);
+
+	size_t getScale() const
+	{
+		return m_nScale;
+	}
+	bool isNegative() const
+	{
+		return m_bNegative;
+	}
+
+	// size of magnitude without high zero-bytes
+	size_t usedSize() const;
+
+	// highest set bit of magnitude +1 (zero for zero)
+	size_t bitLength() const;
+
+	// count of set bits in magnitude
+	size_t popCount() const;
 
 	// TODO: for extending artihmetics etc.
 	//CBigValue operand(CBigOperator *pOp) const;
 
-	operator uint64_t() const;
-	operator double() const;
+	// note: explicit, otherwise shift by integer literal
+	// would be ambiguous with built-in shift of converted value
+	explicit operator uint64_t() const;
+	explicit operator double() const;
 
 	friend class CBigValue;
 };
@@ -163,5 +287,17 @@ class CBigOperator
 };
 */
 
+// allow use as key in unordered containers
+namespace std
+{
+	template <> struct hash<CBigValue>
+	{
+		size_t operator()(const CBigValue &value) const
+		{
+			return value.hash();
+		}
+	};
+}
+
 #endif // BIGVALUE_H
 
@@ -0,0 +1,170 @@
+/////////////////////////////////////
+//
+// AlignedAllocator : heap memory aligned
+// for SIMD loads and stores.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Aligned loads (movaps, vmovaps) and streaming stores (movntps)
+// fault on addresses not aligned to vector size, and operator new
+// guarantees only 16 bytes (8 on some 32-bit targets).
+// Buffers from this allocator are aligned to 16 (SSE), 32 (AVX),
+// 64 (AVX-512, cache line) or page boundary.
+//
+// AlignedAllocator can be given to standard containers,
+// AlignedVector<T> is std::vector using it.
+//
+// Huge pages: allocations of 2 MB or more are aligned to 2 MB
+// and the kernel is asked to back them with huge pages
+// (madvise(MADV_HUGEPAGE), Linux only, ignored elsewhere)
+// which saves TLB misses when streaming over large arrays.
+//
+
+#ifndef ALIGNEDALLOCATOR_H
+#define ALIGNEDALLOCATOR_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <new>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+
+enum AlignedBoundary
+{
+	AlignedBoundarySSE = 16,
+	AlignedBoundaryAVX = 32,
+	AlignedBoundaryAVX512 = 64,
+	AlignedBoundaryCacheLine = 64,
+	// note: base page of x86, actual page size may be larger on other targets
+	AlignedBoundaryPage = 4096,
+	AlignedBoundaryHugePage = 2 * 1024 * 1024
+};
+
+
+// nAlignment must be power of two,
+// zero size gives valid (unique) block, nullptr on failure
+inline void* alignedAlloc(size_t nSize, size_t nAlignment)
+{
+	if (nAlignment < sizeof(void*))
+	{
+		nAlignment = sizeof(void*);
+	}
+	if (nSize == 0)
+	{
+		nSize = nAlignment;
+	}
+#if defined(_MSC_VER)
+	return ::_aligned_malloc(nSize, nAlignment);
+#else
+	// note: malloc() already gives this and is faster than posix_memalign()
+	if (nAlignment <= alignof(max_align_t))
+	{
+		return ::malloc(nSize);
+	}
+	void *p = nullptr;
+	if (::posix_memalign(&p, nAlignment, nSize) != 0)
+	{
+		return nullptr;
+	}
+	return p;
+#endif
+}
+
+inline void alignedFree(void *p)
+{
+#if defined(_MSC_VER)
+	::_aligned_free(p);
+#else
+	::free(p);
+#endif
+}
+
+// large blocks aligned to huge page and advised for huge pages,
+// free with alignedFree()
+inline void* alignedAllocHuge(size_t nSize, size_t nAlignment)
+{
+	if (nSize < (size_t)AlignedBoundaryHugePage)
+	{
+		return alignedAlloc(nSize, nAlignment);
+	}
+
+	// whole huge pages
+	nSize = (nSize + AlignedBoundaryHugePage - 1) & ~((size_t)AlignedBoundaryHugePage - 1);
+	void *p = alignedAlloc(nSize, (nAlignment > (size_t)AlignedBoundaryHugePage) ? nAlignment : (size_t)AlignedBoundaryHugePage);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	if (p != nullptr)
+	{
+		// only advice: small pages are used if this fails
+		::madvise(p, nSize, MADV_HUGEPAGE);
+	}
+#endif
+	return p;
+}
+
+
+template <typename T, size_t nAlignment = AlignedBoundaryCacheLine, bool bHugePages = false>
+class AlignedAllocator
+{
+	static_assert((nAlignment & (nAlignment - 1)) == 0, "alignment must be power of two");
+
+public:
+	typedef T value_type;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	// note: needed since non-type parameters prevent default rebind
+	template <typename U> struct rebind
+	{
+		typedef AlignedAllocator<U, nAlignment, bHugePages> other;
+	};
+
+	AlignedAllocator() noexcept
+	{}
+	template <typename U> AlignedAllocator(const AlignedAllocator<U, nAlignment, bHugePages> &) noexcept
+	{}
+
+	T* allocate(const size_t nCount)
+	{
+		if (nCount > (size_t)-1 / sizeof(T))
+		{
+			throw std::bad_alloc();
+		}
+
+		const size_t nAlign = (nAlignment > alignof(T)) ? nAlignment : alignof(T);
+		void *p = (bHugePages == true) ? alignedAllocHuge(nCount * sizeof(T), nAlign) : alignedAlloc(nCount * sizeof(T), nAlign);
+		if (p == nullptr)
+		{
+			throw std::bad_alloc();
+		}
+		return static_cast<T*>(p);
+	}
+
+	void deallocate(T *p, const size_t) noexcept
+	{
+		alignedFree(p);
+	}
+
+	// stateless: any instance can free memory of another
+	template <typename U> bool operator == (const AlignedAllocator<U, nAlignment, bHugePages> &) const noexcept
+	{
+		return true;
+	}
+	template <typename U> bool operator != (const AlignedAllocator<U, nAlignment, bHugePages> &) const noexcept
+	{
+		return false;
+	}
+};
+
+template <typename T, size_t nAlignment = AlignedBoundaryCacheLine, bool bHugePages = false>
+using AlignedVector = std::vector<T, AlignedAllocator<T, nAlignment, bHugePages> >;
+
+#endif // ALIGNEDALLOCATOR_H
@@ -0,0 +1,344 @@
+/////////////////////////////////////
+//
+// CpuFeatures : runtime detection of x86 instruction set
+// extensions for selecting kernels.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Header-only, builds with MSVC (__cpuidex, _xgetbv)
+// and GCC/Clang (<cpuid.h>, xgetbv in inline assembly).
+// Instruction sets using wider registers (AVX, AVX-512) are reported
+// only if operating system also saves those registers (XCR0),
+// otherwise using them would fault even if CPU has them.
+//
+// Features are grouped to tiers for dispatching kernels:
+// kernel for highest tier that is available is selected once
+// (first call) and called through function pointer after that.
+// For benchmarking lower tiers can be forced by
+// environment variable MATHEXP_CPU_TIER (scalar, sse2, sse41, avx2, avx512)
+// before first use, or by cpuLimitTier() followed by
+// reselecting kernels (see limbSelectKernels() in BigLimb.h).
+//
+// Cache sizes come from deterministic cache parameters
+// (cpuid leaf 4 on Intel, 0x8000001D on AMD), levels that are not
+// reported get typical sizes (32 KB, 256 KB, 8 MB): they are used
+// for tuning (block sizes, streaming thresholds), not for correctness.
+//
+// Non-x86 targets report no features (scalar tier).
+//
+
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#include <immintrin.h>
+#define CPUFEATURES_X86
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+#include <cpuid.h>
+#define CPUFEATURES_X86
+#endif
+
+
+enum CpuFeature
+{
+	CpuFeatureSSE2 = 0x1,
+	CpuFeatureSSE3 = 0x2,
+	CpuFeatureSSSE3 = 0x4,
+	CpuFeatureSSE41 = 0x8,
+	CpuFeatureSSE42 = 0x10,
+	CpuFeaturePOPCNT = 0x20,
+	CpuFeatureAVX = 0x40,
+	CpuFeatureFMA = 0x80,
+	CpuFeatureF16C = 0x100,
+	CpuFeatureAVX2 = 0x200,
+	CpuFeatureBMI2 = 0x400,
+	CpuFeatureADX = 0x800,
+	CpuFeatureAVX512F = 0x1000,
+	CpuFeatureAVX512BW = 0x2000,
+	CpuFeatureAVX512IFMA = 0x4000
+};
+
+// each tier includes features of lower tiers
+enum CpuTier
+{
+	CpuTierScalar = 0,
+	CpuTierSSE2,        // SSE2
+	CpuTierSSE41,       // SSE3, SSSE3, SSE4.1, SSE4.2, POPCNT
+	CpuTierAVX2,        // AVX, FMA, F16C, AVX2 (and BMI2, ADX when present)
+	CpuTierAVX512,      // AVX-512 F, BW, IFMA
+	CpuTierCount
+};
+
+
+////////// detection
+
+// registers of cpuid leaf (eax, ebx, ecx, edx), zero if not supported
+inline void cpuidLeaf(const unsigned int nLeaf, const unsigned int nSubLeaf, unsigned int regs[4])
+{
+	regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#if defined(CPUFEATURES_X86) && defined(_MSC_VER)
+	int info[4] = {0, 0, 0, 0};
+	// highest basic or extended leaf
+	__cpuid(info, (int)(nLeaf & 0x80000000u));
+	if ((unsigned int)info[0] >= nLeaf)
+	{
+		__cpuidex(info, (int)nLeaf, (int)nSubLeaf);
+		for (int i = 0; i < 4; i++)
+		{
+			regs[i] = (unsigned int)info[i];
+		}
+	}
+#elif defined(CPUFEATURES_X86)
+	// checks highest supported leaf itself
+	__get_cpuid_count(nLeaf, nSubLeaf, &regs[0], &regs[1], &regs[2], &regs[3]);
+#else
+	(void)nLeaf;
+	(void)nSubLeaf;
+#endif
+}
+
+// extended control register 0: register state saved by OS,
+// caller must check OSXSAVE first
+inline uint64_t cpuXgetbv()
+{
+#if defined(CPUFEATURES_X86) && defined(_MSC_VER)
+	return _xgetbv(0);
+#elif defined(CPUFEATURES_X86)
+	// note: inline assembly instead of _xgetbv()
+	// which needs -mxsave for whole translation unit
+	uint32_t low = 0;
+	uint32_t high = 0;
+	__asm__ __volatile__ ("xgetbv" : "=a" (low), "=d" (high) : "c" (0));
+	return ((uint64_t)high << 32) | low;
+#else
+	return 0;
+#endif
+}
+
+// features of this CPU and OS (not limited by tier)
+inline uint32_t cpuDetectFeatures()
+{
+	uint32_t features = 0;
+	unsigned int leaf1[4];
+	unsigned int leaf7[4];
+	cpuidLeaf(1, 0, leaf1);
+	cpuidLeaf(7, 0, leaf7);
+
+	const unsigned int ecx1 = leaf1[2];
+	const unsigned int edx1 = leaf1[3];
+	const unsigned int ebx7 = leaf7[1];
+
+	features |= (edx1 & (1u << 26)) ? CpuFeatureSSE2 : 0;
+	features |= (ecx1 & (1u << 0)) ? CpuFeatureSSE3 : 0;
+	features |= (ecx1 & (1u << 9)) ? CpuFeatureSSSE3 : 0;
+	features |= (ecx1 & (1u << 19)) ? CpuFeatureSSE41 : 0;
+	features |= (ecx1 & (1u << 20)) ? CpuFeatureSSE42 : 0;
+	features |= (ecx1 & (1u << 23)) ? CpuFeaturePOPCNT : 0;
+	features |= (ebx7 & (1u << 8)) ? CpuFeatureBMI2 : 0;
+	features |= (ebx7 & (1u << 19)) ? CpuFeatureADX : 0;
+
+	// OSXSAVE: XCR0 can be read
+	if ((ecx1 & (1u << 27)) != 0)
+	{
+		const uint64_t xcr0 = cpuXgetbv();
+
+		// XMM and YMM state
+		if ((xcr0 & 0x6) == 0x6)
+		{
+			features |= (ecx1 & (1u << 28)) ? CpuFeatureAVX : 0;
+			features |= (ecx1 & (1u << 12)) ? CpuFeatureFMA : 0;
+			features |= (ecx1 & (1u << 29)) ? CpuFeatureF16C : 0;
+			features |= (ebx7 & (1u << 5)) ? CpuFeatureAVX2 : 0;
+		}
+
+		// and opmask, upper ZMM0-15 and ZMM16-31 state
+		if ((xcr0 & 0xE6) == 0xE6)
+		{
+			features |= (ebx7 & (1u << 16)) ? CpuFeatureAVX512F : 0;
+			features |= (ebx7 & (1u << 30)) ? CpuFeatureAVX512BW : 0;
+			features |= (ebx7 & (1u << 21)) ? CpuFeatureAVX512IFMA : 0;
+		}
+	}
+	return features;
+}
+
+// features allowed by tier
+inline uint32_t cpuTierMask(const CpuTier eTier)
+{
+	uint32_t mask = 0;
+	if (eTier >= CpuTierSSE2)
+	{
+		mask |= CpuFeatureSSE2;
+	}
+	if (eTier >= CpuTierSSE41)
+	{
+		mask |= CpuFeatureSSE3 | CpuFeatureSSSE3 | CpuFeatureSSE41 | CpuFeatureSSE42 | CpuFeaturePOPCNT;
+	}
+	if (eTier >= CpuTierAVX2)
+	{
+		mask |= CpuFeatureAVX | CpuFeatureFMA | CpuFeatureF16C | CpuFeatureAVX2 | CpuFeatureBMI2 | CpuFeatureADX;
+	}
+	if (eTier >= CpuTierAVX512)
+	{
+		mask |= CpuFeatureAVX512F | CpuFeatureAVX512BW | CpuFeatureAVX512IFMA;
+	}
+	return mask;
+}
+
+inline const char* cpuTierName(const CpuTier eTier)
+{
+	static const char *s_Names[CpuTierCount] = {"scalar", "sse2", "sse41", "avx2", "avx512"};
+	return (eTier < CpuTierCount) ? s_Names[eTier] : "unknown";
+}
+
+// tier from environment (MATHEXP_CPU_TIER), highest if not set
+inline CpuTier cpuEnvironmentTier()
+{
+	const char *szTier = ::getenv("MATHEXP_CPU_TIER");
+	if (szTier != nullptr)
+	{
+		for (int i = 0; i < CpuTierCount; i++)
+		{
+			if (::strcmp(szTier, cpuTierName((CpuTier)i)) == 0)
+			{
+				return (CpuTier)i;
+			}
+		}
+	}
+	return CpuTierAVX512;
+}
+
+
+// sizes in bytes of data caches (level 1 data, level 2 and last level)
+struct CpuCacheSizes
+{
+	size_t m_nL1Data;
+	size_t m_nL2;
+	size_t m_nLastLevel;
+	size_t m_nLineSize;
+};
+
+// cache sizes of leaf 4 layout at nLeaf, false if leaf is not supported
+inline bool cpuDetectCacheLeaf(const unsigned int nLeaf, CpuCacheSizes &sizes)
+{
+	bool bFound = false;
+	for (unsigned int nSubLeaf = 0; nSubLeaf < 16; nSubLeaf++)
+	{
+		unsigned int regs[4];
+		cpuidLeaf(nLeaf, nSubLeaf, regs);
+
+		// type 0: no more caches, 2: instruction cache
+		const unsigned int nType = regs[0] & 0x1F;
+		if (nType == 0)
+		{
+			break;
+		}
+		if (nType == 2)
+		{
+			continue;
+		}
+
+		// ways * partitions * line size * sets
+		const unsigned int nLevel = (regs[0] >> 5) & 0x7;
+		const size_t nLine = (size_t)(regs[1] & 0xFFF) + 1;
+		const size_t nSize = ((size_t)(regs[1] >> 22) + 1) * ((size_t)((regs[1] >> 12) & 0x3FF) + 1) * nLine * ((size_t)regs[2] + 1);
+		if (nLevel == 1)
+		{
+			sizes.m_nL1Data = nSize;
+			sizes.m_nLineSize = nLine;
+		}
+		else if (nLevel == 2)
+		{
+			sizes.m_nL2 = nSize;
+		}
+		if (nLevel >= 2)
+		{
+			sizes.m_nLastLevel = nSize;
+		}
+		bFound = true;
+	}
+	return bFound;
+}
+
+inline CpuCacheSizes cpuDetectCacheSizes()
+{
+	CpuCacheSizes sizes;
+	sizes.m_nL1Data = 32 * 1024;
+	sizes.m_nL2 = 256 * 1024;
+	sizes.m_nLastLevel = 8 * 1024 * 1024;
+	sizes.m_nLineSize = 64;
+
+	// note: leaf 4 is reserved (zero) on AMD
+	if (cpuDetectCacheLeaf(4, sizes) == false)
+	{
+		cpuDetectCacheLeaf(0x8000001D, sizes);
+	}
+	return sizes;
+}
+
+
+////////// queries
+
+// note: function-local statics so that header-only module
+// has single instance of state over translation units
+inline uint32_t& cpuFeatureState()
+{
+	static uint32_t s_nFeatures = cpuDetectFeatures() & cpuTierMask(cpuEnvironmentTier());
+	return s_nFeatures;
+}
+
+// detected features limited by forced tier
+inline uint32_t cpuFeatures()
+{
+	return cpuFeatureState();
+}
+
+inline bool cpuHasFeature(const CpuFeature eFeature)
+{
+	return ((cpuFeatures() & eFeature) == (uint32_t)eFeature);
+}
+
+// features needed by a tier are all present:
+// scalar extensions (BMI2, ADX) and AVX-512 subsets
+// are allowed by tier but not required
+inline bool cpuHasTier(const CpuTier eTier)
+{
+	const uint32_t optional = CpuFeatureBMI2 | CpuFeatureADX | CpuFeatureAVX512BW | CpuFeatureAVX512IFMA;
+	const uint32_t mask = cpuTierMask(eTier) & ~optional;
+	return ((cpuFeatures() & mask) == mask);
+}
+
+// highest tier with all its features
+inline CpuTier cpuTier()
+{
+	int nTier = CpuTierScalar;
+	while (nTier + 1 < CpuTierCount && cpuHasTier((CpuTier)(nTier + 1)) == true)
+	{
+		nTier++;
+	}
+	return (CpuTier)nTier;
+}
+
+// detected once, not affected by tier
+inline const CpuCacheSizes& cpuCacheSizes()
+{
+	static const CpuCacheSizes s_Sizes = cpuDetectCacheSizes();
+	return s_Sizes;
+}
+
+// report only features upto given tier (for benchmarking lower tiers):
+// kernels already selected must be selected again after this
+inline void cpuLimitTier(const CpuTier eTier)
+{
+	cpuFeatureState() = cpuDetectFeatures() & cpuTierMask(eTier);
+}
+
+#endif // CPUFEATURES_H
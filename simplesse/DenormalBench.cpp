@@ -0,0 +1,95 @@
+// DenormalBench.cpp : cost of denormal (subnormal) floats
+// with default mode and with flush-to-zero (DenormalGuard).
+//
+// usage: DenormalBench [count] [MicroBench options]
+//
+// count is array length (default 4096 floats, in L1 cache),
+// same kernels are run on normal inputs, on denormal inputs
+// and on denormal inputs with FTZ/DAZ kernel policy.
+//
+
+#include "DenormalGuard.h"
+#include "sseArray.h"
+#include "SimdMath.h"
+#include "AlignedAllocator.h"
+#include "MicroBench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <float.h>
+
+
+// dst = a * b, left for compiler (scalar or vectorized)
+static void plainMul(float *pDst, const float *pA, const float *pB, const size_t nCount)
+{
+	for (size_t i = 0; i < nCount; i++)
+	{
+		pDst[i] = pA[i] * pB[i];
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	size_t nCount = 4096;
+	if (argc > 1 && argv[1][0] != '-')
+	{
+		nCount = (size_t)::strtoull(argv[1], nullptr, 10);
+	}
+
+	MicroBench bench;
+	if (bench.parseArgs(argc, argv) == false)
+	{
+		fprintf(stderr, "invalid options\n");
+		return 1;
+	}
+
+	// denormal: below FLT_MIN, products also denormal;
+	// exp of values below -87.3 is denormal
+	AlignedVector<float> normal(nCount);
+	AlignedVector<float> denormal(nCount);
+	AlignedVector<float> half(nCount);
+	AlignedVector<float> expNormal(nCount);
+	AlignedVector<float> expDenormal(nCount);
+	AlignedVector<float> dst(nCount);
+	for (size_t i = 0; i < nCount; i++)
+	{
+		normal[i] = 1.0f + (float)(i % 17) * 0.25f;
+		denormal[i] = FLT_MIN * (0.01f + (float)(i % 17) * 0.05f);
+		half[i] = 0.5f;
+		expNormal[i] = -80.0f + (float)(i % 64) * 0.1f;
+		expDenormal[i] = -100.0f + (float)(i % 64) * 0.1f;
+	}
+
+	MicroBenchParams params;
+	params.push_back(std::make_pair(std::string("count"), (double)nCount));
+	const char *szModes[3] = {"normal", "denormal", "denormal flush"};
+	for (int nMode = 0; nMode < 3; nMode++)
+	{
+		const std::string szMode(szModes[nMode]);
+		const float *pInput = (nMode == 0) ? normal.data() : denormal.data();
+		const float *pExpInput = (nMode == 0) ? expNormal.data() : expDenormal.data();
+		denormalSetKernelPolicy((nMode == 2) ? DenormalPolicyFlush : DenormalPolicyCaller);
+
+		bench.run("plain mul " + szMode, params, [&]()
+		{
+			// plain loop is no kernel: guard here
+			const DenormalGuard guard((nMode == 2) ? (unsigned int)DenormalModeFlush : denormalMode());
+			plainMul(dst.data(), pInput, half.data(), nCount);
+		}, (double)nCount);
+		bench.run("sseArrayMul " + szMode, params, [&]()
+		{
+			sseArrayMul(dst.data(), pInput, half.data(), nCount);
+		}, (double)nCount);
+		bench.run("sseArrayDot " + szMode, params, [&]()
+		{
+			microBenchKeep(sseArrayDot(pInput, half.data(), nCount));
+		}, (double)nCount);
+		bench.run("simdArrayExp " + szMode, params, [&]()
+		{
+			simdArrayExp(dst.data(), pExpInput, nCount);
+		}, (double)nCount);
+	}
+	denormalSetKernelPolicy(DenormalPolicyCaller);
+
+	return (bench.report() == true) ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+/////////////////////////////////////
+//
+// DenormalGuard : flush-to-zero and denormals-are-zero
+// modes of SSE unit (MXCSR) for a scope.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Header-only. Operations with denormal (subnormal) input or result
+// take microcode assist on most x86 CPUs: over hundred cycles
+// instead of few. Flush-to-zero (FTZ) gives zero instead of
+// denormal result, denormals-are-zero (DAZ) reads denormal inputs
+// as zero. Values below 1.2e-38 (float) or 2.2e-308 (double)
+// become zero so modes are opt-in.
+//
+// MXCSR is per-thread state: guard affects only thread creating it.
+// Guard changes and restores only the two mode bits, exception flags
+// raised inside scope are kept. New threads start in default mode
+// (Windows) or in mode of creating thread (POSIX): TaskPool runs
+// each task under DenormalGuard of mode of forking thread,
+// other long-lived threads can call denormalSetMode() once at start.
+//
+// Array kernels (sseArray, SimdMath) run in caller's mode unless
+// kernel policy is set to flush (denormalSetKernelPolicy()):
+// then each call runs under guard and caller's mode is restored after.
+//
+// Affects SSE/AVX arithmetic only, not x87 (32-bit builds without
+// SSE2 code generation). DAZ is missing on first Pentium 4 versions.
+//
+
+#ifndef DENORMALGUARD_H
+#define DENORMALGUARD_H
+
+#include <immintrin.h>
+#include <atomic>
+
+
+// bits of MXCSR
+enum DenormalMode
+{
+	DenormalModeIEEE = 0,                   // denormals computed (default)
+	DenormalModeDenormalsAreZero = 0x0040,  // DAZ: denormal inputs read as zero
+	DenormalModeFlushToZero = 0x8000,       // FTZ: denormal results are zero
+	DenormalModeFlush = 0x8040              // both
+};
+
+enum DenormalPolicy
+{
+	DenormalPolicyCaller = 0,    // kernels run in mode of calling thread
+	DenormalPolicyFlush          // kernels run with FTZ and DAZ
+};
+
+
+////////// thread mode
+
+// mode of calling thread
+inline unsigned int denormalMode()
+{
+	return (_mm_getcsr() & DenormalModeFlush);
+}
+
+// mode of calling thread until changed
+inline void denormalSetMode(const unsigned int nMode)
+{
+	_mm_setcsr((_mm_getcsr() & ~(unsigned int)DenormalModeFlush) | (nMode & DenormalModeFlush));
+}
+
+// mode for scope, restored at end of scope
+class DenormalGuard
+{
+protected:
+	unsigned int m_nSavedMode;
+
+	DenormalGuard(const DenormalGuard &) = delete;
+	DenormalGuard& operator = (const DenormalGuard &) = delete;
+
+public:
+	// note: setting MXCSR is slow (serializing on some CPUs),
+	// not written if mode is already same
+	explicit DenormalGuard(const unsigned int nMode = DenormalModeFlush)
+		: m_nSavedMode(denormalMode())
+	{
+		if ((nMode & DenormalModeFlush) != m_nSavedMode)
+		{
+			denormalSetMode(nMode);
+		}
+	}
+	~DenormalGuard()
+	{
+		if (denormalMode() != m_nSavedMode)
+		{
+			denormalSetMode(m_nSavedMode);
+		}
+	}
+
+	// mode before guard
+	unsigned int savedMode() const
+	{
+		return m_nSavedMode;
+	}
+};
+
+
+////////// kernel policy
+
+// note: function-local static so that header-only module
+// has single instance of state over translation units
+inline std::atomic<int>& denormalPolicyState()
+{
+	static std::atomic<int> s_nPolicy(DenormalPolicyCaller);
+	return s_nPolicy;
+}
+
+// policy of array kernels in all threads
+inline void denormalSetKernelPolicy(const DenormalPolicy ePolicy)
+{
+	denormalPolicyState().store(ePolicy, std::memory_order_relaxed);
+}
+
+inline DenormalPolicy denormalKernelPolicy()
+{
+	return (DenormalPolicy)denormalPolicyState().load(std::memory_order_relaxed);
+}
+
+// call func() in mode of kernel policy
+template <class Func> inline void denormalRunKernel(const Func &func)
+{
+	if (denormalKernelPolicy() == DenormalPolicyFlush)
+	{
+		const DenormalGuard guard(DenormalModeFlush);
+		func();
+	}
+	else
+	{
+		func();
+	}
+}
+
+#endif // DENORMALGUARD_H
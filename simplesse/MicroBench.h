@@ -0,0 +1,529 @@
+/////////////////////////////////////
+//
+// MicroBench : timing harness for kernels
+// with repeatable, machine-readable results.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Header-only, portable (std::chrono::steady_clock),
+// optionally also time-stamp counter (rdtsc) on x86:
+// note that counter ticks at constant reference rate, not core clock.
+//
+// Each benchmark is calibrated first: iterations per sample are doubled
+// until one sample takes at least minimum sample time
+// (so that clock resolution does not matter), then warmup samples
+// are discarded and repetitions are timed.
+// Results are per iteration: median and percentiles of samples,
+// mean after trimming outliers from both ends.
+//
+// Results can be written as CSV or JSON (one record per line,
+// same order and keys on every run) to be compared between commits,
+// and compared to earlier CSV directly (--baseline).
+//
+// Command line options given to parseArgs():
+//   --reps N        timed samples (default 15)
+//   --warmup N      discarded samples (default 2)
+//   --min-time S    minimum seconds per sample (default 0.002)
+//   --trim F        fraction trimmed from each end for mean (default 0.1)
+//   --cycles        also count time-stamp counter ticks
+//   --filter TEXT   run only benchmarks with TEXT in name
+//   --csv FILE      write CSV (- for standard output)
+//   --json FILE     write JSON lines (- for standard output)
+//   --baseline FILE compare to earlier CSV
+//
+
+#ifndef MICROBENCH_H
+#define MICROBENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define MICROBENCH_RDTSC
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+#include <x86intrin.h>
+#define MICROBENCH_RDTSC
+#endif
+
+
+////////// keeping results alive
+
+// compiler must assume value is used:
+// prevents removing computation whose result is not otherwise needed
+template <typename T> inline void microBenchKeep(const T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	__asm__ __volatile__ ("" : : "r" (&value) : "memory");
+#else
+	static const void * volatile s_pSink = nullptr;
+	s_pSink = &value;
+	_ReadWriteBarrier();
+#endif
+}
+
+// compiler must assume all memory was read and written:
+// prevents hoisting loads or dropping stores around timed code
+inline void microBenchClobber()
+{
+#if defined(__GNUC__) || defined(__clang__)
+	__asm__ __volatile__ ("" : : : "memory");
+#else
+	_ReadWriteBarrier();
+#endif
+}
+
+// time-stamp counter, zero if not available
+inline uint64_t microBenchTicks()
+{
+#if defined(MICROBENCH_RDTSC)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+
+////////// harness
+
+typedef std::vector<std::pair<std::string, double> > MicroBenchParams;
+
+struct MicroBenchConfig
+{
+	size_t m_nRepetitions;
+	size_t m_nWarmup;
+	double m_dMinSampleTime; // seconds
+	double m_dTrim;          // fraction from each end
+	bool m_bTicks;
+	std::string m_szFilter;
+	std::string m_szCsvFile;
+	std::string m_szJsonFile;
+	std::string m_szBaselineFile;
+
+	MicroBenchConfig()
+		: m_nRepetitions(15)
+		, m_nWarmup(2)
+		, m_dMinSampleTime(0.002)
+		, m_dTrim(0.1)
+		, m_bTicks(false)
+	{}
+};
+
+struct MicroBenchResult
+{
+	std::string m_szName;
+	MicroBenchParams m_Params;
+	size_t m_nIterations;   // per sample
+	double m_dItems;        // work items per iteration (elements, limbs..)
+
+	// nanoseconds per iteration
+	double m_dMedian;
+	double m_dMin;
+	double m_dP10;
+	double m_dP90;
+	double m_dTrimmedMean;
+
+	// counter ticks per iteration (median), zero if not counted
+	double m_dTicks;
+
+	// name and parameters as single key ("name/param=value/..")
+	std::string key() const
+	{
+		std::string szKey = m_szName;
+		for (size_t i = 0; i < m_Params.size(); i++)
+		{
+			char szValue[64];
+			::snprintf(szValue, sizeof(szValue), "%.17g", m_Params[i].second);
+			szKey += "/" + m_Params[i].first + "=" + szValue;
+		}
+		return szKey;
+	}
+	double itemsPerSecond() const
+	{
+		return (m_dMedian > 0.0) ? m_dItems * 1e9 / m_dMedian : 0.0;
+	}
+};
+
+class MicroBench
+{
+protected:
+	MicroBenchConfig m_Config;
+	std::vector<MicroBenchResult> m_Results;
+
+	static double seconds(const std::chrono::steady_clock::time_point &start, const std::chrono::steady_clock::time_point &end)
+	{
+		return std::chrono::duration<double>(end - start).count();
+	}
+
+	// value at fraction of sorted samples, interpolated
+	static double percentile(const std::vector<double> &sorted, const double dFraction)
+	{
+		if (sorted.empty() == true)
+		{
+			return 0.0;
+		}
+		const double dPos = dFraction * (double)(sorted.size() - 1);
+		const size_t nLow = (size_t)dPos;
+		const size_t nHigh = (nLow + 1 < sorted.size()) ? nLow + 1 : nLow;
+		return sorted[nLow] + (sorted[nHigh] - sorted[nLow]) * (dPos - (double)nLow);
+	}
+
+	static std::string jsonString(const std::string &szText)
+	{
+		std::string szOut = "\"";
+		for (size_t i = 0; i < szText.size(); i++)
+		{
+			const char c = szText[i];
+			if (c == '"' || c == '\\')
+			{
+				szOut += '\\';
+			}
+			szOut += c;
+		}
+		return szOut + "\"";
+	}
+
+	static FILE* openOutput(const std::string &szFile)
+	{
+		if (szFile == "-")
+		{
+			return stdout;
+		}
+		return ::fopen(szFile.c_str(), "w");
+	}
+	static void closeOutput(FILE *pFile)
+	{
+		if (pFile != nullptr && pFile != stdout)
+		{
+			::fclose(pFile);
+		}
+	}
+
+public:
+	MicroBench()
+	{}
+	explicit MicroBench(const MicroBenchConfig &config)
+		: m_Config(config)
+	{}
+
+	MicroBenchConfig& config()
+	{
+		return m_Config;
+	}
+	const std::vector<MicroBenchResult>& results() const
+	{
+		return m_Results;
+	}
+
+	// options listed in header, unknown arguments are left to caller:
+	// returns false for malformed option
+	bool parseArgs(const int argc, char * const argv[])
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const char *szArg = argv[i];
+			const char *szValue = (i + 1 < argc) ? argv[i + 1] : nullptr;
+			if (::strcmp(szArg, "--cycles") == 0)
+			{
+				m_Config.m_bTicks = true;
+				continue;
+			}
+			if (::strncmp(szArg, "--", 2) != 0)
+			{
+				continue;
+			}
+			if (szValue == nullptr)
+			{
+				return false;
+			}
+
+			if (::strcmp(szArg, "--reps") == 0)
+			{
+				m_Config.m_nRepetitions = (size_t)::strtoull(szValue, nullptr, 10);
+			}
+			else if (::strcmp(szArg, "--warmup") == 0)
+			{
+				m_Config.m_nWarmup = (size_t)::strtoull(szValue, nullptr, 10);
+			}
+			else if (::strcmp(szArg, "--min-time") == 0)
+			{
+				m_Config.m_dMinSampleTime = ::strtod(szValue, nullptr);
+			}
+			else if (::strcmp(szArg, "--trim") == 0)
+			{
+				m_Config.m_dTrim = ::strtod(szValue, nullptr);
+			}
+			else if (::strcmp(szArg, "--filter") == 0)
+			{
+				m_Config.m_szFilter = szValue;
+			}
+			else if (::strcmp(szArg, "--csv") == 0)
+			{
+				m_Config.m_szCsvFile = szValue;
+			}
+			else if (::strcmp(szArg, "--json") == 0)
+			{
+				m_Config.m_szJsonFile = szValue;
+			}
+			else if (::strcmp(szArg, "--baseline") == 0)
+			{
+				m_Config.m_szBaselineFile = szValue;
+			}
+			else
+			{
+				return false;
+			}
+			i++;
+		}
+		if (m_Config.m_nRepetitions == 0)
+		{
+			m_Config.m_nRepetitions = 1;
+		}
+		return true;
+	}
+
+	// time func() (one iteration), dItems is work per iteration for throughput:
+	// returns nullptr when filtered out
+	template <class Func>
+	const MicroBenchResult* run(const std::string &szName, const MicroBenchParams &params, const Func &func, const double dItems = 1.0)
+	{
+		MicroBenchResult result;
+		result.m_szName = szName;
+		result.m_Params = params;
+		result.m_dItems = dItems;
+		if (m_Config.m_szFilter.empty() == false && result.key().find(m_Config.m_szFilter) == std::string::npos)
+		{
+			return nullptr;
+		}
+
+		// calibrate: double iterations until sample is long enough
+		size_t nIterations = 1;
+		for (;;)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < nIterations; i++)
+			{
+				func();
+				microBenchClobber();
+			}
+			const double dTime = seconds(start, std::chrono::steady_clock::now());
+			if (dTime >= m_Config.m_dMinSampleTime || nIterations >= ((size_t)1 << 40))
+			{
+				break;
+			}
+			nIterations *= 2;
+		}
+		result.m_nIterations = nIterations;
+
+		std::vector<double> samples;
+		std::vector<double> ticks;
+		samples.reserve(m_Config.m_nRepetitions);
+		for (size_t r = 0; r < m_Config.m_nWarmup + m_Config.m_nRepetitions; r++)
+		{
+			const uint64_t nTickStart = (m_Config.m_bTicks == true) ? microBenchTicks() : 0;
+			const auto start = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < nIterations; i++)
+			{
+				func();
+				microBenchClobber();
+			}
+			const auto end = std::chrono::steady_clock::now();
+			const uint64_t nTickEnd = (m_Config.m_bTicks == true) ? microBenchTicks() : 0;
+
+			if (r >= m_Config.m_nWarmup)
+			{
+				samples.push_back(seconds(start, end) * 1e9 / (double)nIterations);
+				ticks.push_back((double)(nTickEnd - nTickStart) / (double)nIterations);
+			}
+		}
+
+		std::sort(samples.begin(), samples.end());
+		std::sort(ticks.begin(), ticks.end());
+		result.m_dMedian = percentile(samples, 0.5);
+		result.m_dMin = samples.front();
+		result.m_dP10 = percentile(samples, 0.1);
+		result.m_dP90 = percentile(samples, 0.9);
+		result.m_dTicks = percentile(ticks, 0.5);
+
+		const size_t nTrim = (size_t)(m_Config.m_dTrim * (double)samples.size());
+		double dSum = 0.0;
+		size_t nKept = 0;
+		for (size_t i = nTrim; i + nTrim < samples.size(); i++)
+		{
+			dSum += samples[i];
+			nKept++;
+		}
+		result.m_dTrimmedMean = (nKept > 0) ? dSum / (double)nKept : result.m_dMedian;
+
+		m_Results.push_back(result);
+		return &m_Results.back();
+	}
+
+	// one run per value of single parameter: func(value) is one iteration,
+	// items(value) is work per iteration
+	template <class Func, class Items>
+	void sweep(const std::string &szName, const std::string &szParam, const std::vector<size_t> &values, const Func &func, const Items &items)
+	{
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			const size_t nValue = values[i];
+			MicroBenchParams params;
+			params.push_back(std::make_pair(szParam, (double)nValue));
+			run(szName, params, [&func, nValue]() { func(nValue); }, (double)items(nValue));
+		}
+	}
+
+	// powers of two from first to last (inclusive)
+	static std::vector<size_t> powersOfTwo(const size_t nFirst, const size_t nLast)
+	{
+		std::vector<size_t> values;
+		for (size_t n = nFirst; n <= nLast && n > 0; n *= 2)
+		{
+			values.push_back(n);
+		}
+		return values;
+	}
+
+	void printTable(FILE *pFile = stdout) const
+	{
+		::fprintf(pFile, "%-44s %12s %12s %12s %14s%s\n", "benchmark", "median ns", "p10 ns", "p90 ns", "items/s", (m_Config.m_bTicks == true) ? "        ticks" : "");
+		for (size_t i = 0; i < m_Results.size(); i++)
+		{
+			const MicroBenchResult &result = m_Results[i];
+			::fprintf(pFile, "%-44s %12.1f %12.1f %12.1f %14.4g", result.key().c_str(), result.m_dMedian, result.m_dP10, result.m_dP90, result.itemsPerSecond());
+			if (m_Config.m_bTicks == true)
+			{
+				::fprintf(pFile, " %12.1f", result.m_dTicks);
+			}
+			::fprintf(pFile, "\n");
+		}
+	}
+
+	void writeCsv(FILE *pFile) const
+	{
+		::fprintf(pFile, "key,iterations,items,median_ns,min_ns,p10_ns,p90_ns,trimmed_mean_ns,ticks\n");
+		for (size_t i = 0; i < m_Results.size(); i++)
+		{
+			const MicroBenchResult &result = m_Results[i];
+			::fprintf(pFile, "%s,%zu,%.17g,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g\n", result.key().c_str(), result.m_nIterations, result.m_dItems,
+				result.m_dMedian, result.m_dMin, result.m_dP10, result.m_dP90, result.m_dTrimmedMean, result.m_dTicks);
+		}
+	}
+
+	void writeJson(FILE *pFile) const
+	{
+		for (size_t i = 0; i < m_Results.size(); i++)
+		{
+			const MicroBenchResult &result = m_Results[i];
+			::fprintf(pFile, "{\"name\": %s, \"params\": {", jsonString(result.m_szName).c_str());
+			for (size_t p = 0; p < result.m_Params.size(); p++)
+			{
+				::fprintf(pFile, "%s%s: %.17g", (p > 0) ? ", " : "", jsonString(result.m_Params[p].first).c_str(), result.m_Params[p].second);
+			}
+			::fprintf(pFile, "}, \"iterations\": %zu, \"items\": %.17g, \"median_ns\": %.6g, \"min_ns\": %.6g, \"p10_ns\": %.6g, \"p90_ns\": %.6g, \"trimmed_mean_ns\": %.6g, \"ticks\": %.6g}\n",
+				result.m_nIterations, result.m_dItems, result.m_dMedian, result.m_dMin, result.m_dP10, result.m_dP90, result.m_dTrimmedMean, result.m_dTicks);
+		}
+	}
+
+	// median of earlier CSV against this run by key:
+	// ratio above one means this run is faster
+	void compareBaseline(FILE *pBaseline, FILE *pFile = stdout) const
+	{
+		std::vector<std::pair<std::string, double> > baseline;
+		char szLine[1024];
+		while (::fgets(szLine, sizeof(szLine), pBaseline) != nullptr)
+		{
+			// key, iterations, items, median
+			const char *pComma = ::strchr(szLine, ',');
+			if (pComma == nullptr || ::strncmp(szLine, "key,", 4) == 0)
+			{
+				continue;
+			}
+			const char *pField = pComma;
+			for (int nField = 0; nField < 2 && pField != nullptr; nField++)
+			{
+				pField = ::strchr(pField + 1, ',');
+			}
+			if (pField != nullptr)
+			{
+				baseline.push_back(std::make_pair(std::string(szLine, pComma - szLine), ::strtod(pField + 1, nullptr)));
+			}
+		}
+
+		::fprintf(pFile, "%-44s %12s %12s %8s\n", "benchmark", "baseline ns", "median ns", "ratio");
+		for (size_t i = 0; i < m_Results.size(); i++)
+		{
+			const MicroBenchResult &result = m_Results[i];
+			const std::string szKey = result.key();
+			for (size_t b = 0; b < baseline.size(); b++)
+			{
+				if (baseline[b].first == szKey && result.m_dMedian > 0.0)
+				{
+					::fprintf(pFile, "%-44s %12.1f %12.1f %8.3f\n", szKey.c_str(), baseline[b].second, result.m_dMedian, baseline[b].second / result.m_dMedian);
+					break;
+				}
+			}
+		}
+	}
+
+	// table to standard output, files and baseline comparison as configured:
+	// returns false if a file could not be opened
+	bool report() const
+	{
+		bool bResult = true;
+		printTable(stdout);
+		if (m_Config.m_szCsvFile.empty() == false)
+		{
+			FILE *pFile = openOutput(m_Config.m_szCsvFile);
+			if (pFile != nullptr)
+			{
+				writeCsv(pFile);
+				closeOutput(pFile);
+			}
+			else
+			{
+				bResult = false;
+			}
+		}
+		if (m_Config.m_szJsonFile.empty() == false)
+		{
+			FILE *pFile = openOutput(m_Config.m_szJsonFile);
+			if (pFile != nullptr)
+			{
+				writeJson(pFile);
+				closeOutput(pFile);
+			}
+			else
+			{
+				bResult = false;
+			}
+		}
+		if (m_Config.m_szBaselineFile.empty() == false)
+		{
+			FILE *pFile = ::fopen(m_Config.m_szBaselineFile.c_str(), "r");
+			if (pFile != nullptr)
+			{
+				compareBaseline(pFile, stdout);
+				::fclose(pFile);
+			}
+			else
+			{
+				bResult = false;
+			}
+		}
+		return bResult;
+	}
+};
+
+#endif // MICROBENCH_H
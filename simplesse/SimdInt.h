@@ -0,0 +1,487 @@
+/////////////////////////////////////
+//
+// SimdInt : vector of unsigned integer lanes
+// (8, 16, 32 or 64 bits) in SSE2 or AVX2 register.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Integer counterpart of SimdVec for byte and limb kernels:
+// SimdInt<uint8_t, 16> .. SimdInt<uint64_t, 2> are 128-bit (SSE2),
+// SimdInt<uint8_t, 32> .. SimdInt<uint64_t, 4> 256-bit (AVX2).
+// Lanes are unsigned: addition and subtraction wrap around
+// and less() compares unsigned.
+//
+// Comparisons give mask vectors (all bits of lane set or clear),
+// mask() collects top bit of each lane to integer (bit i from lane i)
+// and fromMask() expands integer back to mask vector.
+// carryMask() gives lanes where addition wrapped (carry out)
+// from top bits of operands and sum, without compare.
+//
+// Lane shifts move whole lanes (zeros in), byte shuffle is pshufb:
+// index with top bit set gives zero, AVX2 shuffles within 128-bit halves.
+// Instructions missing from SSE2 (64-bit compare, blend, byte shuffle)
+// are done with several instructions or lane by lane through memory.
+//
+
+#ifndef SIMDINT_H
+#define SIMDINT_H
+
+#include "SimdVec.h"
+
+#if defined(__SSSE3__) || (defined(_MSC_VER) && defined(__AVX__))
+#define SIMDINT_SSSE3
+#endif
+#if defined(__SSE4_2__) || (defined(_MSC_VER) && defined(__AVX__))
+#define SIMDINT_SSE42
+#endif
+
+
+template <typename T, int N> struct SimdIntTraits;
+
+
+////////// SSE2: 128-bit
+
+#if defined(SIMDVEC_SSE2)
+
+// operations not depending on lane size
+struct SimdInt128
+{
+	typedef __m128i Register;
+
+	static Register zero() { return _mm_setzero_si128(); }
+	static Register load(const void *p) { return _mm_load_si128((const __m128i*)p); }
+	static Register loadUnaligned(const void *p) { return _mm_loadu_si128((const __m128i*)p); }
+	static void store(void *p, const Register a) { _mm_store_si128((__m128i*)p, a); }
+	static void storeUnaligned(void *p, const Register a) { _mm_storeu_si128((__m128i*)p, a); }
+
+	static Register bitAnd(const Register a, const Register b) { return _mm_and_si128(a, b); }
+	static Register bitOr(const Register a, const Register b) { return _mm_or_si128(a, b); }
+	static Register bitXor(const Register a, const Register b) { return _mm_xor_si128(a, b); }
+	// ~a & b
+	static Register bitAndNot(const Register a, const Register b) { return _mm_andnot_si128(a, b); }
+
+	// b where mask is set, otherwise a
+	static Register select(const Register a, const Register b, const Register mask)
+	{
+#if defined(SIMDVEC_SSE41)
+		return _mm_blendv_epi8(a, b, mask);
+#else
+		return _mm_or_si128(_mm_and_si128(mask, b), _mm_andnot_si128(mask, a));
+#endif
+	}
+
+	// bytes to higher (up) or lower (down) positions, zeros in
+	template <int nBytes> static Register shiftBytesUp(const Register a) { return _mm_slli_si128(a, nBytes); }
+	template <int nBytes> static Register shiftBytesDown(const Register a) { return _mm_srli_si128(a, nBytes); }
+
+	static Register shuffleBytes(const Register a, const Register indices)
+	{
+#if defined(SIMDINT_SSSE3)
+		return _mm_shuffle_epi8(a, indices);
+#else
+		alignas(16) uint8_t values[16];
+		alignas(16) uint8_t index[16];
+		alignas(16) uint8_t result[16];
+		_mm_store_si128((__m128i*)values, a);
+		_mm_store_si128((__m128i*)index, indices);
+		for (int i = 0; i < 16; i++)
+		{
+			result[i] = ((index[i] & 0x80) != 0) ? 0 : values[index[i] & 15];
+		}
+		return _mm_load_si128((const __m128i*)result);
+#endif
+	}
+};
+
+template <> struct SimdIntTraits<uint8_t, 16> : public SimdInt128
+{
+	static Register set1(const uint8_t x) { return _mm_set1_epi8((char)x); }
+	static Register add(const Register a, const Register b) { return _mm_add_epi8(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm_sub_epi8(a, b); }
+	static Register equal(const Register a, const Register b) { return _mm_cmpeq_epi8(a, b); }
+	// unsigned by signed compare of values with top bit flipped
+	static Register less(const Register a, const Register b)
+	{
+		const __m128i bias = _mm_set1_epi8((char)0x80);
+		return _mm_cmplt_epi8(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+	}
+	static unsigned int mask(const Register a) { return (unsigned int)_mm_movemask_epi8(a); }
+	// byte of mask per eight lanes, single bit of it per lane
+	static Register fromMask(const unsigned int nMask)
+	{
+		const __m128i bits = _mm_set1_epi64x((long long)0x8040201008040201ULL);
+		const __m128i bytes = _mm_set_epi64x((long long)(((nMask >> 8) & 0xFF) * 0x0101010101010101ULL), (long long)((nMask & 0xFF) * 0x0101010101010101ULL));
+		return _mm_cmpeq_epi8(_mm_and_si128(bytes, bits), bits);
+	}
+};
+
+template <> struct SimdIntTraits<uint16_t, 8> : public SimdInt128
+{
+	static Register set1(const uint16_t x) { return _mm_set1_epi16((short)x); }
+	static Register add(const Register a, const Register b) { return _mm_add_epi16(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm_sub_epi16(a, b); }
+	static Register equal(const Register a, const Register b) { return _mm_cmpeq_epi16(a, b); }
+	static Register less(const Register a, const Register b)
+	{
+		const __m128i bias = _mm_set1_epi16((short)0x8000);
+		return _mm_cmplt_epi16(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+	}
+	// note: signed saturation to bytes keeps top bit
+	static unsigned int mask(const Register a) { return (unsigned int)_mm_movemask_epi8(_mm_packs_epi16(a, _mm_setzero_si128())); }
+	static Register fromMask(const unsigned int nMask)
+	{
+		const __m128i bits = _mm_setr_epi16(0x1, 0x2, 0x4, 0x8, 0x10, 0x20, 0x40, 0x80);
+		return _mm_cmpeq_epi16(_mm_and_si128(_mm_set1_epi16((short)nMask), bits), bits);
+	}
+};
+
+template <> struct SimdIntTraits<uint32_t, 4> : public SimdInt128
+{
+	static Register set1(const uint32_t x) { return _mm_set1_epi32((int)x); }
+	static Register add(const Register a, const Register b) { return _mm_add_epi32(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm_sub_epi32(a, b); }
+	static Register equal(const Register a, const Register b) { return _mm_cmpeq_epi32(a, b); }
+	static Register less(const Register a, const Register b)
+	{
+		const __m128i bias = _mm_set1_epi32((int)0x80000000);
+		return _mm_cmplt_epi32(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+	}
+	static unsigned int mask(const Register a) { return (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(a)); }
+	static Register fromMask(const unsigned int nMask)
+	{
+		const __m128i bits = _mm_setr_epi32(0x1, 0x2, 0x4, 0x8);
+		return _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32((int)nMask), bits), bits);
+	}
+};
+
+template <> struct SimdIntTraits<uint64_t, 2> : public SimdInt128
+{
+	static Register set1(const uint64_t x) { return _mm_set1_epi64x((long long)x); }
+	static Register add(const Register a, const Register b) { return _mm_add_epi64(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm_sub_epi64(a, b); }
+	static Register equal(const Register a, const Register b)
+	{
+#if defined(SIMDVEC_SSE41)
+		return _mm_cmpeq_epi64(a, b);
+#else
+		// both halves equal
+		const __m128i halves = _mm_cmpeq_epi32(a, b);
+		return _mm_and_si128(halves, _mm_shuffle_epi32(halves, 0xB1));
+#endif
+	}
+	static Register less(const Register a, const Register b)
+	{
+#if defined(SIMDINT_SSE42)
+		const __m128i bias = _mm_set1_epi64x((long long)0x8000000000000000ULL);
+		return _mm_cmpgt_epi64(_mm_xor_si128(b, bias), _mm_xor_si128(a, bias));
+#else
+		// borrow out of a - b in top bit, copied to whole lane
+		const __m128i borrow = _mm_or_si128(_mm_andnot_si128(a, b), _mm_andnot_si128(_mm_xor_si128(a, b), _mm_sub_epi64(a, b)));
+		return _mm_shuffle_epi32(_mm_srai_epi32(borrow, 31), 0xF5);
+#endif
+	}
+	static unsigned int mask(const Register a) { return (unsigned int)_mm_movemask_pd(_mm_castsi128_pd(a)); }
+	static Register fromMask(const unsigned int nMask)
+	{
+		const __m128i bits = _mm_set_epi64x(0x2, 0x1);
+		return equal(_mm_and_si128(_mm_set1_epi64x((long long)nMask), bits), bits);
+	}
+};
+
+#endif // SIMDVEC_SSE2
+
+
+////////// AVX2: 256-bit
+
+#if defined(SIMDVEC_AVX2)
+
+struct SimdInt256
+{
+	typedef __m256i Register;
+
+	static Register zero() { return _mm256_setzero_si256(); }
+	static Register load(const void *p) { return _mm256_load_si256((const __m256i*)p); }
+	static Register loadUnaligned(const void *p) { return _mm256_loadu_si256((const __m256i*)p); }
+	static void store(void *p, const Register a) { _mm256_store_si256((__m256i*)p, a); }
+	static void storeUnaligned(void *p, const Register a) { _mm256_storeu_si256((__m256i*)p, a); }
+
+	static Register bitAnd(const Register a, const Register b) { return _mm256_and_si256(a, b); }
+	static Register bitOr(const Register a, const Register b) { return _mm256_or_si256(a, b); }
+	static Register bitXor(const Register a, const Register b) { return _mm256_xor_si256(a, b); }
+	static Register bitAndNot(const Register a, const Register b) { return _mm256_andnot_si256(a, b); }
+	static Register select(const Register a, const Register b, const Register mask) { return _mm256_blendv_epi8(a, b, mask); }
+
+	// byte shifts of AVX2 are within halves:
+	// low half is moved to high half (zeros to low) and aligned with register
+	template <int nBytes> static Register shiftBytesUp(const Register a)
+	{
+		const __m256i lowUp = _mm256_permute2x128_si256(a, a, 0x08);
+		if (nBytes >= 16)
+		{
+			return _mm256_slli_si256(lowUp, (nBytes >= 16) ? nBytes - 16 : 0);
+		}
+		return _mm256_alignr_epi8(a, lowUp, (nBytes < 16) ? 16 - nBytes : 0);
+	}
+	template <int nBytes> static Register shiftBytesDown(const Register a)
+	{
+		const __m256i highDown = _mm256_permute2x128_si256(a, a, 0x81);
+		if (nBytes >= 16)
+		{
+			return _mm256_srli_si256(highDown, (nBytes >= 16) ? nBytes - 16 : 0);
+		}
+		return _mm256_alignr_epi8(highDown, a, (nBytes < 16) ? nBytes : 0);
+	}
+
+	static Register shuffleBytes(const Register a, const Register indices) { return _mm256_shuffle_epi8(a, indices); }
+};
+
+template <> struct SimdIntTraits<uint8_t, 32> : public SimdInt256
+{
+	static Register set1(const uint8_t x) { return _mm256_set1_epi8((char)x); }
+	static Register add(const Register a, const Register b) { return _mm256_add_epi8(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm256_sub_epi8(a, b); }
+	static Register equal(const Register a, const Register b) { return _mm256_cmpeq_epi8(a, b); }
+	static Register less(const Register a, const Register b)
+	{
+		const __m256i bias = _mm256_set1_epi8((char)0x80);
+		return _mm256_cmpgt_epi8(_mm256_xor_si256(b, bias), _mm256_xor_si256(a, bias));
+	}
+	static unsigned int mask(const Register a) { return (unsigned int)_mm256_movemask_epi8(a); }
+	static Register fromMask(const unsigned int nMask)
+	{
+		const __m256i bits = _mm256_set1_epi64x((long long)0x8040201008040201ULL);
+		const __m256i bytes = _mm256_set_epi64x(
+			(long long)(((nMask >> 24) & 0xFF) * 0x0101010101010101ULL), (long long)(((nMask >> 16) & 0xFF) * 0x0101010101010101ULL),
+			(long long)(((nMask >> 8) & 0xFF) * 0x0101010101010101ULL), (long long)((nMask & 0xFF) * 0x0101010101010101ULL));
+		return _mm256_cmpeq_epi8(_mm256_and_si256(bytes, bits), bits);
+	}
+};
+
+template <> struct SimdIntTraits<uint16_t, 16> : public SimdInt256
+{
+	static Register set1(const uint16_t x) { return _mm256_set1_epi16((short)x); }
+	static Register add(const Register a, const Register b) { return _mm256_add_epi16(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm256_sub_epi16(a, b); }
+	static Register equal(const Register a, const Register b) { return _mm256_cmpeq_epi16(a, b); }
+	static Register less(const Register a, const Register b)
+	{
+		const __m256i bias = _mm256_set1_epi16((short)0x8000);
+		return _mm256_cmpgt_epi16(_mm256_xor_si256(b, bias), _mm256_xor_si256(a, bias));
+	}
+	// packs within halves: quarters 0 and 2 hold bytes, gathered to low half
+	static unsigned int mask(const Register a)
+	{
+		const __m256i bytes = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, _mm256_setzero_si256()), 0xD8);
+		return (unsigned int)_mm256_movemask_epi8(bytes) & 0xFFFF;
+	}
+	static Register fromMask(const unsigned int nMask)
+	{
+		const __m256i bits = _mm256_setr_epi16(0x1, 0x2, 0x4, 0x8, 0x10, 0x20, 0x40, 0x80,
+			0x100, 0x200, 0x400, 0x800, 0x1000, 0x2000, 0x4000, (short)0x8000);
+		return _mm256_cmpeq_epi16(_mm256_and_si256(_mm256_set1_epi16((short)nMask), bits), bits);
+	}
+};
+
+template <> struct SimdIntTraits<uint32_t, 8> : public SimdInt256
+{
+	static Register set1(const uint32_t x) { return _mm256_set1_epi32((int)x); }
+	static Register add(const Register a, const Register b) { return _mm256_add_epi32(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm256_sub_epi32(a, b); }
+	static Register equal(const Register a, const Register b) { return _mm256_cmpeq_epi32(a, b); }
+	static Register less(const Register a, const Register b)
+	{
+		const __m256i bias = _mm256_set1_epi32((int)0x80000000);
+		return _mm256_cmpgt_epi32(_mm256_xor_si256(b, bias), _mm256_xor_si256(a, bias));
+	}
+	static unsigned int mask(const Register a) { return (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(a)); }
+	static Register fromMask(const unsigned int nMask)
+	{
+		const __m256i bits = _mm256_setr_epi32(0x1, 0x2, 0x4, 0x8, 0x10, 0x20, 0x40, 0x80);
+		return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32((int)nMask), bits), bits);
+	}
+};
+
+template <> struct SimdIntTraits<uint64_t, 4> : public SimdInt256
+{
+	static Register set1(const uint64_t x) { return _mm256_set1_epi64x((long long)x); }
+	static Register add(const Register a, const Register b) { return _mm256_add_epi64(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm256_sub_epi64(a, b); }
+	static Register equal(const Register a, const Register b) { return _mm256_cmpeq_epi64(a, b); }
+	static Register less(const Register a, const Register b)
+	{
+		const __m256i bias = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+		return _mm256_cmpgt_epi64(_mm256_xor_si256(b, bias), _mm256_xor_si256(a, bias));
+	}
+	static unsigned int mask(const Register a) { return (unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(a)); }
+	static Register fromMask(const unsigned int nMask)
+	{
+		const __m256i bits = _mm256_setr_epi64x(0x1, 0x2, 0x4, 0x8);
+		return _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x((long long)nMask), bits), bits);
+	}
+};
+
+#endif // SIMDVEC_AVX2
+
+
+////////// vector
+
+template <typename T, int N> class SimdInt
+{
+public:
+	typedef SimdIntTraits<T, N> Traits;
+	typedef typename Traits::Register Register;
+	typedef T Scalar;
+
+	static const int Lanes = N;
+
+protected:
+	Register m_v;
+
+public:
+	// zero
+	SimdInt()
+		: m_v(Traits::zero())
+	{}
+	// same value in all lanes
+	explicit SimdInt(const T x)
+		: m_v(Traits::set1(x))
+	{}
+	SimdInt(const Register &v)
+		: m_v(v)
+	{}
+
+	// pointer must be aligned to size of vector
+	static SimdInt load(const T *p)
+	{
+		return SimdInt(Traits::load(p));
+	}
+	static SimdInt loadUnaligned(const T *p)
+	{
+		return SimdInt(Traits::loadUnaligned(p));
+	}
+	// pointer must be aligned to size of vector
+	void store(T *p) const
+	{
+		Traits::store(p, m_v);
+	}
+	void storeUnaligned(T *p) const
+	{
+		Traits::storeUnaligned(p, m_v);
+	}
+
+	const Register& get() const
+	{
+		return m_v;
+	}
+
+	// single lane (through memory, not for inner loops)
+	T operator [] (const int nIndex) const
+	{
+		alignas(32) T values[N];
+		Traits::store(values, m_v);
+		return values[nIndex & (N - 1)];
+	}
+
+	SimdInt operator + (const SimdInt &other) const
+	{
+		return SimdInt(Traits::add(m_v, other.m_v));
+	}
+	SimdInt operator - (const SimdInt &other) const
+	{
+		return SimdInt(Traits::sub(m_v, other.m_v));
+	}
+	SimdInt operator & (const SimdInt &other) const
+	{
+		return SimdInt(Traits::bitAnd(m_v, other.m_v));
+	}
+	SimdInt operator | (const SimdInt &other) const
+	{
+		return SimdInt(Traits::bitOr(m_v, other.m_v));
+	}
+	SimdInt operator ^ (const SimdInt &other) const
+	{
+		return SimdInt(Traits::bitXor(m_v, other.m_v));
+	}
+	SimdInt& operator += (const SimdInt &other)
+	{
+		m_v = Traits::add(m_v, other.m_v);
+		return *this;
+	}
+	SimdInt& operator -= (const SimdInt &other)
+	{
+		m_v = Traits::sub(m_v, other.m_v);
+		return *this;
+	}
+
+	// ~a & b
+	static SimdInt andNot(const SimdInt &a, const SimdInt &b)
+	{
+		return SimdInt(Traits::bitAndNot(a.m_v, b.m_v));
+	}
+
+	// mask lanes where a == b
+	static SimdInt equal(const SimdInt &a, const SimdInt &b)
+	{
+		return SimdInt(Traits::equal(a.m_v, b.m_v));
+	}
+	// mask lanes where a < b (unsigned)
+	static SimdInt less(const SimdInt &a, const SimdInt &b)
+	{
+		return SimdInt(Traits::less(a.m_v, b.m_v));
+	}
+	// b where mask is set, otherwise a (blend)
+	static SimdInt select(const SimdInt &a, const SimdInt &b, const SimdInt &mask)
+	{
+		return SimdInt(Traits::select(a.m_v, b.m_v, mask.m_v));
+	}
+
+	// top bit of each lane, bit i from lane i
+	unsigned int mask() const
+	{
+		return Traits::mask(m_v);
+	}
+	// mask vector from bits of lanes
+	static SimdInt fromMask(const unsigned int nMask)
+	{
+		return SimdInt(Traits::fromMask(nMask));
+	}
+	// bits of lanes where sum = a + b wrapped around:
+	// carry out is top bit of (a & b) | ((a | b) & ~sum)
+	static unsigned int carryMask(const SimdInt &a, const SimdInt &b, const SimdInt &sum)
+	{
+		return ((a & b) | andNot(sum, a | b)).mask();
+	}
+
+	// lanes to higher (up) or lower (down) index, zeros in
+	template <int nLanes> SimdInt shiftLanesUp() const
+	{
+		return SimdInt(Traits::template shiftBytesUp<nLanes * (int)sizeof(T)>(m_v));
+	}
+	template <int nLanes> SimdInt shiftLanesDown() const
+	{
+		return SimdInt(Traits::template shiftBytesDown<nLanes * (int)sizeof(T)>(m_v));
+	}
+
+	// byte i of result is byte indices[i] of a (pshufb)
+	static SimdInt shuffleBytes(const SimdInt &a, const SimdInt &indices)
+	{
+		return SimdInt(Traits::shuffleBytes(a.m_v, indices.m_v));
+	}
+};
+
+#if defined(SIMDVEC_SSE2)
+typedef SimdInt<uint8_t, 16> sseInt8x16;
+typedef SimdInt<uint16_t, 8> sseInt16x8;
+typedef SimdInt<uint32_t, 4> sseInt4;
+typedef SimdInt<uint64_t, 2> sseInt64x2;
+#endif
+#if defined(SIMDVEC_AVX2)
+typedef SimdInt<uint8_t, 32> avxInt8x32;
+typedef SimdInt<uint16_t, 16> avxInt16x16;
+typedef SimdInt<uint32_t, 8> avxInt32x8;
+typedef SimdInt<uint64_t, 4> avxInt64x4;
+#endif
+
+#endif // SIMDINT_H
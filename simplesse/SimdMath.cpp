@@ -0,0 +1,164 @@
+/////////////////////////////////////
+//
+// SimdMath : exp, log, sin, cos, tanh and refined
+// reciprocal (square root) on float lanes.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Array versions use widest lanes this unit is built for:
+// 16 with AVX-512F, 8 with AVX2, otherwise 4 (SSE2).
+// Less than a register at end is done in padded local buffer.
+// Flush-to-zero kernel policy (DenormalGuard.h) applies to array versions.
+//
+
+#include "SimdMath.h"
+#include "DenormalGuard.h"
+
+#include <string.h>
+
+
+////////// local helpers
+
+#if defined(SIMDVEC_AVX512)
+static const int s_nMathLanes = 16;
+#elif defined(SIMDVEC_AVX2)
+static const int s_nMathLanes = 8;
+#else
+static const int s_nMathLanes = 4;
+#endif
+
+typedef SimdVec<float, s_nMathLanes> MathVec;
+
+// dst = op(a), one register per step
+template <class Op> static void mapRange(float *pDst, const float *pA, const size_t nCount, const Op &op)
+{
+	size_t i = 0;
+	for (; i + MathVec::Lanes <= nCount; i += MathVec::Lanes)
+	{
+		op(MathVec::loadUnaligned(pA + i)).storeUnaligned(pDst + i);
+	}
+	if (i < nCount)
+	{
+		// note: padding one is valid input of all functions
+		float values[MathVec::Lanes];
+		for (int k = 0; k < MathVec::Lanes; k++)
+		{
+			values[k] = 1.0f;
+		}
+		::memcpy(values, pA + i, (nCount - i) * sizeof(float));
+		op(MathVec::loadUnaligned(values)).storeUnaligned(values);
+		::memcpy(pDst + i, values, (nCount - i) * sizeof(float));
+	}
+}
+
+template <class Op> static void mapLanes(float *pDst, const float *pA, const size_t nCount, const Op &op)
+{
+	denormalRunKernel([&]()
+	{
+		mapRange(pDst, pA, nCount, op);
+	});
+}
+
+
+////////// operations
+
+struct ExpOp
+{
+	MathVec operator()(const MathVec &x) const
+	{
+		return simdExp<s_nMathLanes>(x);
+	}
+};
+
+struct LogOp
+{
+	MathVec operator()(const MathVec &x) const
+	{
+		return simdLog<s_nMathLanes>(x);
+	}
+};
+
+struct SinOp
+{
+	MathVec operator()(const MathVec &x) const
+	{
+		return simdSin<s_nMathLanes>(x);
+	}
+};
+
+struct CosOp
+{
+	MathVec operator()(const MathVec &x) const
+	{
+		return simdCos<s_nMathLanes>(x);
+	}
+};
+
+struct TanhOp
+{
+	MathVec operator()(const MathVec &x) const
+	{
+		return simdTanh<s_nMathLanes>(x);
+	}
+};
+
+struct RsqrtOp
+{
+	MathVec operator()(const MathVec &x) const
+	{
+		return simdRsqrt<s_nMathLanes>(x);
+	}
+};
+
+struct RcpOp
+{
+	MathVec operator()(const MathVec &x) const
+	{
+		return simdRcp<s_nMathLanes>(x);
+	}
+};
+
+
+////////// public methods
+
+void simdArrayExp(float *pDst, const float *pA, const size_t nCount)
+{
+	mapLanes(pDst, pA, nCount, ExpOp());
+}
+
+void simdArrayLog(float *pDst, const float *pA, const size_t nCount)
+{
+	mapLanes(pDst, pA, nCount, LogOp());
+}
+
+void simdArraySin(float *pDst, const float *pA, const size_t nCount)
+{
+	mapLanes(pDst, pA, nCount, SinOp());
+}
+
+void simdArrayCos(float *pDst, const float *pA, const size_t nCount)
+{
+	mapLanes(pDst, pA, nCount, CosOp());
+}
+
+void simdArrayTanh(float *pDst, const float *pA, const size_t nCount)
+{
+	mapLanes(pDst, pA, nCount, TanhOp());
+}
+
+void simdArrayRsqrt(float *pDst, const float *pA, const size_t nCount)
+{
+	mapLanes(pDst, pA, nCount, RsqrtOp());
+}
+
+void simdArrayRcp(float *pDst, const float *pA, const size_t nCount)
+{
+	mapLanes(pDst, pA, nCount, RcpOp());
+}
+
+int simdMathLanes()
+{
+	return s_nMathLanes;
+}
@@ -0,0 +1,467 @@
+/////////////////////////////////////
+//
+// SimdMath : exp, log, sin, cos, tanh and refined
+// reciprocal (square root) on float lanes.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Functions are templates over SimdVec<float, N> for 4 (SSE2),
+// 8 (AVX2) and 16 (AVX-512F) lanes, sseQuad versions are
+// sseExp() etc. and array versions simdArrayExp() etc.
+// (widest lanes target allows, see SimdMath.cpp).
+//
+// Polynomials are from Cephes single precision library,
+// sin and cos reduce range by Cody-Waite (pi / 4 split in parts
+// so that multiples of it are exact), exp and log by powers of two.
+//
+// Maximum error in units of last place (ULP) against correctly rounded
+// result, measured by SimdMathBench (same with and without FMA):
+//   exp    1.5  (-104 .. 89, results below that are zero or infinity)
+//   log    1    (all positive floats, subnormals included)
+//   sin    2.5  (|x| above 8192 is done by C library)
+//   cos    2.5
+//   tanh   1.5
+//   rsqrt  3.5  (1.5 with AVX-512: 14-bit estimate)
+//   rcp    3    (1 with AVX-512)
+// rsqrt and rcp are estimate instructions refined by one
+// Newton-Raphson step.
+//
+// Special values follow C library: NaN gives NaN, exp(-inf) is 0,
+// exp(+inf) and exp of large values is +inf, log(0) is -inf,
+// log of negative is NaN, sin and cos of infinity are NaN.
+// Differences: rsqrt and rcp of subnormal are infinity
+// with SSE and AVX (estimate counts them as zero),
+// rcp results below smallest normal are zero.
+// Subnormal results (exp below -87.3) take microcode assist
+// and are many times slower unless flush-to-zero is set
+// (DenormalGuard.h).
+//
+
+#ifndef SIMDMATH_H
+#define SIMDMATH_H
+
+#include "SimdVec.h"
+#include "sseQuad.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+
+
+////////// lane operations beyond SimdTraits:
+// bits, comparison masks, conversions to integer lanes
+
+template <int N> struct SimdMathTraits;
+
+#if defined(SIMDVEC_SSE2)
+
+template <> struct SimdMathTraits<4>
+{
+	typedef __m128 Register;
+	typedef __m128i Int;
+	typedef __m128 Mask;
+
+	static Register bitAnd(const Register a, const Register b) { return _mm_and_ps(a, b); }
+	static Register bitOr(const Register a, const Register b) { return _mm_or_ps(a, b); }
+	static Register bitXor(const Register a, const Register b) { return _mm_xor_ps(a, b); }
+
+	// comparisons are false for NaN
+	static Mask less(const Register a, const Register b) { return _mm_cmplt_ps(a, b); }
+	static Mask equal(const Register a, const Register b) { return _mm_cmpeq_ps(a, b); }
+	static Mask isNaN(const Register a) { return _mm_cmpunord_ps(a, a); }
+	static Mask maskOr(const Mask a, const Mask b) { return _mm_or_ps(a, b); }
+	static bool any(const Mask mask) { return (_mm_movemask_ps(mask) != 0); }
+	// lanes of b where mask is set, otherwise a
+	static Register select(const Register a, const Register b, const Mask mask)
+	{
+#if defined(SIMDVEC_SSE41)
+		return _mm_blendv_ps(a, b, mask);
+#else
+		return _mm_or_ps(_mm_andnot_ps(mask, a), _mm_and_ps(mask, b));
+#endif
+	}
+
+	// nearest (default rounding mode) and toward zero
+	static Int roundToInt(const Register a) { return _mm_cvtps_epi32(a); }
+	static Int truncToInt(const Register a) { return _mm_cvttps_epi32(a); }
+	static Register toFloat(const Int a) { return _mm_cvtepi32_ps(a); }
+	static Int asInt(const Register a) { return _mm_castps_si128(a); }
+	static Register asFloat(const Int a) { return _mm_castsi128_ps(a); }
+
+	static Int int1(const int32_t n) { return _mm_set1_epi32(n); }
+	static Int intAdd(const Int a, const Int b) { return _mm_add_epi32(a, b); }
+	static Int intSub(const Int a, const Int b) { return _mm_sub_epi32(a, b); }
+	static Int intAnd(const Int a, const Int b) { return _mm_and_si128(a, b); }
+	static Int intOr(const Int a, const Int b) { return _mm_or_si128(a, b); }
+	static Mask intEqual(const Int a, const Int b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+	template <int nBits> static Int shiftLeft(const Int a) { return _mm_slli_epi32(a, nBits); }
+	template <int nBits> static Int shiftRight(const Int a) { return _mm_srli_epi32(a, nBits); }
+	template <int nBits> static Int shiftRightSigned(const Int a) { return _mm_srai_epi32(a, nBits); }
+
+	// 12 bits
+	static Register rsqrtEstimate(const Register a) { return _mm_rsqrt_ps(a); }
+	static Register rcpEstimate(const Register a) { return _mm_rcp_ps(a); }
+};
+
+#endif // SIMDVEC_SSE2
+
+#if defined(SIMDVEC_AVX2)
+
+template <> struct SimdMathTraits<8>
+{
+	typedef __m256 Register;
+	typedef __m256i Int;
+	typedef __m256 Mask;
+
+	static Register bitAnd(const Register a, const Register b) { return _mm256_and_ps(a, b); }
+	static Register bitOr(const Register a, const Register b) { return _mm256_or_ps(a, b); }
+	static Register bitXor(const Register a, const Register b) { return _mm256_xor_ps(a, b); }
+
+	static Mask less(const Register a, const Register b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static Mask equal(const Register a, const Register b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+	static Mask isNaN(const Register a) { return _mm256_cmp_ps(a, a, _CMP_UNORD_Q); }
+	static Mask maskOr(const Mask a, const Mask b) { return _mm256_or_ps(a, b); }
+	static bool any(const Mask mask) { return (_mm256_movemask_ps(mask) != 0); }
+	static Register select(const Register a, const Register b, const Mask mask) { return _mm256_blendv_ps(a, b, mask); }
+
+	static Int roundToInt(const Register a) { return _mm256_cvtps_epi32(a); }
+	static Int truncToInt(const Register a) { return _mm256_cvttps_epi32(a); }
+	static Register toFloat(const Int a) { return _mm256_cvtepi32_ps(a); }
+	static Int asInt(const Register a) { return _mm256_castps_si256(a); }
+	static Register asFloat(const Int a) { return _mm256_castsi256_ps(a); }
+
+	static Int int1(const int32_t n) { return _mm256_set1_epi32(n); }
+	static Int intAdd(const Int a, const Int b) { return _mm256_add_epi32(a, b); }
+	static Int intSub(const Int a, const Int b) { return _mm256_sub_epi32(a, b); }
+	static Int intAnd(const Int a, const Int b) { return _mm256_and_si256(a, b); }
+	static Int intOr(const Int a, const Int b) { return _mm256_or_si256(a, b); }
+	static Mask intEqual(const Int a, const Int b) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)); }
+	template <int nBits> static Int shiftLeft(const Int a) { return _mm256_slli_epi32(a, nBits); }
+	template <int nBits> static Int shiftRight(const Int a) { return _mm256_srli_epi32(a, nBits); }
+	template <int nBits> static Int shiftRightSigned(const Int a) { return _mm256_srai_epi32(a, nBits); }
+
+	static Register rsqrtEstimate(const Register a) { return _mm256_rsqrt_ps(a); }
+	static Register rcpEstimate(const Register a) { return _mm256_rcp_ps(a); }
+};
+
+#endif // SIMDVEC_AVX2
+
+#if defined(SIMDVEC_AVX512)
+
+// note: comparisons give mask registers (one bit per lane),
+// float bit operations need AVX-512DQ so integer ones are used
+template <> struct SimdMathTraits<16>
+{
+	typedef __m512 Register;
+	typedef __m512i Int;
+	typedef __mmask16 Mask;
+
+	static Register bitAnd(const Register a, const Register b) { return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a), _mm512_castps_si512(b))); }
+	static Register bitOr(const Register a, const Register b) { return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(a), _mm512_castps_si512(b))); }
+	static Register bitXor(const Register a, const Register b) { return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), _mm512_castps_si512(b))); }
+
+	static Mask less(const Register a, const Register b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+	static Mask equal(const Register a, const Register b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+	static Mask isNaN(const Register a) { return _mm512_cmp_ps_mask(a, a, _CMP_UNORD_Q); }
+	static Mask maskOr(const Mask a, const Mask b) { return (Mask)(a | b); }
+	static bool any(const Mask mask) { return (mask != 0); }
+	static Register select(const Register a, const Register b, const Mask mask) { return _mm512_mask_blend_ps(mask, a, b); }
+
+	static Int roundToInt(const Register a) { return _mm512_cvtps_epi32(a); }
+	static Int truncToInt(const Register a) { return _mm512_cvttps_epi32(a); }
+	static Register toFloat(const Int a) { return _mm512_cvtepi32_ps(a); }
+	static Int asInt(const Register a) { return _mm512_castps_si512(a); }
+	static Register asFloat(const Int a) { return _mm512_castsi512_ps(a); }
+
+	static Int int1(const int32_t n) { return _mm512_set1_epi32(n); }
+	static Int intAdd(const Int a, const Int b) { return _mm512_add_epi32(a, b); }
+	static Int intSub(const Int a, const Int b) { return _mm512_sub_epi32(a, b); }
+	static Int intAnd(const Int a, const Int b) { return _mm512_and_si512(a, b); }
+	static Int intOr(const Int a, const Int b) { return _mm512_or_si512(a, b); }
+	static Mask intEqual(const Int a, const Int b) { return _mm512_cmpeq_epi32_mask(a, b); }
+	template <int nBits> static Int shiftLeft(const Int a) { return _mm512_slli_epi32(a, nBits); }
+	template <int nBits> static Int shiftRight(const Int a) { return _mm512_srli_epi32(a, nBits); }
+	template <int nBits> static Int shiftRightSigned(const Int a) { return _mm512_srai_epi32(a, nBits); }
+
+	// 14 bits
+	static Register rsqrtEstimate(const Register a) { return _mm512_rsqrt14_ps(a); }
+	static Register rcpEstimate(const Register a) { return _mm512_rcp14_ps(a); }
+};
+
+#endif // SIMDVEC_AVX512
+
+
+////////// functions
+
+// e^x
+template <int N> inline SimdVec<float, N> simdExp(const SimdVec<float, N> &x)
+{
+	typedef SimdVec<float, N> V;
+	typedef SimdMathTraits<N> M;
+
+	// beyond these result is zero or infinity anyway,
+	// clamping keeps integer conversion in range
+	const V xc = (min)((max)(x, V(-104.0f)), V(89.0f));
+
+	// x = n * ln(2) + r, |r| <= ln(2) / 2
+	const typename M::Int n = M::roundToInt((xc * V(1.44269504088896341f)).get());
+	const V fn = V(M::toFloat(n));
+	V r = fma(fn, V(-0.693359375f), xc);
+	r = fma(fn, V(2.12194440e-4f), r);
+
+	// e^r = 1 + r + r^2 * P(r)
+	V p = V(1.9875691500e-4f);
+	p = fma(p, r, V(1.3981999507e-3f));
+	p = fma(p, r, V(8.3334519073e-3f));
+	p = fma(p, r, V(4.1665795894e-2f));
+	p = fma(p, r, V(1.6666665459e-1f));
+	p = fma(p, r, V(5.0000001201e-1f));
+	p = fma(p, r * r, r + V(1.0f));
+
+	// 2^n in two normal factors so that n may reach subnormal
+	// and overflow range (-150 .. 128)
+	const typename M::Int n1 = M::template shiftRightSigned<1>(n);
+	const typename M::Int n2 = M::intSub(n, n1);
+	const V scale1 = V(M::asFloat(M::template shiftLeft<23>(M::intAdd(n1, M::int1(127)))));
+	const V scale2 = V(M::asFloat(M::template shiftLeft<23>(M::intAdd(n2, M::int1(127)))));
+	const V result = (p * scale1) * scale2;
+	return V(M::select(result.get(), x.get(), M::isNaN(x.get())));
+}
+
+// natural logarithm
+template <int N> inline SimdVec<float, N> simdLog(const SimdVec<float, N> &x)
+{
+	typedef SimdVec<float, N> V;
+	typedef SimdMathTraits<N> M;
+
+	// subnormal (and non-positive) inputs scaled to normal range
+	const typename M::Mask tiny = M::less(x.get(), V(1.17549435e-38f).get());
+	const V xs = V(M::select(x.get(), (x * V(8388608.0f)).get(), tiny));
+	const V eAdjust = V(M::select(V(0.0f).get(), V(-23.0f).get(), tiny));
+
+	// x = m * 2^e, m in [0.5, 1)
+	const typename M::Int bits = M::asInt(xs.get());
+	V e = V(M::toFloat(M::intSub(M::template shiftRight<23>(bits), M::int1(126)))) + eAdjust;
+	V m = V(M::asFloat(M::intOr(M::intAnd(bits, M::int1(0x007fffff)), M::int1(0x3f000000))));
+
+	// m in [sqrt(0.5), sqrt(2)), then m - 1
+	const typename M::Mask low = M::less(m.get(), V(0.707106781186547524f).get());
+	e = e - V(M::select(V(0.0f).get(), V(1.0f).get(), low));
+	m = m + V(M::select(V(0.0f).get(), m.get(), low)) - V(1.0f);
+
+	// log(1 + m) = m - m^2 / 2 + m^3 * P(m)
+	const V z = m * m;
+	V y = V(7.0376836292e-2f);
+	y = fma(y, m, V(-1.1514610310e-1f));
+	y = fma(y, m, V(1.1676998740e-1f));
+	y = fma(y, m, V(-1.2420140846e-1f));
+	y = fma(y, m, V(1.4249322787e-1f));
+	y = fma(y, m, V(-1.6668057665e-1f));
+	y = fma(y, m, V(2.0000714765e-1f));
+	y = fma(y, m, V(-2.4999993993e-1f));
+	y = fma(y, m, V(3.3333331174e-1f));
+	y = y * m * z;
+	y = fma(e, V(-2.12194440e-4f), y);
+	y = fma(z, V(-0.5f), y);
+	V result = fma(e, V(0.693359375f), m + y);
+
+	// log(0) = -inf, log(negative) = NaN, log(inf) = inf, NaN as is
+	const float fInf = (float)HUGE_VAL;
+	result = V(M::select(result.get(), V(-fInf).get(), M::equal(x.get(), V(0.0f).get())));
+	result = V(M::select(result.get(), V(fInf).get(), M::equal(x.get(), V(fInf).get())));
+	result = V(M::select(result.get(), (x - x).get(), M::isNaN(x.get())));
+	return V(M::select(result.get(), V((float)NAN).get(), M::less(x.get(), V(0.0f).get())));
+}
+
+// sine (bCos false) or cosine (bCos true):
+// |x| reduced to octant by multiples of pi / 4
+template <int N, bool bCos> inline SimdVec<float, N> simdSinCos(const SimdVec<float, N> &x)
+{
+	typedef SimdVec<float, N> V;
+	typedef SimdMathTraits<N> M;
+
+	const V signMask = V(-0.0f);
+	const V ax = V(M::bitAnd(x.get(), V(M::asFloat(M::int1(0x7fffffff))).get()));
+
+	// j = even octant index (rounded up), y = j as float
+	typename M::Int j = M::truncToInt((ax * V(1.27323954473516f)).get());
+	j = M::intAnd(M::intAdd(j, M::int1(1)), M::int1(~1));
+	const V y = V(M::toFloat(j));
+
+	// sign of sine follows x and flips in octants 4..7,
+	// cosine is sine shifted by two octants
+	V sign;
+	if (bCos == true)
+	{
+		j = M::intSub(j, M::int1(2));
+		sign = V(M::asFloat(M::template shiftLeft<29>(M::intAnd(M::intSub(M::int1(-1), j), M::int1(4)))));
+	}
+	else
+	{
+		sign = V(M::bitXor(M::bitAnd(x.get(), signMask.get()), M::asFloat(M::template shiftLeft<29>(M::intAnd(j, M::int1(4))))));
+	}
+	const typename M::Mask sinPoly = M::intEqual(M::intAnd(j, M::int1(2)), M::int1(0));
+
+	// r = |x| - y * pi / 4 in five parts of at most 11 bits:
+	// products with y (even, below 2^14) are exact without FMA
+	V r = fma(y, V(-0.78515625f), ax);
+	r = fma(y, V(-2.4187564849853515625e-4f), r);
+	r = fma(y, V(-3.7747668102383614e-8f), r);
+	r = fma(y, V(-1.2816414596272807e-12f), r);
+	r = fma(y, V(-3.060160631840336e-17f), r);
+	const V z = r * r;
+
+	V c = V(2.443315711809948e-5f);
+	c = fma(c, z, V(-1.388731625493765e-3f));
+	c = fma(c, z, V(4.166664568298827e-2f));
+	c = fma(c * z, z, fma(z, V(-0.5f), V(1.0f)));
+
+	V s = V(-1.9515295891e-4f);
+	s = fma(s, z, V(8.3321608736e-3f));
+	s = fma(s, z, V(-1.6666654611e-1f));
+	s = fma(s * z, r, r);
+
+	V result = V(M::bitXor(M::select(c.get(), s.get(), sinPoly), sign.get()));
+
+	// reduction loses precision above this (and octant overflows later):
+	// such lanes by C library, infinity and NaN give NaN there
+	const typename M::Mask large = M::less(V(8192.0f).get(), ax.get());
+	const typename M::Mask nan = M::isNaN(x.get());
+	if (M::any(M::maskOr(large, nan)) == true)
+	{
+		float values[N];
+		float results[N];
+		x.storeUnaligned(values);
+		result.storeUnaligned(results);
+		for (int i = 0; i < N; i++)
+		{
+			if (!(values[i] <= 8192.0f && values[i] >= -8192.0f))
+			{
+				results[i] = (bCos == true) ? ::cosf(values[i]) : ::sinf(values[i]);
+			}
+		}
+		result = V::loadUnaligned(results);
+	}
+	return result;
+}
+
+template <int N> inline SimdVec<float, N> simdSin(const SimdVec<float, N> &x)
+{
+	return simdSinCos<N, false>(x);
+}
+
+template <int N> inline SimdVec<float, N> simdCos(const SimdVec<float, N> &x)
+{
+	return simdSinCos<N, true>(x);
+}
+
+// hyperbolic tangent: polynomial near zero,
+// 1 - 2 / (e^2|x| + 1) with sign of x elsewhere
+template <int N> inline SimdVec<float, N> simdTanh(const SimdVec<float, N> &x)
+{
+	typedef SimdVec<float, N> V;
+	typedef SimdMathTraits<N> M;
+
+	const V signMask = V(-0.0f);
+	const V ax = V(M::bitAnd(x.get(), V(M::asFloat(M::int1(0x7fffffff))).get()));
+
+	const V z = x * x;
+	V p = V(-5.70498872745e-3f);
+	p = fma(p, z, V(2.06390887954e-2f));
+	p = fma(p, z, V(-5.37397155531e-2f));
+	p = fma(p, z, V(1.33314422036e-1f));
+	p = fma(p, z, V(-3.33332819422e-1f));
+	// note: sign from x, fma gives +0 for -0
+	const V small = V(M::bitOr(fma(p * z, x, x).get(), M::bitAnd(x.get(), signMask.get())));
+
+	const V e = simdExp<N>(ax + ax);
+	const V large = V(M::bitOr((V(1.0f) - V(2.0f) / (e + V(1.0f))).get(), M::bitAnd(x.get(), signMask.get())));
+
+	return V(M::select(large.get(), small.get(), M::less(ax.get(), V(0.625f).get())));
+}
+
+// 1 / sqrt(x): estimate and one Newton-Raphson step
+template <int N> inline SimdVec<float, N> simdRsqrt(const SimdVec<float, N> &x)
+{
+	typedef SimdVec<float, N> V;
+	typedef SimdMathTraits<N> M;
+
+	const V r = V(M::rsqrtEstimate(x.get()));
+	// r + r / 2 * (1 - x * r^2): correction added last rounds less
+	const V e = fma(-(x * r), r, V(1.0f));
+	const V refined = fma(r * V(0.5f), e, r);
+
+	// step would give NaN for zero (inf * 0) and infinity
+	const typename M::Mask keep = M::maskOr(M::less(x.get(), V(1.17549435e-38f).get()), M::equal(x.get(), V((float)HUGE_VAL).get()));
+	return V(M::select(refined.get(), r.get(), keep));
+}
+
+// 1 / x: estimate and one Newton-Raphson step
+template <int N> inline SimdVec<float, N> simdRcp(const SimdVec<float, N> &x)
+{
+	typedef SimdVec<float, N> V;
+	typedef SimdMathTraits<N> M;
+
+	const V r = V(M::rcpEstimate(x.get()));
+	// r + r * (1 - x * r)
+	const V refined = fma(r, fma(-x, r, V(1.0f)), r);
+
+	const V ax = V(M::bitAnd(x.get(), V(M::asFloat(M::int1(0x7fffffff))).get()));
+	const typename M::Mask keep = M::maskOr(M::less(ax.get(), V(1.17549435e-38f).get()), M::equal(ax.get(), V((float)HUGE_VAL).get()));
+	return V(M::select(refined.get(), r.get(), keep));
+}
+
+
+////////// sseQuad
+
+#if defined(SIMDVEC_SSE2)
+
+inline sseQuad sseExp(const sseQuad &x)
+{
+	return sseQuad(simdExp<4>(SimdVec<float, 4>(x.get())).get());
+}
+inline sseQuad sseLog(const sseQuad &x)
+{
+	return sseQuad(simdLog<4>(SimdVec<float, 4>(x.get())).get());
+}
+inline sseQuad sseSin(const sseQuad &x)
+{
+	return sseQuad(simdSin<4>(SimdVec<float, 4>(x.get())).get());
+}
+inline sseQuad sseCos(const sseQuad &x)
+{
+	return sseQuad(simdCos<4>(SimdVec<float, 4>(x.get())).get());
+}
+inline sseQuad sseTanh(const sseQuad &x)
+{
+	return sseQuad(simdTanh<4>(SimdVec<float, 4>(x.get())).get());
+}
+inline sseQuad sseRsqrt(const sseQuad &x)
+{
+	return sseQuad(simdRsqrt<4>(SimdVec<float, 4>(x.get())).get());
+}
+inline sseQuad sseRcp(const sseQuad &x)
+{
+	return sseQuad(simdRcp<4>(SimdVec<float, 4>(x.get())).get());
+}
+
+#endif // SIMDVEC_SSE2
+
+
+////////// arrays (SimdMath.cpp)
+// destination may be same as source, no alignment needed
+
+void simdArrayExp(float *pDst, const float *pA, const size_t nCount);
+void simdArrayLog(float *pDst, const float *pA, const size_t nCount);
+void simdArraySin(float *pDst, const float *pA, const size_t nCount);
+void simdArrayCos(float *pDst, const float *pA, const size_t nCount);
+void simdArrayTanh(float *pDst, const float *pA, const size_t nCount);
+void simdArrayRsqrt(float *pDst, const float *pA, const size_t nCount);
+void simdArrayRcp(float *pDst, const float *pA, const size_t nCount);
+
+// lanes used by array versions
+int simdMathLanes();
+
+#endif // SIMDMATH_H
@@ -0,0 +1,174 @@
+// SimdMathBench.cpp : SimdMath array functions against C library
+// (expf, logf..) and their maximum error in ULP.
+//
+// usage: SimdMathBench [count] [MicroBench options]
+//
+// count is array length (default 4096 floats),
+// error is measured against double precision C library
+// on 1M random values per range.
+//
+
+#include "SimdMath.h"
+#include "AlignedAllocator.h"
+#include "MicroBench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <random>
+#include <vector>
+
+
+typedef void (*ArrayFunc)(float *pDst, const float *pA, const size_t nCount);
+typedef double (*ReferenceFunc)(double x);
+
+static double reference_rsqrt(double x)
+{
+	return 1.0 / ::sqrt(x);
+}
+
+static double reference_rcp(double x)
+{
+	return 1.0 / x;
+}
+
+struct MathFunction
+{
+	const char *szName;
+	ArrayFunc pArray;
+	float (*pLibm)(float);
+	ReferenceFunc pReference;
+	// error range, geometric spacing when bLogScale
+	float fLow;
+	float fHigh;
+	bool bLogScale;
+};
+
+static float libm_rsqrt(float x)
+{
+	return 1.0f / ::sqrtf(x);
+}
+
+static float libm_rcp(float x)
+{
+	return 1.0f / x;
+}
+
+static const MathFunction s_Functions[] = {
+	{"exp", simdArrayExp, ::expf, ::exp, -103.9f, 88.7f, false},
+	{"log", simdArrayLog, ::logf, ::log, 1e-45f, 3e38f, true},
+	{"sin", simdArraySin, ::sinf, ::sin, -8192.0f, 8192.0f, false},
+	{"cos", simdArrayCos, ::cosf, ::cos, -8192.0f, 8192.0f, false},
+	{"tanh", simdArrayTanh, ::tanhf, ::tanh, -10.0f, 10.0f, false},
+	{"rsqrt", simdArrayRsqrt, libm_rsqrt, reference_rsqrt, 1.2e-38f, 3e38f, true},
+	{"rcp", simdArrayRcp, libm_rcp, reference_rcp, 1.2e-38f, 8e37f, true}
+};
+
+// error in units of last place of float at reference
+static double ulpError(const float fResult, const double dReference)
+{
+	if (dReference != dReference)
+	{
+		return (fResult != fResult) ? 0.0 : 1e9;
+	}
+	int nExponent = 0;
+	::frexp(dReference, &nExponent);
+	// subnormal floats have fixed ulp
+	if (nExponent < -125)
+	{
+		nExponent = -125;
+	}
+	return ::fabs((double)fResult - dReference) / ::ldexp(1.0, nExponent - 24);
+}
+
+static double maxError(const MathFunction &function)
+{
+	std::mt19937 rng(12345);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	std::vector<float> x(1 << 20);
+	std::vector<float> y(x.size());
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		const double t = uniform(rng);
+		if (function.bLogScale == true)
+		{
+			x[i] = (float)::exp(::log((double)function.fLow) + t * (::log((double)function.fHigh) - ::log((double)function.fLow)));
+		}
+		else
+		{
+			x[i] = (float)(function.fLow + t * ((double)function.fHigh - function.fLow));
+		}
+	}
+
+	function.pArray(y.data(), x.data(), x.size());
+	double dMax = 0.0;
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		const double dError = ulpError(y[i], function.pReference((double)x[i]));
+		if (dError > dMax)
+		{
+			dMax = dError;
+		}
+	}
+	return dMax;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t nCount = 4096;
+	if (argc > 1 && argv[1][0] != '-')
+	{
+		nCount = (size_t)::strtoull(argv[1], nullptr, 10);
+	}
+
+	MicroBench bench;
+	if (bench.parseArgs(argc, argv) == false)
+	{
+		fprintf(stderr, "invalid options\n");
+		return 1;
+	}
+
+	printf("%d lanes\n", simdMathLanes());
+	printf("%-6s %14s %10s\n", "func", "range", "max ULP");
+	const size_t nFunctions = sizeof(s_Functions) / sizeof(s_Functions[0]);
+	for (size_t f = 0; f < nFunctions; f++)
+	{
+		const MathFunction &function = s_Functions[f];
+		printf("%-6s %6g..%-6g %10.2f\n", function.szName, function.fLow, function.fHigh, maxError(function));
+	}
+	printf("\n");
+
+	AlignedVector<float> x(nCount);
+	AlignedVector<float> y(nCount);
+	std::mt19937 rng(777);
+	MicroBenchParams params;
+	params.push_back(std::make_pair(std::string("count"), (double)nCount));
+	for (size_t f = 0; f < nFunctions; f++)
+	{
+		const MathFunction &function = s_Functions[f];
+
+		// timing inside error range, linear up to 87 in magnitude:
+		// exp results below that are subnormal (slow, see SimdMath.h)
+		const float fLow = (function.bLogScale == true) ? 0.001f : ((function.fLow < -87.0f) ? -87.0f : function.fLow);
+		const float fHigh = (function.fHigh > 87.0f) ? 87.0f : function.fHigh;
+		std::uniform_real_distribution<float> uniform(fLow, fHigh);
+		for (size_t i = 0; i < nCount; i++)
+		{
+			x[i] = uniform(rng);
+		}
+
+		bench.run(std::string(function.szName) + " simd", params, [&]()
+		{
+			function.pArray(y.data(), x.data(), nCount);
+		}, (double)nCount);
+		bench.run(std::string(function.szName) + " libm", params, [&]()
+		{
+			for (size_t i = 0; i < nCount; i++)
+			{
+				y[i] = function.pLibm(x[i]);
+			}
+		}, (double)nCount);
+	}
+
+	return (bench.report() == true) ? 0 : 1;
+}
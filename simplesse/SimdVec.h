@@ -0,0 +1,723 @@
+/////////////////////////////////////
+//
+// SimdVec : vector of N lanes of type T
+// (float, double, int32_t, int64_t) in SIMD register.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Generalizes sseQuad for other element types and widths:
+// SimdVec<float, 4> is sseQuad, SimdVec<float, 8> is AVX register
+// and SimdVec<float, 16> AVX-512 register.
+// All widths have same operators so that kernel is written once
+// as template over vector type and instantiated per width.
+//
+// Operations on register are in SimdTraits<T, N>:
+// specialized for SSE2 (128-bit), AVX/AVX2 (256-bit) and AVX-512F (512-bit)
+// when compiler targets those (-mavx2, -mavx512f, /arch:AVX2..),
+// otherwise generic version works on array of N scalars
+// (compiler may still auto-vectorize it).
+// Note: widths are selected at compile time, translation units built
+// with different flags should not pass SimdVec to each other.
+//
+// Operations without instruction of their own
+// (integer division, 32-bit multiply before SSE4.1, 64-bit minimum..)
+// are done lane by lane.
+//
+
+#ifndef SIMDVEC_H
+#define SIMDVEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define SIMDVEC_SSE2
+#endif
+#if defined(__SSE4_1__) || (defined(_MSC_VER) && defined(__AVX__))
+#define SIMDVEC_SSE41
+#endif
+#if defined(__AVX__)
+#define SIMDVEC_AVX
+#endif
+#if defined(__AVX2__)
+#define SIMDVEC_AVX2
+#endif
+#if defined(__AVX512F__)
+#define SIMDVEC_AVX512
+#endif
+#if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define SIMDVEC_FMA
+#endif
+
+
+// generic: array of scalars
+template <typename T, int N> struct SimdTraits
+{
+	struct Register
+	{
+		T v[N];
+	};
+	static const bool Native = false;
+
+	static Register zero()
+	{
+		return set1(T(0));
+	}
+	static Register set1(const T x)
+	{
+		Register r;
+		for (int i = 0; i < N; i++)
+		{
+			r.v[i] = x;
+		}
+		return r;
+	}
+	static Register load(const T *p)
+	{
+		Register r;
+		for (int i = 0; i < N; i++)
+		{
+			r.v[i] = p[i];
+		}
+		return r;
+	}
+	static Register loadUnaligned(const T *p)
+	{
+		return load(p);
+	}
+	static void store(T *p, const Register &a)
+	{
+		for (int i = 0; i < N; i++)
+		{
+			p[i] = a.v[i];
+		}
+	}
+	static void storeUnaligned(T *p, const Register &a)
+	{
+		store(p, a);
+	}
+
+	static Register add(const Register &a, const Register &b)
+	{
+		Register r;
+		for (int i = 0; i < N; i++)
+		{
+			r.v[i] = a.v[i] + b.v[i];
+		}
+		return r;
+	}
+	static Register sub(const Register &a, const Register &b)
+	{
+		Register r;
+		for (int i = 0; i < N; i++)
+		{
+			r.v[i] = a.v[i] - b.v[i];
+		}
+		return r;
+	}
+	static Register mul(const Register &a, const Register &b)
+	{
+		Register r;
+		for (int i = 0; i < N; i++)
+		{
+			r.v[i] = a.v[i] * b.v[i];
+		}
+		return r;
+	}
+	static Register div(const Register &a, const Register &b)
+	{
+		Register r;
+		for (int i = 0; i < N; i++)
+		{
+			r.v[i] = a.v[i] / b.v[i];
+		}
+		return r;
+	}
+	static Register neg(const Register &a)
+	{
+		Register r;
+		for (int i = 0; i < N; i++)
+		{
+			r.v[i] = -a.v[i];
+		}
+		return r;
+	}
+	// second operand if either is NaN (as minps/maxps)
+	static Register (min)(const Register &a, const Register &b)
+	{
+		Register r;
+		for (int i = 0; i < N; i++)
+		{
+			r.v[i] = (a.v[i] < b.v[i]) ? a.v[i] : b.v[i];
+		}
+		return r;
+	}
+	static Register (max)(const Register &a, const Register &b)
+	{
+		Register r;
+		for (int i = 0; i < N; i++)
+		{
+			r.v[i] = (a.v[i] > b.v[i]) ? a.v[i] : b.v[i];
+		}
+		return r;
+	}
+	// a * b + c, rounded twice
+	static Register fma(const Register &a, const Register &b, const Register &c)
+	{
+		return add(mul(a, b), c);
+	}
+	static Register sqrt(const Register &a)
+	{
+		Register r;
+		for (int i = 0; i < N; i++)
+		{
+			r.v[i] = (T)::sqrt((double)a.v[i]);
+		}
+		return r;
+	}
+};
+
+// lane by lane through memory for operations without instruction
+template <class Traits, typename T, int N, class Op>
+inline typename Traits::Register simdLanes(const typename Traits::Register &a, const typename Traits::Register &b, Op op)
+{
+	alignas(64) T x[N];
+	alignas(64) T y[N];
+	Traits::store(x, a);
+	Traits::store(y, b);
+	for (int i = 0; i < N; i++)
+	{
+		x[i] = op(x[i], y[i]);
+	}
+	return Traits::load(x);
+}
+
+template <typename T> struct SimdDivOp
+{
+	T operator()(const T a, const T b) const { return a / b; }
+};
+template <typename T> struct SimdMulOp
+{
+	T operator()(const T a, const T b) const { return a * b; }
+};
+template <typename T> struct SimdMinOp
+{
+	T operator()(const T a, const T b) const { return (a < b) ? a : b; }
+};
+template <typename T> struct SimdMaxOp
+{
+	T operator()(const T a, const T b) const { return (a > b) ? a : b; }
+};
+
+
+////////// SSE2: 128-bit
+
+#if defined(SIMDVEC_SSE2)
+
+template <> struct SimdTraits<float, 4>
+{
+	typedef __m128 Register;
+	static const bool Native = true;
+
+	static Register zero() { return _mm_setzero_ps(); }
+	static Register set1(const float x) { return _mm_set1_ps(x); }
+	static Register load(const float *p) { return _mm_load_ps(p); }
+	static Register loadUnaligned(const float *p) { return _mm_loadu_ps(p); }
+	static void store(float *p, const Register a) { _mm_store_ps(p, a); }
+	static void storeUnaligned(float *p, const Register a) { _mm_storeu_ps(p, a); }
+
+	static Register add(const Register a, const Register b) { return _mm_add_ps(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm_sub_ps(a, b); }
+	static Register mul(const Register a, const Register b) { return _mm_mul_ps(a, b); }
+	static Register div(const Register a, const Register b) { return _mm_div_ps(a, b); }
+	static Register neg(const Register a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+	static Register (min)(const Register a, const Register b) { return _mm_min_ps(a, b); }
+	static Register (max)(const Register a, const Register b) { return _mm_max_ps(a, b); }
+	static Register fma(const Register a, const Register b, const Register c)
+	{
+#if defined(SIMDVEC_FMA)
+		return _mm_fmadd_ps(a, b, c);
+#else
+		return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+	}
+	static Register sqrt(const Register a) { return _mm_sqrt_ps(a); }
+};
+
+template <> struct SimdTraits<double, 2>
+{
+	typedef __m128d Register;
+	static const bool Native = true;
+
+	static Register zero() { return _mm_setzero_pd(); }
+	static Register set1(const double x) { return _mm_set1_pd(x); }
+	static Register load(const double *p) { return _mm_load_pd(p); }
+	static Register loadUnaligned(const double *p) { return _mm_loadu_pd(p); }
+	static void store(double *p, const Register a) { _mm_store_pd(p, a); }
+	static void storeUnaligned(double *p, const Register a) { _mm_storeu_pd(p, a); }
+
+	static Register add(const Register a, const Register b) { return _mm_add_pd(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm_sub_pd(a, b); }
+	static Register mul(const Register a, const Register b) { return _mm_mul_pd(a, b); }
+	static Register div(const Register a, const Register b) { return _mm_div_pd(a, b); }
+	static Register neg(const Register a) { return _mm_xor_pd(a, _mm_set1_pd(-0.0)); }
+	static Register (min)(const Register a, const Register b) { return _mm_min_pd(a, b); }
+	static Register (max)(const Register a, const Register b) { return _mm_max_pd(a, b); }
+	static Register fma(const Register a, const Register b, const Register c)
+	{
+#if defined(SIMDVEC_FMA)
+		return _mm_fmadd_pd(a, b, c);
+#else
+		return _mm_add_pd(_mm_mul_pd(a, b), c);
+#endif
+	}
+	static Register sqrt(const Register a) { return _mm_sqrt_pd(a); }
+};
+
+template <> struct SimdTraits<int32_t, 4>
+{
+	typedef __m128i Register;
+	static const bool Native = true;
+
+	static Register zero() { return _mm_setzero_si128(); }
+	static Register set1(const int32_t x) { return _mm_set1_epi32(x); }
+	static Register load(const int32_t *p) { return _mm_load_si128((const __m128i*)p); }
+	static Register loadUnaligned(const int32_t *p) { return _mm_loadu_si128((const __m128i*)p); }
+	static void store(int32_t *p, const Register a) { _mm_store_si128((__m128i*)p, a); }
+	static void storeUnaligned(int32_t *p, const Register a) { _mm_storeu_si128((__m128i*)p, a); }
+
+	static Register add(const Register a, const Register b) { return _mm_add_epi32(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm_sub_epi32(a, b); }
+	static Register div(const Register a, const Register b) { return simdLanes<SimdTraits, int32_t, 4>(a, b, SimdDivOp<int32_t>()); }
+	static Register neg(const Register a) { return _mm_sub_epi32(_mm_setzero_si128(), a); }
+#if defined(SIMDVEC_SSE41)
+	static Register mul(const Register a, const Register b) { return _mm_mullo_epi32(a, b); }
+	static Register (min)(const Register a, const Register b) { return _mm_min_epi32(a, b); }
+	static Register (max)(const Register a, const Register b) { return _mm_max_epi32(a, b); }
+#else
+	static Register mul(const Register a, const Register b) { return simdLanes<SimdTraits, int32_t, 4>(a, b, SimdMulOp<int32_t>()); }
+	static Register (min)(const Register a, const Register b) { return simdLanes<SimdTraits, int32_t, 4>(a, b, SimdMinOp<int32_t>()); }
+	static Register (max)(const Register a, const Register b) { return simdLanes<SimdTraits, int32_t, 4>(a, b, SimdMaxOp<int32_t>()); }
+#endif
+	static Register fma(const Register a, const Register b, const Register c) { return add(mul(a, b), c); }
+};
+
+template <> struct SimdTraits<int64_t, 2>
+{
+	typedef __m128i Register;
+	static const bool Native = true;
+
+	static Register zero() { return _mm_setzero_si128(); }
+	static Register set1(const int64_t x) { return _mm_set1_epi64x(x); }
+	static Register load(const int64_t *p) { return _mm_load_si128((const __m128i*)p); }
+	static Register loadUnaligned(const int64_t *p) { return _mm_loadu_si128((const __m128i*)p); }
+	static void store(int64_t *p, const Register a) { _mm_store_si128((__m128i*)p, a); }
+	static void storeUnaligned(int64_t *p, const Register a) { _mm_storeu_si128((__m128i*)p, a); }
+
+	static Register add(const Register a, const Register b) { return _mm_add_epi64(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm_sub_epi64(a, b); }
+	// low 64 bits of product from 32-bit halves:
+	// lo*lo + ((hi*lo + lo*hi) << 32)
+	static Register mul(const Register a, const Register b)
+	{
+		const __m128i cross = _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(a, 32), b), _mm_mul_epu32(a, _mm_srli_epi64(b, 32)));
+		return _mm_add_epi64(_mm_mul_epu32(a, b), _mm_slli_epi64(cross, 32));
+	}
+	static Register div(const Register a, const Register b) { return simdLanes<SimdTraits, int64_t, 2>(a, b, SimdDivOp<int64_t>()); }
+	static Register neg(const Register a) { return _mm_sub_epi64(_mm_setzero_si128(), a); }
+	static Register (min)(const Register a, const Register b) { return simdLanes<SimdTraits, int64_t, 2>(a, b, SimdMinOp<int64_t>()); }
+	static Register (max)(const Register a, const Register b) { return simdLanes<SimdTraits, int64_t, 2>(a, b, SimdMaxOp<int64_t>()); }
+	static Register fma(const Register a, const Register b, const Register c) { return add(mul(a, b), c); }
+};
+
+#endif // SIMDVEC_SSE2
+
+
+////////// AVX, AVX2: 256-bit
+
+#if defined(SIMDVEC_AVX)
+
+template <> struct SimdTraits<float, 8>
+{
+	typedef __m256 Register;
+	static const bool Native = true;
+
+	static Register zero() { return _mm256_setzero_ps(); }
+	static Register set1(const float x) { return _mm256_set1_ps(x); }
+	static Register load(const float *p) { return _mm256_load_ps(p); }
+	static Register loadUnaligned(const float *p) { return _mm256_loadu_ps(p); }
+	static void store(float *p, const Register a) { _mm256_store_ps(p, a); }
+	static void storeUnaligned(float *p, const Register a) { _mm256_storeu_ps(p, a); }
+
+	static Register add(const Register a, const Register b) { return _mm256_add_ps(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm256_sub_ps(a, b); }
+	static Register mul(const Register a, const Register b) { return _mm256_mul_ps(a, b); }
+	static Register div(const Register a, const Register b) { return _mm256_div_ps(a, b); }
+	static Register neg(const Register a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+	static Register (min)(const Register a, const Register b) { return _mm256_min_ps(a, b); }
+	static Register (max)(const Register a, const Register b) { return _mm256_max_ps(a, b); }
+	static Register fma(const Register a, const Register b, const Register c)
+	{
+#if defined(SIMDVEC_FMA)
+		return _mm256_fmadd_ps(a, b, c);
+#else
+		return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+	}
+	static Register sqrt(const Register a) { return _mm256_sqrt_ps(a); }
+};
+
+template <> struct SimdTraits<double, 4>
+{
+	typedef __m256d Register;
+	static const bool Native = true;
+
+	static Register zero() { return _mm256_setzero_pd(); }
+	static Register set1(const double x) { return _mm256_set1_pd(x); }
+	static Register load(const double *p) { return _mm256_load_pd(p); }
+	static Register loadUnaligned(const double *p) { return _mm256_loadu_pd(p); }
+	static void store(double *p, const Register a) { _mm256_store_pd(p, a); }
+	static void storeUnaligned(double *p, const Register a) { _mm256_storeu_pd(p, a); }
+
+	static Register add(const Register a, const Register b) { return _mm256_add_pd(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm256_sub_pd(a, b); }
+	static Register mul(const Register a, const Register b) { return _mm256_mul_pd(a, b); }
+	static Register div(const Register a, const Register b) { return _mm256_div_pd(a, b); }
+	static Register neg(const Register a) { return _mm256_xor_pd(a, _mm256_set1_pd(-0.0)); }
+	static Register (min)(const Register a, const Register b) { return _mm256_min_pd(a, b); }
+	static Register (max)(const Register a, const Register b) { return _mm256_max_pd(a, b); }
+	static Register fma(const Register a, const Register b, const Register c)
+	{
+#if defined(SIMDVEC_FMA)
+		return _mm256_fmadd_pd(a, b, c);
+#else
+		return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+#endif
+	}
+	static Register sqrt(const Register a) { return _mm256_sqrt_pd(a); }
+};
+
+#endif // SIMDVEC_AVX
+
+#if defined(SIMDVEC_AVX2)
+
+template <> struct SimdTraits<int32_t, 8>
+{
+	typedef __m256i Register;
+	static const bool Native = true;
+
+	static Register zero() { return _mm256_setzero_si256(); }
+	static Register set1(const int32_t x) { return _mm256_set1_epi32(x); }
+	static Register load(const int32_t *p) { return _mm256_load_si256((const __m256i*)p); }
+	static Register loadUnaligned(const int32_t *p) { return _mm256_loadu_si256((const __m256i*)p); }
+	static void store(int32_t *p, const Register a) { _mm256_store_si256((__m256i*)p, a); }
+	static void storeUnaligned(int32_t *p, const Register a) { _mm256_storeu_si256((__m256i*)p, a); }
+
+	static Register add(const Register a, const Register b) { return _mm256_add_epi32(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm256_sub_epi32(a, b); }
+	static Register mul(const Register a, const Register b) { return _mm256_mullo_epi32(a, b); }
+	static Register div(const Register a, const Register b) { return simdLanes<SimdTraits, int32_t, 8>(a, b, SimdDivOp<int32_t>()); }
+	static Register neg(const Register a) { return _mm256_sub_epi32(_mm256_setzero_si256(), a); }
+	static Register (min)(const Register a, const Register b) { return _mm256_min_epi32(a, b); }
+	static Register (max)(const Register a, const Register b) { return _mm256_max_epi32(a, b); }
+	static Register fma(const Register a, const Register b, const Register c) { return add(mul(a, b), c); }
+};
+
+template <> struct SimdTraits<int64_t, 4>
+{
+	typedef __m256i Register;
+	static const bool Native = true;
+
+	static Register zero() { return _mm256_setzero_si256(); }
+	static Register set1(const int64_t x) { return _mm256_set1_epi64x(x); }
+	static Register load(const int64_t *p) { return _mm256_load_si256((const __m256i*)p); }
+	static Register loadUnaligned(const int64_t *p) { return _mm256_loadu_si256((const __m256i*)p); }
+	static void store(int64_t *p, const Register a) { _mm256_store_si256((__m256i*)p, a); }
+	static void storeUnaligned(int64_t *p, const Register a) { _mm256_storeu_si256((__m256i*)p, a); }
+
+	static Register add(const Register a, const Register b) { return _mm256_add_epi64(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm256_sub_epi64(a, b); }
+	// as with SSE2: from 32-bit halves
+	static Register mul(const Register a, const Register b)
+	{
+		const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b), _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+		return _mm256_add_epi64(_mm256_mul_epu32(a, b), _mm256_slli_epi64(cross, 32));
+	}
+	static Register div(const Register a, const Register b) { return simdLanes<SimdTraits, int64_t, 4>(a, b, SimdDivOp<int64_t>()); }
+	static Register neg(const Register a) { return _mm256_sub_epi64(_mm256_setzero_si256(), a); }
+	// a > b by compare, select with blend
+	static Register (min)(const Register a, const Register b) { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)); }
+	static Register (max)(const Register a, const Register b) { return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b)); }
+	static Register fma(const Register a, const Register b, const Register c) { return add(mul(a, b), c); }
+};
+
+#endif // SIMDVEC_AVX2
+
+
+////////// AVX-512F: 512-bit
+
+#if defined(SIMDVEC_AVX512)
+
+template <> struct SimdTraits<float, 16>
+{
+	typedef __m512 Register;
+	static const bool Native = true;
+
+	static Register zero() { return _mm512_setzero_ps(); }
+	static Register set1(const float x) { return _mm512_set1_ps(x); }
+	static Register load(const float *p) { return _mm512_load_ps(p); }
+	static Register loadUnaligned(const float *p) { return _mm512_loadu_ps(p); }
+	static void store(float *p, const Register a) { _mm512_store_ps(p, a); }
+	static void storeUnaligned(float *p, const Register a) { _mm512_storeu_ps(p, a); }
+
+	static Register add(const Register a, const Register b) { return _mm512_add_ps(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm512_sub_ps(a, b); }
+	static Register mul(const Register a, const Register b) { return _mm512_mul_ps(a, b); }
+	static Register div(const Register a, const Register b) { return _mm512_div_ps(a, b); }
+	// note: integer xor since floating-point xor of AVX-512 needs DQ
+	static Register neg(const Register a) { return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), _mm512_set1_epi32((int)0x80000000))); }
+	static Register (min)(const Register a, const Register b) { return _mm512_min_ps(a, b); }
+	static Register (max)(const Register a, const Register b) { return _mm512_max_ps(a, b); }
+	static Register fma(const Register a, const Register b, const Register c) { return _mm512_fmadd_ps(a, b, c); }
+	static Register sqrt(const Register a) { return _mm512_sqrt_ps(a); }
+};
+
+template <> struct SimdTraits<double, 8>
+{
+	typedef __m512d Register;
+	static const bool Native = true;
+
+	static Register zero() { return _mm512_setzero_pd(); }
+	static Register set1(const double x) { return _mm512_set1_pd(x); }
+	static Register load(const double *p) { return _mm512_load_pd(p); }
+	static Register loadUnaligned(const double *p) { return _mm512_loadu_pd(p); }
+	static void store(double *p, const Register a) { _mm512_store_pd(p, a); }
+	static void storeUnaligned(double *p, const Register a) { _mm512_storeu_pd(p, a); }
+
+	static Register add(const Register a, const Register b) { return _mm512_add_pd(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm512_sub_pd(a, b); }
+	static Register mul(const Register a, const Register b) { return _mm512_mul_pd(a, b); }
+	static Register div(const Register a, const Register b) { return _mm512_div_pd(a, b); }
+	static Register neg(const Register a) { return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a), _mm512_set1_epi64((long long)0x8000000000000000ULL))); }
+	static Register (min)(const Register a, const Register b) { return _mm512_min_pd(a, b); }
+	static Register (max)(const Register a, const Register b) { return _mm512_max_pd(a, b); }
+	static Register fma(const Register a, const Register b, const Register c) { return _mm512_fmadd_pd(a, b, c); }
+	static Register sqrt(const Register a) { return _mm512_sqrt_pd(a); }
+};
+
+template <> struct SimdTraits<int32_t, 16>
+{
+	typedef __m512i Register;
+	static const bool Native = true;
+
+	static Register zero() { return _mm512_setzero_si512(); }
+	static Register set1(const int32_t x) { return _mm512_set1_epi32(x); }
+	static Register load(const int32_t *p) { return _mm512_load_si512((const void*)p); }
+	static Register loadUnaligned(const int32_t *p) { return _mm512_loadu_si512((const void*)p); }
+	static void store(int32_t *p, const Register a) { _mm512_store_si512((void*)p, a); }
+	static void storeUnaligned(int32_t *p, const Register a) { _mm512_storeu_si512((void*)p, a); }
+
+	static Register add(const Register a, const Register b) { return _mm512_add_epi32(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm512_sub_epi32(a, b); }
+	static Register mul(const Register a, const Register b) { return _mm512_mullo_epi32(a, b); }
+	static Register div(const Register a, const Register b) { return simdLanes<SimdTraits, int32_t, 16>(a, b, SimdDivOp<int32_t>()); }
+	static Register neg(const Register a) { return _mm512_sub_epi32(_mm512_setzero_si512(), a); }
+	static Register (min)(const Register a, const Register b) { return _mm512_min_epi32(a, b); }
+	static Register (max)(const Register a, const Register b) { return _mm512_max_epi32(a, b); }
+	static Register fma(const Register a, const Register b, const Register c) { return add(mul(a, b), c); }
+};
+
+template <> struct SimdTraits<int64_t, 8>
+{
+	typedef __m512i Register;
+	static const bool Native = true;
+
+	static Register zero() { return _mm512_setzero_si512(); }
+	static Register set1(const int64_t x) { return _mm512_set1_epi64(x); }
+	static Register load(const int64_t *p) { return _mm512_load_si512((const void*)p); }
+	static Register loadUnaligned(const int64_t *p) { return _mm512_loadu_si512((const void*)p); }
+	static void store(int64_t *p, const Register a) { _mm512_store_si512((void*)p, a); }
+	static void storeUnaligned(int64_t *p, const Register a) { _mm512_storeu_si512((void*)p, a); }
+
+	static Register add(const Register a, const Register b) { return _mm512_add_epi64(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm512_sub_epi64(a, b); }
+	static Register mul(const Register a, const Register b)
+	{
+#if defined(__AVX512DQ__)
+		return _mm512_mullo_epi64(a, b);
+#else
+		const __m512i cross = _mm512_add_epi64(_mm512_mul_epu32(_mm512_srli_epi64(a, 32), b), _mm512_mul_epu32(a, _mm512_srli_epi64(b, 32)));
+		return _mm512_add_epi64(_mm512_mul_epu32(a, b), _mm512_slli_epi64(cross, 32));
+#endif
+	}
+	static Register div(const Register a, const Register b) { return simdLanes<SimdTraits, int64_t, 8>(a, b, SimdDivOp<int64_t>()); }
+	static Register neg(const Register a) { return _mm512_sub_epi64(_mm512_setzero_si512(), a); }
+	static Register (min)(const Register a, const Register b) { return _mm512_min_epi64(a, b); }
+	static Register (max)(const Register a, const Register b) { return _mm512_max_epi64(a, b); }
+	static Register fma(const Register a, const Register b, const Register c) { return add(mul(a, b), c); }
+};
+
+#endif // SIMDVEC_AVX512
+
+
+////////// vector
+
+template <typename T, int N> class SimdVec
+{
+public:
+	typedef SimdTraits<T, N> Traits;
+	typedef typename Traits::Register Register;
+	typedef T Scalar;
+
+	static const int Lanes = N;
+	// false when generic scalar version is used
+	static const bool Native = Traits::Native;
+
+protected:
+	Register m_v;
+
+public:
+	// zero
+	SimdVec()
+		: m_v(Traits::zero())
+	{}
+	// same value in all lanes
+	explicit SimdVec(const T x)
+		: m_v(Traits::set1(x))
+	{}
+	// N values, no alignment needed
+	explicit SimdVec(const T *p)
+		: m_v(Traits::loadUnaligned(p))
+	{}
+	SimdVec(const Register &v)
+		: m_v(v)
+	{}
+
+	// pointer must be aligned to size of vector
+	static SimdVec load(const T *p)
+	{
+		return SimdVec(Traits::load(p));
+	}
+	static SimdVec loadUnaligned(const T *p)
+	{
+		return SimdVec(Traits::loadUnaligned(p));
+	}
+	// pointer must be aligned to size of vector
+	void store(T *p) const
+	{
+		Traits::store(p, m_v);
+	}
+	void storeUnaligned(T *p) const
+	{
+		Traits::storeUnaligned(p, m_v);
+	}
+
+	const Register& get() const
+	{
+		return m_v;
+	}
+
+	// single lane (through memory, not for inner loops)
+	T operator [] (const int nIndex) const
+	{
+		alignas(64) T values[N];
+		Traits::store(values, m_v);
+		return values[nIndex & (N - 1)];
+	}
+
+	SimdVec& operator += (const SimdVec &other)
+	{
+		m_v = Traits::add(m_v, other.m_v);
+		return *this;
+	}
+	SimdVec& operator -= (const SimdVec &other)
+	{
+		m_v = Traits::sub(m_v, other.m_v);
+		return *this;
+	}
+	SimdVec& operator *= (const SimdVec &other)
+	{
+		m_v = Traits::mul(m_v, other.m_v);
+		return *this;
+	}
+	SimdVec& operator /= (const SimdVec &other)
+	{
+		m_v = Traits::div(m_v, other.m_v);
+		return *this;
+	}
+
+	SimdVec operator + (const SimdVec &other) const
+	{
+		return SimdVec(Traits::add(m_v, other.m_v));
+	}
+	SimdVec operator - (const SimdVec &other) const
+	{
+		return SimdVec(Traits::sub(m_v, other.m_v));
+	}
+	SimdVec operator * (const SimdVec &other) const
+	{
+		return SimdVec(Traits::mul(m_v, other.m_v));
+	}
+	SimdVec operator / (const SimdVec &other) const
+	{
+		return SimdVec(Traits::div(m_v, other.m_v));
+	}
+	SimdVec operator - () const
+	{
+		return SimdVec(Traits::neg(m_v));
+	}
+
+	// note: parentheses keep min/max macros of windows.h from expanding
+	static SimdVec (min)(const SimdVec &a, const SimdVec &b)
+	{
+		return SimdVec((Traits::min)(a.m_v, b.m_v));
+	}
+	static SimdVec (max)(const SimdVec &a, const SimdVec &b)
+	{
+		return SimdVec((Traits::max)(a.m_v, b.m_v));
+	}
+
+	// a * b + c (fused for floating-point with FMA)
+	static SimdVec fma(const SimdVec &a, const SimdVec &b, const SimdVec &c)
+	{
+		return SimdVec(Traits::fma(a.m_v, b.m_v, c.m_v));
+	}
+
+	// floating-point only
+	static SimdVec sqrt(const SimdVec &a)
+	{
+		return SimdVec(Traits::sqrt(a.m_v));
+	}
+
+	// sum of lanes (through memory)
+	T horizontalSum() const
+	{
+		alignas(64) T values[N];
+		Traits::store(values, m_v);
+		T sum = T(0);
+		for (int i = 0; i < N; i++)
+		{
+			sum += values[i];
+		}
+		return sum;
+	}
+};
+
+template <typename T, int N> inline SimdVec<T, N> (min)(const SimdVec<T, N> &a, const SimdVec<T, N> &b)
+{
+	return (SimdVec<T, N>::min)(a, b);
+}
+template <typename T, int N> inline SimdVec<T, N> (max)(const SimdVec<T, N> &a, const SimdVec<T, N> &b)
+{
+	return (SimdVec<T, N>::max)(a, b);
+}
+template <typename T, int N> inline SimdVec<T, N> fma(const SimdVec<T, N> &a, const SimdVec<T, N> &b, const SimdVec<T, N> &c)
+{
+	return SimdVec<T, N>::fma(a, b, c);
+}
+
+#endif // SIMDVEC_H
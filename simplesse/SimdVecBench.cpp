@@ -0,0 +1,112 @@
+// SimdVecBench.cpp : throughput of array add, multiply
+// and multiply-add for each SimdVec type and width.
+//
+// usage: SimdVecBench [count]
+//
+// build with widest instruction set of machine (-march=native),
+// widths that compiler does not target use generic version (marked "generic").
+//
+
+#include "SimdVec.h"
+#include "AlignedAllocator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <chrono>
+
+
+static double elapsed(const std::chrono::steady_clock::time_point &start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+////////// kernels: written once for any vector type
+
+template <class V> static void kernelAdd(typename V::Scalar *pDst, const typename V::Scalar *pA, const typename V::Scalar *pB, const size_t nCount)
+{
+	for (size_t i = 0; i + V::Lanes <= nCount; i += V::Lanes)
+	{
+		(V::load(pA + i) + V::load(pB + i)).store(pDst + i);
+	}
+}
+
+template <class V> static void kernelMul(typename V::Scalar *pDst, const typename V::Scalar *pA, const typename V::Scalar *pB, const size_t nCount)
+{
+	for (size_t i = 0; i + V::Lanes <= nCount; i += V::Lanes)
+	{
+		(V::load(pA + i) * V::load(pB + i)).store(pDst + i);
+	}
+}
+
+// destination = a * b + destination
+template <class V> static void kernelFma(typename V::Scalar *pDst, const typename V::Scalar *pA, const typename V::Scalar *pB, const size_t nCount)
+{
+	for (size_t i = 0; i + V::Lanes <= nCount; i += V::Lanes)
+	{
+		V::fma(V::load(pA + i), V::load(pB + i), V::load(pDst + i)).store(pDst + i);
+	}
+}
+
+// elements per nanosecond, arrays in L1 cache
+template <class V> static double runKernel(void (*pKernel)(typename V::Scalar*, const typename V::Scalar*, const typename V::Scalar*, const size_t), typename V::Scalar *pDst, const typename V::Scalar *pA, const typename V::Scalar *pB, const size_t nCount, const size_t nRounds)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (size_t r = 0; r < nRounds; r++)
+	{
+		pKernel(pDst, pA, pB, nCount);
+	}
+	return (double)(nCount * nRounds) / (elapsed(start) * 1e9);
+}
+
+template <typename T, int N> static void benchWidth(const char *szType, const size_t nRounds)
+{
+	typedef SimdVec<T, N> V;
+
+	// each array 8 kB
+	const size_t nCount = 8192 / sizeof(T);
+	AlignedVector<T> a(nCount);
+	AlignedVector<T> b(nCount);
+	AlignedVector<T> dst(nCount);
+	T *pA = a.data();
+	T *pB = b.data();
+	T *pDst = dst.data();
+	for (size_t i = 0; i < nCount; i++)
+	{
+		pA[i] = (T)(1 + (i % 7));
+		pB[i] = (T)(1 + (i % 5));
+		pDst[i] = (T)0;
+	}
+
+	const double dAdd = runKernel<V>(kernelAdd<V>, pDst, pA, pB, nCount, nRounds);
+	const double dMul = runKernel<V>(kernelMul<V>, pDst, pA, pB, nCount, nRounds);
+	const double dFma = runKernel<V>(kernelFma<V>, pDst, pA, pB, nCount, nRounds);
+
+	printf("%-8s %4d %-8s %10.2f %10.2f %10.2f\n", szType, N, (V::Native == true) ? "native" : "generic", dAdd, dMul, dFma);
+}
+
+int main(int argc, char *argv[])
+{
+	size_t nRounds = 100000;
+	if (argc > 1)
+	{
+		nRounds = (size_t)::strtoull(argv[1], nullptr, 10);
+	}
+
+	printf("elements per ns, %zu rounds over 8 kB arrays\n", nRounds);
+	printf("%-8s %4s %-8s %10s %10s %10s\n", "type", "lanes", "", "add", "mul", "fma");
+
+	benchWidth<float, 4>("float", nRounds);
+	benchWidth<float, 8>("float", nRounds);
+	benchWidth<float, 16>("float", nRounds);
+	benchWidth<double, 2>("double", nRounds);
+	benchWidth<double, 4>("double", nRounds);
+	benchWidth<double, 8>("double", nRounds);
+	benchWidth<int32_t, 4>("int32", nRounds);
+	benchWidth<int32_t, 8>("int32", nRounds);
+	benchWidth<int32_t, 16>("int32", nRounds);
+	benchWidth<int64_t, 2>("int64", nRounds);
+	benchWidth<int64_t, 4>("int64", nRounds);
+	benchWidth<int64_t, 8>("int64", nRounds);
+	return 0;
+}
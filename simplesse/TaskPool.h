@@ -0,0 +1,659 @@
+/////////////////////////////////////
+//
+// TaskPool : work-stealing thread pool
+// for fork/join parallel kernels.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Header-only. Each worker has own deque of tasks: forking thread
+// pushes task to back of its deque and takes it back from there
+// when no one stole it (newest first, its data is still in cache),
+// idle workers steal from front (oldest task: largest piece of work
+// in recursive splitting). Threads outside of pool use shared deque.
+//
+// parallelInvoke(f1, f2) runs f1 on calling thread and f2 on calling
+// thread or on a thief, returns when both are done.
+// parallelFor(begin, end, grain, func) splits range in halves
+// until pieces are at most grain items and calls func(begin, end)
+// for each piece. While waiting for stolen task thread runs
+// other tasks, so nested forks (recursive multiplication inside
+// product tree, kernels inside parallel loop) share same workers.
+//
+// Tasks live on stack of forking call (no allocation per task),
+// exception thrown by task is rethrown at join.
+// Thread-local scratch held over a forking call is not safe:
+// waiting thread may run task entering same code, TaskLocal
+// gives each such nesting level own scratch.
+// Tasks run in denormal mode of forking thread (DenormalGuard.h).
+//
+// Kernels fork in pool of calling thread: pool set by TaskPoolScope,
+// pool of worker thread or shared pool of all hardware threads.
+// Pool of N threads has N-1 workers, calling thread is N:th
+// (pool of single thread calls everything in place).
+//
+// Affinity: pinned workers don't migrate between cores (caches stay
+// warm, timing is repeatable) but share core with any other threads
+// pinned there, default is no pinning. Caller is not pinned.
+//
+
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include "DenormalGuard.h"
+
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+
+enum TaskAffinity
+{
+	TaskAffinityNone = 0,    // scheduled by system (default)
+	TaskAffinityCompact,     // worker i on logical processor i+1
+	TaskAffinitySpread       // workers evenly over logical processors
+};
+
+class TaskPool;
+
+
+////////// tasks
+
+// forked call waiting in deque,
+// lives on stack of forking call until joined
+class TaskItem
+{
+protected:
+	typedef void (*RunFunc)(TaskItem *pItem);
+
+	RunFunc m_pRun;
+	unsigned int m_nDenormalMode;
+	std::atomic<bool> m_bDone;
+	std::exception_ptr m_pError;
+
+	explicit TaskItem(const RunFunc pRun)
+		: m_pRun(pRun)
+		, m_nDenormalMode(denormalMode())
+		, m_bDone(false)
+		, m_pError()
+	{}
+
+	TaskItem(const TaskItem &) = delete;
+	TaskItem& operator = (const TaskItem &) = delete;
+
+public:
+	void run()
+	{
+		try
+		{
+			const DenormalGuard guard(m_nDenormalMode);
+			m_pRun(this);
+		}
+		catch (...)
+		{
+			m_pError = std::current_exception();
+		}
+		m_bDone.store(true, std::memory_order_release);
+	}
+
+	bool isDone() const
+	{
+		return m_bDone.load(std::memory_order_acquire);
+	}
+
+	// exception thrown by task (after done)
+	void rethrow() const
+	{
+		if (m_pError)
+		{
+			std::rethrow_exception(m_pError);
+		}
+	}
+};
+
+template <class Func> class TaskFunc : public TaskItem
+{
+protected:
+	const Func &m_func;
+
+	static void runFunc(TaskItem *pItem)
+	{
+		static_cast<TaskFunc*>(pItem)->m_func();
+	}
+
+public:
+	explicit TaskFunc(const Func &func)
+		: TaskItem(runFunc)
+		, m_func(func)
+	{}
+};
+
+// owner pushes and takes back at back, thieves steal at front
+class TaskDeque
+{
+protected:
+	std::mutex m_lock;
+	std::deque<TaskItem*> m_items;
+
+	// note: read without lock to skip empty deques when stealing
+	std::atomic<size_t> m_nCount;
+
+public:
+	TaskDeque()
+		: m_lock()
+		, m_items()
+		, m_nCount(0)
+	{}
+
+	void push(TaskItem *pItem)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_items.push_back(pItem);
+		m_nCount.store(m_items.size(), std::memory_order_release);
+	}
+
+	// remove task if still queued (not stolen),
+	// owner's latest task is at back
+	bool take(TaskItem *pItem)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		for (size_t i = m_items.size(); i > 0; i--)
+		{
+			if (m_items[i - 1] == pItem)
+			{
+				m_items.erase(m_items.begin() + (i - 1));
+				m_nCount.store(m_items.size(), std::memory_order_release);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// oldest task, nullptr if none
+	TaskItem* steal()
+	{
+		if (m_nCount.load(std::memory_order_acquire) == 0)
+		{
+			return nullptr;
+		}
+
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (m_items.empty() == true)
+		{
+			return nullptr;
+		}
+		TaskItem *pItem = m_items.front();
+		m_items.pop_front();
+		m_nCount.store(m_items.size(), std::memory_order_release);
+		return pItem;
+	}
+};
+
+
+////////// thread state
+
+struct TaskThreadState
+{
+	TaskPool *m_pWorkerPool;  // pool this thread is worker of
+	TaskPool *m_pScopePool;   // pool set by TaskPoolScope
+	size_t m_nWorker;
+};
+
+// note: function-local static so that header-only module
+// has single instance of state over translation units
+inline TaskThreadState& taskThreadState()
+{
+	static thread_local TaskThreadState s_state = {nullptr, nullptr, 0};
+	return s_state;
+}
+
+// per-thread scratch for code that forks while holding it:
+// thread waiting at join runs other tasks and those may enter
+// same code, so each nesting level on thread gets own object.
+// objects are kept for reuse (no allocation in steady state).
+template <class T> class TaskLocal
+{
+protected:
+	T *m_pValue;
+
+	static std::vector<std::unique_ptr<T>>& levels()
+	{
+		static thread_local std::vector<std::unique_ptr<T>> s_levels;
+		return s_levels;
+	}
+	static size_t& depth()
+	{
+		static thread_local size_t s_nDepth = 0;
+		return s_nDepth;
+	}
+
+	TaskLocal(const TaskLocal &) = delete;
+	TaskLocal& operator = (const TaskLocal &) = delete;
+
+public:
+	TaskLocal()
+		: m_pValue(nullptr)
+	{
+		std::vector<std::unique_ptr<T>> &values = levels();
+		size_t &nDepth = depth();
+		if (values.size() <= nDepth)
+		{
+			values.push_back(std::unique_ptr<T>(new T()));
+		}
+		m_pValue = values[nDepth].get();
+		nDepth++;
+	}
+	~TaskLocal()
+	{
+		depth()--;
+	}
+
+	T& get() const
+	{
+		return *m_pValue;
+	}
+
+	// free objects of calling thread not in use
+	static void release()
+	{
+		levels().resize(depth());
+	}
+};
+
+// keep thread on single logical processor, false if not supported
+inline bool taskPinThread(std::thread &thread, const size_t nCpu)
+{
+#if defined(_WIN32)
+	// note: only first processor group (64 logical processors)
+	if (nCpu >= 64)
+	{
+		return false;
+	}
+	return (::SetThreadAffinityMask(thread.native_handle(), (DWORD_PTR)1 << nCpu) != 0);
+#elif defined(__linux__)
+	if (nCpu >= CPU_SETSIZE)
+	{
+		return false;
+	}
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(nCpu, &cpus);
+	return (::pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus) == 0);
+#else
+	(void)thread;
+	(void)nCpu;
+	return false;
+#endif
+}
+
+
+////////// pool
+
+class TaskPool
+{
+protected:
+	// idle worker polls deques this many rounds, then yields
+	// this many rounds before sleeping until tasks are pushed
+	static const size_t s_nSpinRounds = 64;
+	static const size_t s_nYieldRounds = 16;
+
+	// deque per worker, shared deque last
+	std::vector<std::unique_ptr<TaskDeque>> m_deques;
+	std::vector<std::thread> m_threads;
+	size_t m_nThreads;
+	TaskAffinity m_eAffinity;
+
+	// note: queued count is raised before push and lowered after
+	// removal so it is never below real count (sleep check)
+	std::atomic<size_t> m_nQueued;
+	std::atomic<size_t> m_nSleeping;
+	std::atomic<bool> m_bStop;
+	std::mutex m_sleepLock;
+	std::condition_variable m_wake;
+
+	TaskPool(const TaskPool &) = delete;
+	TaskPool& operator = (const TaskPool &) = delete;
+
+	// deque of calling thread
+	size_t selfIndex() const
+	{
+		const TaskThreadState &state = taskThreadState();
+		return (state.m_pWorkerPool == this) ? state.m_nWorker : m_deques.size() - 1;
+	}
+
+	void push(const size_t nSelf, TaskItem &item)
+	{
+		m_nQueued.fetch_add(1);
+		m_deques[nSelf]->push(&item);
+		if (m_nSleeping.load() > 0)
+		{
+			std::lock_guard<std::mutex> lock(m_sleepLock);
+			m_wake.notify_one();
+		}
+	}
+
+	// oldest task of some deque, own deque last
+	TaskItem* steal(const size_t nSelf)
+	{
+		const size_t nDeques = m_deques.size();
+		for (size_t i = 1; i <= nDeques; i++)
+		{
+			TaskItem *pItem = m_deques[(nSelf + i) % nDeques]->steal();
+			if (pItem != nullptr)
+			{
+				m_nQueued.fetch_sub(1);
+				return pItem;
+			}
+		}
+		return nullptr;
+	}
+
+	// run task here if not stolen, otherwise run other tasks until done
+	void join(const size_t nSelf, TaskItem &item)
+	{
+		if (m_deques[nSelf]->take(&item) == true)
+		{
+			m_nQueued.fetch_sub(1);
+			item.run();
+			return;
+		}
+
+		size_t nIdle = 0;
+		while (item.isDone() == false)
+		{
+			TaskItem *pItem = steal(nSelf);
+			if (pItem != nullptr)
+			{
+				pItem->run();
+				nIdle = 0;
+			}
+			else if (++nIdle < s_nSpinRounds)
+			{
+				_mm_pause();
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void workerLoop(const size_t nWorker)
+	{
+		TaskThreadState &state = taskThreadState();
+		state.m_pWorkerPool = this;
+		state.m_nWorker = nWorker;
+
+		size_t nIdle = 0;
+		while (m_bStop.load(std::memory_order_acquire) == false)
+		{
+			TaskItem *pItem = steal(nWorker);
+			if (pItem != nullptr)
+			{
+				pItem->run();
+				nIdle = 0;
+				continue;
+			}
+
+			nIdle++;
+			if (nIdle < s_nSpinRounds)
+			{
+				_mm_pause();
+				continue;
+			}
+			if (nIdle < s_nSpinRounds + s_nYieldRounds)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			// note: sleeping count is raised before queued count is checked
+			// and pusher checks sleeping count after raising queued count
+			std::unique_lock<std::mutex> lock(m_sleepLock);
+			m_nSleeping.fetch_add(1);
+			if (m_nQueued.load() == 0 && m_bStop.load() == false)
+			{
+				m_wake.wait(lock);
+			}
+			m_nSleeping.fetch_sub(1);
+			nIdle = 0;
+		}
+	}
+
+	// logical processor of worker
+	size_t workerCpu(const size_t nWorker, const size_t nCpus) const
+	{
+		if (m_eAffinity == TaskAffinitySpread && m_nThreads < nCpus)
+		{
+			return ((nWorker + 1) * (nCpus / m_nThreads)) % nCpus;
+		}
+		return (nWorker + 1) % nCpus;
+	}
+
+	template <class Func> void splitRange(const size_t nBegin, const size_t nEnd, const size_t nGrain, const Func &func)
+	{
+		if (nEnd - nBegin <= nGrain)
+		{
+			func(nBegin, nEnd);
+			return;
+		}
+
+		const size_t nMiddle = nBegin + (nEnd - nBegin) / 2;
+		invoke([&]() { splitRange(nBegin, nMiddle, nGrain, func); },
+			[&]() { splitRange(nMiddle, nEnd, nGrain, func); });
+	}
+
+public:
+	// thread count zero for all hardware threads
+	explicit TaskPool(size_t nThreads = 0, const TaskAffinity eAffinity = TaskAffinityNone)
+		: m_deques()
+		, m_threads()
+		, m_nThreads(1)
+		, m_eAffinity(eAffinity)
+		, m_nQueued(0)
+		, m_nSleeping(0)
+		, m_bStop(false)
+		, m_sleepLock()
+		, m_wake()
+	{
+		const size_t nCpus = (std::thread::hardware_concurrency() > 0) ? std::thread::hardware_concurrency() : 1;
+		if (nThreads == 0)
+		{
+			nThreads = nCpus;
+		}
+
+		// note: deques are not resized after workers start
+		m_deques.reserve(nThreads);
+		for (size_t i = 0; i < nThreads; i++)
+		{
+			m_deques.push_back(std::unique_ptr<TaskDeque>(new TaskDeque()));
+		}
+
+		m_nThreads = nThreads;
+		m_threads.reserve(nThreads - 1);
+		try
+		{
+			for (size_t i = 0; i + 1 < nThreads; i++)
+			{
+				m_threads.emplace_back(&TaskPool::workerLoop, this, i);
+				if (m_eAffinity != TaskAffinityNone)
+				{
+					taskPinThread(m_threads.back(), workerCpu(i, nCpus));
+				}
+			}
+		}
+		catch (const std::system_error &)
+		{
+			// out of threads: fewer workers
+		}
+		m_nThreads = m_threads.size() + 1;
+	}
+
+	~TaskPool()
+	{
+		m_bStop.store(true);
+		{
+			std::lock_guard<std::mutex> lock(m_sleepLock);
+			m_wake.notify_all();
+		}
+		for (size_t i = 0; i < m_threads.size(); i++)
+		{
+			m_threads[i].join();
+		}
+	}
+
+	// workers and calling thread
+	size_t threadCount() const
+	{
+		return m_nThreads;
+	}
+
+	TaskAffinity affinity() const
+	{
+		return m_eAffinity;
+	}
+
+	// func1() and func2() in parallel, returns when both are done:
+	// exception of func1 is rethrown first
+	template <class Func1, class Func2> void invoke(const Func1 &func1, const Func2 &func2)
+	{
+		if (m_nThreads <= 1)
+		{
+			func1();
+			func2();
+			return;
+		}
+
+		const size_t nSelf = selfIndex();
+		TaskFunc<Func2> task(func2);
+		push(nSelf, task);
+
+		std::exception_ptr pError;
+		try
+		{
+			func1();
+		}
+		catch (...)
+		{
+			pError = std::current_exception();
+		}
+
+		// note: task refers to this stack frame, always joined
+		join(nSelf, task);
+		if (pError)
+		{
+			std::rethrow_exception(pError);
+		}
+		task.rethrow();
+	}
+
+	template <class Func1, class Func2, class Func3> void invoke(const Func1 &func1, const Func2 &func2, const Func3 &func3)
+	{
+		invoke(func1, [&]() { invoke(func2, func3); });
+	}
+
+	// func(begin, end) over pieces of at most grain items,
+	// grain zero for about four pieces per thread.
+	// single thread calls func once for whole range.
+	template <class Func> void forRange(const size_t nBegin, const size_t nEnd, size_t nGrain, const Func &func)
+	{
+		if (nBegin >= nEnd)
+		{
+			return;
+		}
+		if (m_nThreads <= 1)
+		{
+			func(nBegin, nEnd);
+			return;
+		}
+
+		if (nGrain == 0)
+		{
+			const size_t nPieces = 4 * m_nThreads;
+			nGrain = (nEnd - nBegin + nPieces - 1) / nPieces;
+		}
+		splitRange(nBegin, nEnd, nGrain, func);
+	}
+};
+
+
+////////// current pool
+
+// pool of all hardware threads, started on first use
+inline TaskPool& taskPool()
+{
+	static TaskPool s_pool;
+	return s_pool;
+}
+
+// pool kernels fork in on calling thread
+inline TaskPool& taskPoolCurrent()
+{
+	const TaskThreadState &state = taskThreadState();
+	if (state.m_pScopePool != nullptr)
+	{
+		return *state.m_pScopePool;
+	}
+	if (state.m_pWorkerPool != nullptr)
+	{
+		return *state.m_pWorkerPool;
+	}
+	return taskPool();
+}
+
+// pool of calling thread for scope (kernels on own pool,
+// thread count of benchmark), restored at end of scope
+class TaskPoolScope
+{
+protected:
+	TaskPool *m_pSavedPool;
+
+	TaskPoolScope(const TaskPoolScope &) = delete;
+	TaskPoolScope& operator = (const TaskPoolScope &) = delete;
+
+public:
+	explicit TaskPoolScope(TaskPool &pool)
+		: m_pSavedPool(taskThreadState().m_pScopePool)
+	{
+		taskThreadState().m_pScopePool = &pool;
+	}
+	~TaskPoolScope()
+	{
+		taskThreadState().m_pScopePool = m_pSavedPool;
+	}
+};
+
+template <class Func1, class Func2> inline void parallelInvoke(const Func1 &func1, const Func2 &func2)
+{
+	taskPoolCurrent().invoke(func1, func2);
+}
+
+template <class Func1, class Func2, class Func3> inline void parallelInvoke(const Func1 &func1, const Func2 &func2, const Func3 &func3)
+{
+	taskPoolCurrent().invoke(func1, func2, func3);
+}
+
+template <class Func> inline void parallelFor(const size_t nBegin, const size_t nEnd, const size_t nGrain, const Func &func)
+{
+	taskPoolCurrent().forRange(nBegin, nEnd, nGrain, func);
+}
+
+#endif // TASKPOOL_H
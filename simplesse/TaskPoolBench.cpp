@@ -0,0 +1,144 @@
+// TaskPoolBench.cpp : fork/join cost of TaskPool and scaling
+// of parallel kernels from one thread to all hardware threads.
+//
+// usage: TaskPoolBench [max threads] [none|compact|spread] [MicroBench options]
+//
+// thread counts are powers of two upto max threads (default
+// hardware threads) and max itself, each in own pool
+// with given affinity (default none).
+// Items per second are floats or points.
+//
+
+#include "TaskPool.h"
+#include "sseArray.h"
+#include "sseReduce.h"
+#include "sseMat4.h"
+#include "AlignedAllocator.h"
+#include "MicroBench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+
+// array elements in kernels (64 MB per float array)
+static const size_t s_nArrayCount = (size_t)1 << 24;
+
+// points in transform (4M points, 48 MB in and out)
+static const size_t s_nPointCount = (size_t)1 << 22;
+
+// floats per task when array kernel is split by caller
+static const size_t s_nArrayGrain = (size_t)1 << 16;
+
+int main(int argc, char *argv[])
+{
+	size_t nMaxThreads = (std::thread::hardware_concurrency() > 0) ? std::thread::hardware_concurrency() : 1;
+	TaskAffinity eAffinity = TaskAffinityNone;
+	if (argc > 1 && argv[1][0] != '-')
+	{
+		nMaxThreads = (size_t)::strtoull(argv[1], nullptr, 10);
+	}
+	if (argc > 2 && argv[2][0] != '-')
+	{
+		if (::strcmp(argv[2], "compact") == 0)
+		{
+			eAffinity = TaskAffinityCompact;
+		}
+		else if (::strcmp(argv[2], "spread") == 0)
+		{
+			eAffinity = TaskAffinitySpread;
+		}
+	}
+
+	MicroBench bench;
+	if (nMaxThreads == 0 || bench.parseArgs(argc, argv) == false)
+	{
+		fprintf(stderr, "invalid options\n");
+		return 1;
+	}
+
+	// pools created before timing: thread start is not measured
+	std::vector<size_t> counts = MicroBench::powersOfTwo(1, nMaxThreads);
+	if (counts.back() != nMaxThreads)
+	{
+		counts.push_back(nMaxThreads);
+	}
+	std::vector<std::unique_ptr<TaskPool>> pools;
+	for (size_t i = 0; i < counts.size(); i++)
+	{
+		pools.push_back(std::unique_ptr<TaskPool>(new TaskPool(counts[i], eAffinity)));
+	}
+	printf("%u hardware threads, max %zu threads in pool\n\n", std::thread::hardware_concurrency(), nMaxThreads);
+
+	AlignedVector<float> a(s_nArrayCount);
+	AlignedVector<float> b(s_nArrayCount);
+	AlignedVector<float> dst(s_nArrayCount);
+	for (size_t i = 0; i < s_nArrayCount; i++)
+	{
+		a[i] = 1.0f + (float)(i % 17) * 0.25f;
+		b[i] = 0.5f + (float)(i % 13) * 0.125f;
+	}
+	std::vector<float> x(s_nPointCount);
+	std::vector<float> y(s_nPointCount);
+	std::vector<float> z(s_nPointCount);
+	std::vector<float> outX(s_nPointCount);
+	std::vector<float> outY(s_nPointCount);
+	std::vector<float> outZ(s_nPointCount);
+	for (size_t i = 0; i < s_nPointCount; i++)
+	{
+		x[i] = (float)(i % 101);
+		y[i] = (float)(i % 103);
+		z[i] = (float)(i % 107);
+	}
+	const sseMat4 matrix(sseQuad(1.0f, 0.0f, 0.0f, 2.0f), sseQuad(0.0f, 0.0f, -1.0f, 3.0f),
+		sseQuad(0.0f, 1.0f, 0.0f, 4.0f), sseQuad(0.0f, 0.0f, 0.0f, 1.0f));
+
+	// each benchmark over all pools so that scaling reads down the table
+	auto forPools = [&](const std::string &szName, const double dItems, const std::function<void()> &func)
+	{
+		for (size_t i = 0; i < pools.size(); i++)
+		{
+			const TaskPoolScope scope(*pools[i]);
+			MicroBenchParams params;
+			params.push_back(std::make_pair(std::string("threads"), (double)counts[i]));
+			bench.run(szName, params, func, dItems);
+		}
+	};
+
+	// overhead: task not stolen is taken back by forking thread
+	forPools("parallelInvoke empty", 1.0, [&]()
+	{
+		parallelInvoke([]() {}, []() {});
+	});
+	forPools("parallelFor grain 1024", (double)s_nArrayCount, [&]()
+	{
+		parallelFor(0, s_nArrayCount, 1024, [&](const size_t nBegin, const size_t nEnd)
+		{
+			microBenchKeep(nEnd - nBegin);
+		});
+	});
+
+	// kernels forking in current pool
+	forPools("sseReduceSumParallel", (double)s_nArrayCount, [&]()
+	{
+		microBenchKeep(sseReduceSumParallel(a.data(), s_nArrayCount, 0));
+	});
+	forPools("sseTransformPointsSoA", (double)s_nPointCount, [&]()
+	{
+		sseTransformPointsSoA(matrix, x.data(), y.data(), z.data(), outX.data(), outY.data(), outZ.data(), s_nPointCount);
+	});
+
+	// single-threaded kernel split by caller
+	forPools("sseArrayMul tasks", (double)s_nArrayCount, [&]()
+	{
+		parallelFor(0, s_nArrayCount / 4, s_nArrayGrain / 4, [&](const size_t nBegin, const size_t nEnd)
+		{
+			sseArrayMul(dst.data() + 4 * nBegin, a.data() + 4 * nBegin, b.data() + 4 * nBegin, 4 * (nEnd - nBegin));
+		});
+	});
+
+	return (bench.report() == true) ? 0 : 1;
+}
@@ -0,0 +1,439 @@
+/////////////////////////////////////
+//
+// sseArray : kernels over float arrays
+// using sseQuad.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Each kernel is an operation on quads given to common loop:
+// loop is instantiated separately for aligned and unaligned buffers
+// (movaps/movups) and selected by checking pointers once per call.
+//
+// Destinations above stream threshold are written with non-temporal
+// stores (movntps) past cache and inputs are prefetched ahead:
+// output of array larger than cache would only evict
+// other data before it is read again.
+// Destination is aligned first with normal stores (upto three floats),
+// stores are fenced (sfence) before returning so that other threads
+// see them in order.
+//
+
+#include "sseArray.h"
+#include "sseQuad.h"
+#include "CpuFeatures.h"
+#include "DenormalGuard.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+
+
+////////// local helpers
+
+// destination bytes from which stores bypass cache, zero: from cache size
+static std::atomic<size_t> s_nStreamThreshold(0);
+
+// bytes of inputs prefetched ahead of loads in streaming loop:
+// to all cache levels (T0), non-temporal hint (NTA) was much slower
+static const size_t s_nPrefetchDistance = 1024;
+
+static inline bool isAligned16(const void *p)
+{
+	return (((uintptr_t)p & 15) == 0);
+}
+
+template <bool bAligned> static inline sseQuad loadQuad(const float *p)
+{
+	return (bAligned == true) ? sseQuad::load(p) : sseQuad::loadUnaligned(p);
+}
+
+template <bool bAligned> static inline void storeQuad(float *p, const sseQuad &v)
+{
+	if (bAligned == true)
+	{
+		v.store(p);
+	}
+	else
+	{
+		v.storeUnaligned(p);
+	}
+}
+
+// less than four values at end: padded quad in local buffer
+static inline sseQuad loadTail(const float *p, const size_t nCount, const float fPad)
+{
+	alignas(16) float values[4] = {fPad, fPad, fPad, fPad};
+	::memcpy(values, p, nCount * sizeof(float));
+	return sseQuad::load(values);
+}
+
+static inline void storeTail(float *p, const size_t nCount, const sseQuad &v)
+{
+	alignas(16) float values[4];
+	v.store(values);
+	::memcpy(p, values, nCount * sizeof(float));
+}
+
+// dst = op(a, b, c) for nInputs of inputs (others are zero),
+// four quads loaded before storing any so that dst may be same as input
+template <int nInputs, bool bAligned, class Op>
+static void mapQuads(float *pDst, const float *pA, const float *pB, const float *pC, const size_t nCount, const Op &op)
+{
+	sseQuad a[4];
+	sseQuad b[4];
+	sseQuad c[4];
+
+	size_t i = 0;
+	for (; i + 16 <= nCount; i += 16)
+	{
+		for (int k = 0; k < 4; k++)
+		{
+			a[k] = loadQuad<bAligned>(pA + i + 4 * k);
+			if (nInputs >= 2)
+			{
+				b[k] = loadQuad<bAligned>(pB + i + 4 * k);
+			}
+			if (nInputs >= 3)
+			{
+				c[k] = loadQuad<bAligned>(pC + i + 4 * k);
+			}
+		}
+		for (int k = 0; k < 4; k++)
+		{
+			storeQuad<bAligned>(pDst + i + 4 * k, op(a[k], b[k], c[k]));
+		}
+	}
+	for (; i + 4 <= nCount; i += 4)
+	{
+		a[0] = loadQuad<bAligned>(pA + i);
+		if (nInputs >= 2)
+		{
+			b[0] = loadQuad<bAligned>(pB + i);
+		}
+		if (nInputs >= 3)
+		{
+			c[0] = loadQuad<bAligned>(pC + i);
+		}
+		storeQuad<bAligned>(pDst + i, op(a[0], b[0], c[0]));
+	}
+	if (i < nCount)
+	{
+		// note: padding one so that division has no zero divisors
+		const size_t nTail = nCount - i;
+		a[0] = loadTail(pA + i, nTail, 1.0f);
+		if (nInputs >= 2)
+		{
+			b[0] = loadTail(pB + i, nTail, 1.0f);
+		}
+		if (nInputs >= 3)
+		{
+			c[0] = loadTail(pC + i, nTail, 1.0f);
+		}
+		storeTail(pDst + i, nTail, op(a[0], b[0], c[0]));
+	}
+}
+
+// as mapQuads() with non-temporal stores to 16-byte aligned destination,
+// less than four quads at end with normal stores
+template <int nInputs, bool bAligned, class Op>
+static void streamQuads(float *pDst, const float *pA, const float *pB, const float *pC, const size_t nCount, const Op &op)
+{
+	sseQuad a[4];
+	sseQuad b[4];
+	sseQuad c[4];
+
+	// note: prefetch does not fault past end of array
+	size_t i = 0;
+	for (; i + 16 <= nCount; i += 16)
+	{
+		_mm_prefetch((const char*)(pA + i) + s_nPrefetchDistance, _MM_HINT_T0);
+		if (nInputs >= 2)
+		{
+			_mm_prefetch((const char*)(pB + i) + s_nPrefetchDistance, _MM_HINT_T0);
+		}
+		if (nInputs >= 3)
+		{
+			_mm_prefetch((const char*)(pC + i) + s_nPrefetchDistance, _MM_HINT_T0);
+		}
+		for (int k = 0; k < 4; k++)
+		{
+			a[k] = loadQuad<bAligned>(pA + i + 4 * k);
+			if (nInputs >= 2)
+			{
+				b[k] = loadQuad<bAligned>(pB + i + 4 * k);
+			}
+			if (nInputs >= 3)
+			{
+				c[k] = loadQuad<bAligned>(pC + i + 4 * k);
+			}
+		}
+		for (int k = 0; k < 4; k++)
+		{
+			op(a[k], b[k], c[k]).storeStream(pDst + i + 4 * k);
+		}
+	}
+	mapQuads<nInputs, false>(pDst + i, pA + i, (nInputs >= 2) ? pB + i : nullptr, (nInputs >= 3) ? pC + i : nullptr, nCount - i, op);
+	_mm_sfence();
+}
+
+template <int nInputs>
+static bool inputsAligned(const float *pA, const float *pB, const float *pC)
+{
+	bool bAligned = isAligned16(pA);
+	if (nInputs >= 2 && isAligned16(pB) == false)
+	{
+		bAligned = false;
+	}
+	if (nInputs >= 3 && isAligned16(pC) == false)
+	{
+		bAligned = false;
+	}
+	return bAligned;
+}
+
+// streaming or aligned loop by size and pointers
+template <int nInputs, class Op>
+static void mapSelected(float *pDst, const float *pA, const float *pB, const float *pC, const size_t nCount, const Op &op)
+{
+	// streaming needs destination aligned to float
+	// and at least one block of four quads after head
+	size_t nHead = ((16 - ((uintptr_t)pDst & 15)) & 15) / sizeof(float);
+	if (nHead > nCount)
+	{
+		nHead = nCount;
+	}
+	if (nCount * sizeof(float) >= sseArrayStreamThreshold() && ((uintptr_t)pDst & 3) == 0 && nCount >= nHead + 16)
+	{
+		mapQuads<nInputs, false>(pDst, pA, pB, pC, nHead, op);
+		pDst += nHead;
+		pA += nHead;
+		pB = (nInputs >= 2) ? pB + nHead : nullptr;
+		pC = (nInputs >= 3) ? pC + nHead : nullptr;
+
+		if (inputsAligned<nInputs>(pA, pB, pC) == true)
+		{
+			streamQuads<nInputs, true>(pDst, pA, pB, pC, nCount - nHead, op);
+		}
+		else
+		{
+			streamQuads<nInputs, false>(pDst, pA, pB, pC, nCount - nHead, op);
+		}
+		return;
+	}
+
+	if (isAligned16(pDst) == true && inputsAligned<nInputs>(pA, pB, pC) == true)
+	{
+		mapQuads<nInputs, true>(pDst, pA, pB, pC, nCount, op);
+	}
+	else
+	{
+		mapQuads<nInputs, false>(pDst, pA, pB, pC, nCount, op);
+	}
+}
+
+template <int nInputs, class Op>
+static void mapArray(float *pDst, const float *pA, const float *pB, const float *pC, const size_t nCount, const Op &op)
+{
+	denormalRunKernel([&]()
+	{
+		mapSelected<nInputs>(pDst, pA, pB, pC, nCount, op);
+	});
+}
+
+// sum of a * b in four accumulators
+template <bool bAligned>
+static float dotQuads(const float *pA, const float *pB, const size_t nCount)
+{
+	sseQuad sum0;
+	sseQuad sum1;
+	sseQuad sum2;
+	sseQuad sum3;
+
+	size_t i = 0;
+	for (; i + 16 <= nCount; i += 16)
+	{
+		sum0 = fma(loadQuad<bAligned>(pA + i), loadQuad<bAligned>(pB + i), sum0);
+		sum1 = fma(loadQuad<bAligned>(pA + i + 4), loadQuad<bAligned>(pB + i + 4), sum1);
+		sum2 = fma(loadQuad<bAligned>(pA + i + 8), loadQuad<bAligned>(pB + i + 8), sum2);
+		sum3 = fma(loadQuad<bAligned>(pA + i + 12), loadQuad<bAligned>(pB + i + 12), sum3);
+	}
+	for (; i + 4 <= nCount; i += 4)
+	{
+		sum0 = fma(loadQuad<bAligned>(pA + i), loadQuad<bAligned>(pB + i), sum0);
+	}
+	if (i < nCount)
+	{
+		sum1 = fma(loadTail(pA + i, nCount - i, 0.0f), loadTail(pB + i, nCount - i, 0.0f), sum1);
+	}
+	return ((sum0 + sum1) + (sum2 + sum3)).horizontalSum();
+}
+
+
+////////// operations
+
+struct AddOp
+{
+	sseQuad operator()(const sseQuad &a, const sseQuad &b, const sseQuad &) const
+	{
+		return a + b;
+	}
+};
+
+struct SubOp
+{
+	sseQuad operator()(const sseQuad &a, const sseQuad &b, const sseQuad &) const
+	{
+		return a - b;
+	}
+};
+
+struct MulOp
+{
+	sseQuad operator()(const sseQuad &a, const sseQuad &b, const sseQuad &) const
+	{
+		return a * b;
+	}
+};
+
+struct DivOp
+{
+	sseQuad operator()(const sseQuad &a, const sseQuad &b, const sseQuad &) const
+	{
+		return a / b;
+	}
+};
+
+struct FmaOp
+{
+	sseQuad operator()(const sseQuad &a, const sseQuad &b, const sseQuad &c) const
+	{
+		return fma(a, b, c);
+	}
+};
+
+struct ScaleOp
+{
+	sseQuad m_Scale;
+
+	explicit ScaleOp(const float fScale)
+		: m_Scale(fScale)
+	{}
+	sseQuad operator()(const sseQuad &a, const sseQuad &, const sseQuad &) const
+	{
+		return a * m_Scale;
+	}
+};
+
+// a is x, b is y
+struct AxpyOp
+{
+	sseQuad m_Alpha;
+
+	explicit AxpyOp(const float fAlpha)
+		: m_Alpha(fAlpha)
+	{}
+	sseQuad operator()(const sseQuad &a, const sseQuad &b, const sseQuad &) const
+	{
+		return fma(m_Alpha, a, b);
+	}
+};
+
+struct ClampOp
+{
+	sseQuad m_Low;
+	sseQuad m_High;
+
+	ClampOp(const float fLow, const float fHigh)
+		: m_Low(fLow)
+		, m_High(fHigh)
+	{}
+	sseQuad operator()(const sseQuad &a, const sseQuad &, const sseQuad &) const
+	{
+		// minps gives second operand for NaN
+		return (max)(m_Low, (min)(a, m_High));
+	}
+};
+
+
+////////// public methods
+
+void sseArrayAdd(float *pDst, const float *pA, const float *pB, const size_t nCount)
+{
+	mapArray<2>(pDst, pA, pB, nullptr, nCount, AddOp());
+}
+
+void sseArraySub(float *pDst, const float *pA, const float *pB, const size_t nCount)
+{
+	mapArray<2>(pDst, pA, pB, nullptr, nCount, SubOp());
+}
+
+void sseArrayMul(float *pDst, const float *pA, const float *pB, const size_t nCount)
+{
+	mapArray<2>(pDst, pA, pB, nullptr, nCount, MulOp());
+}
+
+void sseArrayDiv(float *pDst, const float *pA, const float *pB, const size_t nCount)
+{
+	mapArray<2>(pDst, pA, pB, nullptr, nCount, DivOp());
+}
+
+void sseArrayFma(float *pDst, const float *pA, const float *pB, const float *pC, const size_t nCount)
+{
+	mapArray<3>(pDst, pA, pB, pC, nCount, FmaOp());
+}
+
+void sseArrayScale(float *pDst, const float *pA, const float fScale, const size_t nCount)
+{
+	mapArray<1>(pDst, pA, nullptr, nullptr, nCount, ScaleOp(fScale));
+}
+
+void sseArrayAxpy(float *pY, const float fAlpha, const float *pX, const size_t nCount)
+{
+	mapArray<2>(pY, pX, pY, nullptr, nCount, AxpyOp(fAlpha));
+}
+
+void sseArrayClamp(float *pDst, const float *pA, const float fLow, const float fHigh, const size_t nCount)
+{
+	mapArray<1>(pDst, pA, nullptr, nullptr, nCount, ClampOp(fLow, fHigh));
+}
+
+float sseArrayDot(const float *pA, const float *pB, const size_t nCount)
+{
+	float fSum = 0.0f;
+	denormalRunKernel([&]()
+	{
+		if (isAligned16(pA) == true && isAligned16(pB) == true)
+		{
+			fSum = dotQuads<true>(pA, pB, nCount);
+		}
+		else
+		{
+			fSum = dotQuads<false>(pA, pB, nCount);
+		}
+	});
+	return fSum;
+}
+
+float sseArrayNorm(const float *pA, const size_t nCount)
+{
+	return ::sqrtf(sseArrayDot(pA, pA, nCount));
+}
+
+void sseArraySetStreamThreshold(const size_t nBytes)
+{
+	s_nStreamThreshold.store(nBytes, std::memory_order_relaxed);
+}
+
+size_t sseArrayStreamThreshold()
+{
+	const size_t nBytes = s_nStreamThreshold.load(std::memory_order_relaxed);
+	if (nBytes != 0)
+	{
+		return nBytes;
+	}
+	// inputs of same size take other half
+	return cpuCacheSizes().m_nLastLevel / 2;
+}
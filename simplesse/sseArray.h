@@ -0,0 +1,77 @@
+/////////////////////////////////////
+//
+// sseArray : kernels over float arrays
+// using sseQuad.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Arrays are plain float buffers (structure of arrays):
+// loop does four quads (16 floats) per iteration,
+// reductions keep four separate accumulators so that
+// additions do not wait for each other (add latency is 3-4 cycles).
+// Less than a quad at end is done as a quad padded in local buffer,
+// so results are same as for elements in middle of array.
+//
+// Buffers should be 16-byte aligned, unaligned buffers
+// work too (with unaligned loads).
+// Destination may be same as source.
+//
+// Kernels writing arrays larger than stream threshold
+// (bytes of destination, default half of last level cache)
+// store past cache (non-temporal stores) and prefetch inputs:
+// faster and leaves cache to other data when result is not
+// read again soon, slower if it is.
+//
+// Kernels run with flush-to-zero when kernel policy of DenormalGuard.h
+// is set to flush, otherwise in mode of calling thread.
+//
+
+#ifndef SSEARRAY_H
+#define SSEARRAY_H
+
+#include <stddef.h>
+
+
+// dst = a + b
+void sseArrayAdd(float *pDst, const float *pA, const float *pB, const size_t nCount);
+
+// dst = a - b
+void sseArraySub(float *pDst, const float *pA, const float *pB, const size_t nCount);
+
+// dst = a * b
+void sseArrayMul(float *pDst, const float *pA, const float *pB, const size_t nCount);
+
+// dst = a / b
+void sseArrayDiv(float *pDst, const float *pA, const float *pB, const size_t nCount);
+
+// dst = a * b + c (fused when built with FMA, see sseQuad::fma())
+void sseArrayFma(float *pDst, const float *pA, const float *pB, const float *pC, const size_t nCount);
+
+// dst = a * scale
+void sseArrayScale(float *pDst, const float *pA, const float fScale, const size_t nCount);
+
+// y = alpha * x + y
+void sseArrayAxpy(float *pY, const float fAlpha, const float *pX, const size_t nCount);
+
+// dst = min(max(a, low), high),
+// NaN gives high (as minps)
+void sseArrayClamp(float *pDst, const float *pA, const float fLow, const float fHigh, const size_t nCount);
+
+// sum of a * b
+float sseArrayDot(const float *pA, const float *pB, const size_t nCount);
+
+// euclidean length: square root of sum of squares
+// (no scaling, squares overflow above 1.8e19)
+float sseArrayNorm(const float *pA, const size_t nCount);
+
+// destination size in bytes from which kernels use non-temporal stores:
+// zero selects default from cache size, SIZE_MAX disables them.
+// note: not synchronized with calls already running in other threads
+void sseArraySetStreamThreshold(const size_t nBytes);
+
+// destination size in bytes from which kernels use non-temporal stores
+size_t sseArrayStreamThreshold();
+
+#endif // SSEARRAY_H
@@ -0,0 +1,185 @@
+// sseArrayBench.cpp : sseArray kernels against plain loops
+// left for compiler to vectorize.
+//
+// usage: sseArrayBench [count]
+//
+// count is array length (default 1M floats: larger than cache),
+// also run for 4096 floats (in L1 cache).
+//
+
+#include "sseArray.h"
+#include "AlignedAllocator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+
+
+static float s_fSink = 0.0f;
+
+static double elapsed(const std::chrono::steady_clock::time_point &start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+////////// plain loops
+
+static void plainAdd(float *pDst, const float *pA, const float *pB, const size_t nCount)
+{
+	for (size_t i = 0; i < nCount; i++)
+	{
+		pDst[i] = pA[i] + pB[i];
+	}
+}
+
+static void plainMul(float *pDst, const float *pA, const float *pB, const size_t nCount)
+{
+	for (size_t i = 0; i < nCount; i++)
+	{
+		pDst[i] = pA[i] * pB[i];
+	}
+}
+
+static void plainDiv(float *pDst, const float *pA, const float *pB, const size_t nCount)
+{
+	for (size_t i = 0; i < nCount; i++)
+	{
+		pDst[i] = pA[i] / pB[i];
+	}
+}
+
+static void plainFma(float *pDst, const float *pA, const float *pB, const float *pC, const size_t nCount)
+{
+	for (size_t i = 0; i < nCount; i++)
+	{
+		pDst[i] = pA[i] * pB[i] + pC[i];
+	}
+}
+
+static void plainAxpy(float *pY, const float fAlpha, const float *pX, const size_t nCount)
+{
+	for (size_t i = 0; i < nCount; i++)
+	{
+		pY[i] = fAlpha * pX[i] + pY[i];
+	}
+}
+
+static void plainClamp(float *pDst, const float *pA, const float fLow, const float fHigh, const size_t nCount)
+{
+	for (size_t i = 0; i < nCount; i++)
+	{
+		const float v = (pA[i] < fHigh) ? pA[i] : fHigh;
+		pDst[i] = (fLow > v) ? fLow : v;
+	}
+}
+
+// note: single accumulator, compiler may not reorder additions
+static float plainDot(const float *pA, const float *pB, const size_t nCount)
+{
+	float sum = 0.0f;
+	for (size_t i = 0; i < nCount; i++)
+	{
+		sum += pA[i] * pB[i];
+	}
+	return sum;
+}
+
+////////// timing
+
+struct BenchArrays
+{
+	float *pA;
+	float *pB;
+	float *pC;
+	float *pDst;
+	size_t nCount;
+};
+
+// elements per nanosecond
+template <class Func> static double timeLoop(const BenchArrays &arrays, const size_t nRounds, const Func &func)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (size_t r = 0; r < nRounds; r++)
+	{
+		func(arrays);
+	}
+	return (double)(arrays.nCount * nRounds) / (elapsed(start) * 1e9);
+}
+
+template <class FuncSse, class FuncPlain> static void benchRow(const char *szName, const BenchArrays &arrays, const size_t nRounds, const FuncSse &funcSse, const FuncPlain &funcPlain)
+{
+	const double dSse = timeLoop(arrays, nRounds, funcSse);
+	const double dPlain = timeLoop(arrays, nRounds, funcPlain);
+	printf("%-8s %10.2f %10.2f %8.2f\n", szName, dSse, dPlain, dSse / dPlain);
+}
+
+static void benchSize(const size_t nCount, const size_t nRounds)
+{
+	AlignedVector<float> a(nCount);
+	AlignedVector<float> b(nCount);
+	AlignedVector<float> c(nCount);
+	AlignedVector<float> dst(nCount);
+
+	BenchArrays arrays;
+	arrays.pA = a.data();
+	arrays.pB = b.data();
+	arrays.pC = c.data();
+	arrays.pDst = dst.data();
+	arrays.nCount = nCount;
+	for (size_t i = 0; i < nCount; i++)
+	{
+		arrays.pA[i] = (float)(i % 17) * 0.25f;
+		arrays.pB[i] = 1.0f + (float)(i % 13) * 0.125f;
+		arrays.pC[i] = (float)(i % 7);
+		arrays.pDst[i] = 0.0f;
+	}
+
+	printf("%zu floats, %zu rounds: elements per ns\n", nCount, nRounds);
+	printf("%-8s %10s %10s %8s\n", "kernel", "sseArray", "plain", "speedup");
+
+	benchRow("add", arrays, nRounds,
+		[](const BenchArrays &x) { sseArrayAdd(x.pDst, x.pA, x.pB, x.nCount); },
+		[](const BenchArrays &x) { plainAdd(x.pDst, x.pA, x.pB, x.nCount); });
+	benchRow("mul", arrays, nRounds,
+		[](const BenchArrays &x) { sseArrayMul(x.pDst, x.pA, x.pB, x.nCount); },
+		[](const BenchArrays &x) { plainMul(x.pDst, x.pA, x.pB, x.nCount); });
+	benchRow("div", arrays, nRounds,
+		[](const BenchArrays &x) { sseArrayDiv(x.pDst, x.pA, x.pB, x.nCount); },
+		[](const BenchArrays &x) { plainDiv(x.pDst, x.pA, x.pB, x.nCount); });
+	benchRow("fma", arrays, nRounds,
+		[](const BenchArrays &x) { sseArrayFma(x.pDst, x.pA, x.pB, x.pC, x.nCount); },
+		[](const BenchArrays &x) { plainFma(x.pDst, x.pA, x.pB, x.pC, x.nCount); });
+	benchRow("axpy", arrays, nRounds,
+		[](const BenchArrays &x) { sseArrayAxpy(x.pDst, 0.5f, x.pA, x.nCount); },
+		[](const BenchArrays &x) { plainAxpy(x.pDst, 0.5f, x.pA, x.nCount); });
+	benchRow("clamp", arrays, nRounds,
+		[](const BenchArrays &x) { sseArrayClamp(x.pDst, x.pA, 0.5f, 2.0f, x.nCount); },
+		[](const BenchArrays &x) { plainClamp(x.pDst, x.pA, 0.5f, 2.0f, x.nCount); });
+	benchRow("dot", arrays, nRounds,
+		[](const BenchArrays &x) { s_fSink += sseArrayDot(x.pA, x.pB, x.nCount); },
+		[](const BenchArrays &x) { s_fSink += plainDot(x.pA, x.pB, x.nCount); });
+	benchRow("norm", arrays, nRounds,
+		[](const BenchArrays &x) { s_fSink += sseArrayNorm(x.pA, x.nCount); },
+		[](const BenchArrays &x) { s_fSink += ::sqrtf(plainDot(x.pA, x.pA, x.nCount)); });
+	printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+	size_t nCount = 1 << 20;
+	if (argc > 1)
+	{
+		nCount = (size_t)::strtoull(argv[1], nullptr, 10);
+	}
+
+	benchSize(4096, 50000);
+	benchSize(nCount, (size_t)200000000 / (nCount + 1) + 1);
+
+	// keep results alive
+	if (s_fSink == 1.0f)
+	{
+		printf("%f\n", s_fSink);
+	}
+	return 0;
+}
@@ -0,0 +1,143 @@
+// sseKernelBench.cpp : sseArray, sseReduce and sseMat4 kernels
+// over array lengths and thread counts, timed by MicroBench.
+//
+// usage: sseKernelBench [max count] [MicroBench options]
+//
+// array lengths are powers of four from 256 floats to max (default 16M),
+// dot product and parallel sum are also run on 1 .. hardware threads
+// on max length.
+// see MicroBench.h for options (--csv, --json, --baseline, ..).
+//
+
+#include "sseArray.h"
+#include "sseMat4.h"
+#include "sseReduce.h"
+#include "AlignedAllocator.h"
+#include "MicroBench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+
+// dot product of array split to threads,
+// partial sums added on calling thread
+static float threadedDot(const float *pA, const float *pB, const size_t nCount, const size_t nThreads)
+{
+	std::vector<float> partial(nThreads, 0.0f);
+	std::vector<std::thread> threads;
+	threads.reserve(nThreads - 1);
+
+	// whole quads per thread
+	const size_t nChunk = ((nCount + nThreads - 1) / nThreads + 3) & ~(size_t)3;
+	for (size_t t = 1; t < nThreads; t++)
+	{
+		const size_t nBegin = (t * nChunk < nCount) ? t * nChunk : nCount;
+		const size_t nEnd = (nBegin + nChunk < nCount) ? nBegin + nChunk : nCount;
+		threads.emplace_back([&partial, pA, pB, t, nBegin, nEnd]() { partial[t] = sseArrayDot(pA + nBegin, pB + nBegin, nEnd - nBegin); });
+	}
+	partial[0] = sseArrayDot(pA, pB, (nChunk < nCount) ? nChunk : nCount);
+
+	float sum = 0.0f;
+	for (size_t t = 0; t < threads.size(); t++)
+	{
+		threads[t].join();
+	}
+	for (size_t t = 0; t < nThreads; t++)
+	{
+		sum += partial[t];
+	}
+	return sum;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t nMaxCount = (size_t)1 << 24;
+	if (argc > 1 && argv[1][0] != '-')
+	{
+		nMaxCount = (size_t)::strtoull(argv[1], nullptr, 10);
+	}
+
+	MicroBench bench;
+	if (bench.parseArgs(argc, argv) == false)
+	{
+		fprintf(stderr, "invalid options\n");
+		return 1;
+	}
+
+	AlignedVector<float> a(nMaxCount);
+	AlignedVector<float> b(nMaxCount);
+	AlignedVector<float> c(nMaxCount);
+	AlignedVector<float> dst(nMaxCount);
+	for (size_t i = 0; i < nMaxCount; i++)
+	{
+		a[i] = (float)(i % 17) * 0.25f;
+		b[i] = 1.0f + (float)(i % 13) * 0.125f;
+		c[i] = (float)(i % 7);
+		dst[i] = 0.0f;
+	}
+
+	std::vector<size_t> lengths;
+	for (size_t n = 256; n <= nMaxCount; n *= 4)
+	{
+		lengths.push_back(n);
+	}
+	auto floats = [](const size_t n) { return n; };
+
+	bench.sweep("sseArrayAdd", "count", lengths,
+		[&](const size_t n) { sseArrayAdd(dst.data(), a.data(), b.data(), n); }, floats);
+	bench.sweep("sseArrayMul", "count", lengths,
+		[&](const size_t n) { sseArrayMul(dst.data(), a.data(), b.data(), n); }, floats);
+	bench.sweep("sseArrayFma", "count", lengths,
+		[&](const size_t n) { sseArrayFma(dst.data(), a.data(), b.data(), c.data(), n); }, floats);
+	bench.sweep("sseArrayAxpy", "count", lengths,
+		[&](const size_t n) { sseArrayAxpy(dst.data(), 0.5f, a.data(), n); }, floats);
+	bench.sweep("sseArrayDot", "count", lengths,
+		[&](const size_t n) { microBenchKeep(sseArrayDot(a.data(), b.data(), n)); }, floats);
+
+	bench.sweep("sseReduceSum", "count", lengths,
+		[&](const size_t n) { microBenchKeep(sseReduceSum(a.data(), n)); }, floats);
+	bench.sweep("sseReduceSumPairwise", "count", lengths,
+		[&](const size_t n) { microBenchKeep(sseReduceSumPairwise(a.data(), n)); }, floats);
+	bench.sweep("sseReduceSumKahan", "count", lengths,
+		[&](const size_t n) { microBenchKeep(sseReduceSumKahan(a.data(), n)); }, floats);
+	bench.sweep("sseReduceMax", "count", lengths,
+		[&](const size_t n) { microBenchKeep(sseReduceMax(a.data(), n)); }, floats);
+	bench.sweep("sseReduceArgMax", "count", lengths,
+		[&](const size_t n) { microBenchKeep(sseReduceArgMax(a.data(), n)); }, floats);
+
+	// points in three arrays, results in thirds of fourth array
+	const float matrix[16] = {
+		0.8f, -0.6f, 0.0f, 1.5f,
+		0.6f, 0.8f, 0.0f, -2.0f,
+		0.0f, 0.0f, 1.0f, 0.25f,
+		0.0f, 0.0f, 0.0f, 1.0f };
+	const sseMat4 m(matrix);
+	std::vector<size_t> points;
+	for (size_t i = 0; i < lengths.size() && lengths[i] <= nMaxCount / 3; i++)
+	{
+		points.push_back(lengths[i]);
+	}
+	bench.sweep("sseTransformPointsSoA", "count", points,
+		[&](const size_t n) { sseTransformPointsSoA(m, a.data(), b.data(), c.data(), dst.data(), dst.data() + n, dst.data() + 2 * n, n); }, floats);
+
+	std::vector<size_t> threadCounts;
+	const size_t nHardware = (std::thread::hardware_concurrency() > 0) ? std::thread::hardware_concurrency() : 1;
+	for (size_t n = 1; n <= nHardware; n *= 2)
+	{
+		threadCounts.push_back(n);
+	}
+	if (threadCounts.back() != nHardware)
+	{
+		threadCounts.push_back(nHardware);
+	}
+	bench.sweep("threadedDot", "threads", threadCounts,
+		[&](const size_t nThreads) { microBenchKeep(threadedDot(a.data(), b.data(), nMaxCount, nThreads)); },
+		[nMaxCount](const size_t) { return nMaxCount; });
+	bench.sweep("sseReduceSumParallel", "threads", threadCounts,
+		[&](const size_t nThreads) { microBenchKeep(sseReduceSumParallel(a.data(), nMaxCount, nThreads)); },
+		[nMaxCount](const size_t) { return nMaxCount; });
+
+	return (bench.report() == true) ? 0 : 1;
+}
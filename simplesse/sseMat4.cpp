@@ -0,0 +1,341 @@
+/////////////////////////////////////
+//
+// sseMat4 : 4x4 float matrix as four sseQuad rows,
+// batched transform of points.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Inverse is by 2x2 blocks: each block of four floats fits one register,
+// adjugates and determinants of blocks need only shuffles,
+// multiplies and subtractions (no division until the end).
+//
+
+#include "sseMat4.h"
+#include "TaskPool.h"
+
+#include <string.h>
+
+
+////////// local helpers
+
+// lanes of two registers: (a[x], a[y], b[z], b[w])
+#define SSEMAT4_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps((a), (b), _MM_SHUFFLE(w, z, y, x))
+
+// minimum points per task in batches
+static const size_t s_nPointsPerTask = 1 << 16;
+
+template <int nLane> static inline __m128 splat(const __m128 v)
+{
+	return _mm_shuffle_ps(v, v, _MM_SHUFFLE(nLane, nLane, nLane, nLane));
+}
+
+static inline void transpose4(__m128 &r0, __m128 &r1, __m128 &r2, __m128 &r3)
+{
+	const __m128 t0 = _mm_unpacklo_ps(r0, r1); // r00 r10 r01 r11
+	const __m128 t1 = _mm_unpacklo_ps(r2, r3); // r20 r30 r21 r31
+	const __m128 t2 = _mm_unpackhi_ps(r0, r1); // r02 r12 r03 r13
+	const __m128 t3 = _mm_unpackhi_ps(r2, r3); // r22 r32 r23 r33
+	r0 = _mm_movelh_ps(t0, t1);
+	r1 = _mm_movehl_ps(t1, t0);
+	r2 = _mm_movelh_ps(t2, t3);
+	r3 = _mm_movehl_ps(t3, t2);
+}
+
+// 2x2 blocks are row-major in register: (a b c d) is | a b |
+//                                                     | c d |
+// P * Q
+static inline __m128 mat2Mul(const __m128 p, const __m128 q)
+{
+	return _mm_add_ps(_mm_mul_ps(p, SSEMAT4_SHUFFLE(q, q, 0, 3, 0, 3)),
+		_mm_mul_ps(SSEMAT4_SHUFFLE(p, p, 1, 0, 3, 2), SSEMAT4_SHUFFLE(q, q, 2, 1, 2, 1)));
+}
+
+// adj(P) * Q
+static inline __m128 mat2AdjMul(const __m128 p, const __m128 q)
+{
+	return _mm_sub_ps(_mm_mul_ps(SSEMAT4_SHUFFLE(p, p, 3, 3, 0, 0), q),
+		_mm_mul_ps(SSEMAT4_SHUFFLE(p, p, 1, 1, 2, 2), SSEMAT4_SHUFFLE(q, q, 2, 3, 0, 1)));
+}
+
+// P * adj(Q)
+static inline __m128 mat2MulAdj(const __m128 p, const __m128 q)
+{
+	return _mm_sub_ps(_mm_mul_ps(p, SSEMAT4_SHUFFLE(q, q, 3, 0, 3, 0)),
+		_mm_mul_ps(SSEMAT4_SHUFFLE(p, p, 1, 0, 3, 2), SSEMAT4_SHUFFLE(q, q, 2, 1, 2, 1)));
+}
+
+// matrix M = | A B | of 2x2 blocks:
+//            | C D |
+// adjugates of blocks of inverse (X#, Y#, Z#, W#) scaled by |M|,
+// and determinant |M| in all lanes
+static void blockInverse(const sseQuad *pRows, __m128 &x, __m128 &y, __m128 &z, __m128 &w, __m128 &det)
+{
+	const __m128 r0 = pRows[0].get();
+	const __m128 r1 = pRows[1].get();
+	const __m128 r2 = pRows[2].get();
+	const __m128 r3 = pRows[3].get();
+
+	const __m128 a = _mm_movelh_ps(r0, r1);
+	const __m128 b = _mm_movehl_ps(r1, r0);
+	const __m128 c = _mm_movelh_ps(r2, r3);
+	const __m128 d = _mm_movehl_ps(r3, r2);
+
+	// (|A| |B| |C| |D|)
+	const __m128 detSub = _mm_sub_ps(
+		_mm_mul_ps(SSEMAT4_SHUFFLE(r0, r2, 0, 2, 0, 2), SSEMAT4_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+		_mm_mul_ps(SSEMAT4_SHUFFLE(r0, r2, 1, 3, 1, 3), SSEMAT4_SHUFFLE(r1, r3, 0, 2, 0, 2)));
+	const __m128 detA = splat<0>(detSub);
+	const __m128 detB = splat<1>(detSub);
+	const __m128 detC = splat<2>(detSub);
+	const __m128 detD = splat<3>(detSub);
+
+	const __m128 dc = mat2AdjMul(d, c);
+	const __m128 ab = mat2AdjMul(a, b);
+
+	// X# = |D|A - B(D#C), W# = |A|D - C(A#B)
+	x = _mm_sub_ps(_mm_mul_ps(detD, a), mat2Mul(b, dc));
+	w = _mm_sub_ps(_mm_mul_ps(detA, d), mat2Mul(c, ab));
+	// Y# = |B|C - D(A#B)#, Z# = |C|B - A(D#C)#
+	y = _mm_sub_ps(_mm_mul_ps(detB, c), mat2MulAdj(d, ab));
+	z = _mm_sub_ps(_mm_mul_ps(detC, b), mat2MulAdj(a, dc));
+
+	// |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+	__m128 trace = _mm_mul_ps(ab, SSEMAT4_SHUFFLE(dc, dc, 0, 2, 1, 3));
+	trace = _mm_add_ps(trace, _mm_movehl_ps(trace, trace));
+	trace = _mm_add_ps(trace, splat<1>(trace));
+	det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), splat<0>(trace));
+}
+
+// tasks over ranges of points when batch is large enough,
+// ranges are in multiples of four points
+template <class Func> static void forRanges(const size_t nCount, const Func &func)
+{
+	if (nCount < 2 * s_nPointsPerTask)
+	{
+		func((size_t)0, nCount);
+		return;
+	}
+
+	const size_t nQuads = (nCount + 3) / 4;
+	parallelFor(0, nQuads, s_nPointsPerTask / 4, [&func, nCount](const size_t nBegin, const size_t nEnd)
+	{
+		func(4 * nBegin, (4 * nEnd < nCount) ? 4 * nEnd : nCount);
+	});
+}
+
+// less than four values at end: padded quad in local buffer
+static inline sseQuad loadTail(const float *p, const size_t nCount)
+{
+	alignas(16) float values[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+	::memcpy(values, p, nCount * sizeof(float));
+	return sseQuad::load(values);
+}
+
+static inline void storeTail(float *p, const size_t nCount, const sseQuad &v)
+{
+	alignas(16) float values[4];
+	v.store(values);
+	::memcpy(p, values, nCount * sizeof(float));
+}
+
+// elements of first three rows broadcast to quads, held in registers over batch
+struct SoAMatrix
+{
+	sseQuad m_Elements[3][4];
+
+	explicit SoAMatrix(const sseMat4 &matrix)
+	{
+		for (int r = 0; r < 3; r++)
+		{
+			alignas(16) float values[4];
+			matrix.row(r).store(values);
+			for (int c = 0; c < 4; c++)
+			{
+				m_Elements[r][c] = sseQuad(values[c]);
+			}
+		}
+	}
+
+	// one output coordinate for four points
+	sseQuad row(const int r, const sseQuad &x, const sseQuad &y, const sseQuad &z) const
+	{
+		return fma(m_Elements[r][0], x, fma(m_Elements[r][1], y, fma(m_Elements[r][2], z, m_Elements[r][3])));
+	}
+};
+
+static void transformSoARange(const sseMat4 &matrix, const float *pX, const float *pY, const float *pZ, float *pOutX, float *pOutY, float *pOutZ, const size_t nBegin, const size_t nEnd)
+{
+	const SoAMatrix m(matrix);
+
+	size_t i = nBegin;
+	for (; i + 4 <= nEnd; i += 4)
+	{
+		const sseQuad x = sseQuad::loadUnaligned(pX + i);
+		const sseQuad y = sseQuad::loadUnaligned(pY + i);
+		const sseQuad z = sseQuad::loadUnaligned(pZ + i);
+		m.row(0, x, y, z).storeUnaligned(pOutX + i);
+		m.row(1, x, y, z).storeUnaligned(pOutY + i);
+		m.row(2, x, y, z).storeUnaligned(pOutZ + i);
+	}
+	if (i < nEnd)
+	{
+		const size_t nTail = nEnd - i;
+		const sseQuad x = loadTail(pX + i, nTail);
+		const sseQuad y = loadTail(pY + i, nTail);
+		const sseQuad z = loadTail(pZ + i, nTail);
+		storeTail(pOutX + i, nTail, m.row(0, x, y, z));
+		storeTail(pOutY + i, nTail, m.row(1, x, y, z));
+		storeTail(pOutZ + i, nTail, m.row(2, x, y, z));
+	}
+}
+
+// columns of matrix: p' = c0 * x + c1 * y + c2 * z + c3 * w
+static inline sseQuad transformColumns(const sseQuad &c0, const sseQuad &c1, const sseQuad &c2, const sseQuad &c3, const __m128 p)
+{
+	return fma(c0, sseQuad(splat<0>(p)), fma(c1, sseQuad(splat<1>(p)), fma(c2, sseQuad(splat<2>(p)), c3 * sseQuad(splat<3>(p)))));
+}
+
+static void transformAoSRange(const sseMat4 &matrix, const float *pPoints, float *pOut, const size_t nBegin, const size_t nEnd)
+{
+	const sseMat4 columns = matrix.transposed();
+	const sseQuad c0 = columns.row(0);
+	const sseQuad c1 = columns.row(1);
+	const sseQuad c2 = columns.row(2);
+	const sseQuad c3 = columns.row(3);
+
+	size_t i = nBegin;
+	for (; i + 2 <= nEnd; i += 2)
+	{
+		const __m128 p0 = _mm_loadu_ps(pPoints + 4 * i);
+		const __m128 p1 = _mm_loadu_ps(pPoints + 4 * i + 4);
+		transformColumns(c0, c1, c2, c3, p0).storeUnaligned(pOut + 4 * i);
+		transformColumns(c0, c1, c2, c3, p1).storeUnaligned(pOut + 4 * i + 4);
+	}
+	if (i < nEnd)
+	{
+		transformColumns(c0, c1, c2, c3, _mm_loadu_ps(pPoints + 4 * i)).storeUnaligned(pOut + 4 * i);
+	}
+}
+
+
+////////// public methods
+
+sseMat4::sseMat4()
+{
+	m_Rows[0] = sseQuad(1.0f, 0.0f, 0.0f, 0.0f);
+	m_Rows[1] = sseQuad(0.0f, 1.0f, 0.0f, 0.0f);
+	m_Rows[2] = sseQuad(0.0f, 0.0f, 1.0f, 0.0f);
+	m_Rows[3] = sseQuad(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+sseMat4::sseMat4(const sseQuad &row0, const sseQuad &row1, const sseQuad &row2, const sseQuad &row3)
+{
+	m_Rows[0] = row0;
+	m_Rows[1] = row1;
+	m_Rows[2] = row2;
+	m_Rows[3] = row3;
+}
+
+sseMat4::sseMat4(const float *pValues)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		m_Rows[i] = sseQuad::loadUnaligned(pValues + 4 * i);
+	}
+}
+
+void sseMat4::store(float *pValues) const
+{
+	for (int i = 0; i < 4; i++)
+	{
+		m_Rows[i].storeUnaligned(pValues + 4 * i);
+	}
+}
+
+// row i of result is sum over k of this[i][k] * other row k
+sseMat4 sseMat4::operator * (const sseMat4 &other) const
+{
+	sseMat4 result;
+	for (int i = 0; i < 4; i++)
+	{
+		const __m128 r = m_Rows[i].get();
+		sseQuad sum = sseQuad(splat<3>(r)) * other.m_Rows[3];
+		sum = fma(sseQuad(splat<2>(r)), other.m_Rows[2], sum);
+		sum = fma(sseQuad(splat<1>(r)), other.m_Rows[1], sum);
+		result.m_Rows[i] = fma(sseQuad(splat<0>(r)), other.m_Rows[0], sum);
+	}
+	return result;
+}
+
+sseMat4& sseMat4::operator *= (const sseMat4 &other)
+{
+	*this = *this * other;
+	return *this;
+}
+
+sseQuad sseMat4::transform(const sseQuad &point) const
+{
+	const sseMat4 columns = transposed();
+	return transformColumns(columns.m_Rows[0], columns.m_Rows[1], columns.m_Rows[2], columns.m_Rows[3], point.get());
+}
+
+sseMat4 sseMat4::transposed() const
+{
+	__m128 r0 = m_Rows[0].get();
+	__m128 r1 = m_Rows[1].get();
+	__m128 r2 = m_Rows[2].get();
+	__m128 r3 = m_Rows[3].get();
+	transpose4(r0, r1, r2, r3);
+	return sseMat4(r0, r1, r2, r3);
+}
+
+bool sseMat4::inverse(sseMat4 &result) const
+{
+	__m128 x, y, z, w, det;
+	blockInverse(m_Rows, x, y, z, w, det);
+
+	const float fDet = _mm_cvtss_f32(det);
+	if (fDet == 0.0f || fDet != fDet)
+	{
+		return false;
+	}
+
+	// signs of adjugate with division by determinant
+	const __m128 scale = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+	x = _mm_mul_ps(x, scale);
+	y = _mm_mul_ps(y, scale);
+	z = _mm_mul_ps(z, scale);
+	w = _mm_mul_ps(w, scale);
+
+	// adjugate of each block (swap diagonal) while placing them in rows
+	result.m_Rows[0] = SSEMAT4_SHUFFLE(x, y, 3, 1, 3, 1);
+	result.m_Rows[1] = SSEMAT4_SHUFFLE(x, y, 2, 0, 2, 0);
+	result.m_Rows[2] = SSEMAT4_SHUFFLE(z, w, 3, 1, 3, 1);
+	result.m_Rows[3] = SSEMAT4_SHUFFLE(z, w, 2, 0, 2, 0);
+	return true;
+}
+
+float sseMat4::determinant() const
+{
+	__m128 x, y, z, w, det;
+	blockInverse(m_Rows, x, y, z, w, det);
+	return _mm_cvtss_f32(det);
+}
+
+void sseTransformPointsSoA(const sseMat4 &matrix, const float *pX, const float *pY, const float *pZ, float *pOutX, float *pOutY, float *pOutZ, const size_t nCount)
+{
+	forRanges(nCount, [&](const size_t nBegin, const size_t nEnd)
+	{
+		transformSoARange(matrix, pX, pY, pZ, pOutX, pOutY, pOutZ, nBegin, nEnd);
+	});
+}
+
+void sseTransformPointsAoS(const sseMat4 &matrix, const float *pPoints, float *pOut, const size_t nCount)
+{
+	forRanges(nCount, [&](const size_t nBegin, const size_t nEnd)
+	{
+		transformAoSRange(matrix, pPoints, pOut, nBegin, nEnd);
+	});
+}
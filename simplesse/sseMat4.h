@@ -0,0 +1,84 @@
+/////////////////////////////////////
+//
+// sseMat4 : 4x4 float matrix as four sseQuad rows,
+// batched transform of points.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Matrix is row-major and multiplies column vectors (p' = M * p),
+// translation is in fourth column.
+//
+// Batch transforms load the matrix to registers once
+// and stream points through them:
+// SoA takes separate x, y, z arrays (w is one, fourth row is not used)
+// and does four points per quad, AoS takes points of four floats (x, y, z, w).
+// Large batches are split to tasks of current pool (TaskPool.h),
+// workers run in denormal mode of calling thread.
+//
+
+#ifndef SSEMAT4_H
+#define SSEMAT4_H
+
+#include "sseQuad.h"
+
+#include <stddef.h>
+
+
+class sseMat4
+{
+protected:
+	sseQuad m_Rows[4];
+
+public:
+	// identity
+	sseMat4();
+	sseMat4(const sseQuad &row0, const sseQuad &row1, const sseQuad &row2, const sseQuad &row3);
+	// 16 floats in row-major order, no alignment needed
+	explicit sseMat4(const float *pValues);
+
+	static sseMat4 identity()
+	{
+		return sseMat4();
+	}
+
+	const sseQuad& row(const int nRow) const
+	{
+		return m_Rows[nRow & 3];
+	}
+	void setRow(const int nRow, const sseQuad &value)
+	{
+		m_Rows[nRow & 3] = value;
+	}
+	// through memory, not for inner loops
+	float get(const int nRow, const int nColumn) const
+	{
+		return m_Rows[nRow & 3][nColumn];
+	}
+
+	// 16 floats in row-major order
+	void store(float *pValues) const;
+
+	sseMat4 operator * (const sseMat4 &other) const;
+	sseMat4& operator *= (const sseMat4 &other);
+
+	// M * p
+	sseQuad transform(const sseQuad &point) const;
+
+	sseMat4 transposed() const;
+
+	// false if matrix is singular (result is left unchanged)
+	bool inverse(sseMat4 &result) const;
+	float determinant() const;
+};
+
+// out = M * (x, y, z, 1) for separate coordinate arrays:
+// output may be same as input
+void sseTransformPointsSoA(const sseMat4 &matrix, const float *pX, const float *pY, const float *pZ, float *pOutX, float *pOutY, float *pOutZ, const size_t nCount);
+
+// out = M * p for points of four floats (x, y, z, w):
+// output may be same as input
+void sseTransformPointsAoS(const sseMat4 &matrix, const float *pPoints, float *pOut, const size_t nCount);
+
+#endif // SSEMAT4_H
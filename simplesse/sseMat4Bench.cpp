@@ -0,0 +1,124 @@
+// sseMat4Bench.cpp : batched point transform by sseMat4
+// against scalar loop.
+//
+// usage: sseMat4Bench [count]
+//
+// count is number of points (default 4M),
+// batches of 128k points or more are split to tasks of shared pool.
+//
+
+#include "sseMat4.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+
+static double elapsed(const std::chrono::steady_clock::time_point &start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// p' = M * (x, y, z, 1) one point at a time
+static void scalarTransformSoA(const float *pMatrix, const float *pX, const float *pY, const float *pZ, float *pOutX, float *pOutY, float *pOutZ, const size_t nCount)
+{
+	for (size_t i = 0; i < nCount; i++)
+	{
+		const float x = pX[i];
+		const float y = pY[i];
+		const float z = pZ[i];
+		pOutX[i] = pMatrix[0] * x + pMatrix[1] * y + pMatrix[2] * z + pMatrix[3];
+		pOutY[i] = pMatrix[4] * x + pMatrix[5] * y + pMatrix[6] * z + pMatrix[7];
+		pOutZ[i] = pMatrix[8] * x + pMatrix[9] * y + pMatrix[10] * z + pMatrix[11];
+	}
+}
+
+static void scalarTransformAoS(const float *pMatrix, const float *pPoints, float *pOut, const size_t nCount)
+{
+	for (size_t i = 0; i < nCount; i++)
+	{
+		const float *p = pPoints + 4 * i;
+		float *pResult = pOut + 4 * i;
+		for (int r = 0; r < 4; r++)
+		{
+			pResult[r] = pMatrix[4 * r] * p[0] + pMatrix[4 * r + 1] * p[1] + pMatrix[4 * r + 2] * p[2] + pMatrix[4 * r + 3] * p[3];
+		}
+	}
+}
+
+static void printRow(const char *szName, const size_t nPoints, const double dFast, const double dScalar)
+{
+	printf("%-6s %12.1f %12.1f %8.2f\n", szName, (double)nPoints / dFast * 1e-6, (double)nPoints / dScalar * 1e-6, dScalar / dFast);
+}
+
+int main(int argc, char *argv[])
+{
+	size_t nCount = 1 << 22;
+	if (argc > 1)
+	{
+		nCount = (size_t)::strtoull(argv[1], nullptr, 10);
+	}
+	const size_t nRounds = (nCount < (1 << 22)) ? (size_t)(1 << 25) / (nCount + 1) + 1 : 10;
+
+	const float matrix[16] = {
+		0.8f, -0.6f, 0.0f, 1.5f,
+		0.6f, 0.8f, 0.0f, -2.0f,
+		0.0f, 0.0f, 1.0f, 0.25f,
+		0.0f, 0.0f, 0.0f, 1.0f };
+	const sseMat4 m(matrix);
+
+	std::vector<float> x(nCount);
+	std::vector<float> y(nCount);
+	std::vector<float> z(nCount);
+	std::vector<float> points(4 * nCount);
+	for (size_t i = 0; i < nCount; i++)
+	{
+		x[i] = (float)(i % 1000) * 0.01f;
+		y[i] = (float)(i % 777) * 0.02f;
+		z[i] = (float)(i % 333) * 0.03f;
+		points[4 * i] = x[i];
+		points[4 * i + 1] = y[i];
+		points[4 * i + 2] = z[i];
+		points[4 * i + 3] = 1.0f;
+	}
+	std::vector<float> outX(nCount);
+	std::vector<float> outY(nCount);
+	std::vector<float> outZ(nCount);
+	std::vector<float> out(4 * nCount);
+
+	printf("%zu points, %u hardware threads: million points per second\n", nCount, std::thread::hardware_concurrency());
+	printf("%-6s %12s %12s %8s\n", "layout", "sseMat4", "scalar", "speedup");
+
+	auto start = std::chrono::steady_clock::now();
+	for (size_t r = 0; r < nRounds; r++)
+	{
+		sseTransformPointsSoA(m, x.data(), y.data(), z.data(), outX.data(), outY.data(), outZ.data(), nCount);
+	}
+	const double dSoA = elapsed(start);
+
+	start = std::chrono::steady_clock::now();
+	for (size_t r = 0; r < nRounds; r++)
+	{
+		scalarTransformSoA(matrix, x.data(), y.data(), z.data(), outX.data(), outY.data(), outZ.data(), nCount);
+	}
+	const double dScalarSoA = elapsed(start);
+	printRow("SoA", nCount * nRounds, dSoA, dScalarSoA);
+
+	start = std::chrono::steady_clock::now();
+	for (size_t r = 0; r < nRounds; r++)
+	{
+		sseTransformPointsAoS(m, points.data(), out.data(), nCount);
+	}
+	const double dAoS = elapsed(start);
+
+	start = std::chrono::steady_clock::now();
+	for (size_t r = 0; r < nRounds; r++)
+	{
+		scalarTransformAoS(matrix, points.data(), out.data(), nCount);
+	}
+	const double dScalarAoS = elapsed(start);
+	printRow("AoS", nCount * nRounds, dAoS, dScalarAoS);
+	return 0;
+}
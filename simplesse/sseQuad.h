@@ -0,0 +1,188 @@
+/////////////////////////////////////
+//
+// sseQuad : four packed floats in SSE register.
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Header-only, intrinsics instead of inline assembly
+// so that same code builds with MSVC, GCC and Clang
+// (x86 and x64) and compiler can keep values in registers
+// across operations and schedule them (__asm blocks
+// force a store to memory and prevent optimization around them).
+//
+// fma() uses fused multiply-add when compiled with FMA enabled
+// (-mfma or -march=haswell and later, /arch:AVX2),
+// otherwise separate multiply and add (rounded twice).
+//
+
+#ifndef SSEQUAD_H
+#define SSEQUAD_H
+
+#include <immintrin.h>
+
+
+class sseQuad
+{
+protected:
+	alignas(16) __m128 m_v;
+
+public:
+	// zero
+	sseQuad()
+		: m_v(_mm_setzero_ps())
+	{}
+	// same value in all lanes
+	explicit sseQuad(const float f)
+		: m_v(_mm_set1_ps(f))
+	{}
+	// lanes in memory order (f1 is lowest)
+	sseQuad(const float f1, const float f2, const float f3, const float f4)
+		: m_v(_mm_setr_ps(f1, f2, f3, f4))
+	{}
+	// four floats, no alignment needed
+	explicit sseQuad(const float *pf)
+		: m_v(_mm_loadu_ps(pf))
+	{}
+	sseQuad(const __m128 v)
+		: m_v(v)
+	{}
+
+	// pointer must be 16-byte aligned
+	static sseQuad load(const float *pf)
+	{
+		return sseQuad(_mm_load_ps(pf));
+	}
+	static sseQuad loadUnaligned(const float *pf)
+	{
+		return sseQuad(_mm_loadu_ps(pf));
+	}
+	// pointer must be 16-byte aligned
+	void store(float *pf) const
+	{
+		_mm_store_ps(pf, m_v);
+	}
+	void storeUnaligned(float *pf) const
+	{
+		_mm_storeu_ps(pf, m_v);
+	}
+	// non-temporal store past cache, pointer must be 16-byte aligned:
+	// ordered with other stores only after _mm_sfence()
+	void storeStream(float *pf) const
+	{
+		_mm_stream_ps(pf, m_v);
+	}
+
+	__m128 get() const
+	{
+		return m_v;
+	}
+	operator __m128() const
+	{
+		return m_v;
+	}
+
+	// single lane (through memory, not for inner loops)
+	float operator [] (const int nIndex) const
+	{
+		alignas(16) float f[4];
+		_mm_store_ps(f, m_v);
+		return f[nIndex & 3];
+	}
+
+	sseQuad& operator += (const sseQuad &other)
+	{
+		m_v = _mm_add_ps(m_v, other.m_v);
+		return *this;
+	}
+	sseQuad& operator -= (const sseQuad &other)
+	{
+		m_v = _mm_sub_ps(m_v, other.m_v);
+		return *this;
+	}
+	sseQuad& operator *= (const sseQuad &other)
+	{
+		m_v = _mm_mul_ps(m_v, other.m_v);
+		return *this;
+	}
+	sseQuad& operator /= (const sseQuad &other)
+	{
+		m_v = _mm_div_ps(m_v, other.m_v);
+		return *this;
+	}
+
+	sseQuad operator + (const sseQuad &other) const
+	{
+		return sseQuad(_mm_add_ps(m_v, other.m_v));
+	}
+	sseQuad operator - (const sseQuad &other) const
+	{
+		return sseQuad(_mm_sub_ps(m_v, other.m_v));
+	}
+	sseQuad operator * (const sseQuad &other) const
+	{
+		return sseQuad(_mm_mul_ps(m_v, other.m_v));
+	}
+	sseQuad operator / (const sseQuad &other) const
+	{
+		return sseQuad(_mm_div_ps(m_v, other.m_v));
+	}
+	// flip sign bits (negative zero stays negative zero of other sign)
+	sseQuad operator - () const
+	{
+		return sseQuad(_mm_xor_ps(m_v, _mm_set1_ps(-0.0f)));
+	}
+
+	// lane-wise minimum and maximum:
+	// second operand is returned if either is NaN (as minps/maxps).
+	// note: parentheses keep min/max macros of windows.h from expanding
+	static sseQuad (min)(const sseQuad &a, const sseQuad &b)
+	{
+		return sseQuad(_mm_min_ps(a.m_v, b.m_v));
+	}
+	static sseQuad (max)(const sseQuad &a, const sseQuad &b)
+	{
+		return sseQuad(_mm_max_ps(a.m_v, b.m_v));
+	}
+
+	// a * b + c
+	static sseQuad fma(const sseQuad &a, const sseQuad &b, const sseQuad &c)
+	{
+#if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+		return sseQuad(_mm_fmadd_ps(a.m_v, b.m_v, c.m_v));
+#else
+		return sseQuad(_mm_add_ps(_mm_mul_ps(a.m_v, b.m_v), c.m_v));
+#endif
+	}
+
+	static sseQuad sqrt(const sseQuad &a)
+	{
+		return sseQuad(_mm_sqrt_ps(a.m_v));
+	}
+
+	// sum of lanes
+	float horizontalSum() const
+	{
+		__m128 shuffled = _mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(2, 3, 0, 1));
+		__m128 sums = _mm_add_ps(m_v, shuffled);
+		shuffled = _mm_movehl_ps(shuffled, sums);
+		sums = _mm_add_ss(sums, shuffled);
+		return _mm_cvtss_f32(sums);
+	}
+};
+
+inline sseQuad (min)(const sseQuad &a, const sseQuad &b)
+{
+	return (sseQuad::min)(a, b);
+}
+inline sseQuad (max)(const sseQuad &a, const sseQuad &b)
+{
+	return (sseQuad::max)(a, b);
+}
+inline sseQuad fma(const sseQuad &a, const sseQuad &b, const sseQuad &c)
+{
+	return sseQuad::fma(a, b, c);
+}
+
+#endif // SSEQUAD_H
@@ -0,0 +1,539 @@
+/////////////////////////////////////
+//
+// sseReduce : horizontal reductions of float arrays
+// (sum, minimum, maximum and their positions).
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Kernels are written once over lane traits (SSE2 or AVX2 registers),
+// selected at compile time as in SimdVec.
+// Loads are unaligned: movups costs same as movaps on aligned data
+// (since Nehalem) and reductions have no stores to align.
+//
+// Lanes are combined by shuffle tree (movhlps, shufps):
+// haddps decodes to two shuffles and add,
+// so it saves no work and has longer latency.
+//
+// Positions are tracked in parallel integer lanes:
+// each lane keeps its best value and index of it,
+// strict comparison keeps first one in lane, ties between lanes
+// are settled by smaller index.
+//
+
+#include "sseReduce.h"
+#include "TaskPool.h"
+
+#include <immintrin.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE4_1__) || (defined(_MSC_VER) && defined(__AVX__))
+#define SSEREDUCE_BLENDV
+#endif
+
+
+////////// lanes
+
+struct ReduceLanes4
+{
+	typedef __m128 Register;
+	typedef __m128i Index;
+	static const size_t Lanes = 4;
+
+	static Register set1(const float f) { return _mm_set1_ps(f); }
+	static Register load(const float *p) { return _mm_loadu_ps(p); }
+	static void store(float *p, const Register a) { _mm_storeu_ps(p, a); }
+
+	static Register add(const Register a, const Register b) { return _mm_add_ps(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm_sub_ps(a, b); }
+	// second operand if either is NaN
+	static Register (min)(const Register a, const Register b) { return _mm_min_ps(a, b); }
+	static Register (max)(const Register a, const Register b) { return _mm_max_ps(a, b); }
+
+	// all bits set in lanes where true, false for NaN
+	static Register greater(const Register a, const Register b) { return _mm_cmpgt_ps(a, b); }
+	static Register less(const Register a, const Register b) { return _mm_cmplt_ps(a, b); }
+
+	// lanes of b where mask is set, otherwise a
+	static Register select(const Register a, const Register b, const Register mask)
+	{
+#if defined(SSEREDUCE_BLENDV)
+		return _mm_blendv_ps(a, b, mask);
+#else
+		return _mm_or_ps(_mm_andnot_ps(mask, a), _mm_and_ps(mask, b));
+#endif
+	}
+
+	static Index indexFirst() { return _mm_setr_epi32(0, 1, 2, 3); }
+	static Index index1(const int32_t n) { return _mm_set1_epi32(n); }
+	static Index indexAdd(const Index a, const Index b) { return _mm_add_epi32(a, b); }
+	static Index selectIndex(const Index a, const Index b, const Register mask)
+	{
+		return _mm_castps_si128(select(_mm_castsi128_ps(a), _mm_castsi128_ps(b), mask));
+	}
+	static void storeIndex(int32_t *p, const Index a) { _mm_storeu_si128((__m128i*)p, a); }
+
+	static float horizontalSum(const Register a)
+	{
+		__m128 shuffled = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+		__m128 sums = _mm_add_ps(a, shuffled);
+		shuffled = _mm_movehl_ps(shuffled, sums);
+		return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+	}
+	static float horizontalMin(const Register a)
+	{
+		const __m128 m = _mm_min_ps(a, _mm_movehl_ps(a, a));
+		return _mm_cvtss_f32(_mm_min_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1))));
+	}
+	static float horizontalMax(const Register a)
+	{
+		const __m128 m = _mm_max_ps(a, _mm_movehl_ps(a, a));
+		return _mm_cvtss_f32(_mm_max_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1))));
+	}
+};
+
+#if defined(__AVX2__)
+
+struct ReduceLanes8
+{
+	typedef __m256 Register;
+	typedef __m256i Index;
+	static const size_t Lanes = 8;
+
+	static Register set1(const float f) { return _mm256_set1_ps(f); }
+	static Register load(const float *p) { return _mm256_loadu_ps(p); }
+	static void store(float *p, const Register a) { _mm256_storeu_ps(p, a); }
+
+	static Register add(const Register a, const Register b) { return _mm256_add_ps(a, b); }
+	static Register sub(const Register a, const Register b) { return _mm256_sub_ps(a, b); }
+	static Register (min)(const Register a, const Register b) { return _mm256_min_ps(a, b); }
+	static Register (max)(const Register a, const Register b) { return _mm256_max_ps(a, b); }
+
+	static Register greater(const Register a, const Register b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static Register less(const Register a, const Register b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static Register select(const Register a, const Register b, const Register mask) { return _mm256_blendv_ps(a, b, mask); }
+
+	static Index indexFirst() { return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7); }
+	static Index index1(const int32_t n) { return _mm256_set1_epi32(n); }
+	static Index indexAdd(const Index a, const Index b) { return _mm256_add_epi32(a, b); }
+	static Index selectIndex(const Index a, const Index b, const Register mask)
+	{
+		return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), mask));
+	}
+	static void storeIndex(int32_t *p, const Index a) { _mm256_storeu_si256((__m256i*)p, a); }
+
+	// halves first, then as four lanes
+	static float horizontalSum(const Register a)
+	{
+		return ReduceLanes4::horizontalSum(_mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1)));
+	}
+	static float horizontalMin(const Register a)
+	{
+		return ReduceLanes4::horizontalMin(_mm_min_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1)));
+	}
+	static float horizontalMax(const Register a)
+	{
+		return ReduceLanes4::horizontalMax(_mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1)));
+	}
+};
+
+typedef ReduceLanes8 ReduceLanes;
+#else
+typedef ReduceLanes4 ReduceLanes;
+#endif
+
+
+////////// local helpers
+
+// floats summed directly before adding pairwise
+static const size_t s_nPairwiseLeaf = 1024;
+
+// floats per block in parallel versions:
+// power of two leaves, so that blocks are subtrees of pairwise sum
+static const size_t s_nParallelBlock = (size_t)1 << 16;
+
+// positions are tracked in 32-bit lanes
+static const size_t s_nIndexChunk = (size_t)1 << 30;
+
+// less than a register of values at end: padded in local buffer
+template <class L> static inline typename L::Register loadTail(const float *p, const size_t nCount, const float fPad)
+{
+	float values[L::Lanes];
+	for (size_t i = 0; i < L::Lanes; i++)
+	{
+		values[i] = fPad;
+	}
+	::memcpy(values, p, nCount * sizeof(float));
+	return L::load(values);
+}
+
+template <class L, bool bMax> static inline typename L::Register pick(const typename L::Register a, const typename L::Register b)
+{
+	return (bMax == true) ? (L::max)(a, b) : (L::min)(a, b);
+}
+
+template <class L, bool bMax> static inline typename L::Register better(const typename L::Register a, const typename L::Register b)
+{
+	return (bMax == true) ? L::greater(a, b) : L::less(a, b);
+}
+
+template <bool bMax> static inline float identity()
+{
+	return (bMax == true) ? -std::numeric_limits<float>::infinity() : std::numeric_limits<float>::infinity();
+}
+
+// sum in four accumulators
+template <class L> static float sumRange(const float *p, const size_t nCount)
+{
+	typename L::Register sum0 = L::set1(0.0f);
+	typename L::Register sum1 = sum0;
+	typename L::Register sum2 = sum0;
+	typename L::Register sum3 = sum0;
+
+	size_t i = 0;
+	for (; i + 4 * L::Lanes <= nCount; i += 4 * L::Lanes)
+	{
+		sum0 = L::add(sum0, L::load(p + i));
+		sum1 = L::add(sum1, L::load(p + i + L::Lanes));
+		sum2 = L::add(sum2, L::load(p + i + 2 * L::Lanes));
+		sum3 = L::add(sum3, L::load(p + i + 3 * L::Lanes));
+	}
+	for (; i + L::Lanes <= nCount; i += L::Lanes)
+	{
+		sum0 = L::add(sum0, L::load(p + i));
+	}
+	if (i < nCount)
+	{
+		sum1 = L::add(sum1, loadTail<L>(p + i, nCount - i, 0.0f));
+	}
+	return L::horizontalSum(L::add(L::add(sum0, sum1), L::add(sum2, sum3)));
+}
+
+// halves at power of two leaves:
+// left half is always complete tree
+template <class L> static float sumPairwise(const float *p, const size_t nCount)
+{
+	if (nCount <= s_nPairwiseLeaf)
+	{
+		return sumRange<L>(p, nCount);
+	}
+	size_t nHalf = s_nPairwiseLeaf;
+	while (2 * nHalf < nCount)
+	{
+		nHalf *= 2;
+	}
+	return sumPairwise<L>(p, nHalf) + sumPairwise<L>(p + nHalf, nCount - nHalf);
+}
+
+// same tree over block sums as sumPairwise() over blocks
+static float combinePairwise(const float *pSums, const size_t nCount)
+{
+	if (nCount == 1)
+	{
+		return pSums[0];
+	}
+	size_t nHalf = 1;
+	while (2 * nHalf < nCount)
+	{
+		nHalf *= 2;
+	}
+	return combinePairwise(pSums, nHalf) + combinePairwise(pSums + nHalf, nCount - nHalf);
+}
+
+// sum += value, compensation keeps (negated) low part lost in rounding
+template <class L> static inline void kahanAdd(typename L::Register &sum, typename L::Register &comp, const typename L::Register value)
+{
+	const typename L::Register y = L::sub(value, comp);
+	const typename L::Register t = L::add(sum, y);
+	comp = L::sub(L::sub(t, sum), y);
+	sum = t;
+}
+
+// four accumulators since each add waits for previous four operations
+template <class L> static float sumKahan(const float *p, const size_t nCount)
+{
+	typename L::Register sums[4];
+	typename L::Register comps[4];
+	for (int k = 0; k < 4; k++)
+	{
+		sums[k] = L::set1(0.0f);
+		comps[k] = L::set1(0.0f);
+	}
+
+	size_t i = 0;
+	for (; i + 4 * L::Lanes <= nCount; i += 4 * L::Lanes)
+	{
+		for (int k = 0; k < 4; k++)
+		{
+			kahanAdd<L>(sums[k], comps[k], L::load(p + i + k * L::Lanes));
+		}
+	}
+	for (; i + L::Lanes <= nCount; i += L::Lanes)
+	{
+		kahanAdd<L>(sums[0], comps[0], L::load(p + i));
+	}
+	if (i < nCount)
+	{
+		kahanAdd<L>(sums[1], comps[1], loadTail<L>(p + i, nCount - i, 0.0f));
+	}
+
+	// lanes combined in double: exact enough for few values
+	float values[4 * L::Lanes];
+	float lost[4 * L::Lanes];
+	for (int k = 0; k < 4; k++)
+	{
+		L::store(values + k * L::Lanes, sums[k]);
+		L::store(lost + k * L::Lanes, comps[k]);
+	}
+	double dSum = 0.0;
+	for (size_t j = 0; j < 4 * L::Lanes; j++)
+	{
+		dSum += (double)values[j] - (double)lost[j];
+	}
+	return (float)dSum;
+}
+
+// value as accumulator second operand: NaN values are dropped
+template <class L, bool bMax> static float extremeRange(const float *p, const size_t nCount)
+{
+	typename L::Register m0 = L::set1(identity<bMax>());
+	typename L::Register m1 = m0;
+	typename L::Register m2 = m0;
+	typename L::Register m3 = m0;
+
+	size_t i = 0;
+	for (; i + 4 * L::Lanes <= nCount; i += 4 * L::Lanes)
+	{
+		m0 = pick<L, bMax>(L::load(p + i), m0);
+		m1 = pick<L, bMax>(L::load(p + i + L::Lanes), m1);
+		m2 = pick<L, bMax>(L::load(p + i + 2 * L::Lanes), m2);
+		m3 = pick<L, bMax>(L::load(p + i + 3 * L::Lanes), m3);
+	}
+	for (; i + L::Lanes <= nCount; i += L::Lanes)
+	{
+		m0 = pick<L, bMax>(L::load(p + i), m0);
+	}
+	if (i < nCount)
+	{
+		m1 = pick<L, bMax>(loadTail<L>(p + i, nCount - i, identity<bMax>()), m1);
+	}
+
+	const typename L::Register m = pick<L, bMax>(pick<L, bMax>(m0, m1), pick<L, bMax>(m2, m3));
+	return (bMax == true) ? L::horizontalMax(m) : L::horizontalMin(m);
+}
+
+// position of first extreme in less than s_nIndexChunk values,
+// two sets of lanes (even and odd registers) to shorten dependency chain
+template <class L, bool bMax> static size_t extremeIndexRange(const float *p, const size_t nCount)
+{
+	typename L::Register best0 = L::set1(identity<bMax>());
+	typename L::Register best1 = best0;
+	typename L::Index index0 = L::index1(-1);
+	typename L::Index index1 = index0;
+	typename L::Index current0 = L::indexFirst();
+	typename L::Index current1 = L::indexAdd(current0, L::index1((int32_t)L::Lanes));
+	const typename L::Index step = L::index1((int32_t)(2 * L::Lanes));
+
+	size_t i = 0;
+	for (; i + 2 * L::Lanes <= nCount; i += 2 * L::Lanes)
+	{
+		const typename L::Register x0 = L::load(p + i);
+		const typename L::Register x1 = L::load(p + i + L::Lanes);
+		const typename L::Register mask0 = better<L, bMax>(x0, best0);
+		const typename L::Register mask1 = better<L, bMax>(x1, best1);
+		best0 = L::select(best0, x0, mask0);
+		best1 = L::select(best1, x1, mask1);
+		index0 = L::selectIndex(index0, current0, mask0);
+		index1 = L::selectIndex(index1, current1, mask1);
+		current0 = L::indexAdd(current0, step);
+		current1 = L::indexAdd(current1, step);
+	}
+	for (; i < nCount; i += L::Lanes)
+	{
+		// padding is never strictly better
+		const size_t nPart = (nCount - i < L::Lanes) ? nCount - i : L::Lanes;
+		const typename L::Register x = loadTail<L>(p + i, nPart, identity<bMax>());
+		const typename L::Register mask = better<L, bMax>(x, best0);
+		best0 = L::select(best0, x, mask);
+		index0 = L::selectIndex(index0, L::indexAdd(L::indexFirst(), L::index1((int32_t)i)), mask);
+	}
+
+	float values[2 * L::Lanes];
+	int32_t indices[2 * L::Lanes];
+	L::store(values, best0);
+	L::store(values + L::Lanes, best1);
+	L::storeIndex(indices, index0);
+	L::storeIndex(indices + L::Lanes, index1);
+
+	size_t nBest = nCount;
+	for (size_t j = 0; j < 2 * L::Lanes; j++)
+	{
+		if (indices[j] < 0)
+		{
+			continue;
+		}
+		const size_t nIndex = (size_t)indices[j];
+		if (nBest == nCount
+			|| ((bMax == true) ? (values[j] > p[nBest]) : (values[j] < p[nBest]))
+			|| (values[j] == p[nBest] && nIndex < nBest))
+		{
+			nBest = nIndex;
+		}
+	}
+
+	if (nBest == nCount)
+	{
+		// nothing beyond identity: first value that is not NaN
+		for (size_t j = 0; j < nCount; j++)
+		{
+			if (p[j] == p[j])
+			{
+				return j;
+			}
+		}
+	}
+	return nBest;
+}
+
+// earlier position wins ties, none is nCount
+template <bool bMax> static inline bool betterAt(const float *p, const size_t nCandidate, const size_t nBest, const size_t nCount)
+{
+	if (nCandidate == nCount)
+	{
+		return false;
+	}
+	if (nBest == nCount)
+	{
+		return true;
+	}
+	return (bMax == true) ? (p[nCandidate] > p[nBest]) : (p[nCandidate] < p[nBest]);
+}
+
+template <class L, bool bMax> static size_t extremeIndex(const float *p, const size_t nCount)
+{
+	size_t nBest = nCount;
+	for (size_t nBegin = 0; nBegin < nCount; nBegin += s_nIndexChunk)
+	{
+		const size_t nPart = (nCount - nBegin < s_nIndexChunk) ? nCount - nBegin : s_nIndexChunk;
+		const size_t nIndex = extremeIndexRange<L, bMax>(p + nBegin, nPart);
+		const size_t nCandidate = (nIndex < nPart) ? nBegin + nIndex : nCount;
+		if (betterAt<bMax>(p, nCandidate, nBest, nCount) == true)
+		{
+			nBest = nCandidate;
+		}
+	}
+	return nBest;
+}
+
+// func(block) for each block, contiguous ranges of blocks in tasks
+// of current pool: at most nThreads ranges, zero for pool's choice
+template <class Func> static void forBlocks(const size_t nBlocks, const size_t nThreads, const Func &func)
+{
+	const size_t nGrain = (nThreads > 0) ? (nBlocks + nThreads - 1) / nThreads : 0;
+	parallelFor(0, nBlocks, nGrain, [&func](const size_t nBegin, const size_t nEnd)
+	{
+		for (size_t nBlock = nBegin; nBlock < nEnd; nBlock++)
+		{
+			func(nBlock);
+		}
+	});
+}
+
+// block results in block order: same for any thread count
+template <bool bMax> static size_t extremeIndexParallel(const float *p, const size_t nCount, const size_t nThreads)
+{
+	if (nCount <= s_nParallelBlock)
+	{
+		return extremeIndex<ReduceLanes, bMax>(p, nCount);
+	}
+
+	const size_t nBlocks = (nCount + s_nParallelBlock - 1) / s_nParallelBlock;
+	std::vector<size_t> indices(nBlocks);
+	forBlocks(nBlocks, nThreads, [p, nCount, &indices](const size_t nBlock)
+	{
+		const size_t nBegin = nBlock * s_nParallelBlock;
+		const size_t nPart = (nCount - nBegin < s_nParallelBlock) ? nCount - nBegin : s_nParallelBlock;
+		const size_t nIndex = extremeIndexRange<ReduceLanes, bMax>(p + nBegin, nPart);
+		indices[nBlock] = (nIndex < nPart) ? nBegin + nIndex : nCount;
+	});
+
+	size_t nBest = nCount;
+	for (size_t nBlock = 0; nBlock < nBlocks; nBlock++)
+	{
+		if (betterAt<bMax>(p, indices[nBlock], nBest, nCount) == true)
+		{
+			nBest = indices[nBlock];
+		}
+	}
+	return nBest;
+}
+
+
+////////// public methods
+
+float sseReduceSum(const float *pA, const size_t nCount)
+{
+	return sumRange<ReduceLanes>(pA, nCount);
+}
+
+float sseReduceSumPairwise(const float *pA, const size_t nCount)
+{
+	return sumPairwise<ReduceLanes>(pA, nCount);
+}
+
+float sseReduceSumKahan(const float *pA, const size_t nCount)
+{
+	return sumKahan<ReduceLanes>(pA, nCount);
+}
+
+float sseReduceMin(const float *pA, const size_t nCount)
+{
+	return extremeRange<ReduceLanes, false>(pA, nCount);
+}
+
+float sseReduceMax(const float *pA, const size_t nCount)
+{
+	return extremeRange<ReduceLanes, true>(pA, nCount);
+}
+
+size_t sseReduceArgMin(const float *pA, const size_t nCount)
+{
+	return extremeIndex<ReduceLanes, false>(pA, nCount);
+}
+
+size_t sseReduceArgMax(const float *pA, const size_t nCount)
+{
+	return extremeIndex<ReduceLanes, true>(pA, nCount);
+}
+
+float sseReduceSumParallel(const float *pA, const size_t nCount, const size_t nThreads)
+{
+	if (nCount <= s_nParallelBlock)
+	{
+		return sumPairwise<ReduceLanes>(pA, nCount);
+	}
+
+	const size_t nBlocks = (nCount + s_nParallelBlock - 1) / s_nParallelBlock;
+	std::vector<float> sums(nBlocks);
+	forBlocks(nBlocks, nThreads, [pA, nCount, &sums](const size_t nBlock)
+	{
+		const size_t nBegin = nBlock * s_nParallelBlock;
+		const size_t nPart = (nCount - nBegin < s_nParallelBlock) ? nCount - nBegin : s_nParallelBlock;
+		sums[nBlock] = sumPairwise<ReduceLanes>(pA + nBegin, nPart);
+	});
+	return combinePairwise(sums.data(), nBlocks);
+}
+
+size_t sseReduceArgMinParallel(const float *pA, const size_t nCount, const size_t nThreads)
+{
+	return extremeIndexParallel<false>(pA, nCount, nThreads);
+}
+
+size_t sseReduceArgMaxParallel(const float *pA, const size_t nCount, const size_t nThreads)
+{
+	return extremeIndexParallel<true>(pA, nCount, nThreads);
+}
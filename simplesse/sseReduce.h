@@ -0,0 +1,72 @@
+/////////////////////////////////////
+//
+// sseReduce : horizontal reductions of float arrays
+// (sum, minimum, maximum and their positions).
+//
+// Author: Ilkka Prusi
+// Contact: ilkka.prusi@gmail.com
+// Copyright (c): Ilkka Prusi
+//
+// Lanes reduce separately over array (four floats with SSE2,
+// eight when built with AVX2) and lanes are combined once at end.
+// Arrays need no alignment.
+//
+// Sums differ in accuracy:
+// - sseReduceSum() has error growing with array length (fastest)
+// - sseReduceSumPairwise() adds blocks in binary tree,
+//   error grows with logarithm of length at almost same speed
+// - sseReduceSumKahan() carries compensation of rounding in each lane,
+//   error does not depend on length (several times slower).
+//   note: compensation is removed by value-unsafe optimizations
+//   (-ffast-math, /fp:fast), don't build with them.
+//
+// Minimum and maximum ignore NaN values: empty array or only NaN
+// gives +infinity (min) or -infinity (max).
+// Position functions give index of first minimum or maximum,
+// count of values if there is none (empty or only NaN).
+//
+// Parallel versions split array to fixed blocks and combine
+// block results in fixed order: result does not depend
+// on thread count or scheduling, sseReduceSumParallel()
+// gives same bits as sseReduceSumPairwise().
+// Blocks run as tasks of current pool (TaskPool.h): thread count
+// limits array to that many pieces, zero lets pool balance them.
+//
+
+#ifndef SSEREDUCE_H
+#define SSEREDUCE_H
+
+#include <stddef.h>
+
+
+// sum of values
+float sseReduceSum(const float *pA, const size_t nCount);
+
+// sum of values, blocks added pairwise
+float sseReduceSumPairwise(const float *pA, const size_t nCount);
+
+// sum of values with compensated (Kahan) summation
+float sseReduceSumKahan(const float *pA, const size_t nCount);
+
+// smallest value
+float sseReduceMin(const float *pA, const size_t nCount);
+
+// largest value
+float sseReduceMax(const float *pA, const size_t nCount);
+
+// index of first smallest value
+size_t sseReduceArgMin(const float *pA, const size_t nCount);
+
+// index of first largest value
+size_t sseReduceArgMax(const float *pA, const size_t nCount);
+
+// as sseReduceSumPairwise() in threads
+float sseReduceSumParallel(const float *pA, const size_t nCount, const size_t nThreads);
+
+// as sseReduceArgMin() in threads
+size_t sseReduceArgMinParallel(const float *pA, const size_t nCount, const size_t nThreads);
+
+// as sseReduceArgMax() in threads
+size_t sseReduceArgMaxParallel(const float *pA, const size_t nCount, const size_t nThreads);
+
+#endif // SSEREDUCE_H
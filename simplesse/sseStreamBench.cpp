@@ -0,0 +1,74 @@
+// sseStreamBench.cpp : sseArray kernels with normal (cached)
+// and non-temporal (streaming) stores over array sizes.
+//
+// usage: sseStreamBench [max bytes] [MicroBench options]
+//
+// array sizes are powers of two from level 1 data cache size
+// to max bytes per array (default four times last level cache),
+// items per second is memory bandwidth in bytes (read and written).
+//
+
+#include "sseArray.h"
+#include "CpuFeatures.h"
+#include "AlignedAllocator.h"
+#include "MicroBench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+
+
+int main(int argc, char *argv[])
+{
+	const CpuCacheSizes &caches = cpuCacheSizes();
+	size_t nMaxBytes = 4 * caches.m_nLastLevel;
+	if (argc > 1 && argv[1][0] != '-')
+	{
+		nMaxBytes = (size_t)::strtoull(argv[1], nullptr, 10);
+	}
+
+	MicroBench bench;
+	if (bench.parseArgs(argc, argv) == false)
+	{
+		fprintf(stderr, "invalid options\n");
+		return 1;
+	}
+
+	printf("caches: L1 %zu KB, L2 %zu KB, last level %zu KB, stream threshold %zu KB\n\n",
+		caches.m_nL1Data / 1024, caches.m_nL2 / 1024, caches.m_nLastLevel / 1024, sseArrayStreamThreshold() / 1024);
+
+	const std::vector<size_t> sizes = MicroBench::powersOfTwo(caches.m_nL1Data, nMaxBytes);
+	const size_t nMaxCount = sizes.back() / sizeof(float);
+	AlignedVector<float> a(nMaxCount);
+	AlignedVector<float> b(nMaxCount);
+	AlignedVector<float> dst(nMaxCount);
+	for (size_t i = 0; i < nMaxCount; i++)
+	{
+		a[i] = (float)(i % 17) * 0.25f;
+		b[i] = 1.0f + (float)(i % 13) * 0.125f;
+		dst[i] = 0.0f;
+	}
+
+	// bytes read and written
+	auto scaleBytes = [](const size_t nBytes) { return 2 * nBytes; };
+	auto addBytes = [](const size_t nBytes) { return 3 * nBytes; };
+
+	sseArraySetStreamThreshold(SIZE_MAX);
+	bench.sweep("sseArrayScale cached", "bytes", sizes,
+		[&](const size_t nBytes) { sseArrayScale(dst.data(), a.data(), 0.5f, nBytes / sizeof(float)); }, scaleBytes);
+	bench.sweep("sseArrayAdd cached", "bytes", sizes,
+		[&](const size_t nBytes) { sseArrayAdd(dst.data(), a.data(), b.data(), nBytes / sizeof(float)); }, addBytes);
+
+	sseArraySetStreamThreshold(1);
+	bench.sweep("sseArrayScale stream", "bytes", sizes,
+		[&](const size_t nBytes) { sseArrayScale(dst.data(), a.data(), 0.5f, nBytes / sizeof(float)); }, scaleBytes);
+	bench.sweep("sseArrayAdd stream", "bytes", sizes,
+		[&](const size_t nBytes) { sseArrayAdd(dst.data(), a.data(), b.data(), nBytes / sizeof(float)); }, addBytes);
+
+	sseArraySetStreamThreshold(0);
+	bench.sweep("sseArrayAdd default", "bytes", sizes,
+		[&](const size_t nBytes) { sseArrayAdd(dst.data(), a.data(), b.data(), nBytes / sizeof(float)); }, addBytes);
+
+	return (bench.report() == true) ? 0 : 1;
+}